@@ -55,7 +55,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 {
     long intId = integerId(id);
 
-    EntityDict::const_iterator I = m_eobjects.find(intId);
+    EntityTable::const_iterator I = m_eobjects.find(intId);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -70,7 +70,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 /// @return pointer to Entity retrieved, or zero if it was not found.
 LocatedEntity * BaseWorld::getEntity(long id) const
 {
-    EntityDict::const_iterator I = m_eobjects.find(id);
+    EntityTable::const_iterator I = m_eobjects.find(id);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
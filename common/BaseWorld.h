@@ -20,6 +20,7 @@
 #define COMMON_BASE_WORLD_H
 
 #include "globals.h"
+#include "IdMap.h"
 
 #include <Atlas/Message/Element.h>
 #include <Atlas/Objects/ObjectsFwd.h>
@@ -32,7 +33,7 @@ class SystemTime;
 class Task;
 class Location;
 
-typedef std::map<long, LocatedEntity *> EntityDict;
+typedef IdMap<LocatedEntity *> EntityTable;
 
 /// \brief Base class for game world manager object.
 ///
@@ -55,11 +56,11 @@ class BaseWorld {
     /// at startup
     double m_realTime;
 
-    /// \brief Dictionary of all the objects in the world.
+    /// \brief Table of all the objects in the world.
     ///
     /// Pointers to all in-game entities in the world are stored keyed to
     /// their integer ID.
-    EntityDict m_eobjects;
+    EntityTable m_eobjects;
 
     /// \brief Whether the base world is suspended or not.
     ///
@@ -89,8 +90,8 @@ class BaseWorld {
 
     LocatedEntity * getEntity(long id) const;
 
-    /// \brief Read only accessor for the in-game objects dictionary.
-    const EntityDict & getEntities() const {
+    /// \brief Read only accessor for the in-game objects table.
+    const EntityTable & getEntities() const {
         return m_eobjects;
     }
 
@@ -169,9 +170,38 @@ class BaseWorld {
     /// \brief Find an entity of the given type.
     virtual LocatedEntity * findByType(const std::string & type) = 0;
 
+    /// \brief Find all the entities of the given name.
+    ///
+    /// By default only the entity found by findByName() is returned.
+    virtual void findAllByName(const std::string & name,
+                               std::vector<LocatedEntity *> & res) {
+        LocatedEntity * ent = findByName(name);
+        if (ent != 0) {
+            res.push_back(ent);
+        }
+    }
+
+    /// \brief Find all the entities of the given type.
+    ///
+    /// By default only the entity found by findByType() is returned.
+    virtual void findAllByType(const std::string & type,
+                               std::vector<LocatedEntity *> & res,
+                               bool subtypes) {
+        LocatedEntity * ent = findByType(type);
+        if (ent != 0) {
+            res.push_back(ent);
+        }
+    }
+
     /// \brief Add an entity provided to the list of perceptive entities.
     virtual void addPerceptive(LocatedEntity *) = 0;
 
+    /// \brief Called when entities which were asleep have been woken.
+    ///
+    /// Any Tick ops which were parked while the entities were asleep
+    /// should be sent.
+    virtual void wakeEntities() {}
+
     /// \brief Signal that an operation is being dispatched.
     sigc::signal<void, Atlas::Objects::Operation::RootOperation> Dispatching;
 };
@@ -0,0 +1,242 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef COMMON_ID_MAP_H
+#define COMMON_ID_MAP_H
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+/// \brief Open addressing hash table of objects keyed by integer ID
+///
+/// Entries are held in a single flat array, probed linearly from the slot
+/// given by the ID. IDs are allocated sequentially, so the ID itself is
+/// used as the hash, and a table of live IDs behaves much like a dense
+/// array indexed by ID. Removed entries leave a marker in their slot, so
+/// removing entries does not disturb iteration. Iterators present each
+/// entry as a pair of ID and value, as a std::map would, but in no
+/// particular order, and are invalidated when entries are added.
+template <typename T>
+class IdMap {
+  public:
+    typedef long key_type;
+    typedef T mapped_type;
+    typedef std::pair<long, T> value_type;
+    typedef std::size_t size_type;
+  protected:
+    typedef std::vector<value_type> SlotList;
+
+    /// Key of a slot which has never been used
+    static long emptyKey() { return std::numeric_limits<long>::min(); }
+    /// Key of a slot whose entry has been removed
+    static long removedKey() { return std::numeric_limits<long>::min() + 1; }
+
+    /// Slots, with a capacity which is a power of two, or empty
+    SlotList m_slots;
+    /// Number of entries in the table
+    size_type m_size;
+    /// Number of slots which are not empty, including removed entries
+    size_type m_used;
+
+    size_type home(long key) const {
+        return static_cast<size_type>(key) & (m_slots.size() - 1);
+    }
+
+    /// \brief Rebuild the table with at least the given number of slots
+    void rehash(size_type capacity) {
+        size_type slots = 16;
+        while (slots < capacity) {
+            slots *= 2;
+        }
+        SlotList old(slots, value_type(emptyKey(), T()));
+        m_slots.swap(old);
+        m_size = 0;
+        m_used = 0;
+        typename SlotList::const_iterator I = old.begin();
+        typename SlotList::const_iterator Iend = old.end();
+        for (; I != Iend; ++I) {
+            if (I->first > removedKey()) {
+                place(*I);
+            }
+        }
+    }
+
+    /// \brief Put an entry whose key is not in the table into a free slot
+    value_type & place(const value_type & v) {
+        size_type mask = m_slots.size() - 1;
+        size_type i = home(v.first);
+        while (m_slots[i].first > removedKey()) {
+            i = (i + 1) & mask;
+        }
+        if (m_slots[i].first == emptyKey()) {
+            ++m_used;
+        }
+        ++m_size;
+        m_slots[i] = v;
+        return m_slots[i];
+    }
+  public:
+    /// \brief Iterator over the entries in the table
+    class const_iterator {
+      protected:
+        const value_type * m_slot;
+        const value_type * m_end;
+
+        void skipFreeSlots() {
+            while (m_slot != m_end && m_slot->first <= removedKey()) {
+                ++m_slot;
+            }
+        }
+
+        friend class IdMap;
+      public:
+        const_iterator() : m_slot(0), m_end(0) { }
+
+        const_iterator(const value_type * slot, const value_type * end) :
+              m_slot(slot), m_end(end) {
+            skipFreeSlots();
+        }
+
+        const value_type & operator*() const {
+            return *m_slot;
+        }
+
+        const value_type * operator->() const {
+            return m_slot;
+        }
+
+        const_iterator & operator++() {
+            ++m_slot;
+            skipFreeSlots();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old(*this);
+            ++(*this);
+            return old;
+        }
+
+        bool operator==(const const_iterator & other) const {
+            return m_slot == other.m_slot;
+        }
+
+        bool operator!=(const const_iterator & other) const {
+            return !(*this == other);
+        }
+    };
+
+    typedef const_iterator iterator;
+
+    IdMap() : m_size(0), m_used(0) { }
+
+    const_iterator begin() const {
+        if (m_slots.empty()) {
+            return const_iterator();
+        }
+        return const_iterator(&m_slots.front(),
+                              &m_slots.front() + m_slots.size());
+    }
+
+    const_iterator end() const {
+        if (m_slots.empty()) {
+            return const_iterator();
+        }
+        const value_type * end = &m_slots.front() + m_slots.size();
+        return const_iterator(end, end);
+    }
+
+    size_type size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    void clear() {
+        m_slots.clear();
+        m_size = 0;
+        m_used = 0;
+    }
+
+    const_iterator find(long key) const {
+        if (m_slots.empty() || key <= removedKey()) {
+            return end();
+        }
+        size_type mask = m_slots.size() - 1;
+        size_type i = home(key);
+        while (m_slots[i].first != emptyKey()) {
+            if (m_slots[i].first == key) {
+                const value_type * end = &m_slots.front() + m_slots.size();
+                return const_iterator(&m_slots[i], end);
+            }
+            i = (i + 1) & mask;
+        }
+        return end();
+    }
+
+    /// \brief Get the value for an ID, or a default value if it is absent
+    T get(long key) const {
+        const_iterator I = find(key);
+        return I == end() ? T() : I->second;
+    }
+
+    /// \brief Get the value for an ID, adding an entry if there is none
+    T & operator[](long key) {
+        const_iterator I = find(key);
+        if (I != end()) {
+            return const_cast<value_type *>(I.m_slot)->second;
+        }
+        // Keep at least a quarter of the slots empty, so probes are short
+        // and always terminate.
+        if ((m_used + 1) * 4 > m_slots.size() * 3) {
+            rehash((m_size + 1) * 2);
+        }
+        return place(value_type(key, T())).second;
+    }
+
+    std::pair<const_iterator, bool> insert(const value_type & v) {
+        const_iterator I = find(v.first);
+        if (I != end()) {
+            return std::make_pair(I, false);
+        }
+        (*this)[v.first] = v.second;
+        return std::make_pair(find(v.first), true);
+    }
+
+    void erase(const const_iterator & I) {
+        value_type * slot = const_cast<value_type *>(I.m_slot);
+        slot->first = removedKey();
+        slot->second = T();
+        --m_size;
+    }
+
+    size_type erase(long key) {
+        const_iterator I = find(key);
+        if (I == end()) {
+            return 0;
+        }
+        erase(I);
+        return 1;
+    }
+};
+
+#endif // COMMON_ID_MAP_H
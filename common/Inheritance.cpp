@@ -59,6 +59,7 @@ using Atlas::Objects::Operation::Use;
 using Atlas::Objects::Operation::Wield;
 
 Inheritance * Inheritance::m_instance = NULL;
+unsigned long Inheritance::m_generation = 0;
 
 Root atlasOpDefinition(const std::string & name, const std::string & parent)
 {
@@ -116,6 +117,7 @@ void Inheritance::flush()
         delete I->second;
     }
     atlasObjects.clear();
+    ++m_generation;
 }
 
 Inheritance & Inheritance::instance()
@@ -226,13 +228,17 @@ bool Inheritance::isTypeOf(const std::string & instance,
     if (I == Iend) {
         return false;
     }
-    return I->second->isTypeOf(base_type);
+    return isTypeOf(I->second, base_type);
 }
 
 bool Inheritance::isTypeOf(const TypeNode * instance,
                            const std::string & base_type) const
 {
-    return instance->isTypeOf(base_type);
+    TypeNodeDict::const_iterator I = atlasObjects.find(base_type);
+    if (I == atlasObjects.end()) {
+        return instance->isTypeOf(base_type);
+    }
+    return instance->isTypeOf(I->second);
 }
 
 bool Inheritance::isTypeOf(const TypeNode * instance,
@@ -305,3 +311,12 @@ void installStandardObjects()
     // base classes. Script classes defined in rulsets need to be added
     // at runtime.
 }
+
+const TypeNode * TypeHandle::get() const
+{
+    if (m_type == 0 || m_generation != Inheritance::generation()) {
+        m_type = Inheritance::instance().getType(m_name);
+        m_generation = Inheritance::generation();
+    }
+    return m_type;
+}
@@ -30,7 +30,6 @@ void installStandardObjects();
 void installCustomOperations();
 void installCustomEntities();
 
-typedef std::map<std::string, PropertyBase *> PropertyDict;
 typedef std::map<std::string, TypeNode *> TypeNodeDict;
 
 /// \brief Class to manage the inheritance tree for in-game entity types
@@ -40,6 +39,7 @@ class Inheritance {
     TypeNodeDict atlasObjects;
 
     static Inheritance * m_instance;
+    static unsigned long m_generation;
 
     Inheritance();
 
@@ -47,6 +47,14 @@ class Inheritance {
     static Inheritance & instance();
     static void clear();
 
+    /// \brief Count of the times the type tree has been discarded
+    ///
+    /// Any TypeNode pointer obtained from an earlier generation is no
+    /// longer valid.
+    static unsigned long generation() {
+        return m_generation;
+    }
+
     const TypeNodeDict & getAllObjects() const {
         return atlasObjects;
     }
@@ -66,6 +74,30 @@ class Inheritance {
     void flush();
 };
 
+/// \brief Handle to a named type in the inheritance tree
+///
+/// Callers which check entities against a fixed type name hold one of
+/// these, so the name is looked up once, and each check is a comparison
+/// of TypeNode pointers. The node is looked up again if the type has not
+/// yet been installed, or the tree has been rebuilt since.
+class TypeHandle {
+  protected:
+    const std::string m_name;
+    mutable const TypeNode * m_type;
+    mutable unsigned long m_generation;
+  public:
+    explicit TypeHandle(const std::string & name) : m_name(name),
+                                                    m_type(0),
+                                                    m_generation(0) { }
+
+    /// \brief Name of the type this handle refers to
+    const std::string & name() const {
+        return m_name;
+    }
+
+    const TypeNode * get() const;
+};
+
 Atlas::Objects::Root atlasOpDefinition(const std::string & name,
                                        const std::string & parent);
 Atlas::Objects::Root atlasClass(const std::string & name,
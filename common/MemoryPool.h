@@ -0,0 +1,174 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef COMMON_MEMORY_POOL_H
+#define COMMON_MEMORY_POOL_H
+
+#include <vector>
+
+#include <cstddef>
+
+/// \brief Allocator which carves small objects out of large slabs
+///
+/// Objects are rounded up to a multiple of granularity bytes, and each
+/// size has its own list of free blocks, so a block freed by one object is
+/// reused by the next object of the same size class instead of being
+/// returned to the heap. Slabs are only released when the pool itself is
+/// destroyed. Objects larger than max_size are passed straight through to
+/// the global allocator.
+///
+/// The pool is not thread safe, and must only be used from the thread
+/// which owns the objects it allocates.
+class MemoryPool {
+  public:
+    /// \brief Alignment and size step of blocks allocated from the pool
+    static const std::size_t granularity = 16;
+    /// \brief Largest object allocated from the pool
+    static const std::size_t max_size = 2048;
+    /// \brief Size of each slab requested from the global allocator
+    static const std::size_t slab_size = 64 * 1024;
+  protected:
+    /// \brief Header of a block on a free list
+    struct FreeBlock {
+        FreeBlock * next;
+    };
+
+    static const std::size_t class_count = max_size / granularity;
+
+    /// \brief Free blocks in each size class
+    FreeBlock * m_free[class_count];
+    /// \brief Slabs allocated by this pool
+    std::vector<char *> m_slabs;
+    /// \brief Next unused byte in the newest slab
+    char * m_next;
+    /// \brief End of the newest slab
+    char * m_end;
+
+    /// \brief Count of pooled objects currently allocated
+    int m_live;
+    /// \brief Count of pooled blocks available for reuse
+    int m_reusable;
+    /// \brief Total size in kilobytes of the slabs held by the pool
+    int m_slabKilobytes;
+    /// \brief Count of objects too large for the pool
+    int m_oversize;
+
+    static std::size_t sizeClass(std::size_t size) {
+        return (size + granularity - 1) / granularity - 1;
+    }
+
+    void * carve(std::size_t bytes) {
+        if (m_next + bytes > m_end) {
+            char * slab = static_cast<char *>(::operator new(slab_size));
+            m_slabs.push_back(slab);
+            m_slabKilobytes += slab_size / 1024;
+            // Remaining space at the end of the old slab is given up
+            m_next = slab;
+            m_end = slab + slab_size;
+        }
+        void * block = m_next;
+        m_next += bytes;
+        return block;
+    }
+
+  private:
+    MemoryPool(const MemoryPool &) = delete;
+    MemoryPool & operator=(const MemoryPool &) = delete;
+  public:
+    MemoryPool() : m_next(0), m_end(0), m_live(0), m_reusable(0),
+                   m_slabKilobytes(0), m_oversize(0) {
+        for (std::size_t i = 0; i < class_count; ++i) {
+            m_free[i] = 0;
+        }
+    }
+
+    ~MemoryPool() {
+        std::vector<char *>::const_iterator I = m_slabs.begin();
+        std::vector<char *>::const_iterator Iend = m_slabs.end();
+        for (; I != Iend; ++I) {
+            ::operator delete(*I);
+        }
+    }
+
+    /// \brief Allocate a block of at least size bytes
+    void * allocate(std::size_t size) {
+        if (size > max_size) {
+            ++m_oversize;
+            return ::operator new(size);
+        }
+        if (size == 0) {
+            size = 1;
+        }
+        std::size_t cls = sizeClass(size);
+        ++m_live;
+        FreeBlock * block = m_free[cls];
+        if (block != 0) {
+            m_free[cls] = block->next;
+            --m_reusable;
+            return block;
+        }
+        return carve((cls + 1) * granularity);
+    }
+
+    /// \brief Return a block to the pool
+    ///
+    /// @param p block returned by allocate()
+    /// @param size the size passed to allocate() when it was allocated
+    void deallocate(void * p, std::size_t size) {
+        if (p == 0) {
+            return;
+        }
+        if (size > max_size) {
+            --m_oversize;
+            ::operator delete(p);
+            return;
+        }
+        if (size == 0) {
+            size = 1;
+        }
+        std::size_t cls = sizeClass(size);
+        FreeBlock * block = static_cast<FreeBlock *>(p);
+        block->next = m_free[cls];
+        m_free[cls] = block;
+        --m_live;
+        ++m_reusable;
+    }
+
+    /// \brief Count of objects currently allocated from the pool
+    const int & live() const {
+        return m_live;
+    }
+
+    /// \brief Count of freed blocks waiting to be reused
+    const int & reusable() const {
+        return m_reusable;
+    }
+
+    /// \brief Total size of the slabs held by the pool in kilobytes
+    const int & slabKilobytes() const {
+        return m_slabKilobytes;
+    }
+
+    /// \brief Count of live objects too large to be pooled
+    const int & oversize() const {
+        return m_oversize;
+    }
+};
+
+#endif // COMMON_MEMORY_POOL_H
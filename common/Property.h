@@ -20,6 +20,7 @@
 #define COMMON_PROPERTY_H
 
 #include "OperationRouter.h"
+#include "MemoryPool.h"
 
 #include <Atlas/Message/Element.h>
 
@@ -37,6 +38,21 @@ class PropertyBase {
   public:
     virtual ~PropertyBase();
 
+    /// \brief Pool from which all properties are allocated
+    static MemoryPool & pool() {
+        // Never destroyed, as properties may outlive static destruction
+        static MemoryPool * property_pool = new MemoryPool;
+        return *property_pool;
+    }
+
+    static void * operator new(std::size_t size) {
+        return pool().allocate(size);
+    }
+
+    static void operator delete(void * p, std::size_t size) {
+        pool().deallocate(p, size);
+    }
+
     /// \brief Accessor for Property flags
     unsigned int flags() const { return m_flags; }
     /// \brief Accessor for Property flags
@@ -0,0 +1,364 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef COMMON_PROPERTY_DICT_H
+#define COMMON_PROPERTY_DICT_H
+
+#include "common/PropertyKey.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+class PropertyBase;
+
+/// \brief Table of property objects keyed by interned property name
+///
+/// The built-in properties with fixed keys are held in fixed slots, which
+/// are reached by indexing an array. Other entries are held in a flat
+/// array sorted by PropertyKey, so a table costs one small allocation
+/// rather than a tree node and a string per property. Only built-in and
+/// ruleset names are interned; entries for any other name, such as soft
+/// properties set by clients, are held by name in a separate array owned
+/// by this table, so they do not grow the global intern table. Iterators
+/// present each entry as a pair of name and property, as a std::map
+/// would, and are invalidated when entries are added or removed.
+class PropertyDict {
+  protected:
+    struct Entry {
+        PropertyKey m_key;
+        PropertyBase * m_value;
+    };
+
+    typedef std::vector<Entry> EntryList;
+
+    struct DynamicEntry {
+        std::string m_name;
+        PropertyBase * m_value;
+    };
+
+    typedef std::vector<DynamicEntry> DynamicList;
+
+    /// Properties with fixed keys, indexed by key, or 0 if not present
+    PropertyBase * m_slots[PropertyKey::FIXED_COUNT];
+    /// Properties with other interned keys
+    EntryList m_entries;
+    /// Properties with names which are not interned, sorted by name
+    DynamicList m_dynamic;
+
+    static bool keyLess(const Entry & entry, const PropertyKey & key) {
+        return entry.m_key < key;
+    }
+
+    static bool nameLess(const DynamicEntry & entry, const std::string & name) {
+        return entry.m_name < name;
+    }
+  public:
+    typedef EntryList::size_type size_type;
+    typedef std::pair<const std::string &, PropertyBase *> value_type;
+
+    /// \brief Iterator over the fixed slots which are in use, then the
+    /// other interned entries, then the entries which are not interned
+    class const_iterator {
+      protected:
+        const PropertyDict * m_dict;
+        /// Index of the fixed slot, or of the entry plus the slot count,
+        /// or of the entry which is not interned plus both
+        size_type m_pos;
+
+        /// \brief Get the entry which is not interned at this position,
+        /// or 0 if the position is not one
+        const DynamicEntry * dynamic() const {
+            size_type interned = PropertyKey::FIXED_COUNT +
+                                 m_dict->m_entries.size();
+            if (m_pos < interned) {
+                return 0;
+            }
+            return &m_dict->m_dynamic[m_pos - interned];
+        }
+
+        void skipEmptySlots() {
+            while (m_pos < PropertyKey::FIXED_COUNT &&
+                   m_dict->m_slots[m_pos] == 0) {
+                ++m_pos;
+            }
+        }
+
+        friend class PropertyDict;
+      public:
+        /// \brief Holds the pair for an entry while it is dereferenced
+        class pointer {
+          protected:
+            value_type m_value;
+          public:
+            explicit pointer(const value_type & v) : m_value(v) { }
+
+            const value_type * operator->() const {
+                return &m_value;
+            }
+        };
+
+        const_iterator() : m_dict(0), m_pos(0) { }
+
+        const_iterator(const PropertyDict * dict, size_type pos) :
+              m_dict(dict), m_pos(pos) {
+            skipEmptySlots();
+        }
+
+        /// \brief Get the key of the entry, which is not valid if the
+        /// name of the entry is not interned
+        PropertyKey key() const {
+            if (m_pos < PropertyKey::FIXED_COUNT) {
+                return PropertyKey(static_cast<PropertyKey::Fixed>(m_pos));
+            }
+            if (dynamic() != 0) {
+                return PropertyKey();
+            }
+            return m_dict->m_entries[m_pos - PropertyKey::FIXED_COUNT].m_key;
+        }
+
+        const std::string & name() const {
+            const DynamicEntry * d = dynamic();
+            if (d != 0) {
+                return d->m_name;
+            }
+            return key().name();
+        }
+
+        PropertyBase * value() const {
+            if (m_pos < PropertyKey::FIXED_COUNT) {
+                return m_dict->m_slots[m_pos];
+            }
+            const DynamicEntry * d = dynamic();
+            if (d != 0) {
+                return d->m_value;
+            }
+            return m_dict->m_entries[m_pos - PropertyKey::FIXED_COUNT].m_value;
+        }
+
+        value_type operator*() const {
+            return value_type(name(), value());
+        }
+
+        pointer operator->() const {
+            return pointer(**this);
+        }
+
+        const_iterator & operator++() {
+            ++m_pos;
+            skipEmptySlots();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old(*this);
+            ++(*this);
+            return old;
+        }
+
+        bool operator==(const const_iterator & other) const {
+            return m_pos == other.m_pos && m_dict == other.m_dict;
+        }
+
+        bool operator!=(const const_iterator & other) const {
+            return !(*this == other);
+        }
+    };
+
+    typedef const_iterator iterator;
+
+  protected:
+    /// \brief Get the position of the entry for a name which is not
+    /// interned, or where it would be inserted
+    DynamicList::iterator dynamicBound(const std::string & name) {
+        return std::lower_bound(m_dynamic.begin(), m_dynamic.end(),
+                                name, nameLess);
+    }
+
+    /// \brief Find the entry for a name which is not interned
+    const_iterator findDynamic(const std::string & name) const;
+
+  public:
+    PropertyDict() {
+        std::fill(m_slots, m_slots + PropertyKey::FIXED_COUNT,
+                  static_cast<PropertyBase *>(0));
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, PropertyKey::FIXED_COUNT +
+                                    m_entries.size() + m_dynamic.size());
+    }
+
+    size_type size() const {
+        size_type count = m_entries.size() + m_dynamic.size();
+        for (int i = 0; i < PropertyKey::FIXED_COUNT; ++i) {
+            if (m_slots[i] != 0) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    bool empty() const {
+        return begin() == end();
+    }
+
+    void clear() {
+        std::fill(m_slots, m_slots + PropertyKey::FIXED_COUNT,
+                  static_cast<PropertyBase *>(0));
+        m_entries.clear();
+        m_dynamic.clear();
+    }
+
+    /// \brief Get the property in the slot for a built-in property
+    ///
+    /// @return the property, or 0 if it is not present
+    PropertyBase * slot(PropertyKey::Fixed key) const {
+        return m_slots[key];
+    }
+
+    const_iterator find(const PropertyKey & key) const {
+        if (!key.isValid()) {
+            return end();
+        }
+        if (key.isFixed()) {
+            if (m_slots[key.id()] == 0) {
+                return end();
+            }
+            return const_iterator(this, key.id());
+        }
+        EntryList::const_iterator I = std::lower_bound(m_entries.begin(),
+                                                       m_entries.end(),
+                                                       key, keyLess);
+        if (I == m_entries.end() || I->m_key != key) {
+            return end();
+        }
+        return const_iterator(this, PropertyKey::FIXED_COUNT +
+                                    (I - m_entries.begin()));
+    }
+
+    /// \brief Find the entry for a name, given the key it was looked up as
+    ///
+    /// This avoids looking the name up again when searching several
+    /// tables for the same name.
+    const_iterator find(const PropertyKey & key,
+                        const std::string & name) const {
+        if (!m_dynamic.empty()) {
+            const_iterator I = findDynamic(name);
+            if (I != end()) {
+                return I;
+            }
+        }
+        return find(key);
+    }
+
+    const_iterator find(const std::string & name) const {
+        return find(PropertyKey::lookup(name), name);
+    }
+
+    /// \brief Get the property for a key, adding an empty entry if there
+    /// is none
+    ///
+    /// An empty fixed slot is treated as absent. An entry made by name
+    /// before the name was interned is still used.
+    PropertyBase *& operator[](const PropertyKey & key) {
+        if (key.isFixed()) {
+            return m_slots[key.id()];
+        }
+        if (!m_dynamic.empty()) {
+            DynamicList::iterator J = dynamicBound(key.name());
+            if (J != m_dynamic.end() && J->m_name == key.name()) {
+                return J->m_value;
+            }
+        }
+        EntryList::iterator I = std::lower_bound(m_entries.begin(),
+                                                 m_entries.end(),
+                                                 key, keyLess);
+        if (I == m_entries.end() || I->m_key != key) {
+            Entry entry;
+            entry.m_key = key;
+            entry.m_value = 0;
+            I = m_entries.insert(I, entry);
+        }
+        return I->m_value;
+    }
+
+    /// \brief Get the property for a name, adding an empty entry if there
+    /// is none
+    ///
+    /// The name is not interned. If it has not already been interned as a
+    /// built-in or ruleset name, the entry is held by name in this table.
+    PropertyBase *& operator[](const std::string & name) {
+        DynamicList::iterator I = dynamicBound(name);
+        if (I != m_dynamic.end() && I->m_name == name) {
+            return I->m_value;
+        }
+        PropertyKey key = PropertyKey::lookup(name);
+        if (key.isValid()) {
+            return (*this)[key];
+        }
+        DynamicEntry entry;
+        entry.m_name = name;
+        entry.m_value = 0;
+        return m_dynamic.insert(I, entry)->m_value;
+    }
+
+    void erase(const const_iterator & I) {
+        if (I.m_pos < PropertyKey::FIXED_COUNT) {
+            m_slots[I.m_pos] = 0;
+            return;
+        }
+        size_type interned = PropertyKey::FIXED_COUNT + m_entries.size();
+        if (I.m_pos >= interned) {
+            m_dynamic.erase(m_dynamic.begin() + (I.m_pos - interned));
+            return;
+        }
+        m_entries.erase(m_entries.begin() +
+                        (I.m_pos - PropertyKey::FIXED_COUNT));
+    }
+
+    size_type erase(const std::string & name) {
+        const_iterator I = find(name);
+        if (I == end()) {
+            return 0;
+        }
+        erase(I);
+        return 1;
+    }
+};
+
+inline PropertyDict::const_iterator PropertyDict::findDynamic(
+      const std::string & name) const
+{
+    DynamicList::const_iterator I = std::lower_bound(m_dynamic.begin(),
+                                                     m_dynamic.end(),
+                                                     name, nameLess);
+    if (I == m_dynamic.end() || I->m_name != name) {
+        return end();
+    }
+    return const_iterator(this, PropertyKey::FIXED_COUNT + m_entries.size() +
+                                (I - m_dynamic.begin()));
+}
+
+#endif // COMMON_PROPERTY_DICT_H
@@ -0,0 +1,150 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef COMMON_PROPERTY_KEY_H
+#define COMMON_PROPERTY_KEY_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// \brief Handle to an interned property name
+///
+/// Each distinct property name is stored once in a global table and
+/// identified by a small integer, so property tables can be keyed and
+/// compared by integer instead of by string. A few hot built-in
+/// properties are interned first with fixed ids, so tables can keep
+/// them in fixed slots. The table never shrinks, so only names defined
+/// by the server or the rulesets are interned, never names chosen by
+/// clients.
+class PropertyKey {
+  public:
+    /// \brief Built-in properties with fixed ids
+    enum Fixed {
+        STATUS,
+        MASS,
+        MAXMASS,
+        FOOD,
+        STAMINA,
+        TASKS,
+        BBOX,
+        FIXED_COUNT
+    };
+  protected:
+    typedef std::unordered_map<std::string, unsigned int> KeyDict;
+
+    /// \brief Global table of interned names
+    struct Table {
+        KeyDict m_keys;
+        /// Interned names, indexed by id. The strings are the keys of
+        /// the dictionary, which do not move once inserted.
+        std::vector<const std::string *> m_names;
+
+        Table() {
+            static const char * const fixed_names[FIXED_COUNT] = {
+                "status", "mass", "maxmass", "food", "stamina", "tasks", "bbox"
+            };
+            for (int i = 0; i < FIXED_COUNT; ++i) {
+                intern(fixed_names[i]);
+            }
+        }
+
+        unsigned int intern(const std::string & name) {
+            std::pair<KeyDict::iterator, bool> res =
+                  m_keys.insert(std::make_pair(name, 0u));
+            if (res.second) {
+                res.first->second = m_names.size();
+                m_names.push_back(&res.first->first);
+            }
+            return res.first->second;
+        }
+    };
+
+    /// Marks a handle which does not refer to an interned name
+    static const unsigned int invalid_id = ~0u;
+
+    unsigned int m_id;
+
+    static Table & table() {
+        static Table t;
+        return t;
+    }
+
+    explicit PropertyKey(unsigned int id) : m_id(id) { }
+  public:
+    PropertyKey() : m_id(invalid_id) { }
+
+    /// \brief Get the handle for a name, interning it if it is new
+    ///
+    /// Only used for built-in and ruleset names.
+    explicit PropertyKey(const std::string & name) :
+          m_id(table().intern(name)) { }
+
+    /// \brief Intern a built-in or ruleset property name
+    static PropertyKey intern(const std::string & name) {
+        return PropertyKey(name);
+    }
+
+    /// \brief Get the handle for a built-in property
+    explicit PropertyKey(Fixed key) : m_id(key) { }
+
+    /// \brief Get the handle for a name without interning it
+    ///
+    /// @return the handle, which is not valid if the name has never been
+    /// interned, and so can not be the key of any property
+    static PropertyKey lookup(const std::string & name) {
+        KeyDict::const_iterator I = table().m_keys.find(name);
+        if (I == table().m_keys.end()) {
+            return PropertyKey();
+        }
+        return PropertyKey(I->second);
+    }
+
+    bool isValid() const {
+        return m_id != invalid_id;
+    }
+
+    /// \brief Check if this is one of the built-in properties with a
+    /// fixed id
+    bool isFixed() const {
+        return m_id < static_cast<unsigned int>(FIXED_COUNT);
+    }
+
+    unsigned int id() const {
+        return m_id;
+    }
+
+    const std::string & name() const {
+        return *table().m_names[m_id];
+    }
+
+    bool operator==(const PropertyKey & other) const {
+        return m_id == other.m_id;
+    }
+
+    bool operator!=(const PropertyKey & other) const {
+        return m_id != other.m_id;
+    }
+
+    bool operator<(const PropertyKey & other) const {
+        return m_id < other.m_id;
+    }
+};
+
+#endif // COMMON_PROPERTY_KEY_H
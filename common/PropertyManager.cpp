@@ -19,6 +19,7 @@
 #include "PropertyManager.h"
 
 #include "PropertyFactory.h"
+#include "PropertyKey.h"
 
 #include <cassert>
 
@@ -59,6 +60,9 @@ PropertyKit * PropertyManager::getPropertyFactory(const std::string & name) cons
 void PropertyManager::installFactory(const std::string & name,
                                      PropertyKit * factory)
 {
+    // Property classes are defined by the server or the rulesets, so
+    // their names are interned for fast lookup in entity property tables.
+    PropertyKey::intern(name);
     m_propertyFactories.insert(std::make_pair(name, factory));
 }
 
@@ -28,14 +28,16 @@ static const bool debug_flag = false;
 
 using Atlas::Message::MapType;
 
-TypeNode::TypeNode(const std::string & name) : m_name(name), m_parent(0)
+TypeNode::TypeNode(const std::string & name) : m_name(name), m_parent(0),
+                                               m_ancestors(1, this)
 {
 }
 
 TypeNode::TypeNode(const std::string & name,
                    const Atlas::Objects::Root & d) : m_name(name),
                                                      m_description(d),
-                                                     m_parent(0)
+                                                     m_parent(0),
+                                                     m_ancestors(1, this)
 {
 }
 
@@ -51,7 +53,7 @@ TypeNode::~TypeNode()
 void TypeNode::addProperty(const std::string & name,
                            PropertyBase * p)
 {
-    m_defaults[name] = p;
+    m_defaults[PropertyKey::intern(name)] = p;
 }
 
 void TypeNode::addProperties(const MapType & attributes)
@@ -65,7 +67,7 @@ void TypeNode::addProperties(const MapType & attributes)
         assert(p != 0);
         p->set(J->second);
         p->setFlags(flag_class);
-        m_defaults[J->first] = p;
+        m_defaults[PropertyKey::intern(J->first)] = p;
     }
 }
 
@@ -100,12 +102,12 @@ void TypeNode::updateProperties(const MapType & attributes)
     PropertyBase * p;
     for (; J != Jend; ++J) {
         PropertyDict::const_iterator I = m_defaults.find(J->first);
-        if (I == Iend) {
+        if (I == m_defaults.end()) {
             p = PropertyManager::instance()->addProperty(J->first,
                                                          J->second.getType());
             assert(p != 0);
             p->setFlags(flag_class);
-            m_defaults[J->first] = p;
+            m_defaults[PropertyKey::intern(J->first)] = p;
         } else {
             p = I->second;
         }
@@ -127,12 +129,11 @@ bool TypeNode::isTypeOf(const std::string & base_type) const
 
 bool TypeNode::isTypeOf(const TypeNode * base_type) const
 {
-    const TypeNode * node = this;
-    do {
-        if (node == base_type) {
-            return true;
-        }
-        node = node->parent();
-    } while (node != 0);
-    return false;
+    // A base type is found at the same depth in the ancestors of every
+    // type which inherits from it.
+    if (base_type == 0) {
+        return false;
+    }
+    std::size_t depth = base_type->depth();
+    return depth < m_ancestors.size() && m_ancestors[depth] == base_type;
 }
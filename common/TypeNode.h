@@ -19,14 +19,16 @@
 #ifndef COMMON_TYPE_NODE_H
 #define COMMON_TYPE_NODE_H
 
+#include "common/PropertyDict.h"
+
 #include <Atlas/Objects/Root.h>
 #include <Atlas/Objects/SmartPtr.h>
 
 #include <iostream>
+#include <vector>
 
 class PropertyBase;
 
-typedef std::map<std::string, PropertyBase *> PropertyDict;
 
 /// \brief Entry in the type hierarchy for in-game entity classes.
 class TypeNode {
@@ -42,6 +44,10 @@ class TypeNode {
 
     /// \brief parent node
     const TypeNode * m_parent;
+
+    /// \brief ancestors of this node, indexed by depth from the root,
+    /// ending with this node
+    std::vector<const TypeNode *> m_ancestors;
   public:
     TypeNode(const std::string &);
     TypeNode(const std::string &, const Atlas::Objects::Root &);
@@ -86,9 +92,22 @@ class TypeNode {
         return m_parent;
     }
 
+    /// \brief depth of this node below the root of its tree
+    std::size_t depth() const {
+        return m_ancestors.size() - 1;
+    }
+
     /// \brief set the parent node
+    ///
+    /// Nodes are added to the tree below their parent, so the parent's
+    /// ancestors are already known, and are extended to cover this node.
     void setParent(const TypeNode * parent) {
         m_parent = parent;
+        m_ancestors.clear();
+        if (parent != 0) {
+            m_ancestors = parent->m_ancestors;
+        }
+        m_ancestors.push_back(this);
     }
 };
 
@@ -38,6 +38,8 @@ Location::Location() :
     m_simple(true), m_solid(true),
     m_boxSize(consts::minBoxSize),
     m_squareBoxSize(consts::minSqrBoxSize),
+    m_worldStamp(0), m_worldParentStamp(0), m_worldLoc(0),
+    m_worldValid(false),
     m_loc(0)
 {
 }
@@ -46,6 +48,8 @@ Location::Location(LocatedEntity * rf) :
     m_simple(true), m_solid(true),
     m_boxSize(consts::minBoxSize),
     m_squareBoxSize(consts::minSqrBoxSize),
+    m_worldStamp(0), m_worldParentStamp(0), m_worldLoc(0),
+    m_worldValid(false),
     m_loc(rf)
 {
 }
@@ -54,6 +58,8 @@ Location::Location(LocatedEntity * rf, const Point3D & pos) :
     m_simple(true), m_solid(true),
     m_boxSize(consts::minBoxSize),
     m_squareBoxSize(consts::minSqrBoxSize),
+    m_worldStamp(0), m_worldParentStamp(0), m_worldLoc(0),
+    m_worldValid(false),
     m_loc(rf), m_pos(pos)
 {
 }
@@ -64,6 +70,8 @@ Location::Location(LocatedEntity * rf,
     m_simple(true), m_solid(true),
     m_boxSize(consts::minBoxSize),
     m_squareBoxSize(consts::minSqrBoxSize),
+    m_worldStamp(0), m_worldParentStamp(0), m_worldLoc(0),
+    m_worldValid(false),
     m_loc(rf), m_pos(pos), m_velocity(velocity)
 {
 }
@@ -196,6 +204,76 @@ const Atlas::Objects::Root Location::asEntity() const
     return ret;
 }
 
+/// Source of unique stamps for cached world transforms
+static unsigned long world_stamp = 0;
+
+static bool samePoint(const Point3D & a, const Point3D & b)
+{
+    if (!a.isValid() || !b.isValid()) {
+        return a.isValid() == b.isValid();
+    }
+    return a.x() == b.x() && a.y() == b.y() && a.z() == b.z();
+}
+
+static bool sameOrientation(const Quaternion & a, const Quaternion & b)
+{
+    if (!a.isValid() || !b.isValid()) {
+        return a.isValid() == b.isValid();
+    }
+    const Vector3D & av = a.vector();
+    const Vector3D & bv = b.vector();
+    return a.scalar() == b.scalar() &&
+           av.x() == bv.x() && av.y() == bv.y() && av.z() == bv.z();
+}
+
+const Location * Location::updateWorldTransform() const
+{
+    const Location * root = this;
+    const Location * parent = 0;
+    unsigned long parent_stamp = 0;
+    if (m_loc != 0) {
+        parent = &m_loc->m_location;
+        root = parent->updateWorldTransform();
+        parent_stamp = parent->m_worldStamp;
+    }
+
+    if (m_worldStamp != 0 &&
+        m_worldLoc == m_loc &&
+        m_worldParentStamp == parent_stamp &&
+        samePoint(m_worldFromPos, m_pos) &&
+        sameOrientation(m_worldFromOrientation, m_orientation)) {
+        return root;
+    }
+
+    static const Quaternion identity(1, 0, 0, 0);
+
+    if (parent == 0) {
+        // Everything is measured from the origin of the root
+        m_worldPos = Point3D(0, 0, 0);
+        m_worldOrientation = identity;
+        m_worldValid = true;
+    } else if (!parent->m_worldValid || !m_pos.isValid()) {
+        m_worldValid = false;
+    } else {
+        m_worldPos = m_pos.toParentCoords(parent->m_worldPos,
+                                          parent->m_worldOrientation);
+        if (m_orientation.isValid()) {
+            m_worldOrientation = m_orientation;
+            m_worldOrientation *= parent->m_worldOrientation;
+        } else {
+            m_worldOrientation = parent->m_worldOrientation;
+        }
+        m_worldValid = true;
+    }
+
+    m_worldLoc = m_loc;
+    m_worldFromPos = m_pos;
+    m_worldFromOrientation = m_orientation;
+    m_worldParentStamp = parent_stamp;
+    m_worldStamp = ++world_stamp;
+    return root;
+}
+
 static bool distanceFromAncestor(const Location & self,
                                  const Location & other, Point3D & c)
 {
@@ -287,6 +365,12 @@ const Point3D relativePos(const Location & self, const Location & other)
 
 float squareDistance(const Location & self, const Location & other)
 {
+    // Where both locations are in the same hierarchy, the distance is
+    // the same in the coordinates of the root as anywhere else.
+    if (self.updateWorldTransform() == other.updateWorldTransform() &&
+        self.hasWorldTransform() && other.hasWorldTransform()) {
+        return squareDistance(self.worldPos(), other.worldPos());
+    }
     Point3D dist;
     distanceToAncestor(self, other, dist);
     return sqrMag(dist);
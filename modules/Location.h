@@ -44,6 +44,18 @@ class Location {
 
     float m_radius; // Radius of bounding sphere of box
     float m_squareRadius;
+
+    // Cached transform from this location to the root of the hierarchy,
+    // and the values it was calculated from. The stamp is unique for each
+    // calculation, so a child can tell if its parent has changed.
+    mutable Point3D m_worldPos;
+    mutable Quaternion m_worldOrientation;
+    mutable unsigned long m_worldStamp;
+    mutable unsigned long m_worldParentStamp;
+    mutable LocatedEntity * m_worldLoc;
+    mutable Point3D m_worldFromPos;
+    mutable Quaternion m_worldFromOrientation;
+    mutable bool m_worldValid;
   public:
     LocatedEntity * m_loc;
     Point3D m_pos;   // Coords relative to m_loc entity
@@ -113,6 +125,22 @@ class Location {
     void modifyBBox();
     void setVisibility(float v);
 
+    /// \brief Bring the cached transform to the root of the hierarchy up
+    /// to date.
+    ///
+    /// Only the parts of the hierarchy which have moved since the last call
+    /// are recalculated.
+    /// @return the Location at the root of the hierarchy
+    const Location * updateWorldTransform() const;
+
+    /// \brief Position in the coordinates of the root of the hierarchy
+    ///
+    /// Only valid after a call to updateWorldTransform().
+    const Point3D & worldPos() const { return m_worldPos; }
+
+    /// \brief Whether worldPos() could be calculated
+    bool hasWorldTransform() const { return m_worldValid; }
+
     friend std::ostream & operator<<(std::ostream& s, Location& v);
 };
 
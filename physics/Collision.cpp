@@ -25,7 +25,14 @@
 
 #include <iostream>
 
+#include <algorithm>
+
 #include <cassert>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 static const bool debug_flag = false;
 
@@ -209,6 +216,17 @@ bool predictCollision(const CoordList & l,    // Vertices of this mesh
 //       y\ | /x                     0
 //         \|/
 
+// Returns true if the bounding spheres of l and o can not meet in time
+static bool outOfReach(const Location & l,
+                       const Location & o,
+                       const Vector3D & o_velocity,
+                       float time)
+{
+    Vector3D dist = o.pos() - l.pos();
+    return ((dist.mag() - l.velocity().mag() * time - o_velocity.mag() * time) >
+            (boxBoundingRadius(l.bBox()) + boxBoundingRadius(o.bBox())));
+}
+
 bool predictCollision(const Location & l,  // This location
                       const Location & o,  // Other location
                       float & time,       // Returned time to collision
@@ -231,9 +249,7 @@ bool predictCollision(const Location & l,  // This location
 
     assert(o_velocity.isValid());
 
-    Vector3D dist = o.pos() - l.pos();
-    if ((dist.mag() - l.velocity().mag() * time - o_velocity.mag() * time) >
-        (boxBoundingRadius(l.bBox()) + boxBoundingRadius(o.bBox()))) {
+    if (outOfReach(l, o, o_velocity, time)) {
         return false;
     }
 
@@ -322,6 +338,344 @@ bool predictCollision(const Location & l,  // This location
                             time, normal);
 }
 
+////////////////////////// BATCHED COLLISION //////////////////////////
+
+const std::size_t CollisionBatch::lanes;
+
+void CollisionBatch::clear()
+{
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        m_fields[f].clear();
+    }
+    m_locations.clear();
+    m_oriented.clear();
+}
+
+void CollisionBatch::add(const Location & loc)
+{
+    assert(loc.bBox().isValid());
+
+    std::size_t i = m_locations.size();
+    m_locations.push_back(&loc);
+    m_oriented.push_back(loc.orientation().isValid());
+
+    if (i % lanes == 0) {
+        // Pad every field out to the end of a new group of lanes
+        for (int f = 0; f < FIELD_COUNT; ++f) {
+            m_fields[f].resize(i + lanes, 0.f);
+        }
+    }
+
+    const Vector3D & velocity = loc.velocity().isValid() ? loc.velocity()
+                                                         : Vector3D::ZERO();
+    const WFMath::Point<3> & low = loc.bBox().lowCorner();
+    const WFMath::Point<3> & high = loc.bBox().highCorner();
+
+    m_fields[POS_X][i] = loc.pos().x();
+    m_fields[POS_Y][i] = loc.pos().y();
+    m_fields[POS_Z][i] = loc.pos().z();
+    m_fields[VEL_X][i] = velocity.x();
+    m_fields[VEL_Y][i] = velocity.y();
+    m_fields[VEL_Z][i] = velocity.z();
+    m_fields[LOW_X][i] = low.x();
+    m_fields[LOW_Y][i] = low.y();
+    m_fields[LOW_Z][i] = low.z();
+    m_fields[HIGH_X][i] = high.x();
+    m_fields[HIGH_Y][i] = high.y();
+    m_fields[HIGH_Z][i] = high.z();
+}
+
+#ifdef __SSE2__
+
+/// Face of an axis aligned box, in the order predictCollision() visits the
+/// surface normals of a box.
+struct BoxFace {
+    int axis;          // Axis the face is perpendicular to
+    bool high;         // Face is on the high side of the box
+    float normal[3];   // Surface normal
+};
+
+static const BoxFace box_faces[6] = {
+    { 2, false, {  0.f,  0.f, -1.f } }, // Bottom face
+    { 1, false, {  0.f, -1.f,  0.f } }, // South face
+    { 0, true,  {  1.f,  0.f,  0.f } }, // East face
+    { 0, false, { -1.f,  0.f,  0.f } }, // West face
+    { 2, true,  {  0.f,  0.f,  1.f } }, // Top face
+    { 1, true,  {  0.f,  1.f,  0.f } }, // North face
+};
+
+// Which corners of the box vertex layout above are on the high side of
+// each axis.
+static const bool box_corners[8][3] = {
+    { false, false, false },
+    { true,  false, false },
+    { true,  true,  false },
+    { false, true,  false },
+    { false, false, true  },
+    { true,  false, true  },
+    { true,  true,  true  },
+    { false, true,  true  },
+};
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Lane by lane equivalent of predictEntryExit() for axis aligned boxes.
+// Each time is calculated as getCollisionTime() does, operation for
+// operation, so the results are identical to the scalar code.
+static void predictEntryExit(const __m128 c[8][3],     // Vertices of this box
+                             const __m128 u[3],        // Velocity of this box
+                             const __m128 o[6],        // Faces of other box
+                             const __m128 v[3],        // Velocity of other box
+                             __m128 & first_collision, // Time first vertex enters
+                             __m128 & face,            // Returned face index
+                             __m128 & ret)             // Returned hit mask
+{
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 denominator[6];
+    for (int j = 0; j < 6; ++j) {
+        const float * n = box_faces[j].normal;
+        const __m128 nx = _mm_set1_ps(n[0]);
+        const __m128 ny = _mm_set1_ps(n[1]);
+        const __m128 nz = _mm_set1_ps(n[2]);
+        denominator[j] = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_add_ps(_mm_add_ps(
+                                    _mm_mul_ps(v[0], nx),
+                                    _mm_mul_ps(v[1], ny)),
+                                    _mm_mul_ps(v[2], nz)),
+                                    _mm_mul_ps(u[0], nx)),
+                                    _mm_mul_ps(u[1], ny)),
+                                    _mm_mul_ps(u[2], nz));
+    }
+
+    __m128 already = zero;
+    ret = zero;
+    for (int i = 0; i < 8; ++i) {
+        __m128 last_vertex_entry = _mm_set1_ps(-100.f);
+        __m128 first_vertex_exit = _mm_set1_ps(100.f);
+        __m128 entry_face = zero;
+        for (int j = 0; j < 6; ++j) {
+            const BoxFace & f = box_faces[j];
+            const __m128 & p = c[i][f.axis];
+            // The distance infront of the plane
+            __m128 distance = f.high ? _mm_sub_ps(p, o[j])
+                                     : _mm_sub_ps(o[j], p);
+            __m128 time = _mm_div_ps(distance, denominator[j]);
+            __m128 entering = _mm_xor_ps(_mm_cmpgt_ps(distance, zero),
+                                         _mm_cmplt_ps(time, zero));
+            __m128 entry = _mm_and_ps(entering,
+                                      _mm_cmpgt_ps(time, last_vertex_entry));
+            last_vertex_entry = select(entry, time, last_vertex_entry);
+            entry_face = select(entry, _mm_set1_ps(j), entry_face);
+            __m128 exit = _mm_andnot_ps(entering,
+                                        _mm_cmplt_ps(time, first_vertex_exit));
+            first_vertex_exit = select(exit, time, first_vertex_exit);
+        }
+        __m128 inside = _mm_and_ps(
+              _mm_cmplt_ps(last_vertex_entry, first_vertex_exit),
+              _mm_cmplt_ps(last_vertex_entry, first_collision));
+        __m128 future = _mm_cmpge_ps(last_vertex_entry, zero);
+        __m128 hit = _mm_and_ps(inside, future);
+        first_collision = select(hit, last_vertex_entry, first_collision);
+        face = select(hit, entry_face, face);
+        ret = _mm_or_ps(ret, hit);
+        already = _mm_or_ps(already, _mm_andnot_ps(future, inside));
+    }
+    first_collision = select(_mm_and_ps(ret, already), zero, first_collision);
+}
+
+// Predict collisions between an axis aligned box, and one group of lanes
+// from a batch. Returns a bit mask of the lanes with a collision.
+static int predictGroupCollision(const Location & l,
+                                 const CollisionBatch & batch,
+                                 std::size_t base,
+                                 float horizon,
+                                 float times[CollisionBatch::lanes],
+                                 int faces[CollisionBatch::lanes])
+{
+    const float * data[CollisionBatch::FIELD_COUNT];
+    for (int f = 0; f < CollisionBatch::FIELD_COUNT; ++f) {
+        data[f] = batch.field(CollisionBatch::Field(f)) + base;
+    }
+
+    const float l_pos[3] = { l.pos().x(), l.pos().y(), l.pos().z() };
+    const float l_low[3] = { l.bBox().lowCorner().x(),
+                             l.bBox().lowCorner().y(),
+                             l.bBox().lowCorner().z() };
+    const float l_high[3] = { l.bBox().highCorner().x(),
+                              l.bBox().highCorner().y(),
+                              l.bBox().highCorner().z() };
+
+    __m128 u[3], v[3], lbox[8][3], obox[8][3], lfaces[6], ofaces[6];
+    __m128 o_pos[3], o_low[3], o_high[3];
+    for (int a = 0; a < 3; ++a) {
+        u[a] = _mm_set1_ps(l.velocity()[a]);
+        v[a] = _mm_loadu_ps(data[CollisionBatch::VEL_X + a]);
+        o_pos[a] = _mm_loadu_ps(data[CollisionBatch::POS_X + a]);
+        o_low[a] = _mm_loadu_ps(data[CollisionBatch::LOW_X + a]);
+        o_high[a] = _mm_loadu_ps(data[CollisionBatch::HIGH_X + a]);
+    }
+    for (int i = 0; i < 8; ++i) {
+        for (int a = 0; a < 3; ++a) {
+            bool high = box_corners[i][a];
+            lbox[i][a] = _mm_set1_ps(l_pos[a] + (high ? l_high[a] : l_low[a]));
+            obox[i][a] = _mm_add_ps(o_pos[a], high ? o_high[a] : o_low[a]);
+        }
+    }
+    for (int j = 0; j < 6; ++j) {
+        const BoxFace & f = box_faces[j];
+        lfaces[j] = _mm_set1_ps(l_pos[f.axis] + (f.high ? l_high[f.axis]
+                                                        : l_low[f.axis]));
+        ofaces[j] = _mm_add_ps(o_pos[f.axis], f.high ? o_high[f.axis]
+                                                     : o_low[f.axis]);
+    }
+
+    __m128 time = _mm_set1_ps(horizon);
+    __m128 lo_face = _mm_setzero_ps(), ol_face = _mm_setzero_ps(), lo, ol;
+    predictEntryExit(lbox, u, ofaces, v, time, lo_face, lo);
+    predictEntryExit(obox, v, lfaces, u, time, ol_face, ol);
+    // Faces hit from the other box are numbered after those of this one,
+    // as the normal reaction needs to be reversed.
+    __m128 face = select(ol, _mm_add_ps(ol_face, _mm_set1_ps(6.f)), lo_face);
+
+    _mm_storeu_ps(times, time);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(faces),
+                     _mm_cvtps_epi32(face));
+    return _mm_movemask_ps(_mm_or_ps(lo, ol));
+}
+
+// Returns a bit mask of the lanes in a group whose boxes, swept over the
+// horizon, overlap the swept box of l. The boxes are grown by a margin so
+// that no collision found by the exact test is lost to rounding.
+static int sweptOverlap(const Location & l,
+                        const CollisionBatch & batch,
+                        std::size_t base,
+                        float horizon)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 h = _mm_set1_ps(horizon);
+    const float margin = 0.01f + 1e-5f * (std::fabs(l.pos().x()) +
+                                          std::fabs(l.pos().y()) +
+                                          std::fabs(l.pos().z()));
+    __m128 overlap = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (int a = 0; a < 3; ++a) {
+        const float * pos = batch.field(CollisionBatch::Field(CollisionBatch::POS_X + a));
+        const float * vel = batch.field(CollisionBatch::Field(CollisionBatch::VEL_X + a));
+        const float * low = batch.field(CollisionBatch::Field(CollisionBatch::LOW_X + a));
+        const float * high = batch.field(CollisionBatch::Field(CollisionBatch::HIGH_X + a));
+
+        float travel = l.velocity()[a] * horizon;
+        __m128 l_low = _mm_set1_ps(l.pos()[a] + l.bBox().lowCorner()[a] +
+                                   std::min(travel, 0.f) - margin);
+        __m128 l_high = _mm_set1_ps(l.pos()[a] + l.bBox().highCorner()[a] +
+                                    std::max(travel, 0.f) + margin);
+
+        __m128 o_pos = _mm_loadu_ps(pos + base);
+        __m128 o_travel = _mm_mul_ps(_mm_loadu_ps(vel + base), h);
+        __m128 o_low = _mm_add_ps(_mm_add_ps(o_pos, _mm_loadu_ps(low + base)),
+                                  _mm_min_ps(o_travel, zero));
+        __m128 o_high = _mm_add_ps(_mm_add_ps(o_pos, _mm_loadu_ps(high + base)),
+                                   _mm_max_ps(o_travel, zero));
+
+        overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(o_low, l_high),
+                                                 _mm_cmple_ps(l_low, o_high)));
+    }
+    return _mm_movemask_ps(overlap);
+}
+
+static Vector3D faceNormal(int face)
+{
+    if (face < 6) {
+        const float * n = box_faces[face].normal;
+        return Vector3D(n[0], n[1], n[2]);
+    }
+    const float * n = box_faces[face - 6].normal;
+    return -Vector3D(n[0], n[1], n[2]);
+}
+
+#endif // __SSE2__
+
+int predictCollision(const Location & l,       // This location
+                     const CollisionBatch & o, // Other locations
+                     float horizon,            // Time to look ahead
+                     float & time,             // Returned time to collision
+                     Vector3D & normal)        // Returned normal acting on l
+{
+    assert(l.bBox().isValid());
+    assert(l.velocity().isValid());
+
+    int hit = -1;
+    std::size_t count = o.size();
+
+#ifdef __SSE2__
+    // Rotated boxes are left to the scalar code below
+    if (!l.orientation().isValid()) {
+        const std::size_t lanes = CollisionBatch::lanes;
+        float times[lanes];
+        int faces[lanes];
+        for (std::size_t base = 0; base < count; base += lanes) {
+            std::size_t group = std::min(lanes, count - base);
+            int active = 0;
+            for (std::size_t k = 0; k < group; ++k) {
+                const Location & other = o.location(base + k);
+                if (o.oriented(base + k)) {
+                    continue;
+                }
+                const Vector3D & o_velocity = other.velocity().isValid() ?
+                                              other.velocity() :
+                                              Vector3D::ZERO();
+                if (!outOfReach(l, other, o_velocity, horizon)) {
+                    active |= 1 << k;
+                }
+            }
+            if (active != 0) {
+                active &= sweptOverlap(l, o, base, horizon);
+            }
+            if (active != 0) {
+                active &= predictGroupCollision(l, o, base, horizon,
+                                                times, faces);
+            }
+            for (std::size_t k = 0; k < group; ++k) {
+                float t = horizon;
+                Vector3D n;
+                if (o.oriented(base + k)) {
+                    if (!predictCollision(l, o.location(base + k), t, n)) {
+                        continue;
+                    }
+                } else if (active & (1 << k)) {
+                    t = times[k];
+                    n = faceNormal(faces[k]);
+                } else {
+                    continue;
+                }
+                if (t >= 0 && t <= time) {
+                    hit = static_cast<int>(base + k);
+                    time = t;
+                    normal = n;
+                }
+            }
+        }
+        return hit;
+    }
+#endif // __SSE2__
+
+    for (std::size_t i = 0; i < count; ++i) {
+        float t = horizon;
+        Vector3D n;
+        if (!predictCollision(l, o.location(i), t, n)) {
+            continue;
+        }
+        if (t >= 0 && t <= time) {
+            hit = static_cast<int>(i);
+            time = t;
+            normal = n;
+        }
+    }
+    return hit;
+}
+
 ////////////////////////// EMERGENCE //////////////////////////
 
 bool getEmergenceTime(const Point3D & p,     // Position of point
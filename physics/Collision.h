@@ -25,6 +25,7 @@
 #include <wfmath/axisbox.h>
 
 #include <map>
+#include <vector>
 
 class Location;
 
@@ -65,6 +66,64 @@ bool predictCollision(const Location & l,     // Location data of this object
                       float & time,           // Returned time to collision
                       Vector3D & normal);     // Returned collision normal
 
+/// \brief A set of boxes packed for batched collision prediction.
+///
+/// The position, velocity and box extents of each location are stored as
+/// a structure of arrays, padded to a whole number of lanes, so that the
+/// batched predictCollision() can test several boxes at once.
+class CollisionBatch {
+  public:
+    /// \brief Packed per box values
+    enum Field {
+        POS_X, POS_Y, POS_Z,
+        VEL_X, VEL_Y, VEL_Z,
+        LOW_X, LOW_Y, LOW_Z,
+        HIGH_X, HIGH_Y, HIGH_Z,
+        FIELD_COUNT
+    };
+
+    /// \brief Number of boxes tested together
+    static const std::size_t lanes = 4;
+  protected:
+    std::vector<float> m_fields[FIELD_COUNT];
+    std::vector<const Location *> m_locations;
+    std::vector<bool> m_oriented;
+  public:
+    void clear();
+    void add(const Location & loc);
+
+    std::size_t size() const {
+        return m_locations.size();
+    }
+
+    const Location & location(std::size_t i) const {
+        return *m_locations[i];
+    }
+
+    /// \brief Whether the box at i is rotated, and must be checked singly
+    bool oriented(std::size_t i) const {
+        return m_oriented[i];
+    }
+
+    /// \brief Packed values of one field, padded to a multiple of lanes
+    const float * field(Field f) const {
+        return &m_fields[f].front();
+    }
+};
+
+/// \brief Predict the earliest collision between an entity location and
+/// a batch of other locations.
+///
+/// The result is identical to calling predictCollision() for each location
+/// in the batch in turn, with time to collision starting at horizon, and
+/// keeping the last of the earliest collisions no later than time.
+/// @return the index in the batch of the location hit, or -1 if none is.
+int predictCollision(const Location & l,      // Location data of this object
+                     const CollisionBatch & o,// Locations of other objects
+                     float horizon,           // Time to look ahead
+                     float & time,            // Returned time to collision
+                     Vector3D & normal);      // Returned collision normal
+
 ////////////////////////// EMERGENCE //////////////////////////
 
 /// \brief Predict collision between a point and a plane.
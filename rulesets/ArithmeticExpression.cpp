@@ -0,0 +1,396 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "ArithmeticExpression.h"
+
+#include "ArithmeticScript.h"
+
+#include "common/log.h"
+#include "common/compose.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+/// \brief Recursive descent compiler for arithmetic formulas
+class ArithmeticCompiler {
+  protected:
+    /// \brief Expression the formula is compiled into
+    ArithmeticExpression & m_expression;
+    /// \brief Source text of the formula
+    const std::string & m_source;
+    /// \brief Position of the next character to be read
+    std::string::size_type m_pos;
+    /// \brief Number of values on the stack at this point in the code
+    unsigned int m_depth;
+    /// \brief Description of the first error found, if any
+    std::string m_error;
+
+    void skipSpace();
+    bool accept(char c);
+    void emit(ArithmeticExpression::Opcode op, float constant = 0.f,
+              int symbol = -1);
+    int fail(const std::string & message);
+
+    int expression();
+    int term();
+    int unary();
+    int power();
+    int primary();
+    int function(const std::string & name);
+  public:
+    ArithmeticCompiler(ArithmeticExpression & e, const std::string & source) :
+          m_expression(e), m_source(source), m_pos(0), m_depth(0) { }
+
+    int compile();
+
+    const std::string & error() const {
+        return m_error;
+    }
+
+    std::string::size_type position() const {
+        return m_pos;
+    }
+};
+
+void ArithmeticCompiler::skipSpace()
+{
+    while (m_pos < m_source.size() &&
+           std::isspace((unsigned char)m_source[m_pos])) {
+        ++m_pos;
+    }
+}
+
+bool ArithmeticCompiler::accept(char c)
+{
+    skipSpace();
+    if (m_pos < m_source.size() && m_source[m_pos] == c) {
+        ++m_pos;
+        return true;
+    }
+    return false;
+}
+
+void ArithmeticCompiler::emit(ArithmeticExpression::Opcode op,
+                              float constant,
+                              int symbol)
+{
+    ArithmeticExpression::Instruction i = { op, symbol, constant };
+    m_expression.m_code.push_back(i);
+    switch (op) {
+        case ArithmeticExpression::PUSH_CONSTANT:
+        case ArithmeticExpression::PUSH_SYMBOL:
+            ++m_depth;
+            break;
+        case ArithmeticExpression::NEGATE:
+        case ArithmeticExpression::ABS:
+        case ArithmeticExpression::SQRT:
+            break;
+        default:
+            --m_depth;
+            break;
+    }
+}
+
+int ArithmeticCompiler::fail(const std::string & message)
+{
+    if (m_error.empty()) {
+        m_error = message;
+    }
+    return -1;
+}
+
+int ArithmeticCompiler::compile()
+{
+    if (expression() != 0) {
+        return -1;
+    }
+    skipSpace();
+    if (m_pos != m_source.size()) {
+        return fail("unexpected characters after formula");
+    }
+    return 0;
+}
+
+int ArithmeticCompiler::expression()
+{
+    if (term() != 0) {
+        return -1;
+    }
+    while (true) {
+        if (accept('+')) {
+            if (term() != 0) {
+                return -1;
+            }
+            emit(ArithmeticExpression::ADD);
+        } else if (accept('-')) {
+            if (term() != 0) {
+                return -1;
+            }
+            emit(ArithmeticExpression::SUBTRACT);
+        } else {
+            return 0;
+        }
+    }
+}
+
+int ArithmeticCompiler::term()
+{
+    if (unary() != 0) {
+        return -1;
+    }
+    while (true) {
+        if (accept('*')) {
+            if (unary() != 0) {
+                return -1;
+            }
+            emit(ArithmeticExpression::MULTIPLY);
+        } else if (accept('/')) {
+            if (unary() != 0) {
+                return -1;
+            }
+            emit(ArithmeticExpression::DIVIDE);
+        } else {
+            return 0;
+        }
+    }
+}
+
+int ArithmeticCompiler::unary()
+{
+    if (accept('-')) {
+        if (unary() != 0) {
+            return -1;
+        }
+        emit(ArithmeticExpression::NEGATE);
+        return 0;
+    }
+    if (accept('+')) {
+        return unary();
+    }
+    return power();
+}
+
+int ArithmeticCompiler::power()
+{
+    if (primary() != 0) {
+        return -1;
+    }
+    // Exponentiation is right associative, and binds more tightly than
+    // negation on its left, but not on its right.
+    if (accept('^')) {
+        if (unary() != 0) {
+            return -1;
+        }
+        emit(ArithmeticExpression::POWER);
+    }
+    return 0;
+}
+
+int ArithmeticCompiler::primary()
+{
+    if (m_depth >= ArithmeticExpression::max_stack_depth) {
+        return fail("formula is too complex");
+    }
+    if (accept('(')) {
+        if (expression() != 0) {
+            return -1;
+        }
+        if (!accept(')')) {
+            return fail("expected )");
+        }
+        return 0;
+    }
+    skipSpace();
+    if (m_pos >= m_source.size()) {
+        return fail("unexpected end of formula");
+    }
+    const char * start = m_source.c_str() + m_pos;
+    if (std::isdigit((unsigned char)*start) || *start == '.') {
+        char * end;
+        double value = std::strtod(start, &end);
+        if (end == start) {
+            return fail("malformed number");
+        }
+        m_pos += end - start;
+        emit(ArithmeticExpression::PUSH_CONSTANT, value);
+        return 0;
+    }
+    if (std::isalpha((unsigned char)*start) || *start == '_') {
+        std::string::size_type name_start = m_pos;
+        while (m_pos < m_source.size() &&
+               (std::isalnum((unsigned char)m_source[m_pos]) ||
+                m_source[m_pos] == '_')) {
+            ++m_pos;
+        }
+        std::string name = m_source.substr(name_start, m_pos - name_start);
+        if (accept('(')) {
+            return function(name);
+        }
+        std::vector<std::string> & symbols = m_expression.m_symbols;
+        int symbol = std::find(symbols.begin(), symbols.end(), name) -
+                     symbols.begin();
+        if (symbol == (int)symbols.size()) {
+            symbols.push_back(name);
+        }
+        emit(ArithmeticExpression::PUSH_SYMBOL, 0.f, symbol);
+        return 0;
+    }
+    return fail(String::compose("unexpected character '%1'", *start));
+}
+
+/// \brief Compile a call to a built in function
+///
+/// The opening parenthesis has already been read.
+int ArithmeticCompiler::function(const std::string & name)
+{
+    ArithmeticExpression::Opcode op;
+    int arity;
+    if (name == "min") {
+        op = ArithmeticExpression::MIN;
+        arity = 2;
+    } else if (name == "max") {
+        op = ArithmeticExpression::MAX;
+        arity = 2;
+    } else if (name == "pow") {
+        op = ArithmeticExpression::POWER;
+        arity = 2;
+    } else if (name == "abs") {
+        op = ArithmeticExpression::ABS;
+        arity = 1;
+    } else if (name == "sqrt") {
+        op = ArithmeticExpression::SQRT;
+        arity = 1;
+    } else {
+        return fail(String::compose("unknown function \"%1\"", name));
+    }
+    for (int i = 0; i < arity; ++i) {
+        if (i > 0 && !accept(',')) {
+            return fail(String::compose("expected , in call to %1", name));
+        }
+        if (expression() != 0) {
+            return -1;
+        }
+    }
+    if (!accept(')')) {
+        return fail(String::compose("expected ) after arguments to %1",
+                                    name));
+    }
+    emit(op);
+    return 0;
+}
+
+ArithmeticExpression::ArithmeticExpression()
+{
+}
+
+/// \brief Compile a formula, replacing any previously compiled formula
+///
+/// @param source the formula to compile
+/// @return zero if the formula was compiled, non-zero otherwise
+int ArithmeticExpression::compile(const std::string & source)
+{
+    m_code.clear();
+    m_symbols.clear();
+    ArithmeticCompiler compiler(*this, source);
+    if (compiler.compile() != 0) {
+        log(ERROR, String::compose("Error at character %1 of formula "
+                                   "\"%2\": %3", compiler.position(),
+                                   source, compiler.error()));
+        m_code.clear();
+        m_symbols.clear();
+        return -1;
+    }
+    return 0;
+}
+
+/// \brief Evaluate the formula
+///
+/// @param context the model asked for the value of each name used
+/// @param val the value of the formula is returned here
+/// @return zero if the formula has a value, non-zero otherwise. A formula
+/// has no value if it was not compiled, if the context can not provide a
+/// value for a name, or if it divides by zero.
+int ArithmeticExpression::evaluate(ArithmeticScript & context,
+                                   float & val) const
+{
+    if (m_code.empty()) {
+        return -1;
+    }
+    float stack[max_stack_depth];
+    float * top = stack - 1;
+    std::vector<Instruction>::const_iterator I = m_code.begin();
+    std::vector<Instruction>::const_iterator Iend = m_code.end();
+    for (; I != Iend; ++I) {
+        switch (I->m_op) {
+            case PUSH_CONSTANT:
+                *++top = I->m_constant;
+                break;
+            case PUSH_SYMBOL:
+                if (context.attribute(m_symbols[I->m_symbol], *++top) != 0) {
+                    return -1;
+                }
+                break;
+            case NEGATE:
+                *top = -*top;
+                break;
+            case ADD:
+                --top;
+                *top += top[1];
+                break;
+            case SUBTRACT:
+                --top;
+                *top -= top[1];
+                break;
+            case MULTIPLY:
+                --top;
+                *top *= top[1];
+                break;
+            case DIVIDE:
+                --top;
+                if (top[1] == 0.f) {
+                    return -1;
+                }
+                *top /= top[1];
+                break;
+            case POWER:
+                --top;
+                *top = std::pow(*top, top[1]);
+                break;
+            case MIN:
+                --top;
+                *top = std::min(*top, top[1]);
+                break;
+            case MAX:
+                --top;
+                *top = std::max(*top, top[1]);
+                break;
+            case ABS:
+                *top = std::fabs(*top);
+                break;
+            case SQRT:
+                *top = std::sqrt(*top);
+                break;
+        }
+    }
+    assert(top == stack);
+    val = *top;
+    return 0;
+}
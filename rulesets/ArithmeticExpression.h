@@ -0,0 +1,88 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef RULESETS_ARITHMETIC_EXPRESSION_H
+#define RULESETS_ARITHMETIC_EXPRESSION_H
+
+#include <string>
+#include <vector>
+
+class ArithmeticScript;
+
+/// \brief A numeric formula compiled for evaluation without any scripting
+///
+/// Formulas are written in infix notation using numbers, names,
+/// the operators + - * / and ^, parentheses, and the functions
+/// min, max, abs, sqrt and pow. They are compiled into a sequence of
+/// instructions for a small stack machine. Names are looked up when the
+/// formula is evaluated, by asking an arithmetic model for their values.
+class ArithmeticExpression {
+  public:
+    /// \brief Operations performed by the instructions of a formula
+    enum Opcode {
+        PUSH_CONSTANT,
+        PUSH_SYMBOL,
+        NEGATE,
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        POWER,
+        MIN,
+        MAX,
+        ABS,
+        SQRT
+    };
+
+    /// \brief One instruction of a compiled formula
+    struct Instruction {
+        /// \brief Operation to perform
+        Opcode m_op;
+        /// \brief Index of the symbol to push, for PUSH_SYMBOL
+        int m_symbol;
+        /// \brief Value to push, for PUSH_CONSTANT
+        float m_constant;
+    };
+
+    /// \brief Largest number of values a formula may need on the stack
+    static const unsigned int max_stack_depth = 32;
+  protected:
+    /// \brief Instructions to execute in order
+    std::vector<Instruction> m_code;
+    /// \brief Names referred to by the formula
+    std::vector<std::string> m_symbols;
+
+    friend class ArithmeticCompiler;
+  public:
+    ArithmeticExpression();
+
+    /// \brief Read only accessor for the names referred to by the formula
+    const std::vector<std::string> & symbols() const {
+        return m_symbols;
+    }
+
+    /// \brief Check whether a formula has been successfully compiled
+    bool isValid() const {
+        return !m_code.empty();
+    }
+
+    int compile(const std::string & source);
+    int evaluate(ArithmeticScript & context, float & val) const;
+};
+
+#endif // RULESETS_ARITHMETIC_EXPRESSION_H
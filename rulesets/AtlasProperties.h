@@ -19,9 +19,9 @@
 #ifndef RULESETS_ATLAS_PROPERTIES_H
 #define RULESETS_ATLAS_PROPERTIES_H
 
-#include "common/Property.h"
+#include "rulesets/LocatedEntitySet.h"
 
-#include <set>
+#include "common/Property.h"
 
 /// \brief Class to handle Entity id property
 /// \ingroup PropertyClasses
@@ -47,10 +47,6 @@ class NameProperty : public Property<std::string> {
     virtual void add(const std::string & key, const Atlas::Objects::Entity::RootEntity & ent) const;
 };
 
-class LocatedEntity;
-
-typedef std::set<LocatedEntity *> LocatedEntitySet;
-
 /// \brief Class to handle Entity contains property
 /// \ingroup PropertyClasses
 class ContainsProperty : public PropertyBase {
@@ -0,0 +1,320 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "BroadPhase.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include "common/const.h"
+
+#include <algorithm>
+
+#include <cmath>
+
+/// Width of a grid cell in metres
+static const float cell_size = 16.f;
+/// Largest number of cells an entry may cover before it is checked by
+/// every query instead
+static const float max_entry_cells = 64.f;
+/// Period over which entries are swept, which covers the move tick after
+/// the grid is built, and the move tick checked by a query at the end of it
+static const float sweep_interval = 2.f * consts::move_tick;
+/// Time after which a grid which has not been used is deleted
+static const double idle_limit = 60.;
+
+BroadPhase::BroadPhaseDict BroadPhase::m_grids;
+
+/// \brief Calculate the range of grid cells covered by a box
+///
+/// @return true if the range is small enough to be handled by the grid
+static bool cellRange(const BBox & box, int & minX, int & minY,
+                                        int & maxX, int & maxY)
+{
+    float low_x = std::floor(box.lowCorner().x() / cell_size);
+    float low_y = std::floor(box.lowCorner().y() / cell_size);
+    float high_x = std::floor(box.highCorner().x() / cell_size);
+    float high_y = std::floor(box.highCorner().y() / cell_size);
+    if (((high_x - low_x + 1) * (high_y - low_y + 1)) > max_entry_cells) {
+        return false;
+    }
+    minX = (int)low_x;
+    minY = (int)low_y;
+    maxX = (int)high_x;
+    maxY = (int)high_y;
+    return true;
+}
+
+static inline long cellKey(int x, int y)
+{
+    return ((long)x << 32) | (unsigned int)y;
+}
+
+static inline bool overlaps(const BBox & a, const BBox & b)
+{
+    for (int i = 0; i < 3; ++i) {
+        if (a.highCorner()[i] < b.lowCorner()[i] ||
+            b.highCorner()[i] < a.lowCorner()[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static BroadPhase * newBroadPhase()
+{
+    return new BroadPhase;
+}
+
+BroadPhase::BroadPhase() : m_built(-1.), m_used(-1.), m_stamp(0),
+                           m_query(0)
+{
+}
+
+BroadPhase::~BroadPhase()
+{
+}
+
+BroadPhase * BroadPhase::forContainer(const LocatedEntity & container,
+                                      double time)
+{
+    return findGrid(m_grids, container, time, &newBroadPhase);
+}
+
+BroadPhase * BroadPhase::findGrid(BroadPhaseDict & grids,
+                                  const LocatedEntity & container,
+                                  double time,
+                                  BroadPhase * (*create)())
+{
+    BroadPhase * grid = 0;
+    BroadPhaseDict::iterator I = grids.find(&container);
+    if (I != grids.end()) {
+        grid = I->second;
+        unsigned long stamp = container.m_contains != 0 ?
+                              container.m_contains->stamp() : 0;
+        if (time >= grid->m_built &&
+            time - grid->m_built <= consts::move_tick &&
+            stamp == grid->m_stamp) {
+            grid->m_used = time;
+            return grid;
+        }
+    }
+
+    // Grids are only built once per move tick, so this is a good time
+    // to discard those belonging to containers which are no longer active.
+    BroadPhaseDict::iterator J = grids.begin();
+    while (J != grids.end()) {
+        if (J->second != grid && time - J->second->m_used > idle_limit) {
+            delete J->second;
+            grids.erase(J++);
+        } else {
+            ++J;
+        }
+    }
+
+    if (grid == 0) {
+        grid = create();
+        grids.insert(std::make_pair(&container, grid));
+    }
+    grid->build(container, time);
+    grid->m_used = time;
+    return grid;
+}
+
+void BroadPhase::flush()
+{
+    BroadPhaseDict::const_iterator I = m_grids.begin();
+    BroadPhaseDict::const_iterator Iend = m_grids.end();
+    for (; I != Iend; ++I) {
+        delete I->second;
+    }
+    m_grids.clear();
+}
+
+int BroadPhase::sweptBox(const Location & loc, float interval, BBox & box)
+{
+    if (!loc.bBox().isValid() || !loc.pos().isValid()) {
+        return -1;
+    }
+    const Point3D & pos = loc.pos();
+    Point3D low, high;
+    if (loc.orientation().isValid()) {
+        // The box may be rotated to any extent within its bounding sphere
+        float radius = boxBoundingRadius(loc.bBox());
+        low = Point3D(pos.x() - radius, pos.y() - radius, pos.z() - radius);
+        high = Point3D(pos.x() + radius, pos.y() + radius, pos.z() + radius);
+    } else {
+        low = Point3D(pos.x() + loc.bBox().lowCorner().x(),
+                      pos.y() + loc.bBox().lowCorner().y(),
+                      pos.z() + loc.bBox().lowCorner().z());
+        high = Point3D(pos.x() + loc.bBox().highCorner().x(),
+                       pos.y() + loc.bBox().highCorner().y(),
+                       pos.z() + loc.bBox().highCorner().z());
+    }
+    if (loc.velocity().isValid()) {
+        for (int i = 0; i < 3; ++i) {
+            float d = loc.velocity()[i] * interval;
+            if (d < 0) {
+                low[i] += d;
+            } else {
+                high[i] += d;
+            }
+        }
+    }
+    box = BBox(low, high);
+    return 0;
+}
+
+int BroadPhase::entryBox(const Location & loc, BBox & box) const
+{
+    return sweptBox(loc, sweep_interval, box);
+}
+
+void BroadPhase::link(std::size_t index)
+{
+    Entry & entry = m_entries[index];
+    entry.m_large = false;
+    entry.m_minX = entry.m_minY = 1;
+    entry.m_maxX = entry.m_maxY = 0;
+    if (!entry.m_box.isValid()) {
+        return;
+    }
+    if (!cellRange(entry.m_box, entry.m_minX, entry.m_minY,
+                                entry.m_maxX, entry.m_maxY)) {
+        entry.m_large = true;
+        m_large.push_back(index);
+        return;
+    }
+    for (int x = entry.m_minX; x <= entry.m_maxX; ++x) {
+        for (int y = entry.m_minY; y <= entry.m_maxY; ++y) {
+            m_cells[cellKey(x, y)].push_back(index);
+        }
+    }
+}
+
+void BroadPhase::unlink(std::size_t index)
+{
+    Entry & entry = m_entries[index];
+    if (entry.m_large) {
+        m_large.erase(std::find(m_large.begin(), m_large.end(), index));
+        return;
+    }
+    for (int x = entry.m_minX; x <= entry.m_maxX; ++x) {
+        for (int y = entry.m_minY; y <= entry.m_maxY; ++y) {
+            CellDict::iterator I = m_cells.find(cellKey(x, y));
+            if (I == m_cells.end()) {
+                continue;
+            }
+            Cell & cell = I->second;
+            Cell::iterator J = std::find(cell.begin(), cell.end(), index);
+            if (J != cell.end()) {
+                cell.erase(J);
+            }
+            if (cell.empty()) {
+                m_cells.erase(I);
+            }
+        }
+    }
+}
+
+void BroadPhase::insert(LocatedEntity * entity)
+{
+    std::size_t index = m_entries.size();
+    m_entries.push_back(Entry());
+    Entry & entry = m_entries.back();
+    entry.m_entity = entity;
+    entry.m_query = 0;
+    entryBox(entity->m_location, entry.m_box);
+    m_index.insert(std::make_pair(entity, index));
+    link(index);
+}
+
+void BroadPhase::build(const LocatedEntity & container, double time)
+{
+    m_entries.clear();
+    m_index.clear();
+    m_cells.clear();
+    m_large.clear();
+    m_built = time;
+    m_stamp = 0;
+    if (container.m_contains == 0) {
+        return;
+    }
+    m_stamp = container.m_contains->stamp();
+    m_entries.reserve(container.m_contains->size());
+    LocatedEntitySet::const_iterator I = container.m_contains->begin();
+    LocatedEntitySet::const_iterator Iend = container.m_contains->end();
+    for (; I != Iend; ++I) {
+        insert(*I);
+    }
+}
+
+void BroadPhase::update(LocatedEntity * entity)
+{
+    EntryIndex::const_iterator I = m_index.find(entity);
+    if (I == m_index.end()) {
+        insert(entity);
+        return;
+    }
+    unlink(I->second);
+    Entry & entry = m_entries[I->second];
+    if (entryBox(entity->m_location, entry.m_box) != 0) {
+        entry.m_box = BBox();
+    }
+    link(I->second);
+}
+
+void BroadPhase::query(const BBox & box, CandidateList & res)
+{
+    ++m_query;
+
+    Cell found(m_large);
+    int minX, minY, maxX, maxY;
+    if (cellRange(box, minX, minY, maxX, maxY)) {
+        for (int x = minX; x <= maxX; ++x) {
+            for (int y = minY; y <= maxY; ++y) {
+                CellDict::const_iterator I = m_cells.find(cellKey(x, y));
+                if (I != m_cells.end()) {
+                    found.insert(found.end(), I->second.begin(),
+                                              I->second.end());
+                }
+            }
+        }
+    } else {
+        // The query covers too much of the grid, so just check everything
+        found.clear();
+        for (std::size_t i = 0; i < m_entries.size(); ++i) {
+            found.push_back(i);
+        }
+    }
+
+    // Entries were added in the order of the container contents
+    std::sort(found.begin(), found.end());
+    Cell::const_iterator I = found.begin();
+    Cell::const_iterator Iend = found.end();
+    for (; I != Iend; ++I) {
+        Entry & entry = m_entries[*I];
+        if (entry.m_query == m_query) {
+            continue;
+        }
+        entry.m_query = m_query;
+        if (!entry.m_box.isValid() || !overlaps(entry.m_box, box)) {
+            continue;
+        }
+        res.push_back(entry.m_entity);
+    }
+}
@@ -0,0 +1,136 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef RULESETS_BROAD_PHASE_H
+#define RULESETS_BROAD_PHASE_H
+
+#include "physics/BBox.h"
+
+#include <wfmath/axisbox.h>
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+class LocatedEntity;
+class Location;
+
+/// \brief Uniform grid of swept bounding boxes used to find collision
+/// candidates in a container
+///
+/// Each entity in the container with a bounding box is entered in the grid
+/// cells covered by its box swept along its velocity. Motion queries the
+/// grid with its own swept box, so only nearby entities reach the exact
+/// predictCollision test. Boxes are swept far enough that a grid remains
+/// valid for one move tick after it is built, and moving entities refresh
+/// their own entry each time they check for collisions.
+class BroadPhase {
+  public:
+    typedef std::vector<LocatedEntity *> CandidateList;
+  protected:
+    /// \brief Grid entry for one entity in the container
+    struct Entry {
+        LocatedEntity * m_entity;
+        BBox m_box;
+        int m_minX, m_minY, m_maxX, m_maxY;
+        /// Entry is too large for the grid and is checked by every query
+        bool m_large;
+        /// Serial number of the last query which reported this entry
+        unsigned long m_query;
+    };
+
+    typedef std::vector<std::size_t> Cell;
+    typedef std::unordered_map<long, Cell> CellDict;
+    typedef std::map<const LocatedEntity *, std::size_t> EntryIndex;
+    typedef std::map<const LocatedEntity *, BroadPhase *> BroadPhaseDict;
+
+    static BroadPhaseDict m_grids;
+
+    std::vector<Entry> m_entries;
+    EntryIndex m_index;
+    CellDict m_cells;
+    Cell m_large;
+
+    /// Time the grid was last built
+    double m_built;
+    /// Time the grid was last used
+    double m_used;
+    /// Stamp of the contents of the container when the grid was built
+    unsigned long m_stamp;
+    /// Serial number of the current query
+    unsigned long m_query;
+
+    void link(std::size_t index);
+    void unlink(std::size_t index);
+    void insert(LocatedEntity * entity);
+
+    /// \brief Calculate the box an entity covers in the grid
+    ///
+    /// @return 0 if the box was calculated, -1 if the entity is not
+    /// entered in the grid
+    virtual int entryBox(const Location & loc, BBox & box) const;
+
+    /// \brief Get an up to date grid from a set of grids
+    ///
+    /// @param grids the grids to search, and add any new grid to
+    /// @param create function to create a new grid of the right type
+    static BroadPhase * findGrid(BroadPhaseDict & grids,
+                                 const LocatedEntity & container,
+                                 double time,
+                                 BroadPhase * (*create)());
+  public:
+    BroadPhase();
+    virtual ~BroadPhase();
+
+    /// \brief Get an up to date grid for the contents of a container
+    ///
+    /// The grid is rebuilt if any entity has joined or left the container
+    /// since it was built, or if it was built more than a move tick before
+    /// the time given.
+    /// @param container entity with the contents to be checked
+    /// @param time current time in the world
+    static BroadPhase * forContainer(const LocatedEntity & container,
+                                     double time);
+
+    /// \brief Delete all grids
+    static void flush();
+
+    /// \brief Calculate the box covered by a location moving for a period
+    ///
+    /// @return 0 if the box was calculated, -1 if the location has no
+    /// bounding box
+    static int sweptBox(const Location & loc, float interval, BBox & box);
+
+    std::size_t size() const {
+        return m_index.size();
+    }
+
+    void build(const LocatedEntity & container, double time);
+
+    /// \brief Refresh the entry for an entity which has changed its
+    /// location or velocity
+    void update(LocatedEntity * entity);
+
+    /// \brief Find the entities whose swept boxes overlap a box
+    ///
+    /// Candidates are returned in the order the container held them when
+    /// the grid was built, followed by any added since.
+    void query(const BBox & box, CandidateList & res);
+};
+
+#endif // RULESETS_BROAD_PHASE_H
@@ -22,17 +22,78 @@
 
 #include "BulletDomain.h"
 
+#include "rulesets/BroadPhase.h"
+#include "rulesets/LocatedEntity.h"
+#include "rulesets/TerrainProperty.h"
+
+#include "common/const.h"
 #include "common/debug.h"
 
 #ifdef HAVE_BULLET
 #include "btBulletCollisionCommon.h"
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
 #endif // HAVE_BULLET
 
+#include <Mercator/Terrain.h>
+#include <Mercator/Segment.h>
+
+#include <algorithm>
+#include <iostream>
+
 #include <cassert>
 
 static const bool debug_flag = false;
 
-BulletDomain::BulletDomain() :
+#ifdef HAVE_BULLET
+
+/// Period over which entity bounding boxes are swept, which covers the
+/// move tick after a synchronisation, and the move tick checked by a
+/// query at the end of it.
+static const float sweep_interval = 2.f * consts::move_tick;
+
+/// Collision filter group for entities. Entities have an empty mask so
+/// Bullet never maintains pairs of overlapping entities, which would be
+/// wasted work as collision prediction queries the broadphase directly.
+static const short entity_filter = btBroadphaseProxy::DefaultFilter;
+/// Collision filter group for terrain segments
+static const short terrain_filter = btBroadphaseProxy::StaticFilter;
+
+static inline btVector3 toBullet(const Point3D & p)
+{
+    return btVector3(p.x(), p.y(), p.z());
+}
+
+/// \brief Broadphase callback which collects the entities whose
+/// collision objects overlap a box
+class CandidateCallback : public btBroadphaseAabbCallback {
+  protected:
+    std::vector<const BulletDomain::EntityObject *> & m_res;
+  public:
+    explicit CandidateCallback(std::vector<const BulletDomain::EntityObject *> & res) :
+             m_res(res) { }
+
+    virtual bool process(const btBroadphaseProxy * proxy)
+    {
+        if (proxy->m_collisionFilterGroup != entity_filter) {
+            return true;
+        }
+        btCollisionObject * object = static_cast<btCollisionObject *>(proxy->m_clientObject);
+        m_res.push_back(static_cast<const BulletDomain::EntityObject *>(object->getUserPointer()));
+        return true;
+    }
+
+    /// \brief Order entity objects by the position of their entities in
+    /// the contents of the world
+    static bool containerOrder(const BulletDomain::EntityObject * a,
+                               const BulletDomain::EntityObject * b)
+    {
+        return a->m_order < b->m_order;
+    }
+};
+
+#endif // HAVE_BULLET
+
+BulletDomain::BulletDomain(LocatedEntity & world) : m_world(world),
 #ifdef HAVE_BULLET
     // collision configuration contains default setup for memory,
     // collision setup. Advanced users can create their own configuration.
@@ -40,10 +101,10 @@ BulletDomain::BulletDomain() :
     // use the default collision dispatcher. For parallel processing you can
     // use a diffent dispatcher (see Extras/BulletMultiThreaded)
     m_dispatcher(new btCollisionDispatcher(m_collisionConfiguration)),
-    // btDbvtBroadphase is a good general purpose broadphase.
-    // You can also try out btAxis3Sweep.
-    m_overlappingPairCache(new btAxisSweep3(btVector3(-1000,-1000,-1000),
-                                            btVector3(1000,1000,1000))),
+    // btDbvtBroadphase is a good general purpose broadphase, and unlike
+    // btAxisSweep3 it answers box queries without checking every object,
+    // and does not limit the size of the world.
+    m_overlappingPairCache(new btDbvtBroadphase()),
     // the default constraint solver. For parallel processing you can use a
     // different solver (see Extras/BulletMultiThreaded)
     // No need for constraint solver without dynamics
@@ -51,13 +112,15 @@ BulletDomain::BulletDomain() :
     //       new btSequentialImpulseConstraintSolver;
     m_collisionWorld(new btCollisionWorld(m_dispatcher,
                                           m_overlappingPairCache,
-                                          m_collisionConfiguration))
+                                          m_collisionConfiguration)),
 #else // HAVE_BULLET
     m_collisionConfiguration(0),
     m_dispatcher(0),
     m_overlappingPairCache(0),
-    m_collisionWorld(0)
+    m_collisionWorld(0),
 #endif // HAVE_BULLET
+    m_synced(-1.), m_sync(0), m_stamp(0),
+    m_terrainLow(0.f), m_terrainHigh(0.f)
 {
     // No gravity in collision world
     // collisionWorld->setGravity(btVector3(0,-10,0));
@@ -65,16 +128,279 @@ BulletDomain::BulletDomain() :
 
 BulletDomain::~BulletDomain()
 {
+#ifdef HAVE_BULLET
+    EntityObjectDict::const_iterator I = m_entities.begin();
+    EntityObjectDict::const_iterator Iend = m_entities.end();
+    for (; I != Iend; ++I) {
+        removeObject(I->second.m_object, I->second.m_shape);
+    }
+    TerrainObjectDict::const_iterator J = m_terrain.begin();
+    TerrainObjectDict::const_iterator Jend = m_terrain.end();
+    for (; J != Jend; ++J) {
+        removeObject(J->second.m_object, J->second.m_shape);
+    }
+    delete m_collisionWorld;
+    delete m_overlappingPairCache;
+    delete m_dispatcher;
+    delete m_collisionConfiguration;
+#endif // HAVE_BULLET
+}
+
+void BulletDomain::removeObject(btCollisionObject * object,
+                                btCollisionShape * shape)
+{
+#ifdef HAVE_BULLET
+    if (object != 0) {
+        m_collisionWorld->removeCollisionObject(object);
+        delete object;
+    }
+    delete shape;
+#endif // HAVE_BULLET
+}
+
+void BulletDomain::updateEntity(LocatedEntity & entity, EntityObject & eo)
+{
+#ifdef HAVE_BULLET
+    const Location & loc = entity.m_location;
+    if (eo.m_object != 0 && eo.m_timeStamp == loc.timeStamp() &&
+        eo.m_pos == loc.pos() && eo.m_bBox == loc.bBox()) {
+        return;
+    }
+    const BBox & bbox = loc.bBox();
+    btTransform transform;
+    transform.setIdentity();
+    transform.setOrigin(toBullet(loc.pos()) +
+                        (toBullet(bbox.lowCorner()) +
+                         toBullet(bbox.highCorner())) / 2);
+    if (eo.m_object == 0 || !(eo.m_bBox == bbox)) {
+        removeObject(eo.m_object, eo.m_shape);
+        eo.m_shape = new btBoxShape((toBullet(bbox.highCorner()) -
+                                     toBullet(bbox.lowCorner())) / 2);
+        eo.m_object = new btCollisionObject;
+        eo.m_object->setUserPointer(&eo);
+        eo.m_object->setCollisionShape(eo.m_shape);
+        eo.m_object->setWorldTransform(transform);
+        m_collisionWorld->addCollisionObject(eo.m_object, entity_filter, 0);
+        eo.m_bBox = bbox;
+    } else {
+        eo.m_object->setWorldTransform(transform);
+    }
+    eo.m_pos = loc.pos();
+    eo.m_timeStamp = loc.timeStamp();
+
+    // The broadphase holds the box swept along the velocity, rather than
+    // the bounds of the shape, so it finds everything that could be hit
+    // before the next synchronisation.
+    BBox swept;
+    BroadPhase::sweptBox(loc, sweep_interval, swept);
+    m_overlappingPairCache->setAabb(eo.m_object->getBroadphaseHandle(),
+                                    toBullet(swept.lowCorner()),
+                                    toBullet(swept.highCorner()),
+                                    m_dispatcher);
+#endif // HAVE_BULLET
+}
+
+void BulletDomain::syncEntities()
+{
+#ifdef HAVE_BULLET
+    ++m_sync;
+    m_stamp = 0;
+    if (m_world.m_contains != 0) {
+        m_stamp = m_world.m_contains->stamp();
+        std::size_t order = 0;
+        LocatedEntitySet::const_iterator I = m_world.m_contains->begin();
+        LocatedEntitySet::const_iterator Iend = m_world.m_contains->end();
+        for (; I != Iend; ++I, ++order) {
+            const Location & loc = (*I)->m_location;
+            if (!loc.bBox().isValid() || !loc.isSolid() ||
+                !loc.pos().isValid()) {
+                continue;
+            }
+            EntityObject & eo = m_entities[*I];
+            // An entity allocated where a destroyed one was must not
+            // inherit its object.
+            if (eo.m_id != (*I)->getIntId()) {
+                removeObject(eo.m_object, eo.m_shape);
+                eo.m_object = 0;
+                eo.m_shape = 0;
+                eo.m_entity = *I;
+                eo.m_id = (*I)->getIntId();
+            }
+            eo.m_order = order;
+            eo.m_sync = m_sync;
+            updateEntity(**I, eo);
+        }
+    }
+
+    // Remove the objects of entities which have left the world, or
+    // are no longer solid.
+    EntityObjectDict::iterator J = m_entities.begin();
+    while (J != m_entities.end()) {
+        if (J->second.m_sync != m_sync) {
+            removeObject(J->second.m_object, J->second.m_shape);
+            m_entities.erase(J++);
+        } else {
+            ++J;
+        }
+    }
+#endif // HAVE_BULLET
+}
+
+void BulletDomain::syncTerrain()
+{
+#ifdef HAVE_BULLET
+    const TerrainProperty * tp = m_world.getPropertyClass<TerrainProperty>("terrain");
+    if (tp != 0) {
+        const Mercator::Terrain::Segmentstore & segments = tp->getData().getTerrain();
+        Mercator::Terrain::Segmentstore::const_iterator I = segments.begin();
+        Mercator::Terrain::Segmentstore::const_iterator Iend = segments.end();
+        for (; I != Iend; ++I) {
+            Mercator::Terrain::Segmentcolumn::const_iterator J = I->second.begin();
+            Mercator::Terrain::Segmentcolumn::const_iterator Jend = I->second.end();
+            for (; J != Jend; ++J) {
+                Mercator::Segment * segment = J->second;
+                if (!segment->isValid()) {
+                    segment->populate();
+                }
+                TerrainObject & to = m_terrain[std::make_pair(I->first, J->first)];
+                to.m_sync = m_sync;
+
+                // Heights are copied, as Mercator frees the points of
+                // a segment when it is modified.
+                int size = segment->getSize();
+                const float * points = segment->getPoints();
+                if (to.m_object != 0 &&
+                    std::equal(points, points + size * size,
+                               to.m_heights.begin())) {
+                    continue;
+                }
+                debug(std::cout << "Registering terrain segment "
+                                << I->first << "," << J->first
+                                << std::endl << std::flush;);
+                removeObject(to.m_object, to.m_shape);
+                to.m_heights.assign(points, points + size * size);
+                float low = *std::min_element(to.m_heights.begin(),
+                                              to.m_heights.end());
+                float high = *std::max_element(to.m_heights.begin(),
+                                               to.m_heights.end());
+                to.m_shape = new btHeightfieldTerrainShape(size, size,
+                                                           &to.m_heights.front(),
+                                                           1.f, low, high,
+                                                           2, PHY_FLOAT,
+                                                           false);
+                // Heightfields are centred on the origin of their object
+                float half = (size - 1) / 2.f;
+                btTransform transform;
+                transform.setIdentity();
+                transform.setOrigin(btVector3(segment->getXRef() + half,
+                                              segment->getYRef() + half,
+                                              (low + high) / 2));
+                to.m_object = new btCollisionObject;
+                to.m_object->setCollisionShape(to.m_shape);
+                to.m_object->setWorldTransform(transform);
+                m_collisionWorld->addCollisionObject(to.m_object,
+                                                     terrain_filter,
+                                                     entity_filter);
+            }
+        }
+    }
+
+    bool first = true;
+    TerrainObjectDict::iterator K = m_terrain.begin();
+    while (K != m_terrain.end()) {
+        if (K->second.m_sync != m_sync) {
+            removeObject(K->second.m_object, K->second.m_shape);
+            m_terrain.erase(K++);
+            continue;
+        }
+        const std::vector<float> & heights = K->second.m_heights;
+        float low = *std::min_element(heights.begin(), heights.end());
+        float high = *std::max_element(heights.begin(), heights.end());
+        if (first || low < m_terrainLow) {
+            m_terrainLow = low;
+        }
+        if (first || high > m_terrainHigh) {
+            m_terrainHigh = high;
+        }
+        first = false;
+        ++K;
+    }
+#endif // HAVE_BULLET
+}
+
+void BulletDomain::sync(double t)
+{
+    syncEntities();
+    syncTerrain();
+    m_synced = t;
 }
 
 float BulletDomain::constrainHeight(LocatedEntity * parent,
                               const Point3D & pos,
                               const std::string & mode)
 {
+#ifdef HAVE_BULLET
+    if (parent == &m_world && !m_terrain.empty() &&
+        mode != "fixed" && mode != "floating") {
+        btVector3 from(pos.x(), pos.y(), m_terrainHigh + 1.f);
+        btVector3 to(pos.x(), pos.y(), m_terrainLow - 1.f);
+        btCollisionWorld::ClosestRayResultCallback callback(from, to);
+        callback.m_collisionFilterGroup = entity_filter;
+        callback.m_collisionFilterMask = terrain_filter;
+        m_collisionWorld->rayTest(from, to, callback);
+        if (callback.hasHit()) {
+            return callback.m_hitPointWorld.z();
+        }
+    }
+#endif // HAVE_BULLET
     return Domain::constrainHeight(parent, pos, mode);
 }
 
+bool BulletDomain::collisionCandidates(LocatedEntity & entity,
+                                       const BBox & box,
+                                       std::vector<LocatedEntity *> & res)
+{
+#ifdef HAVE_BULLET
+    if (entity.m_location.m_loc != &m_world || !box.isValid()) {
+        return false;
+    }
+    // Entities which have joined or left the world since the last
+    // synchronisation must be accounted for. The terrain is left to tick().
+    unsigned long stamp = m_world.m_contains != 0 ?
+                          m_world.m_contains->stamp() : 0;
+    if (stamp != m_stamp) {
+        syncEntities();
+    }
+    // Refresh the object of the moving entity, so others see its new course
+    EntityObjectDict::iterator I = m_entities.find(&entity);
+    if (I != m_entities.end()) {
+        updateEntity(entity, I->second);
+    }
+    std::vector<const EntityObject *> found;
+    CandidateCallback callback(found);
+    m_overlappingPairCache->aabbTest(toBullet(box.lowCorner()),
+                                     toBullet(box.highCorner()),
+                                     callback);
+    // Candidates are returned in the order of the contents of the world,
+    // as by the other domains, so ties between collisions are broken the
+    // same way.
+    std::sort(found.begin(), found.end(),
+              CandidateCallback::containerOrder);
+    std::vector<const EntityObject *>::const_iterator J = found.begin();
+    std::vector<const EntityObject *>::const_iterator Jend = found.end();
+    for (; J != Jend; ++J) {
+        res.push_back((*J)->m_entity);
+    }
+    return true;
+#else // HAVE_BULLET
+    return false;
+#endif // HAVE_BULLET
+}
+
 void BulletDomain::tick(double t)
 {
-    
+    if (m_synced >= 0 && t >= m_synced && t - m_synced < consts::move_tick) {
+        return;
+    }
+    sync(t);
 }
@@ -21,30 +21,118 @@
 
 #include "rulesets/Domain.h"
 
+#include <map>
+
 class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
 class btBroadphaseInterface;
 class btCollisionWorld;
+class btCollisionObject;
+class btCollisionShape;
 
 /// \brief Movement domain using the bullet physics library
 ///
 /// The movement domain implements movement in the game world, including
 /// visibility calculations, collision detection and physics.
 /// Motion objects interact with the movement domain.
+///
+/// Solid entities at the top level of the world are mirrored as collision
+/// objects, with the bounding box swept along their velocity, and each
+/// terrain segment is registered as a heightfield. Bullet's broadphase
+/// then provides collision candidates, in the order of the contents of
+/// the world, and ray tests against the heightfields clamp entities to
+/// the ground.
 class BulletDomain : public Domain {
   protected:
+    /// \brief Collision object mirroring an entity in the world
+    struct EntityObject {
+        btCollisionObject * m_object;
+        btCollisionShape * m_shape;
+        /// Entity mirrored by the object
+        LocatedEntity * m_entity;
+        /// Integer ID of the entity, as its address may be reused
+        long m_id;
+        /// Position of the entity in the contents of the world
+        std::size_t m_order;
+        /// Bounding box used to create the shape
+        BBox m_bBox;
+        /// Position of the entity when the object was last updated
+        Point3D m_pos;
+        /// Time stamp of the entity when the object was last updated
+        double m_timeStamp;
+        /// Serial number of the last synchronisation that found the entity
+        unsigned long m_sync;
+
+        EntityObject() : m_object(0), m_shape(0), m_entity(0), m_id(-1),
+                         m_order(0), m_timeStamp(-1.), m_sync(0) { }
+    };
+
+    /// \brief Collision object for one segment of the terrain
+    struct TerrainObject {
+        btCollisionObject * m_object;
+        btCollisionShape * m_shape;
+        /// Copy of the segment heights referenced by the shape
+        std::vector<float> m_heights;
+        /// Serial number of the last synchronisation that found the segment
+        unsigned long m_sync;
+
+        TerrainObject() : m_object(0), m_shape(0), m_sync(0) { }
+    };
+
+    typedef std::map<const LocatedEntity *, EntityObject> EntityObjectDict;
+    typedef std::map<std::pair<int, int>, TerrainObject> TerrainObjectDict;
+
+    LocatedEntity & m_world;
+
     btDefaultCollisionConfiguration * m_collisionConfiguration;
     btCollisionDispatcher* m_dispatcher;
     btBroadphaseInterface* m_overlappingPairCache;
     btCollisionWorld * m_collisionWorld;
+
+    EntityObjectDict m_entities;
+    TerrainObjectDict m_terrain;
+
+    /// Time the collision world was last synchronised with the game world
+    double m_synced;
+    /// Serial number of the last synchronisation
+    unsigned long m_sync;
+    /// Stamp of the contents of the world at the last synchronisation of
+    /// the entities
+    unsigned long m_stamp;
+    /// Lowest point on the terrain
+    float m_terrainLow;
+    /// Highest point on the terrain
+    float m_terrainHigh;
+
+    void removeObject(btCollisionObject * object, btCollisionShape * shape);
+    void updateEntity(LocatedEntity & entity, EntityObject & eo);
+    void syncEntities();
+    void syncTerrain();
   public:
-    BulletDomain();
+    explicit BulletDomain(LocatedEntity & world);
+
+    friend class CandidateCallback;
 
     virtual ~BulletDomain();
 
+    std::size_t entityCount() const {
+        return m_entities.size();
+    }
+
+    std::size_t terrainCount() const {
+        return m_terrain.size();
+    }
+
+    /// \brief Bring the collision world up to date with the game world
+    void sync(double t);
+
     virtual float constrainHeight(LocatedEntity *, const Point3D &,
                                   const std::string &);
 
+    virtual bool collisionCandidates(LocatedEntity & entity,
+                                     const BBox & box,
+                                     std::vector<LocatedEntity *> & res);
+
     virtual void tick(double t);
 };
 
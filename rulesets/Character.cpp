@@ -23,7 +23,11 @@
 #include "EntityProperty.h"
 #include "ExternalMind.h"
 #include "ExternalProperty.h"
+#include "MetabolismSystem.h"
+#include "MovementSystem.h"
+#include "MindLodScheduler.h"
 #include "OutfitProperty.h"
+#include "PropertySlots.h"
 #include "StatusProperty.h"
 #include "TasksProperty.h"
 
@@ -56,6 +60,9 @@
 #include <sigc++/functors/mem_fun.h>
 #include <sigc++/adaptors/hide.h>
 
+#include <algorithm>
+
+#include <cmath>
 #include <cassert>
 
 using Atlas::Message::Element;
@@ -120,14 +127,15 @@ static const std::string TASKS = "tasks";
 /// is slower, as weight is used to compensate.
 /// A fully healthy Character should take about a week to starve to death.
 /// So 10080 / 90 = 6720 ticks.
-/// @param res Any result of changes is returned here.
-/// @param ammount Time scale factor, currently not used.
-void Character::metabolise(OpVector & res, double ammount)
+/// Changed properties are flagged as unsent, but no Update is sent.
+/// @param ammount Number of cycles to apply in one step. Food is digested
+/// and energy burned for each cycle.
+void Character::applyMetabolism(double ammount)
 {
     // Currently handles energy
     // We should probably call this whenever the entity performs a movement.
 
-    StatusProperty * status_prop = modPropertyClass<StatusProperty>(STATUS);
+    StatusProperty * status_prop = modPropertySlot<StatusSlot>();
     if (status_prop == 0) {
         // FIXME Probably don't do enough here to set up the property.
         status_prop = new StatusProperty;
@@ -138,21 +146,28 @@ void Character::metabolise(OpVector & res, double ammount)
     double & status = status_prop->data();
     status_prop->setFlags(flag_unsent);
 
-    Property<double> * food_prop = modPropertyType<double>(FOOD);
+    Property<double> * food_prop = modPropertySlot<FoodSlot>();
     // DIGEST
     if (food_prop != 0) {
         double & food = food_prop->data();
         if (food >= foodConsumption && status < 2) {
+            // Food is digested in whole portions, until it runs out or
+            // status reaches its limit.
+            double digested = std::min(foodConsumption * ammount,
+                                       std::floor(food / foodConsumption) *
+                                       foodConsumption);
+            digested = std::min(digested,
+                                std::max(2 - status, foodConsumption));
             // It is important that the metabolise bit is done next, as this
             // handles the status change
-            status += foodConsumption;
-            food -= foodConsumption;
+            status += digested;
+            food -= digested;
 
             food_prop->setFlags(flag_unsent);
         }
     }
 
-    Property<double> * mass_prop = modPropertyType<double>(MASS);
+    Property<double> * mass_prop = modPropertySlot<MassSlot>();
     // If status is very high, we gain weight
     if (status > (1.5 + energyLaidDown)) {
         status -= energyLaidDown;
@@ -183,10 +198,10 @@ void Character::metabolise(OpVector & res, double ammount)
         }
     }
     // FIXME Stamina property?
-    const TasksProperty * tp = getPropertyClass<TasksProperty>(TASKS);
+    const TasksProperty * tp = getPropertySlot<TasksSlot>();
     if ((tp == 0 || !tp->busy()) && !m_movement.updateNeeded(m_location)) {
 
-        Property<double> * stamina_prop = modPropertyType<double>(STAMINA);
+        Property<double> * stamina_prop = modPropertySlot<StaminaSlot>();
         if (stamina_prop != 0) {
             double & stamina = stamina_prop->data();
             if (stamina < 1.f) {
@@ -195,11 +210,6 @@ void Character::metabolise(OpVector & res, double ammount)
             }
         }
     }
-
-    Update update;
-    update->setTo(getId());
-
-    res.push_back(update);
 }
 
 /// \brief Hooked to the Entity::containered signal of the wielded entity
@@ -269,6 +279,8 @@ Character::Character(const std::string & id, long intId) :
 
 Character::~Character()
 {
+    MindLodScheduler::instance()->removePlayer(this);
+    MindLodScheduler::instance()->removeMind(this);
     if (m_rightHandWieldConnection.connected()) {
         m_rightHandWieldConnection.disconnect();
     }
@@ -285,6 +297,7 @@ int Character::linkExternal(Link * link)
         return -1;
     }
     m_externalMind->linkUp(link);
+    MindLodScheduler::instance()->addPlayer(this);
 
     if (getProperty("external") == 0) {
         ExternalProperty * ep = new ExternalProperty(m_externalMind);
@@ -340,6 +353,7 @@ int Character::unlinkExternal(Link * link)
     // leave it in place, as it takes care of the disconnected
     // character.
     m_externalMind->linkUp(0);
+    MindLodScheduler::instance()->removePlayer(this);
     return 0;
 }
 
@@ -418,19 +432,10 @@ void Character::TickOperation(const Operation & op, OpVector & res)
             } else {
                 log(ERROR, "Character::TickOperation: No serialno in tick arg");
             }
-            Location return_location;
-            if (m_movement.getUpdatedLocation(return_location)) {
-                return;
-            }
-            res.push_back(m_movement.generateMove(return_location));
-            Anonymous tick_arg;
-            tick_arg->setName("move");
-            tick_arg->setAttr(SERIALNO, m_movement.serialno());
-            Tick tickOp;
-            tickOp->setTo(getId());
-            tickOp->setFutureSeconds(m_movement.getTickAddition(return_location.pos(), return_location.velocity()));
-            tickOp->setArgs1(tick_arg);
-            res.push_back(tickOp);
+            // Movement is integrated in batches, rather than by a Tick
+            // rescheduled here for each step. This Tick follows the Move
+            // which changed our movement, so the system reads the result.
+            MovementSystem::instance()->addEntity(this);
         } else if (arg->getName() == "task") {
             TasksProperty * tp = modPropertyClass<TasksProperty>(TASKS);
 
@@ -449,13 +454,9 @@ void Character::TickOperation(const Operation & op, OpVector & res)
         }
     } else {
         // METABOLISE
-        metabolise(res);
-        
-        // TICK
-        Tick tickOp;
-        tickOp->setTo(getId());
-        tickOp->setFutureSeconds(consts::basic_tick * 30);
-        res.push_back(tickOp);
+        // Metabolism is run in batches, rather than by a Tick rescheduled
+        // here for each character.
+        MetabolismSystem::instance()->addEntity(this);
     }
 }
 
@@ -1184,6 +1185,7 @@ void Character::mindTickOperation(const Operation & op, OpVector & res)
     tick_arg->setName("mind");
     op->setArgs1(tick_arg);
     op->setTo(getId());
+    MindLodScheduler::instance()->scheduleTick(*this, op);
     res.push_back(op);
 }
 
@@ -1375,14 +1377,14 @@ void Character::mindMoveOperation(const Operation & op, OpVector & res)
         ret_location.velocity().isValid() &&
         ret_location.velocity() != Vector3D(0,0,0)) {
 
+        // The Tick is handled after the Move, so the MovementSystem
+        // does not pick up the movement until the Move has been applied.
         Tick tickOp;
         Anonymous tick_arg;
         tick_arg->setAttr(SERIALNO, m_movement.serialno());
         tick_arg->setName("move");
         tickOp->setArgs1(tick_arg);
         tickOp->setTo(getId());
-        tickOp->setFutureSeconds(m_movement.getTickAddition(ret_location.pos(),
-                                                     ret_location.velocity()));
 
         res.push_back(tickOp);
     }
@@ -1665,7 +1667,7 @@ bool Character::w2mTickOperation(const Operation & op)
 {
     if (!op->getArgs().empty()) {
         if (op->getArgs().front()->getName() == "mind") {
-            return true;
+            return MindLodScheduler::instance()->checkTick(*this, op);
         }
     }
     return false;
@@ -1686,7 +1688,10 @@ bool Character::w2mUnseenOperation(const Operation & op)
 /// @return true if the operation should be passed.
 bool Character::w2mSightOperation(const Operation & op)
 {
-    return true;
+    if (m_externalMind != 0 && m_externalMind->isLinked()) {
+        return true;
+    }
+    return MindLodScheduler::instance()->checkPerception(*this, op);
 }
 
 /// \brief Filter a Sound operation coming from the world to the mind
@@ -1918,6 +1923,10 @@ void Character::operation(const Operation & op, OpVector & res)
 {
     debug( std::cout << "Character::operation(" << op->getParents().front() << ")" << std::endl << std::flush;);
     Entity::operation(op, res);
+    if (op->getClassNo() == Atlas::Objects::Operation::MOVE_NO &&
+        m_externalMind != 0 && m_externalMind->isLinked()) {
+        MindLodScheduler::instance()->playerMoved(*this);
+    }
     if (world2mind(op)) {
         debug( std::cout << "Character::operation(" << op->getParents().front() << ") passed to mind" << std::endl << std::flush;);
         OpVector mres;
@@ -98,12 +98,14 @@ class Character : public Thing, public virtual sigc::trackable {
     sigc::connection m_rightHandWieldConnection;
 
     void filterExternalOperation(const Operation &);
-    void metabolise(OpVector &, double ammount = 1); 
+    void applyMetabolism(double ammount = 1);
     void wieldDropped();
     LocatedEntity * findInContains(LocatedEntity * ent, const std::string & id);
     LocatedEntity * findInInventory(const std::string & id);
 
     friend class Movement;
+    friend class MetabolismSystem;
+    friend class MovementSystem;
   public:
     /// \brief Internal AI mind controlling this character
     BaseMind * m_mind;
@@ -82,6 +82,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return pos.z();
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
     
@@ -19,9 +19,11 @@
 #ifndef RULESETS_DOMAIN_H
 #define RULESETS_DOMAIN_H
 
+#include "physics/BBox.h"
 #include "physics/Vector3D.h"
 
 #include <string>
+#include <vector>
 
 class LocatedEntity;
 
@@ -60,6 +62,17 @@ class Domain {
     virtual float constrainHeight(LocatedEntity *, const Point3D &,
                                   const std::string &);
 
+    /// \brief Find the entities which may collide with a moving entity
+    ///
+    /// @param entity the moving entity
+    /// @param box the box swept by the entity before its next update
+    /// @param res list to which the candidate entities are added
+    /// @return true if the domain has found the candidates, or false if
+    /// the caller should check the contents of the container itself.
+    virtual bool collisionCandidates(LocatedEntity & entity,
+                                     const BBox & box,
+                                     std::vector<LocatedEntity *> & res);
+
     virtual void tick(double t);
 };
 
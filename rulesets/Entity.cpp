@@ -114,12 +114,13 @@ PropertyBase * Entity::setAttr(const std::string & name, const Element & attr)
 
 const PropertyBase * Entity::getProperty(const std::string & name) const
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    PropertyKey key = PropertyKey::lookup(name);
+    PropertyDict::const_iterator I = m_properties.find(key, name);
     if (I != m_properties.end()) {
         return I->second;
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(key);
         if (I != m_type->defaults().end()) {
             return I->second;
         }
@@ -129,18 +130,19 @@ const PropertyBase * Entity::getProperty(const std::string & name) const
 
 PropertyBase * Entity::modProperty(const std::string & name)
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    PropertyKey key = PropertyKey::lookup(name);
+    PropertyDict::const_iterator I = m_properties.find(key, name);
     if (I != m_properties.end()) {
         return I->second;
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(key);
         if (I != m_type->defaults().end()) {
             // We have a default for this property. Create a new instance
             // property with the same value.
             PropertyBase * new_prop = I->second->copy();
             new_prop->flags() &= ~flag_class;
-            m_properties[name] = new_prop;
+            m_properties[key] = new_prop;
             new_prop->apply(this);
             return new_prop;
         }
@@ -501,11 +503,12 @@ HandlerResult Entity::callDelegate(const std::string & name,
                                    OpVector & res)
 {
     PropertyBase * p = 0;
-    PropertyDict::const_iterator I = m_properties.find(name);
+    PropertyKey key = PropertyKey::lookup(name);
+    PropertyDict::const_iterator I = m_properties.find(key, name);
     if (I != m_properties.end()) {
         p = I->second;
     } else if (m_type != 0) {
-        I = m_type->defaults().find(name); 
+        I = m_type->defaults().find(key); 
         if (I != m_type->defaults().end()) {
             p = I->second;
         }
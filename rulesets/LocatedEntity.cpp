@@ -82,12 +82,13 @@ LocatedEntity::~LocatedEntity()
 /// false otherwise
 bool LocatedEntity::hasAttr(const std::string & name) const
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    PropertyKey key = PropertyKey::lookup(name);
+    PropertyDict::const_iterator I = m_properties.find(key, name);
     if (I != m_properties.end()) {
         return true;
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(key);
         if (I != m_type->defaults().end()) {
             return true;
         }
@@ -104,12 +105,13 @@ bool LocatedEntity::hasAttr(const std::string & name) const
 int LocatedEntity::getAttr(const std::string & name,
                            Element & attr) const
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    PropertyKey key = PropertyKey::lookup(name);
+    PropertyDict::const_iterator I = m_properties.find(key, name);
     if (I != m_properties.end()) {
         return I->second->get(attr);
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(key);
         if (I != m_type->defaults().end()) {
             return I->second->get(attr);
         }
@@ -127,12 +129,13 @@ int LocatedEntity::getAttrType(const std::string & name,
                                Element & attr,
                                int type) const
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    PropertyKey key = PropertyKey::lookup(name);
+    PropertyDict::const_iterator I = m_properties.find(key, name);
     if (I != m_properties.end()) {
         return I->second->get(attr) || (attr.getType() == type ? 0 : 1);
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(key);
         if (I != m_type->defaults().end()) {
             return I->second->get(attr) || (attr.getType() == type ? 0 : 1);
         }
@@ -19,9 +19,13 @@
 #ifndef RULESETS_LOCATED_ENTITY_H
 #define RULESETS_LOCATED_ENTITY_H
 
+#include "rulesets/LocatedEntitySet.h"
+
 #include "modules/Location.h"
 
+#include "common/MemoryPool.h"
 #include "common/Property.h"
+#include "common/PropertyDict.h"
 #include "common/Router.h"
 #include "common/log.h"
 #include "common/compose.hpp"
@@ -29,6 +33,7 @@
 #include <sigc++/signal.h>
 
 #include <set>
+#include <typeinfo>
 
 #include <cassert>
 
@@ -41,9 +46,6 @@ class TypeNode;
 template <typename T>
 class Property;
 
-typedef std::set<LocatedEntity *> LocatedEntitySet;
-typedef std::map<std::string, PropertyBase *> PropertyDict;
-
 /// \brief Flag indicating entity has been written to permanent store
 /// \ingroup EntityFlags
 static const unsigned int entity_clean = 1 << 0;
@@ -78,6 +80,12 @@ static const unsigned int entity_visible = 1 << 7;
 /// \ingroup EntityFlags
 /// Currently only used on BaseMind
 static const unsigned int entity_asleep = 1 << 8;
+/// \brief Flag indicating entity is metabolised by the MetabolismSystem
+/// \ingroup EntityFlags
+static const unsigned int entity_metabolising = 1 << 9;
+/// \brief Flag indicating entity is moved by the MovementSystem
+/// \ingroup EntityFlags
+static const unsigned int entity_moving = 1 << 10;
 
 
 /// \brief This is the base class from which in-game and in-memory objects
@@ -120,6 +128,21 @@ class LocatedEntity : public Router {
     explicit LocatedEntity(const std::string & id, long intId);
     virtual ~LocatedEntity();
 
+    /// \brief Pool from which all entities are allocated
+    static MemoryPool & pool() {
+        // Never destroyed, as entities may outlive static destruction
+        static MemoryPool * entity_pool = new MemoryPool;
+        return *entity_pool;
+    }
+
+    static void * operator new(std::size_t size) {
+        return pool().allocate(size);
+    }
+
+    static void operator delete(void * p, std::size_t size) {
+        pool().deallocate(p, size);
+    }
+
     /// \brief Increment the reference count on this entity
     void incRef() {
         ++m_refCount;
@@ -294,6 +317,67 @@ class LocatedEntity : public Router {
         return sp;
     }
 
+    /// \brief Cast a property to the class expected of it
+    ///
+    /// Properties are almost always exactly the class expected, which is
+    /// much cheaper to check than a dynamic_cast.
+    template <class PropertyT, class BaseT>
+    static PropertyT * propertyCast(BaseT * p)
+    {
+        if (p == 0) {
+            return 0;
+        }
+        if (typeid(*p) == typeid(PropertyT)) {
+            return static_cast<PropertyT *>(p);
+        }
+        return dynamic_cast<PropertyT *>(p);
+    }
+
+    /// \brief Get a built-in property from its fixed slot
+    ///
+    /// Behaves as getPropertyClass, but the instance property is found
+    /// without a search. @see PropertySlot
+    template <class SlotT>
+    const typename SlotT::type * getPropertySlot() const
+    {
+        const PropertyBase * p = m_properties.slot(SlotT::key);
+        if (p == 0) {
+            p = getProperty(PropertyKey(SlotT::key).name());
+        }
+        return propertyCast<const typename SlotT::type>(p);
+    }
+
+    /// \brief Get a modifiable built-in property from its fixed slot
+    ///
+    /// Behaves as modPropertyClass, but the instance property is found
+    /// without a search.
+    template <class SlotT>
+    typename SlotT::type * modPropertySlot()
+    {
+        PropertyBase * p = m_properties.slot(SlotT::key);
+        if (p == 0) {
+            p = modProperty(PropertyKey(SlotT::key).name());
+        }
+        return propertyCast<typename SlotT::type>(p);
+    }
+
+    /// \brief Require that a built-in property is set
+    ///
+    /// Behaves as requirePropertyClass, but the instance property is found
+    /// without a search.
+    template <class SlotT>
+    typename SlotT::type * requirePropertySlot(const Atlas::Message::Element & def_val
+                                               = Atlas::Message::Element())
+    {
+        typename SlotT::type * sp =
+              propertyCast<typename SlotT::type>(m_properties.slot(SlotT::key));
+        if (sp != 0) {
+            return sp;
+        }
+        return requirePropertyClass<typename SlotT::type>(
+              PropertyKey(SlotT::key).name(), def_val);
+    }
+
     /// Signal indicating that this entity has been changed
     sigc::signal<void> updated;
 
@@ -0,0 +1,205 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef RULESETS_LOCATED_ENTITY_SET_H
+#define RULESETS_LOCATED_ENTITY_SET_H
+
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+class LocatedEntity;
+
+/// \brief Set of entities held in contiguous storage
+///
+/// Members are kept in a dense array in the order they were inserted,
+/// except that erasing a member moves the last member into its place, so
+/// iterating the set does not chase tree nodes. Sets with more than a few
+/// members also keep an open addressing hash table of positions in the
+/// array, so lookup and erase take constant time.
+/// Iterators are invalidated by insert and erase.
+/// Each change to the membership gives the set a new stamp, unique
+/// across all sets, so users can tell when contents they have cached
+/// are out of date.
+class LocatedEntitySet {
+  public:
+    typedef std::vector<LocatedEntity *>::size_type size_type;
+    typedef std::vector<LocatedEntity *>::const_iterator const_iterator;
+    typedef const_iterator iterator;
+    typedef LocatedEntity * value_type;
+  protected:
+    /// Sets no larger than this are searched without the hash table
+    static const size_type linear_limit = 16;
+    /// Marks an unused slot in the hash table
+    static const size_type empty_slot = ~static_cast<size_type>(0);
+
+    /// Members of the set in iteration order
+    std::vector<LocatedEntity *> m_members;
+    /// Positions in m_members, or empty_slot, indexed by member hash
+    std::vector<size_type> m_table;
+    /// Stamp given to the set by the last change to its membership
+    unsigned long m_stamp;
+
+    static unsigned long nextStamp() {
+        static unsigned long next = 0;
+        return ++next;
+    }
+
+    static size_type hash(const LocatedEntity * e) {
+        std::uint64_t h = reinterpret_cast<std::uintptr_t>(e);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return static_cast<size_type>(h);
+    }
+
+    /// \brief Find the hash table slot holding a member or the empty slot
+    /// where it would go
+    size_type slot(const LocatedEntity * e) const {
+        size_type mask = m_table.size() - 1;
+        size_type s = hash(e) & mask;
+        while (m_table[s] != empty_slot && m_members[m_table[s]] != e) {
+            s = (s + 1) & mask;
+        }
+        return s;
+    }
+
+    /// \brief Find the position of a member in m_members
+    ///
+    /// @return the position, or the size of the set if not a member
+    size_type position(const LocatedEntity * e) const {
+        if (m_table.empty()) {
+            size_type i = 0;
+            while (i < m_members.size() && m_members[i] != e) {
+                ++i;
+            }
+            return i;
+        }
+        size_type s = slot(e);
+        return m_table[s] == empty_slot ? m_members.size() : m_table[s];
+    }
+
+    /// \brief Rebuild the hash table with a given number of slots
+    void rehash(size_type slots) {
+        m_table.assign(slots, static_cast<size_type>(empty_slot));
+        for (size_type i = 0; i < m_members.size(); ++i) {
+            m_table[slot(m_members[i])] = i;
+        }
+    }
+
+    /// \brief Empty a hash table slot, closing the gap in any probe
+    /// sequence which passed through it
+    void release(size_type hole) {
+        size_type mask = m_table.size() - 1;
+        size_type s = hole;
+        while (true) {
+            s = (s + 1) & mask;
+            if (m_table[s] == empty_slot) {
+                break;
+            }
+            size_type home = hash(m_members[m_table[s]]) & mask;
+            // The entry may move back to the hole unless its home slot
+            // lies cyclically between the hole and its current slot.
+            bool stays = (hole <= s) ? (hole < home && home <= s)
+                                     : (hole < home || home <= s);
+            if (!stays) {
+                m_table[hole] = m_table[s];
+                hole = s;
+            }
+        }
+        m_table[hole] = empty_slot;
+    }
+  public:
+    LocatedEntitySet() : m_stamp(nextStamp()) {
+    }
+
+    const_iterator begin() const {
+        return m_members.begin();
+    }
+
+    const_iterator end() const {
+        return m_members.end();
+    }
+
+    size_type size() const {
+        return m_members.size();
+    }
+
+    bool empty() const {
+        return m_members.empty();
+    }
+
+    unsigned long stamp() const {
+        return m_stamp;
+    }
+
+    const_iterator find(const LocatedEntity * e) const {
+        return m_members.begin() + position(e);
+    }
+
+    size_type count(const LocatedEntity * e) const {
+        return position(e) == m_members.size() ? 0 : 1;
+    }
+
+    std::pair<const_iterator, bool> insert(LocatedEntity * e) {
+        size_type pos = position(e);
+        if (pos != m_members.size()) {
+            return std::make_pair(m_members.begin() + pos, false);
+        }
+        m_members.push_back(e);
+        m_stamp = nextStamp();
+        if (!m_table.empty()) {
+            if (m_members.size() * 2 > m_table.size()) {
+                rehash(m_table.size() * 2);
+            } else {
+                m_table[slot(e)] = pos;
+            }
+        } else if (m_members.size() > linear_limit) {
+            rehash(linear_limit * 4);
+        }
+        return std::make_pair(m_members.begin() + pos, true);
+    }
+
+    size_type erase(const LocatedEntity * e) {
+        size_type pos = position(e);
+        if (pos == m_members.size()) {
+            return 0;
+        }
+        LocatedEntity * last = m_members.back();
+        if (!m_table.empty()) {
+            release(slot(e));
+            if (last != e) {
+                m_table[slot(last)] = pos;
+            }
+        }
+        m_members[pos] = last;
+        m_members.pop_back();
+        m_stamp = nextStamp();
+        return 1;
+    }
+
+    void clear() {
+        m_members.clear();
+        m_table.clear();
+        m_stamp = nextStamp();
+    }
+};
+
+#endif // RULESETS_LOCATED_ENTITY_SET_H
@@ -0,0 +1,202 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#include "MetabolismSystem.h"
+
+#include "Character.h"
+#include "PropertySlots.h"
+#include "StatusProperty.h"
+
+#include "common/const.h"
+#include "common/debug.h"
+#include "common/Monitors.h"
+#include "common/Property.h"
+#include "common/Variable.h"
+#include "common/Update.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include <cmath>
+
+using Atlas::Objects::Operation::Update;
+
+static const bool debug_flag = false;
+
+const double MetabolismSystem::observable_change = 0.01;
+
+MetabolismSystem * MetabolismSystem::m_instance = 0;
+
+MetabolismSystem::MetabolismSystem() : m_interval(consts::basic_tick * 30),
+                                       m_due(-1.),
+                                       m_entityCount(0),
+                                       m_updateCount(0)
+{
+    Monitors::instance()->watch("metabolism_entities",
+                                new Variable<int>(m_entityCount));
+    Monitors::instance()->watch("metabolism_updates",
+                                new Variable<int>(m_updateCount));
+}
+
+MetabolismSystem::~MetabolismSystem()
+{
+    std::vector<Character *>::const_iterator I = m_members.begin();
+    std::vector<Character *>::const_iterator Iend = m_members.end();
+    for (; I != Iend; ++I) {
+        (*I)->resetFlags(entity_metabolising);
+        (*I)->decRef();
+    }
+}
+
+MetabolismSystem * MetabolismSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MetabolismSystem;
+    }
+    return m_instance;
+}
+
+void MetabolismSystem::del()
+{
+    delete m_instance;
+    m_instance = 0;
+}
+
+/// \brief Read the values which metabolism changes from a character
+///
+/// Missing properties are read as zero.
+void MetabolismSystem::readValues(const Character & character,
+                                  double * values)
+{
+    const StatusProperty * status = character.getPropertySlot<StatusSlot>();
+    const Property<double> * food = character.getPropertySlot<FoodSlot>();
+    const Property<double> * mass = character.getPropertySlot<MassSlot>();
+    const Property<double> * stamina = character.getPropertySlot<StaminaSlot>();
+    values[0] = status != 0 ? status->data() : 0.;
+    values[1] = food != 0 ? food->data() : 0.;
+    values[2] = mass != 0 ? mass->data() : 0.;
+    values[3] = stamina != 0 ? stamina->data() : 0.;
+}
+
+/// \brief Remove a member, moving the last member into its place
+void MetabolismSystem::removeMember(std::size_t index)
+{
+    Character * character = m_members[index];
+    std::size_t last = m_members.size() - 1;
+    m_members[index] = m_members[last];
+    m_members.pop_back();
+    const double * last_sent = &m_sent[last * value_count];
+    std::copy(last_sent, last_sent + value_count, &m_sent[index * value_count]);
+    m_sent.resize(last * value_count);
+    m_missed[index] = m_missed[last];
+    m_missed.pop_back();
+    --m_entityCount;
+
+    character->resetFlags(entity_metabolising);
+    character->decRef();
+}
+
+/// \brief Metabolise one member, and send an Update if it has changed
+/// observably since it was last sent one
+///
+/// A member which has just woken is metabolised for all the passes it
+/// missed while it was asleep in one step, so waking a region does not
+/// replay every pass it slept through.
+void MetabolismSystem::metaboliseMember(std::size_t index)
+{
+    Character & character = *m_members[index];
+    if (character.getFlags() & entity_asleep) {
+        ++m_missed[index];
+        return;
+    }
+    character.applyMetabolism(m_missed[index] + 1);
+    m_missed[index] = 0;
+
+    double values[value_count];
+    readValues(character, values);
+    double * sent = &m_sent[index * value_count];
+    bool observable = false;
+    for (int i = 0; i < value_count; ++i) {
+        if (std::fabs(values[i] - sent[i]) > observable_change) {
+            observable = true;
+            break;
+        }
+    }
+    if (!observable) {
+        return;
+    }
+    std::copy(values, values + value_count, sent);
+
+    debug(std::cout << "Metabolism update for " << character.getId()
+                    << std::endl << std::flush;);
+    Update update;
+    update->setTo(character.getId());
+    character.sendWorld(update);
+    ++m_updateCount;
+}
+
+/// \brief Add a character to be metabolised in batches
+///
+/// @return zero if the character was added, or one if it was already
+/// being metabolised.
+int MetabolismSystem::addEntity(Character * character)
+{
+    if (character->getFlags() & entity_metabolising) {
+        return 1;
+    }
+    character->setFlags(entity_metabolising);
+    character->incRef();
+    m_members.push_back(character);
+    m_sent.resize(m_members.size() * value_count);
+    m_missed.push_back(0);
+    readValues(*character, &m_sent[(m_members.size() - 1) * value_count]);
+    ++m_entityCount;
+    return 0;
+}
+
+/// \brief Run a pass over all members if one is due
+///
+/// @param time the current world time
+void MetabolismSystem::tick(double time)
+{
+    if (m_due < 0.) {
+        m_due = time + m_interval;
+        return;
+    }
+    if (time < m_due) {
+        return;
+    }
+    // If the server has fallen behind, don't try to catch up.
+    m_due += m_interval;
+    if (m_due <= time) {
+        m_due = time + m_interval;
+    }
+
+    std::size_t i = 0;
+    while (i < m_members.size()) {
+        if (m_members[i]->isDestroyed()) {
+            removeMember(i);
+        } else {
+            metaboliseMember(i);
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef RULESETS_METABOLISM_SYSTEM_H
+#define RULESETS_METABOLISM_SYSTEM_H
+
+#include <vector>
+
+class Character;
+
+/// \brief Metabolises all the characters in the world in batched passes
+///
+/// A Character joins the system the first time it is sent a Tick with no
+/// arguments, instead of scheduling a Tick of its own for each cycle of its
+/// metabolism. Once every interval all members are metabolised in a single
+/// pass, which changes the properties of each member in place through its
+/// fixed property slots. Only the status, food, mass and stamina last
+/// broadcast for each member are packed alongside it, and an Update is
+/// only sent for a member once one of them has changed by more than
+/// observable_change, so slow changes are accumulated and broadcast
+/// together. Members which are
+/// asleep are skipped, and metabolised for all the passes they missed in
+/// one step once they wake.
+class MetabolismSystem {
+  public:
+    /// \brief Number of values packed for each member
+    static const int value_count = 4;
+    /// \brief Smallest change in a value which is broadcast
+    static const double observable_change;
+  protected:
+    static MetabolismSystem * m_instance;
+
+    /// \brief Characters which are metabolised by the system
+    std::vector<Character *> m_members;
+    /// \brief Values last broadcast, value_count for each member
+    std::vector<double> m_sent;
+    /// \brief Number of passes each member has missed while asleep
+    std::vector<int> m_missed;
+    /// \brief World time in seconds between passes
+    double m_interval;
+    /// \brief World time at which the next pass is due
+    double m_due;
+    /// \brief Number of characters metabolised by the system
+    int m_entityCount;
+    /// \brief Number of Update operations sent by the system
+    int m_updateCount;
+
+    MetabolismSystem();
+
+    static void readValues(const Character &, double * values);
+
+    void removeMember(std::size_t index);
+    void metaboliseMember(std::size_t index);
+  public:
+    ~MetabolismSystem();
+
+    static MetabolismSystem * instance();
+    static void del();
+
+    /// \brief Read only accessor for the number of characters metabolised
+    int entityCount() const {
+        return m_entityCount;
+    }
+
+    /// \brief Read only accessor for the number of Updates sent
+    int updateCount() const {
+        return m_updateCount;
+    }
+
+    /// \brief Read only accessor for the interval between passes
+    double interval() const {
+        return m_interval;
+    }
+
+    int addEntity(Character *);
+    void tick(double time);
+
+    friend class MetabolismSystemtest;
+};
+
+#endif // RULESETS_METABOLISM_SYSTEM_H
@@ -0,0 +1,368 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "MindLodScheduler.h"
+
+#include "LocatedEntity.h"
+
+#include "common/log.h"
+#include "common/debug.h"
+#include "common/compose.hpp"
+#include "common/Monitors.h"
+#include "common/Variable.h"
+#include "common/Tick.h"
+
+#include <Atlas/Objects/Operation.h>
+#include <Atlas/Objects/Anonymous.h>
+
+#include <algorithm>
+#include <sstream>
+#include <limits>
+
+using Atlas::Message::Element;
+using Atlas::Objects::Root;
+using Atlas::Objects::Operation::Tick;
+using Atlas::Objects::Entity::Anonymous;
+
+static const bool debug_flag = false;
+
+static const std::string SERIALNO = "serialno";
+
+/// \brief Upper limit on the number of tiers that can be configured
+static const unsigned int max_tiers = 8;
+
+/// \brief Fraction of the nearest tier distance a player must move before
+/// the minds around it are re-evaluated
+static const float reevaluate_fraction = 0.25f;
+
+MindLodScheduler * MindLodScheduler::m_instance = 0;
+
+MindLodScheduler::MindLodScheduler() : m_tierCounts(max_tiers, 0),
+                                       m_monitored(0)
+{
+    // A single unbounded tier leaves minds scheduled exactly as the
+    // scripts request, until some tiers are configured.
+    MindLodTier all = { std::numeric_limits<float>::max(), 1.f, 1 };
+    setTiers(MindLodTierList(1, all));
+}
+
+MindLodScheduler::~MindLodScheduler()
+{
+}
+
+MindLodScheduler * MindLodScheduler::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MindLodScheduler;
+    }
+    return m_instance;
+}
+
+void MindLodScheduler::del()
+{
+    delete m_instance;
+    m_instance = 0;
+}
+
+/// \brief Determine which tier a mind belongs in
+///
+/// The tier is chosen using the distance from the body of the mind to the
+/// nearest player controlled character.
+/// @param mind The character whose mind is being scheduled
+/// @return index of the tier the mind belongs in
+int MindLodScheduler::selectTier(const LocatedEntity & mind) const
+{
+    int furthest = m_tiers.size() - 1;
+    if (furthest == 0 || mind.m_location.m_loc == 0) {
+        return 0;
+    }
+    float nearest = std::numeric_limits<float>::max();
+    std::set<LocatedEntity *>::const_iterator I = m_players.begin();
+    std::set<LocatedEntity *>::const_iterator Iend = m_players.end();
+    for (; I != Iend; ++I) {
+        const LocatedEntity * player = *I;
+        if (player == &mind) {
+            return 0;
+        }
+        if (player->m_location.m_loc == 0) {
+            continue;
+        }
+        nearest = std::min(nearest, squareDistance(mind.m_location,
+                                                   player->m_location));
+    }
+    for (int i = 0; i < furthest; ++i) {
+        float range = m_tiers[i].m_distance;
+        if (nearest <= range * range) {
+            return i;
+        }
+    }
+    return furthest;
+}
+
+/// \brief Get the scheduling state of a mind, creating it if required
+MindLodState & MindLodScheduler::state(LocatedEntity & mind)
+{
+    std::map<LocatedEntity *, MindLodState>::iterator I = m_minds.find(&mind);
+    if (I != m_minds.end()) {
+        return I->second;
+    }
+    MindLodState & s = m_minds[&mind];
+    s.m_tier = selectTier(mind);
+    s.m_serialno = 0;
+    s.m_perceptionCount = 0;
+    ++m_tierCounts[s.m_tier];
+    return s;
+}
+
+/// \brief Move a mind into a new tier, keeping the counts up to date
+void MindLodScheduler::changeTier(MindLodState & s, int tier)
+{
+    --m_tierCounts[s.m_tier];
+    ++m_tierCounts[tier];
+    s.m_tier = tier;
+}
+
+/// \brief Configure the tiers from a string specification
+///
+/// The specification is a whitespace separated list of tiers, each of the
+/// form distance:tickscale:perceptioninterval, ordered by increasing
+/// distance. A perception interval less than one means Sight(Move)
+/// operations are not passed to minds in that tier at all.
+/// @param spec the tier specification
+/// @return zero if the specification was valid, non-zero otherwise
+int MindLodScheduler::configure(const std::string & spec)
+{
+    MindLodTierList tiers;
+    std::istringstream specstream(spec);
+    std::string item;
+    while (specstream >> item) {
+        MindLodTier tier;
+        char sep1 = 0, sep2 = 0;
+        std::istringstream itemstream(item);
+        itemstream >> tier.m_distance >> sep1 >> tier.m_tickScale >> sep2
+                   >> tier.m_perceptionInterval;
+        if (itemstream.fail() || sep1 != ':' || sep2 != ':' ||
+            tier.m_tickScale <= 0.f) {
+            log(ERROR, String::compose("Malformed mind LOD tier \"%1\"",
+                                       item));
+            return -1;
+        }
+        if (!tiers.empty() && tier.m_distance <= tiers.back().m_distance) {
+            log(ERROR, "Mind LOD tiers must be in order of increasing "
+                       "distance");
+            return -1;
+        }
+        tiers.push_back(tier);
+    }
+    if (tiers.empty()) {
+        return 0;
+    }
+    if (tiers.size() > max_tiers) {
+        log(ERROR, String::compose("Too many mind LOD tiers. "
+                                   "A maximum of %1 is permitted.",
+                                   max_tiers));
+        return -1;
+    }
+    setTiers(tiers);
+    return 0;
+}
+
+/// \brief Replace the tiers, and re-assign all known minds to them
+void MindLodScheduler::setTiers(const MindLodTierList & tiers)
+{
+    assert(!tiers.empty());
+    assert(tiers.size() <= max_tiers);
+    m_tiers = tiers;
+    for (; m_monitored < m_tiers.size(); ++m_monitored) {
+        Monitors::instance()->watch(String::compose("minds{lod=%1}",
+                                                    m_monitored),
+                                    new Variable<int>(m_tierCounts[m_monitored]));
+    }
+    std::fill(m_tierCounts.begin(), m_tierCounts.end(), 0);
+    std::map<LocatedEntity *, MindLodState>::iterator I = m_minds.begin();
+    std::map<LocatedEntity *, MindLodState>::iterator Iend = m_minds.end();
+    for (; I != Iend; ++I) {
+        I->second.m_tier = selectTier(*I->first);
+        ++m_tierCounts[I->second.m_tier];
+    }
+}
+
+/// \brief Note that a character has come under the control of a player
+void MindLodScheduler::addPlayer(LocatedEntity * player)
+{
+    m_players.insert(player);
+    m_evaluated.erase(player);
+    playerMoved(*player);
+}
+
+/// \brief Note that a character is no longer controlled by a player
+void MindLodScheduler::removePlayer(LocatedEntity * player)
+{
+    m_players.erase(player);
+    m_evaluated.erase(player);
+}
+
+/// \brief Forget about a mind, usually because its body is being destroyed
+void MindLodScheduler::removeMind(LocatedEntity * mind)
+{
+    std::map<LocatedEntity *, MindLodState>::iterator I = m_minds.find(mind);
+    if (I != m_minds.end()) {
+        --m_tierCounts[I->second.m_tier];
+        m_minds.erase(I);
+    }
+}
+
+/// \brief Re-evaluate the tier of a mind
+///
+/// @return index of the tier the mind is now in
+int MindLodScheduler::tier(LocatedEntity & mind)
+{
+    MindLodState & s = state(mind);
+    int new_tier = selectTier(mind);
+    if (new_tier != s.m_tier) {
+        changeTier(s, new_tier);
+    }
+    return new_tier;
+}
+
+/// \brief Adjust a Tick operation the mind is scheduling for itself
+///
+/// The tier of the mind is re-evaluated, the delay before the Tick is
+/// scaled to match, and the Tick is stamped with the mind's current serial
+/// number so it can be discarded if the mind is promoted in the meantime.
+/// @param mind The character whose mind generated the Tick
+/// @param op The Tick operation, which must already have a mind argument
+void MindLodScheduler::scheduleTick(LocatedEntity & mind, const Operation & op)
+{
+    int t = tier(mind);
+    assert(!op->getArgs().empty());
+    op->getArgs().front()->setAttr(SERIALNO, m_minds[&mind].m_serialno);
+    if (!op->isDefaultFutureSeconds()) {
+        op->setFutureSeconds(op->getFutureSeconds() * m_tiers[t].m_tickScale);
+    }
+}
+
+/// \brief Check whether a mind Tick arriving from the world is still current
+///
+/// @return true if the Tick should be passed to the mind
+bool MindLodScheduler::checkTick(LocatedEntity & mind, const Operation & op)
+{
+    std::map<LocatedEntity *, MindLodState>::const_iterator I = m_minds.find(&mind);
+    if (I == m_minds.end()) {
+        return true;
+    }
+    Element serialno;
+    if (op->getArgs().front()->copyAttr(SERIALNO, serialno) == 0 &&
+        serialno.isInt() && serialno.Int() < I->second.m_serialno) {
+        debug(std::cout << "Dropping superseded mind tick for "
+                        << mind.getId() << std::endl << std::flush;);
+        return false;
+    }
+    return true;
+}
+
+/// \brief Check whether a Sight operation should be passed to a mind
+///
+/// Only Sight(Move) operations of other entities are throttled, as
+/// each one supersedes the last. All other perception is passed.
+/// @return true if the Sight should be passed to the mind
+bool MindLodScheduler::checkPerception(LocatedEntity & mind,
+                                       const Operation & op)
+{
+    if (m_tiers.size() < 2) {
+        return true;
+    }
+    const std::vector<Root> & args = op->getArgs();
+    if (args.empty() ||
+        args.front()->getClassNo() != Atlas::Objects::Operation::MOVE_NO ||
+        op->getFrom() == mind.getId()) {
+        return true;
+    }
+    MindLodState & s = state(mind);
+    int interval = m_tiers[s.m_tier].m_perceptionInterval;
+    if (interval == 1) {
+        return true;
+    }
+    if (interval < 1 || ++s.m_perceptionCount < interval) {
+        return false;
+    }
+    s.m_perceptionCount = 0;
+    return true;
+}
+
+/// \brief Promote any minds a player has moved closer to
+///
+/// Only minds whose bodies share a container with the player are
+/// considered, and only once the player has changed container or moved
+/// more than a fraction of the nearest tier distance since the minds were
+/// last re-evaluated. A mind may therefore be promoted that much later
+/// than the exact tier boundary, but a player walking in small steps does
+/// not rescan its whole container on every Move. Any mind which moves into a nearer tier is given an
+/// immediate Tick, and its serial number is incremented so that the
+/// Tick it had already scheduled is discarded when it arrives.
+/// @param player The player controlled character that has moved
+void MindLodScheduler::playerMoved(LocatedEntity & player)
+{
+    if (m_tiers.size() < 2 || m_minds.empty()) {
+        return;
+    }
+    LocatedEntity * loc = player.m_location.m_loc;
+    if (loc == 0 || loc->m_contains == 0) {
+        return;
+    }
+    const Point3D & pos = player.m_location.m_pos;
+    if (pos.isValid()) {
+        std::map<LocatedEntity *, MindLodPlayerState>::iterator K =
+              m_evaluated.find(&player);
+        if (K != m_evaluated.end() && K->second.m_loc == loc &&
+            K->second.m_pos.isValid()) {
+            float step = m_tiers.front().m_distance * reevaluate_fraction;
+            if (squareDistance(K->second.m_pos, pos) < step * step) {
+                return;
+            }
+        }
+        MindLodPlayerState & last = m_evaluated[&player];
+        last.m_loc = loc;
+        last.m_pos = pos;
+    }
+    LocatedEntitySet::const_iterator I = loc->m_contains->begin();
+    LocatedEntitySet::const_iterator Iend = loc->m_contains->end();
+    for (; I != Iend; ++I) {
+        LocatedEntity * mind = *I;
+        std::map<LocatedEntity *, MindLodState>::iterator J = m_minds.find(mind);
+        if (J == m_minds.end()) {
+            continue;
+        }
+        MindLodState & s = J->second;
+        int new_tier = selectTier(*mind);
+        if (new_tier >= s.m_tier) {
+            continue;
+        }
+        changeTier(s, new_tier);
+        s.m_perceptionCount = 0;
+
+        Anonymous tick_arg;
+        tick_arg->setName("mind");
+        tick_arg->setAttr(SERIALNO, ++s.m_serialno);
+
+        Tick tick;
+        tick->setTo(mind->getId());
+        tick->setArgs1(tick_arg);
+        mind->sendWorld(tick);
+    }
+}
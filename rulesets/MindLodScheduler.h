@@ -0,0 +1,131 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef RULESETS_MIND_LOD_SCHEDULER_H
+#define RULESETS_MIND_LOD_SCHEDULER_H
+
+#include "common/OperationRouter.h"
+
+#include "physics/Vector3D.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class LocatedEntity;
+
+/// \brief One distance band used when scheduling NPC minds
+struct MindLodTier {
+    /// Upper bound of the band, as distance to the nearest player
+    float m_distance;
+    /// Multiplier applied to the FUTURE_SECONDS of mind Tick ops
+    float m_tickScale;
+    /// Only one in this many Sight(Move) ops is passed to the mind
+    int m_perceptionInterval;
+};
+
+/// \brief Per mind level of detail book-keeping
+struct MindLodState {
+    /// Index of the tier the mind is currently in
+    int m_tier;
+    /// Serial number stamped on mind Tick ops, so superseded ticks are dropped
+    long m_serialno;
+    /// Count of throttled perception ops seen since one was last passed
+    int m_perceptionCount;
+};
+
+/// \brief Where a player was when nearby minds were last re-evaluated
+struct MindLodPlayerState {
+    /// Container of the player at the time
+    const LocatedEntity * m_loc;
+    /// Position of the player at the time
+    Point3D m_pos;
+};
+
+typedef std::vector<MindLodTier> MindLodTierList;
+
+/// \brief Schedules NPC mind activity based on distance to the players
+///
+/// Minds a long way from any player controlled character are ticked less
+/// often, and are shown fewer movement perceptions. When a player moves
+/// within range of a mind in a distant tier, the mind is promoted
+/// immediately, and given a fresh Tick so it does not wait out the
+/// long interval it was last scheduled with. Minds are only re-evaluated
+/// once a player has moved a fraction of the nearest tier distance, so
+/// players walking in small steps do not rescan their container each time.
+class MindLodScheduler {
+  protected:
+    static MindLodScheduler * m_instance;
+
+    /// \brief Distance bands ordered from nearest to furthest
+    MindLodTierList m_tiers;
+    /// \brief Number of minds currently in each tier
+    std::vector<int> m_tierCounts;
+    /// \brief Number of tiers which have been registered with Monitors
+    unsigned int m_monitored;
+    /// \brief Characters currently controlled by an external mind
+    std::set<LocatedEntity *> m_players;
+    /// \brief Scheduling state of each NPC mind
+    std::map<LocatedEntity *, MindLodState> m_minds;
+    /// \brief Position of each player when minds were last re-evaluated
+    std::map<LocatedEntity *, MindLodPlayerState> m_evaluated;
+
+    MindLodScheduler();
+
+    int selectTier(const LocatedEntity &) const;
+    MindLodState & state(LocatedEntity &);
+    void changeTier(MindLodState &, int);
+  public:
+    ~MindLodScheduler();
+
+    static MindLodScheduler * instance();
+    static void del();
+
+    /// \brief Read only accessor for the configured tiers
+    const MindLodTierList & tiers() const {
+        return m_tiers;
+    }
+
+    /// \brief Read only accessor for the count of minds in each tier
+    const std::vector<int> & tierCounts() const {
+        return m_tierCounts;
+    }
+
+    /// \brief Read only accessor for the player controlled characters
+    const std::set<LocatedEntity *> & players() const {
+        return m_players;
+    }
+
+    int configure(const std::string &);
+    void setTiers(const MindLodTierList &);
+
+    void addPlayer(LocatedEntity *);
+    void removePlayer(LocatedEntity *);
+    void removeMind(LocatedEntity *);
+
+    int tier(LocatedEntity &);
+    void scheduleTick(LocatedEntity &, const Operation &);
+    bool checkTick(LocatedEntity &, const Operation &);
+    bool checkPerception(LocatedEntity &, const Operation &);
+    void playerMoved(LocatedEntity &);
+
+    friend class MindLodSchedulertest;
+};
+
+#endif // RULESETS_MIND_LOD_SCHEDULER_H
@@ -18,6 +18,8 @@
 
 #include "Motion.h"
 
+#include "rulesets/BroadPhase.h"
+#include "rulesets/Domain.h"
 #include "rulesets/LocatedEntity.h"
 
 #include "physics/Collision.h"
@@ -34,6 +36,15 @@ using String::compose;
 
 static const bool debug_flag = false;
 
+/// Number of entities in a container above which collision candidates are
+/// found using a BroadPhase grid, rather than checking every entity.
+static const LocatedEntitySet::size_type broadphase_threshold = 64;
+
+/// Candidates for collision with the entity being checked, and their
+/// locations packed for batched collision prediction.
+static CollisionBatch collision_batch;
+static std::vector<LocatedEntity *> collision_entities;
+
 Motion::Motion(LocatedEntity & body) : m_entity(body), m_serialno(0),
                                        m_collision(false), m_collEntity(0),
                                        m_collisionTime(0.f)
@@ -64,6 +75,19 @@ Operation * Motion::genMoveOperation()
     return 0;
 }
 
+void Motion::addCollisionCandidate(LocatedEntity * other)
+{
+    // Don't check for collisions with ourselves
+    if (other == &m_entity) { return; }
+    const Location & other_location = other->m_location;
+    if (!other_location.bBox().isValid() || !other_location.isSolid()) {
+        return;
+    }
+    debug( std::cout << " " << other->getId(); );
+    collision_batch.add(other_location);
+    collision_entities.push_back(other);
+}
+
 float Motion::checkCollisions()
 {
     assert(m_entity.m_location.m_loc != 0);
@@ -85,29 +109,45 @@ float Motion::checkCollisions()
     if (!m_entity.m_location.bBox().isValid()) {
         return coll_time;
     }
-    LocatedEntitySet::const_iterator I = m_entity.m_location.m_loc->m_contains->begin();
-    LocatedEntitySet::const_iterator Iend = m_entity.m_location.m_loc->m_contains->end();
-    for (; I != Iend; ++I) {
-        // Don't check for collisions with ourselves
-        if ((*I) == &m_entity) { continue; }
-        const Location & other_location = (*I)->m_location;
-        if (!other_location.bBox().isValid() || !other_location.isSolid()) {
-            continue;
+    const LocatedEntitySet & contains = *m_entity.m_location.m_loc->m_contains;
+    LocatedEntitySet::const_iterator I;
+    LocatedEntitySet::const_iterator Iend;
+    BBox swept;
+    BroadPhase::sweptBox(m_entity.m_location, consts::move_tick, swept);
+    BroadPhase::CandidateList candidates;
+    Domain * domain = m_entity.getMovementDomain();
+    if (domain != 0 &&
+        domain->collisionCandidates(m_entity, swept, candidates)) {
+        // The movement domain has found the candidates
+    } else if (contains.size() < broadphase_threshold) {
+        I = contains.begin();
+        Iend = contains.end();
+        for (; I != Iend; ++I) {
+            addCollisionCandidate(*I);
         }
-        debug( std::cout << " " << (*I)->getId(); );
-        Vector3D normal;
-        float t = consts::move_tick + 1;
-        if (!predictCollision(m_entity.m_location, other_location, t, normal) || (t < 0)) {
+    } else {
+        BroadPhase * grid = BroadPhase::forContainer(*m_entity.m_location.m_loc,
+                                                     m_entity.m_location.timeStamp());
+        grid->update(&m_entity);
+        grid->query(swept, candidates);
+    }
+    BroadPhase::CandidateList::const_iterator J = candidates.begin();
+    BroadPhase::CandidateList::const_iterator Jend = candidates.end();
+    for (; J != Jend; ++J) {
+        // Candidates may still include entities which have left
+        if (contains.find(*J) == contains.end()) {
             continue;
         }
-        debug( std::cout << (*I)->getId() << other_location.pos() << other_location.velocity(); );
-        debug( std::cout << "[" << t << "]"; );
-        if (t <= coll_time) {
-            m_collEntity = *I;
-            m_collNormal = normal;
-            coll_time = t;
-        }
+        addCollisionCandidate(*J);
+    }
+    int hit = predictCollision(m_entity.m_location, collision_batch,
+                               consts::move_tick + 1, coll_time,
+                               m_collNormal);
+    if (hit != -1) {
+        m_collEntity = collision_entities[hit];
     }
+    collision_batch.clear();
+    collision_entities.clear();
     if (m_collEntity == NULL) {
         return consts::move_tick;
     }
@@ -58,6 +58,10 @@ class Motion {
     /// Normal to the collision surface
     Vector3D m_collNormal;
 
+    /// \brief Add one other entity in the container to the collision batch
+    ///
+    /// Entities which can not be collided with are skipped.
+    void addCollisionCandidate(LocatedEntity * other);
   public:
     explicit Motion(LocatedEntity & body);
     virtual ~Motion();
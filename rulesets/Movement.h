@@ -55,6 +55,10 @@ class Movement {
         return m_targetPos.isValid();
     }
 
+    const Point3D & target() const {
+        return m_targetPos;
+    }
+
     void setTarget(const Point3D & target) {
         m_targetPos = target;
     }
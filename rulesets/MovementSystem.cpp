@@ -0,0 +1,374 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#include "MovementSystem.h"
+
+#include "Character.h"
+#include "Domain.h"
+#include "Movement.h"
+
+#include "common/const.h"
+#include "common/debug.h"
+#include "common/Monitors.h"
+#include "common/Variable.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include <cmath>
+
+static const bool debug_flag = false;
+
+const float MovementSystem::cell_size = 16.f;
+
+/// Largest number of cells a member may cover before it is left out of
+/// the broadphase grid
+static const int max_member_cells = 64;
+
+MovementSystem * MovementSystem::m_instance = 0;
+
+static inline long cellKey(int x, int y)
+{
+    return ((long)x << 32) | (unsigned int)y;
+}
+
+static inline float squareDistance(const float * a, const float * b)
+{
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+MovementSystem::MovementSystem() : m_interval(consts::basic_tick / 10.f),
+                                   m_due(-1.),
+                                   m_entityCount(0),
+                                   m_moveCount(0)
+{
+    Monitors::instance()->watch("movement_entities",
+                                new Variable<int>(m_entityCount));
+    Monitors::instance()->watch("movement_moves",
+                                new Variable<int>(m_moveCount));
+}
+
+MovementSystem::~MovementSystem()
+{
+    std::vector<Character *>::const_iterator I = m_members.begin();
+    std::vector<Character *>::const_iterator Iend = m_members.end();
+    for (; I != Iend; ++I) {
+        (*I)->resetFlags(entity_moving);
+        (*I)->decRef();
+    }
+}
+
+MovementSystem * MovementSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MovementSystem;
+    }
+    return m_instance;
+}
+
+void MovementSystem::del()
+{
+    delete m_instance;
+    m_instance = 0;
+}
+
+/// \brief Read the location and target of a member into the packed arrays
+void MovementSystem::readMember(std::size_t index)
+{
+    const Character & character = *m_members[index];
+    const Location & location = character.m_location;
+    const Movement & movement = character.m_movement;
+    float * pos = &m_positions[index * value_count];
+    float * velocity = &m_velocities[index * value_count];
+    float * target = &m_targets[index * value_count];
+    bool has_velocity = location.velocity().isValid();
+    bool has_target = movement.hasTarget();
+    for (int i = 0; i < value_count; ++i) {
+        pos[i] = location.pos().isValid() ? location.pos()[i] : 0.f;
+        velocity[i] = has_velocity ? location.velocity()[i] : 0.f;
+        target[i] = has_target ? movement.target()[i] : 0.f;
+    }
+    m_stamps[index] = location.timeStamp();
+    m_serialnos[index] = movement.serialno();
+}
+
+/// \brief Remove a member, moving the last member into its place
+void MovementSystem::removeMember(std::size_t index)
+{
+    Character * character = m_members[index];
+    std::size_t last = m_members.size() - 1;
+    m_index.erase(character);
+    if (index != last) {
+        m_index[m_members[last]] = index;
+    }
+    m_members[index] = m_members[last];
+    m_members.pop_back();
+    for (int i = 0; i < value_count; ++i) {
+        m_positions[index * value_count + i] = m_positions[last * value_count + i];
+        m_velocities[index * value_count + i] = m_velocities[last * value_count + i];
+        m_targets[index * value_count + i] = m_targets[last * value_count + i];
+        m_integrated[index * value_count + i] = m_integrated[last * value_count + i];
+    }
+    m_positions.resize(last * value_count);
+    m_velocities.resize(last * value_count);
+    m_targets.resize(last * value_count);
+    m_integrated.resize(last * value_count);
+    m_boxes.resize(last * value_count * 2);
+    m_stamps[index] = m_stamps[last];
+    m_stamps.pop_back();
+    m_serialnos[index] = m_serialnos[last];
+    m_serialnos.pop_back();
+    m_contact[index] = m_contact[last];
+    m_contact.pop_back();
+    --m_entityCount;
+
+    character->resetFlags(entity_moving);
+    character->decRef();
+}
+
+/// \brief Integrate the position of a member to the time given
+///
+/// A member has arrived once moving any further would take it away from
+/// its target, in which case its integrated position is its target. The
+/// position is not clamped to the terrain, as that is only needed when a
+/// Move is sent.
+/// @return true if the member has arrived at its target
+bool MovementSystem::integrateMember(std::size_t index, double time)
+{
+    const float * pos = &m_positions[index * value_count];
+    const float * velocity = &m_velocities[index * value_count];
+    const float * target = &m_targets[index * value_count];
+    float * integrated = &m_integrated[index * value_count];
+
+    float time_diff = (float)(time - m_stamps[index]);
+    float ahead[value_count];
+    for (int i = 0; i < value_count; ++i) {
+        integrated[i] = pos[i] + velocity[i] * time_diff;
+        ahead[i] = integrated[i] + velocity[i] * (float)m_interval;
+    }
+    // The values returned by squareDistance are squares, so
+    // cannot be used except for comparison
+    bool arrived = squareDistance(target, ahead) >
+                   squareDistance(target, integrated);
+    if (arrived) {
+        std::copy(target, target + value_count, integrated);
+    }
+    return arrived;
+}
+
+/// \brief Find the members whose boxes come into contact over this pass
+///
+/// Each member integrated in this pass which has a bounding box is entered
+/// in the grid cells covered by its box swept along its velocity for one
+/// interval, and checked against the members already entered in those
+/// cells which share its parent.
+/// @param active whether each member was integrated in this pass
+/// @param contact returns whether each member is in contact
+void MovementSystem::findContacts(const std::vector<char> & active,
+                                  std::vector<char> & contact)
+{
+    m_cells.clear();
+    contact.assign(m_members.size(), 0);
+    for (std::size_t i = 0; i < m_members.size(); ++i) {
+        const Character & character = *m_members[i];
+        const BBox & bbox = character.m_location.bBox();
+        if (!active[i] || !bbox.isValid()) {
+            continue;
+        }
+        const float * integrated = &m_integrated[i * value_count];
+        const float * velocity = &m_velocities[i * value_count];
+        float * low = &m_boxes[i * value_count * 2];
+        float * high = low + value_count;
+        for (int k = 0; k < value_count; ++k) {
+            float sweep = velocity[k] * (float)m_interval;
+            low[k] = integrated[k] + bbox.lowCorner()[k] + std::min(sweep, 0.f);
+            high[k] = integrated[k] + bbox.highCorner()[k] + std::max(sweep, 0.f);
+        }
+        int min_x = (int)std::floor(low[0] / cell_size);
+        int min_y = (int)std::floor(low[1] / cell_size);
+        int max_x = (int)std::floor(high[0] / cell_size);
+        int max_y = (int)std::floor(high[1] / cell_size);
+        if ((max_x - min_x + 1) * (max_y - min_y + 1) > max_member_cells) {
+            continue;
+        }
+        for (int x = min_x; x <= max_x; ++x) {
+            for (int y = min_y; y <= max_y; ++y) {
+                std::vector<std::size_t> & cell = m_cells[cellKey(x, y)];
+                std::vector<std::size_t>::const_iterator I = cell.begin();
+                std::vector<std::size_t>::const_iterator Iend = cell.end();
+                for (; I != Iend; ++I) {
+                    std::size_t j = *I;
+                    if (m_members[j]->m_location.m_loc !=
+                        character.m_location.m_loc) {
+                        continue;
+                    }
+                    const float * other_low = &m_boxes[j * value_count * 2];
+                    const float * other_high = other_low + value_count;
+                    bool overlap = true;
+                    for (int k = 0; k < value_count; ++k) {
+                        if (high[k] < other_low[k] || other_high[k] < low[k]) {
+                            overlap = false;
+                            break;
+                        }
+                    }
+                    if (overlap) {
+                        contact[i] = 1;
+                        contact[j] = 1;
+                    }
+                }
+                cell.push_back(i);
+            }
+        }
+    }
+}
+
+/// \brief Send a Move for a member from its integrated position
+///
+/// The position sent is clamped to the terrain.
+/// @param arrived whether the member has arrived at its target, in
+/// which case it is stopped there
+void MovementSystem::sendMove(std::size_t index, bool arrived)
+{
+    Character & character = *m_members[index];
+    const float * integrated = &m_integrated[index * value_count];
+
+    Location new_location(character.m_location);
+    new_location.m_pos = Point3D(integrated[0], integrated[1], integrated[2]);
+    Domain * domain = character.getMovementDomain();
+    if (domain != 0 && character.m_location.m_loc != 0) {
+        new_location.m_pos.z() = domain->constrainHeight(character.m_location.m_loc,
+                                                         new_location.pos(),
+                                                         "standing");
+    }
+    if (arrived) {
+        character.m_movement.reset();
+        new_location.m_velocity = Vector3D(0,0,0);
+    }
+
+    debug(std::cout << "Movement update for " << character.getId()
+                    << (arrived ? " arrived" : " contact")
+                    << std::endl << std::flush;);
+    character.sendWorld(character.m_movement.generateMove(new_location));
+    ++m_moveCount;
+}
+
+/// \brief Add a character to be moved in batches
+///
+/// A character which is already being moved has its location and
+/// target read again.
+/// @return zero if the character was added, or one if it was already
+/// being moved.
+int MovementSystem::addEntity(Character * character)
+{
+    if (character->getFlags() & entity_moving) {
+        MemberIndex::const_iterator I = m_index.find(character);
+        if (I != m_index.end()) {
+            readMember(I->second);
+        }
+        return 1;
+    }
+    character->setFlags(entity_moving);
+    character->incRef();
+    std::size_t index = m_members.size();
+    m_members.push_back(character);
+    m_index[character] = index;
+    std::size_t count = m_members.size();
+    m_positions.resize(count * value_count);
+    m_velocities.resize(count * value_count);
+    m_targets.resize(count * value_count);
+    m_integrated.resize(count * value_count);
+    m_boxes.resize(count * value_count * 2);
+    m_stamps.push_back(0.);
+    m_serialnos.push_back(0);
+    m_contact.push_back(0);
+    readMember(index);
+    ++m_entityCount;
+    return 0;
+}
+
+/// \brief Run a pass over all members if one is due
+///
+/// Members which have been destroyed, have lost their target, or have
+/// stopped are removed. A member whose movement has been changed by its
+/// mind is not integrated until its move Tick has it read again, as the
+/// Move which changed it may not have been applied to its location yet.
+/// Members are read again whenever their location has been updated.
+/// @param time the current world time
+void MovementSystem::tick(double time)
+{
+    if (m_due < 0.) {
+        m_due = time + m_interval;
+        return;
+    }
+    if (time < m_due) {
+        return;
+    }
+    // If the server has fallen behind, don't try to catch up.
+    m_due += m_interval;
+    if (m_due <= time) {
+        m_due = time + m_interval;
+    }
+
+    // Members are only ever moved into the place of a removed member from
+    // further along, so the entries for members not yet reached are clear.
+    std::vector<char> active(m_members.size(), 0);
+    std::size_t i = 0;
+    while (i < m_members.size()) {
+        Character & character = *m_members[i];
+        if (character.isDestroyed() || !character.m_movement.hasTarget()) {
+            removeMember(i);
+            continue;
+        }
+        if (character.m_movement.serialno() != m_serialnos[i]) {
+            ++i;
+            continue;
+        }
+        if (character.m_location.timeStamp() != m_stamps[i]) {
+            readMember(i);
+        }
+        if (!character.m_movement.updateNeeded(character.m_location)) {
+            removeMember(i);
+            continue;
+        }
+        if (character.getFlags() & entity_asleep) {
+            ++i;
+            continue;
+        }
+        if (integrateMember(i, time)) {
+            sendMove(i, true);
+            removeMember(i);
+            continue;
+        }
+        active[i] = 1;
+        ++i;
+    }
+    active.resize(m_members.size());
+
+    std::vector<char> contact;
+    findContacts(active, contact);
+    for (i = 0; i < m_members.size(); ++i) {
+        if (contact[i] && !m_contact[i]) {
+            sendMove(i, false);
+        }
+    }
+    m_contact.swap(contact);
+}
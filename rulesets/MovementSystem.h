@@ -0,0 +1,129 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef RULESETS_MOVEMENT_SYSTEM_H
+#define RULESETS_MOVEMENT_SYSTEM_H
+
+#include <unordered_map>
+#include <vector>
+
+class Character;
+
+/// \brief Tracks all the characters walking to a target in batched passes
+///
+/// A Character joins the system when it is sent the move Tick which
+/// follows the Move from its mind setting it walking towards a target,
+/// instead of rescheduling that Tick and sending itself a Move for each
+/// step. The same Tick has the system read the member again each time its
+/// mind changes its movement, and the member is left alone in between.
+/// Once every interval the position of every member is integrated in a
+/// single pass over packed position and velocity arrays. A Move is only
+/// sent for a member when its observable trajectory changes, either
+/// because it has reached its target, or because its box has come into
+/// contact with the box of another member in the broadphase grid, so the
+/// exact collision check in Motion is run with up to date positions. The
+/// position is only clamped to the terrain when a Move is sent. In
+/// between, observers extrapolate from the velocity they were last sent.
+/// The Update ops scheduled by Thing keep the location of the member in
+/// step, but don't broadcast it while the member is moved by the system
+/// unless a collision changes its trajectory. Members which are asleep
+/// are skipped.
+class MovementSystem {
+  public:
+    /// \brief Number of values packed for each member
+    static const int value_count = 3;
+    /// \brief Width in metres of a cell in the broadphase grid
+    static const float cell_size;
+  protected:
+    typedef std::unordered_map<long, std::vector<std::size_t> > CellDict;
+    typedef std::unordered_map<const Character *, std::size_t> MemberIndex;
+
+    static MovementSystem * m_instance;
+
+    /// \brief Characters which are moved by the system
+    std::vector<Character *> m_members;
+    /// \brief Position of each member in the packed arrays
+    MemberIndex m_index;
+    /// \brief Position of each member at the time its location was last
+    /// read, value_count for each member
+    std::vector<float> m_positions;
+    /// \brief Velocity of each member, value_count for each member
+    std::vector<float> m_velocities;
+    /// \brief Target of each member, value_count for each member
+    std::vector<float> m_targets;
+    /// \brief Position of each member integrated in the current pass,
+    /// value_count for each member
+    std::vector<float> m_integrated;
+    /// \brief Box covered by each member over the current pass, twice
+    /// value_count for each member
+    std::vector<float> m_boxes;
+    /// \brief Time stamp of the location each member was last read from
+    std::vector<double> m_stamps;
+    /// \brief Movement serial number each member was last read with
+    std::vector<int> m_serialnos;
+    /// \brief Whether each member was in contact with another member in
+    /// the last pass
+    std::vector<char> m_contact;
+    /// \brief Broadphase grid of the members, rebuilt each pass
+    CellDict m_cells;
+    /// \brief World time in seconds between passes
+    double m_interval;
+    /// \brief World time at which the next pass is due
+    double m_due;
+    /// \brief Number of characters moved by the system
+    int m_entityCount;
+    /// \brief Number of Move operations sent by the system
+    int m_moveCount;
+
+    MovementSystem();
+
+    void readMember(std::size_t index);
+    void removeMember(std::size_t index);
+    bool integrateMember(std::size_t index, double time);
+    void findContacts(const std::vector<char> & active,
+                      std::vector<char> & contact);
+    void sendMove(std::size_t index, bool arrived);
+  public:
+    ~MovementSystem();
+
+    static MovementSystem * instance();
+    static void del();
+
+    /// \brief Read only accessor for the number of characters moved
+    int entityCount() const {
+        return m_entityCount;
+    }
+
+    /// \brief Read only accessor for the number of Moves sent
+    int moveCount() const {
+        return m_moveCount;
+    }
+
+    /// \brief Read only accessor for the interval between passes
+    double interval() const {
+        return m_interval;
+    }
+
+    int addEntity(Character *);
+    void tick(double time);
+
+    friend class MovementSystemtest;
+};
+
+#endif // RULESETS_MOVEMENT_SYSTEM_H
@@ -0,0 +1,93 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "NativeArithmeticScript.h"
+
+#include "LocatedEntity.h"
+
+#include "common/log.h"
+#include "common/compose.hpp"
+
+using Atlas::Message::Element;
+
+/// \brief Limit on formulas evaluated within one another
+///
+/// This is reached only if a formula refers to itself, directly or
+/// through other formulas.
+static const int max_formula_depth = 16;
+
+NativeArithmeticScript::NativeArithmeticScript(LocatedEntity * owner) :
+                                               m_owner(owner), m_depth(0)
+{
+}
+
+NativeArithmeticScript::~NativeArithmeticScript()
+{
+}
+
+/// \brief Compile a formula and add it to the model
+///
+/// @param name the name whose value the formula calculates
+/// @param source the formula
+/// @return zero if the formula was compiled, non-zero otherwise
+int NativeArithmeticScript::addFormula(const std::string & name,
+                                       const std::string & source)
+{
+    ArithmeticExpression expression;
+    if (expression.compile(source) != 0) {
+        log(ERROR, String::compose("Unable to compile formula for \"%1\"",
+                                   name));
+        return -1;
+    }
+    m_formulae[name] = expression;
+    return 0;
+}
+
+int NativeArithmeticScript::attribute(const std::string & name, float & val)
+{
+    std::map<std::string, ArithmeticExpression>::const_iterator I = m_formulae.find(name);
+    if (I != m_formulae.end()) {
+        if (m_depth >= max_formula_depth) {
+            log(ERROR, String::compose("Formula for \"%1\" refers to itself",
+                                       name));
+            return -1;
+        }
+        ++m_depth;
+        int ret = I->second.evaluate(*this, val);
+        --m_depth;
+        return ret;
+    }
+    std::map<std::string, float>::const_iterator J = m_variables.find(name);
+    if (J != m_variables.end()) {
+        val = J->second;
+        return 0;
+    }
+    if (m_owner != 0) {
+        Element attr;
+        if (m_owner->getAttr(name, attr) == 0 && attr.isNum()) {
+            val = attr.asNum();
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void NativeArithmeticScript::set(const std::string & name, const float & val)
+{
+    m_variables[name] = val;
+}
@@ -0,0 +1,55 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef RULESETS_NATIVE_ARITHMETIC_SCRIPT_H
+#define RULESETS_NATIVE_ARITHMETIC_SCRIPT_H
+
+#include "ArithmeticScript.h"
+#include "ArithmeticExpression.h"
+
+#include <map>
+
+class LocatedEntity;
+
+/// \brief Arithmetic model built from formulas declared in the ruleset
+///
+/// The value of a name is calculated from its formula if it has one.
+/// Otherwise it is a value which has been set on the model, or failing
+/// that a numeric property of the entity which owns the model.
+/// Formulas may use other names, but not themselves.
+class NativeArithmeticScript : public ArithmeticScript {
+  protected:
+    /// \brief Entity whose properties formulas can use, or NULL
+    LocatedEntity * m_owner;
+    /// \brief Compiled formulas keyed by the name they calculate
+    std::map<std::string, ArithmeticExpression> m_formulae;
+    /// \brief Values which have been set on the model
+    std::map<std::string, float> m_variables;
+    /// \brief Number of formulas currently being evaluated
+    int m_depth;
+  public:
+    explicit NativeArithmeticScript(LocatedEntity * owner);
+    virtual ~NativeArithmeticScript();
+
+    int addFormula(const std::string & name, const std::string & source);
+
+    virtual int attribute(const std::string & name, float & val);
+    virtual void set(const std::string & name, const float & val);
+};
+
+#endif // RULESETS_NATIVE_ARITHMETIC_SCRIPT_H
@@ -18,9 +18,11 @@
 
 #include "Plant.h"
 
+#include "PlantGrowthSystem.h"
 #include "StatusProperty.h"
 #include "BBoxProperty.h"
 #include "AreaProperty.h"
+#include "PropertySlots.h"
 #include "physics/Shape.h"
 
 #include "common/const.h"
@@ -33,11 +35,9 @@
 #include "common/log.h"
 
 #include "common/Eat.h"
-#include "common/Tick.h"
 #include "common/Update.h"
 
 #include <wfmath/atlasconv.h>
-#include <wfmath/MersenneTwister.h>
 
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
@@ -48,7 +48,6 @@ using Atlas::Objects::Operation::Create;
 using Atlas::Objects::Operation::Eat;
 using Atlas::Objects::Operation::Set;
 using Atlas::Objects::Operation::Move;
-using Atlas::Objects::Operation::Tick;
 using Atlas::Objects::Operation::Update;
 using Atlas::Objects::Entity::Anonymous;
 
@@ -125,14 +124,22 @@ void Plant::TickOperation(const Operation & op, OpVector & res)
 {
     debug(std::cout << "Plant::Tick(" << getId() << "," << m_type << ")"
                     << std::endl << std::flush;);
-    // Use a value seeded from the ID, so it's always the same.
-    WFMath::MTRand::instance.seed(getIntId());
-    double jitter = WFMath::MTRand::instance.rand() * 10.;
+    // Growth is advanced by the system in batches, so the Tick is not
+    // rescheduled here.
+    PlantGrowthSystem::instance()->addEntity(this);
+}
 
-    Tick tick_op;
-    tick_op->setTo(getId());
-    tick_op->setFutureSeconds(consts::basic_tick * m_speed + jitter);
-    res.push_back(tick_op);
+/// \brief Advance the plant by one growth cycle
+///
+/// Operations to feed the plant and to drop its fruit are added to res,
+/// and properties which have changed are marked unsent, but no Update is
+/// generated.
+/// @param cycles Number of growth cycles since the plant last grew, which
+/// is more than one if the plant has been asleep.
+/// @return true if the number of fruit on the plant has changed.
+bool Plant::grow(OpVector & res, int cycles)
+{
+    bool fruit_changed = false;
 
     // FIXME I don't like having to do this test, as its only required
     // during the unit tests.
@@ -141,29 +148,29 @@ void Plant::TickOperation(const Operation & op, OpVector & res)
     if (m_location.m_loc != nullptr) {
         Eat eat_op;
         eat_op->setTo(m_location.m_loc->getId());
+        if (cycles > 1) {
+            // Let the container know how long it has been since we ate
+            Anonymous eat_arg;
+            eat_arg->setAttr("cycles", cycles);
+            eat_op->setArgs1(eat_arg);
+        }
         res.push_back(eat_op);
     }
 
-    // The update op will broadcast notification for all properties that
-    // are marked flag_unsent
-    Update update;
-    update->setTo(getId());
-    res.push_back(update);
-
-    StatusProperty * status = requirePropertyClass<StatusProperty>("status", 1);
+    StatusProperty * status = requirePropertySlot<StatusSlot>(1);
     double & new_status = status->data();
     status->setFlags(flag_unsent);
     if (m_nourishment <= 0) {
         debug(std::cout << "No nourishment; shrinking."
                         << std::endl << std::flush;);
-        new_status -= 0.1;
+        new_status -= 0.1 * cycles;
     } else {
-        new_status += 0.1;
+        new_status += 0.1 * cycles;
         if (new_status > 1.) {
             new_status = 1.;
         }
 
-        Property<double> * mass_prop = requirePropertyClass<Property<double> >("mass", 0.);
+        Property<double> * mass_prop = requirePropertySlot<MassSlot>(0.);
         double & mass = mass_prop->data();
         double old_mass = mass;
         mass += m_nourishment;
@@ -218,7 +225,9 @@ void Plant::TickOperation(const Operation & op, OpVector & res)
             //Only drop fruits if we're an adult
             if (m_location.bBox().isValid() &&
                     (m_location.bBox().highCorner().z() >= sizeAdult.asNum())) {
-                if (dropFruit(res, fruits_prop) != -1) {
+                int drop = dropFruit(res, fruits_prop);
+                if (drop != -1) {
+                    fruit_changed = drop > 0;
                     int & fruits = fruits_prop->data();
                     Element fruitChance;
 
@@ -227,12 +236,14 @@ void Plant::TickOperation(const Operation & op, OpVector & res)
                             fruits++;
                             fruits_prop->set(fruits);
                             fruits_prop->setFlags(flag_unsent);
+                            fruit_changed = true;
                         }
                     }
                 }
             }
         }
     }
+    return fruit_changed;
 }
 
 void Plant::TouchOperation(const Operation & op, OpVector & res)
@@ -31,8 +31,9 @@ class Property;
 /// for producing and dropping fruit very simply.
 ///
 /// The basic functionality of Plant is as follows:
-/// 1) The plant receives a tick operation. It checks it's m_nourishment value to see
-/// whether it should grow or wither.
+/// 1) The plant receives a tick operation, which adds it to the
+/// PlantGrowthSystem. Each growth cycle the system calls grow(), which checks
+/// it's m_nourishment value to see whether it should grow or wither.
 /// If the plant has fruitName set, it will also do a check whether it should drop a fruit or not.
 /// It also sends an Eat operation to it's parent.
 /// 2) If the parent is the world, the world will respond to the Eat operation by checking
@@ -59,6 +60,7 @@ class Plant : public Thing {
     static const int m_maxuDrop = 2; // max fruit dropped
 
     int dropFruit(OpVector & res, Property<int> * fruits_prop);
+    bool grow(OpVector & res, int cycles = 1);
     /**
      * If there's an area attached to the plant it will be scaled according to the radius of the bounding box.
      */
@@ -72,6 +74,8 @@ class Plant : public Thing {
     virtual void NourishOperation(const Operation &, OpVector &);
     virtual void TickOperation(const Operation &, OpVector &);
     virtual void TouchOperation(const Operation &, OpVector &);
+
+    friend class PlantGrowthSystem;
 };
 
 #endif // RULESETS_PLANT_H
@@ -0,0 +1,239 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#include "PlantGrowthSystem.h"
+
+#include "Plant.h"
+
+#include "common/const.h"
+#include "common/debug.h"
+#include "common/Monitors.h"
+#include "common/Variable.h"
+#include "common/Update.h"
+
+#include <wfmath/MersenneTwister.h>
+
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include <cmath>
+
+using Atlas::Objects::Operation::Update;
+
+static const bool debug_flag = false;
+
+const double PlantGrowthSystem::max_jitter = 10.;
+const double PlantGrowthSystem::visible_growth = 0.02;
+
+PlantGrowthSystem * PlantGrowthSystem::m_instance = 0;
+
+PlantGrowthSystem::PlantGrowthSystem() :
+      m_period(consts::basic_tick * Plant::m_speed + max_jitter / 2.),
+      m_cycleStart(-1.),
+      m_next(0),
+      m_removed(0),
+      m_entityCount(0),
+      m_updateCount(0)
+{
+    Monitors::instance()->watch("plant_growth_entities",
+                                new Variable<int>(m_entityCount));
+    Monitors::instance()->watch("plant_growth_updates",
+                                new Variable<int>(m_updateCount));
+}
+
+PlantGrowthSystem::~PlantGrowthSystem()
+{
+    std::vector<Plant *>::const_iterator I = m_members.begin();
+    std::vector<Plant *>::const_iterator Iend = m_members.end();
+    for (; I != Iend; ++I) {
+        if (*I != 0) {
+            (*I)->decRef();
+        }
+    }
+}
+
+PlantGrowthSystem * PlantGrowthSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new PlantGrowthSystem;
+    }
+    return m_instance;
+}
+
+void PlantGrowthSystem::del()
+{
+    delete m_instance;
+    m_instance = 0;
+}
+
+/// \brief Get the phase within each cycle at which a plant is grown
+///
+/// The phase is seeded from the ID of the plant, so it is always the same.
+/// A generator local to the call is used, so the global generator is
+/// not reseeded.
+double PlantGrowthSystem::phase(long intId)
+{
+    WFMath::MTRand rng(intId);
+    return rng.rand() * max_jitter;
+}
+
+/// \brief Get the height of a plant as seen by clients
+float PlantGrowthSystem::visibleHeight(const Plant & plant)
+{
+    const BBox & bbox = plant.m_location.bBox();
+    return bbox.isValid() ? bbox.highCorner().z() : 0.f;
+}
+
+/// \brief Grow one member, and send the operations it generates
+///
+/// An Update is added if the plant has changed visibly since it was last
+/// sent one. A plant which has just woken is grown by the cycles it
+/// missed while it was asleep as well.
+void PlantGrowthSystem::growMember(std::size_t index)
+{
+    Plant & plant = *m_members[index];
+    if (plant.getFlags() & entity_asleep) {
+        ++m_missed[index];
+        return;
+    }
+    bool fruit_changed = plant.grow(m_results, m_missed[index] + 1);
+    m_missed[index] = 0;
+
+    float height = visibleHeight(plant);
+    float & sent_height = m_sentHeights[index];
+    if (fruit_changed ||
+        std::fabs(height - sent_height) > sent_height * visible_growth) {
+        debug(std::cout << "Plant growth update for " << plant.getId()
+                        << std::endl << std::flush;);
+        sent_height = height;
+        // The update op will broadcast notification for all properties
+        // that are marked flag_unsent
+        Update update;
+        update->setTo(plant.getId());
+        m_results.push_back(update);
+        ++m_updateCount;
+    }
+
+    OpVector::const_iterator I = m_results.begin();
+    OpVector::const_iterator Iend = m_results.end();
+    for (; I != Iend; ++I) {
+        plant.sendWorld(*I);
+    }
+    m_results.clear();
+}
+
+/// \brief Remove the members which have been destroyed, keeping the rest
+/// in order of phase
+void PlantGrowthSystem::pruneMembers()
+{
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < m_members.size(); ++i) {
+        if (m_members[i] == 0) {
+            continue;
+        }
+        m_members[j] = m_members[i];
+        m_phases[j] = m_phases[i];
+        m_sentHeights[j] = m_sentHeights[i];
+        m_missed[j] = m_missed[i];
+        ++j;
+    }
+    m_members.resize(j);
+    m_phases.resize(j);
+    m_sentHeights.resize(j);
+    m_missed.resize(j);
+    m_removed = 0;
+}
+
+/// \brief Add a plant to be grown in batches
+///
+/// A plant added part way through a cycle is first grown in the next one.
+/// @return zero if the plant was added, or one if it was already being
+/// grown.
+int PlantGrowthSystem::addEntity(Plant * plant)
+{
+    double plant_phase = phase(plant->getIntId());
+    std::vector<double>::iterator I = std::lower_bound(m_phases.begin(),
+                                                       m_phases.end(),
+                                                       plant_phase);
+    std::size_t index = I - m_phases.begin();
+    for (std::size_t i = index; i < m_phases.size() &&
+                                m_phases[i] == plant_phase; ++i) {
+        if (m_members[i] == plant) {
+            return 1;
+        }
+    }
+    plant->incRef();
+    m_members.insert(m_members.begin() + index, plant);
+    m_phases.insert(I, plant_phase);
+    m_sentHeights.insert(m_sentHeights.begin() + index, visibleHeight(*plant));
+    m_missed.insert(m_missed.begin() + index, 0);
+    if (index < m_next) {
+        ++m_next;
+    }
+    ++m_entityCount;
+    return 0;
+}
+
+/// \brief Grow the members which have become due
+///
+/// @param time the current world time
+void PlantGrowthSystem::tick(double time)
+{
+    if (m_cycleStart < 0.) {
+        m_cycleStart = time;
+        return;
+    }
+    bool wrapped = false;
+    while (true) {
+        if (m_next >= m_members.size()) {
+            // Only start one new cycle per call, so a server which has
+            // fallen behind doesn't try to catch up.
+            if (wrapped || time < m_cycleStart + m_period) {
+                break;
+            }
+            wrapped = true;
+            if (m_removed > 0) {
+                pruneMembers();
+            }
+            m_cycleStart += m_period;
+            if (m_cycleStart + m_period <= time) {
+                m_cycleStart = time - m_period;
+            }
+            m_next = 0;
+            continue;
+        }
+        if (m_cycleStart + m_period + m_phases[m_next] > time) {
+            break;
+        }
+        Plant * plant = m_members[m_next];
+        if (plant != 0) {
+            if (plant->isDestroyed()) {
+                m_members[m_next] = 0;
+                ++m_removed;
+                --m_entityCount;
+                plant->decRef();
+            } else {
+                growMember(m_next);
+            }
+        }
+        ++m_next;
+    }
+}
@@ -0,0 +1,112 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef RULESETS_PLANT_GROWTH_SYSTEM_H
+#define RULESETS_PLANT_GROWTH_SYSTEM_H
+
+#include "common/OperationRouter.h"
+
+#include <vector>
+
+class Plant;
+
+/// \brief Advances the growth of all the plants in the world in batches
+///
+/// A Plant joins the system the first time it is sent a Tick, instead of
+/// scheduling a Tick of its own for each growth cycle. Each plant has a
+/// phase within the cycle which is derived from its ID, so plants keep the
+/// same jitter they had when they ticked themselves. A plant used to add
+/// its jitter to each of its own cycles, so the shared cycle includes the
+/// mean jitter, and plants grow at the same average rate. Members are kept
+/// in order of phase, so each call to tick() grows the contiguous run of
+/// members which have become due since the last call. An Update is only
+/// sent for a plant when the height of its bbox has changed visibly since
+/// it was last sent one, or when its fruit has changed. Fruit dropped in a
+/// pass is created by the same batch of operations. Members which are
+/// asleep are skipped, and grown by all the cycles they missed in one step
+/// once they wake.
+class PlantGrowthSystem {
+  public:
+    /// \brief Largest phase offset given to a plant, in seconds
+    static const double max_jitter;
+    /// \brief Smallest relative change in height which is broadcast
+    static const double visible_growth;
+  protected:
+    static PlantGrowthSystem * m_instance;
+
+    /// \brief Plants grown by the system, in order of phase
+    std::vector<Plant *> m_members;
+    /// \brief Phase of each member within the cycle
+    std::vector<double> m_phases;
+    /// \brief Height of each member's bbox when it was last sent an Update
+    std::vector<float> m_sentHeights;
+    /// \brief Number of cycles each member has missed while asleep
+    std::vector<int> m_missed;
+    /// \brief Operations generated by the member being grown
+    OpVector m_results;
+    /// \brief World time in seconds between cycles of each plant, including
+    /// the mean jitter
+    double m_period;
+    /// \brief World time at which the current cycle started
+    double m_cycleStart;
+    /// \brief Index of the next member to be grown in the current cycle
+    std::size_t m_next;
+    /// \brief Number of members which have been destroyed
+    std::size_t m_removed;
+    /// \brief Number of plants grown by the system
+    int m_entityCount;
+    /// \brief Number of Update operations sent by the system
+    int m_updateCount;
+
+    PlantGrowthSystem();
+
+    static float visibleHeight(const Plant &);
+
+    void growMember(std::size_t index);
+    void pruneMembers();
+  public:
+    ~PlantGrowthSystem();
+
+    static PlantGrowthSystem * instance();
+    static void del();
+
+    static double phase(long intId);
+
+    /// \brief Read only accessor for the number of plants grown
+    int entityCount() const {
+        return m_entityCount;
+    }
+
+    /// \brief Read only accessor for the number of Updates sent
+    int updateCount() const {
+        return m_updateCount;
+    }
+
+    /// \brief Read only accessor for the time between cycles
+    double period() const {
+        return m_period;
+    }
+
+    int addEntity(Plant *);
+    void tick(double time);
+
+    friend class PlantGrowthSystemtest;
+};
+
+#endif // RULESETS_PLANT_GROWTH_SYSTEM_H
@@ -0,0 +1,51 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef RULESETS_PROPERTY_SLOTS_H
+#define RULESETS_PROPERTY_SLOTS_H
+
+#include "common/PropertyKey.h"
+
+class BBoxProperty;
+class StatusProperty;
+class TasksProperty;
+
+template <typename T>
+class Property;
+
+/// \brief Compile time description of a built-in property kept in a
+/// fixed slot of each PropertyDict
+///
+/// Used with LocatedEntity::getPropertySlot and related accessors, which
+/// reach the property by indexing its slot rather than searching by name.
+template <class PropertyT, PropertyKey::Fixed Key>
+class PropertySlot {
+  public:
+    typedef PropertyT type;
+    static const PropertyKey::Fixed key = Key;
+};
+
+typedef PropertySlot<StatusProperty, PropertyKey::STATUS> StatusSlot;
+typedef PropertySlot<Property<double>, PropertyKey::MASS> MassSlot;
+typedef PropertySlot<Property<double>, PropertyKey::FOOD> FoodSlot;
+typedef PropertySlot<Property<double>, PropertyKey::STAMINA> StaminaSlot;
+typedef PropertySlot<TasksProperty, PropertyKey::TASKS> TasksSlot;
+typedef PropertySlot<BBoxProperty, PropertyKey::BBOX> BBoxSlot;
+
+#endif // RULESETS_PROPERTY_SLOTS_H
@@ -17,6 +17,7 @@
 
 
 #include "Py_Message.h"
+#include "Py_MessageMap.h"
 #include "Py_Operation.h"
 #include "Py_Oplist.h"
 #include "Py_Location.h"
@@ -86,10 +87,43 @@ static PyMethodDef Message_methods[] = {
 
 static void Message_dealloc(PyMessage *self)
 {
-    delete self->m_obj;
+    if (self->m_owner != NULL) {
+        Py_DECREF(self->m_owner);
+    } else {
+        delete self->m_obj;
+    }
     self->ob_type->tp_free((PyObject*)self);
 }
 
+/// \brief Get an object which owns the data of this message, so it can
+/// be shared with views of the data
+///
+/// If this message owns its data, ownership is passed to a new hidden
+/// message, which is never modified.
+static PyObject * Message_shareData(PyMessage * self)
+{
+    if (self->m_owner == NULL) {
+        PyMessage * owner = newPyMessage();
+        if (owner == NULL) {
+            return NULL;
+        }
+        owner->m_obj = self->m_obj;
+        self->m_owner = (PyObject *)owner;
+    }
+    return self->m_owner;
+}
+
+/// \brief Make sure this message has its own copy of its data before
+/// the data is modified
+static void Message_unshareData(PyMessage * self)
+{
+    if (self->m_owner != NULL) {
+        self->m_obj = new Element(*self->m_obj);
+        Py_DECREF(self->m_owner);
+        self->m_owner = NULL;
+    }
+}
+
 static PyObject * Message_repr(PyMessage *self)
 {
 #ifndef NDEBUG
@@ -120,7 +154,14 @@ static PyObject * Message_getattro(PyMessage *self, PyObject *oname)
         const MapType & omap = self->m_obj->asMap();
         MapType::const_iterator I = omap.find(name);
         if (I != omap.end()) {
-            return MessageElement_asPyObject(I->second);
+            if (!I->second.isMap() && !I->second.isList()) {
+                return MessageElement_asPyObject(I->second);
+            }
+            PyObject * owner = Message_shareData(self);
+            if (owner == NULL) {
+                return NULL;
+            }
+            return MessageElement_asPyView(I->second, owner);
         }
     }
     return PyObject_GenericGetAttr((PyObject *)self, oname);
@@ -138,6 +179,7 @@ static int Message_setattro(PyMessage *self, PyObject *oname, PyObject *v)
     log(WARNING, String::compose("Setting \"%1\" attribute on an Atlas Message",
                                  name));
     if (self->m_obj->isMap()) {
+        Message_unshareData(self);
         MapType & omap = self->m_obj->asMap();
         Element v_obj;
         if (PyObject_asMessageElement(v, v_obj) == 0) {
@@ -197,6 +239,7 @@ static int Message_init(PyMessage * self, PyObject * args, PyObject * kwds)
     if (!PyArg_ParseTuple(args, "|O", &arg)) {
         return -1;
     }
+    Py_CLEAR(self->m_owner);
     self->m_obj = new Element();
     if (arg == 0) {
         return 0;
@@ -260,6 +303,24 @@ PyMessage * newPyMessage()
     return (PyMessage *)PyMessage_Type.tp_new(&PyMessage_Type, 0, 0);
 }
 
+/// \brief Create a Message which shares Atlas data owned by another object
+///
+/// The data is not copied unless the Message is modified.
+/// @param obj the data to be wrapped
+/// @param owner Python object which keeps obj valid while it is referenced
+PyMessage * newPySharedMessage(const Element & obj, PyObject * owner)
+{
+    PyMessage * ret = newPyMessage();
+    if (ret != NULL) {
+        // The data is only modified after Message_unshareData has made
+        // a private copy
+        ret->m_obj = const_cast<Element *>(&obj);
+        Py_INCREF(owner);
+        ret->m_owner = owner;
+    }
+    return ret;
+}
+
 /*
  * Utility functions to munge between Object related types and python types
  */
@@ -330,6 +391,62 @@ PyObject * MessageElement_asPyObject(const Element & obj)
     return ret;
 }
 
+/// \brief Convert Atlas data to Python, sharing the data where possible
+///
+/// Maps become views which wrap items as they are looked up, and lists
+/// become lists of Messages which share the data of the items, so the
+/// data is not copied until it is modified.
+/// @param obj the data to be converted
+/// @param owner Python object which keeps obj valid while it is referenced
+PyObject * MessageElement_asPyView(const Element & obj, PyObject * owner)
+{
+    if (obj.isMap()) {
+        return (PyObject *)newPyMessageMap(obj.Map(), owner);
+    }
+    if (obj.isList()) {
+        const ListType & list = obj.List();
+        PyObject * ret = PyList_New(list.size());
+        if (ret == NULL) {
+            return NULL;
+        }
+        for (ListType::size_type i = 0; i < list.size(); ++i) {
+            PyMessage * item = newPySharedMessage(list[i], owner);
+            if (item == NULL) {
+                Py_DECREF(ret);
+                return NULL;
+            }
+            PyList_SET_ITEM(ret, i, (PyObject *)item);
+        }
+        return ret;
+    }
+    return MessageElement_asPyObject(obj);
+}
+
+/// \brief Convert Atlas data to Python, taking over the data
+///
+/// The contents of a map or list are moved into a new owner without being
+/// copied, and obj is left empty.
+PyObject * MessageElement_takePyView(Element & obj)
+{
+    if (!obj.isMap() && !obj.isList()) {
+        return MessageElement_asPyObject(obj);
+    }
+    PyMessage * owner = newPyMessage();
+    if (owner == NULL) {
+        return NULL;
+    }
+    if (obj.isMap()) {
+        owner->m_obj = new Element(MapType());
+        owner->m_obj->Map().swap(obj.Map());
+    } else {
+        owner->m_obj = new Element(ListType());
+        owner->m_obj->List().swap(obj.List());
+    }
+    PyObject * ret = MessageElement_asPyView(*owner->m_obj, (PyObject *)owner);
+    Py_DECREF(owner);
+    return ret;
+}
+
 int PyListObject_asElement(PyObject * list, ListType & res)
 {
     PyMessage * item;
@@ -420,6 +537,10 @@ int PyObject_asMessageElement(PyObject * o, Element & res, bool simple)
         res = *(obj->m_obj);
         return 0;
     }
+    if (PyMessageMap_Check(o)) {
+        res = MapType();
+        return PyMessageMap_asElement((PyMessageMap *)o, res.Map());
+    }
     if (PyOperation_Check(o)) {
         PyOperation * op = (PyOperation *)o;
         res = op->operation->asMessage();
@@ -39,6 +39,9 @@ typedef struct {
     PyObject_HEAD
     /// \brief Atlas::Message::Element object handled by this wrapper
     Atlas::Message::Element * m_obj;
+    /// \brief Python object which owns m_obj if it is shared, or NULL
+    /// if this wrapper owns it
+    PyObject * m_owner;
 } PyMessage;
 
 extern PyTypeObject PyMessage_Type;
@@ -50,6 +53,8 @@ extern PyTypeObject PyMessage_Type;
 //
 
 PyMessage * newPyMessage();
+PyMessage * newPySharedMessage(const Atlas::Message::Element & obj,
+                               PyObject * owner);
 
 //
 // Utility functions to munge between Object related types and python types
@@ -57,6 +62,9 @@ PyMessage * newPyMessage();
 
 
 PyObject * MessageElement_asPyObject(const Atlas::Message::Element & obj);
+PyObject * MessageElement_asPyView(const Atlas::Message::Element & obj,
+                                   PyObject * owner);
+PyObject * MessageElement_takePyView(Atlas::Message::Element & obj);
 int PyObject_asMessageElement(PyObject * o,
                               Atlas::Message::Element & res,
                               bool simple = false);
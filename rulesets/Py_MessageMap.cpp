@@ -0,0 +1,433 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "Py_MessageMap.h"
+
+#include "Py_Message.h"
+
+#include <Atlas/Message/Element.h>
+
+using Atlas::Message::Element;
+using Atlas::Message::MapType;
+
+#if PY_VERSION_HEX < 0x02050000
+typedef int Py_ssize_t;
+#endif
+
+/*
+ * Beginning of MessageMap section.
+ *
+ * Each item is wrapped as a Message which shares the Atlas data, just as
+ * the items of a dict converted from an Atlas map are wrapped as Messages.
+ * Until a script does anything other than read from the view, m_cache
+ * holds only the items which have been looked up. Once every item has been
+ * wrapped m_cache is a complete dict, and from then on the view is just
+ * a proxy for it.
+ */
+
+static int MessageMap_complete(PyMessageMap * self)
+{
+    if (self->m_complete) {
+        return 0;
+    }
+    if (self->m_cache == NULL) {
+        self->m_cache = PyDict_New();
+        if (self->m_cache == NULL) {
+            return -1;
+        }
+    }
+    MapType::const_iterator I = self->m_map->begin();
+    MapType::const_iterator Iend = self->m_map->end();
+    for (; I != Iend; ++I) {
+        char * key = (char *)I->first.c_str();
+        if (PyDict_GetItemString(self->m_cache, key) != NULL) {
+            continue;
+        }
+        PyObject * item = (PyObject *)newPySharedMessage(I->second,
+                                                         self->m_owner);
+        if (item == NULL) {
+            return -1;
+        }
+        int ret = PyDict_SetItemString(self->m_cache, key, item);
+        Py_DECREF(item);
+        if (ret != 0) {
+            return -1;
+        }
+    }
+    self->m_complete = true;
+    return 0;
+}
+
+/// \brief Find the wrapped item for a key, wrapping it if required
+///
+/// @return a borrowed reference to the item, or NULL if the key is not
+/// present or an error occured
+static PyObject * MessageMap_lookup(PyMessageMap * self, PyObject * key)
+{
+    if (self->m_complete || !PyString_Check(key)) {
+        if (MessageMap_complete(self) != 0) {
+            return NULL;
+        }
+        return PyDict_GetItem(self->m_cache, key);
+    }
+    if (self->m_cache == NULL) {
+        self->m_cache = PyDict_New();
+        if (self->m_cache == NULL) {
+            return NULL;
+        }
+    } else {
+        PyObject * item = PyDict_GetItem(self->m_cache, key);
+        if (item != NULL) {
+            return item;
+        }
+    }
+    MapType::const_iterator I = self->m_map->find(PyString_AS_STRING(key));
+    if (I == self->m_map->end()) {
+        return NULL;
+    }
+    PyObject * item = (PyObject *)newPySharedMessage(I->second,
+                                                     self->m_owner);
+    if (item == NULL) {
+        return NULL;
+    }
+    int ret = PyDict_SetItem(self->m_cache, key, item);
+    // The cache now holds the reference
+    Py_DECREF(item);
+    if (ret != 0) {
+        return NULL;
+    }
+    return item;
+}
+
+/// \brief Check whether the data seen through the view is still the
+/// Atlas data it was created from
+static bool MessageMap_unchanged(PyMessageMap * self)
+{
+    if (self->m_modified) {
+        return false;
+    }
+    if (self->m_cache == NULL) {
+        return true;
+    }
+    Py_ssize_t pos = 0;
+    PyObject * key, * value;
+    while (PyDict_Next(self->m_cache, &pos, &key, &value)) {
+        // A shared Message takes a copy of the data if it is modified
+        if (!PyMessage_Check(value)) {
+            return false;
+        }
+        MapType::const_iterator I = self->m_map->find(PyString_AsString(key));
+        if (I == self->m_map->end() ||
+            ((PyMessage *)value)->m_obj != &I->second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static PyObject * MessageMap_keys(PyMessageMap * self)
+{
+    if (self->m_complete) {
+        return PyDict_Keys(self->m_cache);
+    }
+    PyObject * keys = PyList_New(self->m_map->size());
+    if (keys == NULL) {
+        return NULL;
+    }
+    Py_ssize_t i = 0;
+    MapType::const_iterator I = self->m_map->begin();
+    MapType::const_iterator Iend = self->m_map->end();
+    for (; I != Iend; ++I, ++i) {
+        PyObject * key = PyString_FromStringAndSize(I->first.data(),
+                                                    I->first.size());
+        if (key == NULL) {
+            Py_DECREF(keys);
+            return NULL;
+        }
+        PyList_SET_ITEM(keys, i, key);
+    }
+    return keys;
+}
+
+static PyObject * MessageMap_values(PyMessageMap * self)
+{
+    if (MessageMap_complete(self) != 0) {
+        return NULL;
+    }
+    return PyDict_Values(self->m_cache);
+}
+
+static PyObject * MessageMap_items(PyMessageMap * self)
+{
+    if (MessageMap_complete(self) != 0) {
+        return NULL;
+    }
+    return PyDict_Items(self->m_cache);
+}
+
+static PyObject * MessageMap_get(PyMessageMap * self, PyObject * args)
+{
+    PyObject * key;
+    PyObject * def = Py_None;
+    if (!PyArg_UnpackTuple(args, "get", 1, 2, &key, &def)) {
+        return NULL;
+    }
+    PyObject * item = MessageMap_lookup(self, key);
+    if (item == NULL) {
+        if (PyErr_Occurred()) {
+            return NULL;
+        }
+        item = def;
+    }
+    Py_INCREF(item);
+    return item;
+}
+
+static int MessageMap_contains(PyMessageMap * self, PyObject * key)
+{
+    if (self->m_complete || !PyString_Check(key)) {
+        if (MessageMap_complete(self) != 0) {
+            return -1;
+        }
+        return PyDict_Contains(self->m_cache, key);
+    }
+    if (self->m_map->find(PyString_AS_STRING(key)) != self->m_map->end()) {
+        return 1;
+    }
+    return 0;
+}
+
+static PyObject * MessageMap_has_key(PyMessageMap * self, PyObject * key)
+{
+    int ret = MessageMap_contains(self, key);
+    if (ret < 0) {
+        return NULL;
+    }
+    return PyBool_FromLong(ret);
+}
+
+static PyMethodDef MessageMap_methods[] = {
+    {"keys",            (PyCFunction)MessageMap_keys,           METH_NOARGS},
+    {"values",          (PyCFunction)MessageMap_values,         METH_NOARGS},
+    {"items",           (PyCFunction)MessageMap_items,          METH_NOARGS},
+    {"get",             (PyCFunction)MessageMap_get,            METH_VARARGS},
+    {"has_key",         (PyCFunction)MessageMap_has_key,        METH_O},
+    {NULL,              NULL}           /* sentinel */
+};
+
+/*
+ * MessageMap mapping methods.
+ */
+
+static Py_ssize_t MessageMap_length(PyMessageMap * self)
+{
+    if (self->m_complete) {
+        return PyDict_Size(self->m_cache);
+    }
+    return self->m_map->size();
+}
+
+static PyObject * MessageMap_subscript(PyMessageMap * self, PyObject * key)
+{
+    PyObject * item = MessageMap_lookup(self, key);
+    if (item == NULL) {
+        if (!PyErr_Occurred()) {
+            PyErr_SetObject(PyExc_KeyError, key);
+        }
+        return NULL;
+    }
+    Py_INCREF(item);
+    return item;
+}
+
+static int MessageMap_ass_subscript(PyMessageMap * self,
+                                    PyObject * key,
+                                    PyObject * v)
+{
+    if (MessageMap_complete(self) != 0) {
+        return -1;
+    }
+    self->m_modified = true;
+    if (v == NULL) {
+        return PyDict_DelItem(self->m_cache, key);
+    }
+    return PyDict_SetItem(self->m_cache, key, v);
+}
+
+static PyMappingMethods MessageMap_as_mapping = {
+    (lenfunc)MessageMap_length,                 // mp_length
+    (binaryfunc)MessageMap_subscript,           // mp_subscript
+    (objobjargproc)MessageMap_ass_subscript     // mp_ass_subscript
+};
+
+static PySequenceMethods MessageMap_as_sequence = {
+    0,                                          // sq_length
+    0,                                          // sq_concat
+    0,                                          // sq_repeat
+    0,                                          // sq_item
+    0,                                          // sq_slice
+    0,                                          // sq_ass_item
+    0,                                          // sq_ass_slice
+    (objobjproc)MessageMap_contains,            // sq_contains
+    0,                                          // sq_inplace_concat
+    0                                           // sq_inplace_repeat
+};
+
+/*
+ * Beginning of MessageMap standard methods section.
+ */
+
+static void MessageMap_dealloc(PyMessageMap * self)
+{
+    Py_XDECREF(self->m_cache);
+    Py_XDECREF(self->m_owner);
+    self->ob_type->tp_free((PyObject*)self);
+}
+
+static PyObject * MessageMap_repr(PyMessageMap * self)
+{
+    if (MessageMap_complete(self) != 0) {
+        return NULL;
+    }
+    return PyObject_Repr(self->m_cache);
+}
+
+static PyObject * MessageMap_getattro(PyMessageMap * self, PyObject * oname)
+{
+    PyObject * ret = PyObject_GenericGetAttr((PyObject *)self, oname);
+    if (ret != NULL || !PyErr_ExceptionMatches(PyExc_AttributeError)) {
+        return ret;
+    }
+    PyErr_Clear();
+    // Any other dict method is used on a complete dict, and might modify it
+    if (MessageMap_complete(self) != 0) {
+        return NULL;
+    }
+    self->m_modified = true;
+    return PyObject_GetAttr(self->m_cache, oname);
+}
+
+static PyObject * MessageMap_richcompare(PyMessageMap * self,
+                                         PyObject * other,
+                                         int op)
+{
+    if (MessageMap_complete(self) != 0) {
+        return NULL;
+    }
+    if (PyMessageMap_Check(other)) {
+        PyMessageMap * other_map = (PyMessageMap *)other;
+        if (MessageMap_complete(other_map) != 0) {
+            return NULL;
+        }
+        other = other_map->m_cache;
+    }
+    return PyObject_RichCompare(self->m_cache, other, op);
+}
+
+static PyObject * MessageMap_iter(PyMessageMap * self)
+{
+    PyObject * keys = MessageMap_keys(self);
+    if (keys == NULL) {
+        return NULL;
+    }
+    PyObject * iter = PyObject_GetIter(keys);
+    Py_DECREF(keys);
+    return iter;
+}
+
+PyTypeObject PyMessageMap_Type = {
+        PyObject_HEAD_INIT(&PyType_Type)
+        0,                              /*ob_size*/
+        "atlas.MessageMap",             /*tp_name*/
+        sizeof(PyMessageMap),           /*tp_basicsize*/
+        0,                              /*tp_itemsize*/
+        /* methods */
+        (destructor)MessageMap_dealloc, /*tp_dealloc*/
+        0,                              /*tp_print*/
+        0,                              /*tp_getattr*/
+        0,                              /*tp_setattr*/
+        0,                              /*tp_compare*/
+        (reprfunc)MessageMap_repr,      /*tp_repr*/
+        0,                              /*tp_as_number*/
+        &MessageMap_as_sequence,        /*tp_as_sequence*/
+        &MessageMap_as_mapping,         /*tp_as_mapping*/
+        0,                              /*tp_hash*/
+        0,                              // tp_call
+        0,                              // tp_str
+        (getattrofunc)MessageMap_getattro,// tp_getattro
+        0,                              // tp_setattro
+        0,                              // tp_as_buffer
+        Py_TPFLAGS_DEFAULT,             // tp_flags
+        "MessageMap objects",           // tp_doc
+        0,                              // tp_travers
+        0,                              // tp_clear
+        (richcmpfunc)MessageMap_richcompare,// tp_richcompare
+        0,                              // tp_weaklistoffset
+        (getiterfunc)MessageMap_iter,   // tp_iter
+        0,                              // tp_iternext
+        MessageMap_methods,             // tp_methods
+        0,                              // tp_members
+        0,                              // tp_getset
+        0,                              // tp_base
+        0,                              // tp_dict
+        0,                              // tp_descr_get
+        0,                              // tp_descr_set
+        0,                              // tp_dictoffset
+        0,                              // tp_init
+        0,                              // tp_alloc
+        0,                              // tp_new
+};
+
+/*
+ * Beginning of MessageMap creation functions section.
+ */
+
+/// \brief Create a view of an Atlas map
+///
+/// @param map the map to be viewed
+/// @param owner Python object which keeps map valid while it is referenced
+PyMessageMap * newPyMessageMap(const MapType & map, PyObject * owner)
+{
+    PyMessageMap * self = (PyMessageMap *)PyMessageMap_Type.tp_alloc(&PyMessageMap_Type, 0);
+    if (self != NULL) {
+        Py_INCREF(owner);
+        self->m_owner = owner;
+        self->m_map = &map;
+        self->m_cache = NULL;
+        self->m_complete = false;
+        self->m_modified = false;
+    }
+    return self;
+}
+
+/// \brief Convert the data seen through a view back into an Atlas map
+///
+/// If nothing has been modified the Atlas data is copied directly,
+/// without looking at the wrapped items.
+int PyMessageMap_asElement(PyMessageMap * view, MapType & res)
+{
+    if (MessageMap_unchanged(view)) {
+        res = *view->m_map;
+        return 0;
+    }
+    if (MessageMap_complete(view) != 0) {
+        PyErr_Clear();
+        return -1;
+    }
+    return PyDictObject_asElement(view->m_cache, res);
+}
@@ -0,0 +1,65 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef RULESETS_PY_MESSAGE_MAP_H
+#define RULESETS_PY_MESSAGE_MAP_H
+
+#include <Python.h>
+
+#include <map>
+#include <string>
+
+namespace Atlas {
+    namespace Message {
+        class Element;
+        typedef std::map<std::string, Element> MapType;
+    }
+}
+
+/// \brief View of an Atlas map in Python which converts items on access
+/// \ingroup PythonWrappers
+///
+/// Items are wrapped only when a script looks them up, and they share the
+/// Atlas data rather than copying it, so reading one key of a large
+/// message does not convert the rest of it. Any operation the view does
+/// not handle itself, including every kind of modification, first wraps
+/// all the items in a real dict and is then passed on to it.
+typedef struct {
+    PyObject_HEAD
+    /// \brief Python object which owns the Atlas data
+    PyObject * m_owner;
+    /// \brief Atlas map handled by this view
+    const Atlas::Message::MapType * m_map;
+    /// \brief Items wrapped so far
+    PyObject * m_cache;
+    /// \brief Flag indicating that every item has been wrapped
+    bool m_complete;
+    /// \brief Flag indicating that the wrapped items may have been changed
+    bool m_modified;
+} PyMessageMap;
+
+extern PyTypeObject PyMessageMap_Type;
+
+#define PyMessageMap_Check(_o) ((_o)->ob_type == &PyMessageMap_Type)
+
+PyMessageMap * newPyMessageMap(const Atlas::Message::MapType & map,
+                               PyObject * owner);
+int PyMessageMap_asElement(PyMessageMap * view,
+                           Atlas::Message::MapType & res);
+
+#endif // RULESETS_PY_MESSAGE_MAP_H
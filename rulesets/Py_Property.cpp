@@ -36,18 +36,15 @@ PyObject * Property_asPyObject(PropertyBase * property, Entity * owner)
             PyObject * o = script->script();
             Py_INCREF(o);
             return o;
-        } else {
-            log(ERROR, "Unexpected non-python Statistics script");
-            // FIXME Do we need PyStatisticsProperty for this kind of thing?
-            // PyStatistics * ps = newPyStatistics();
-            // if (ps == NULL) {
-                // return NULL;
-            // }
-            // ps->m_entity = owner;
-            // return (PyObject*)ps;
-            Py_INCREF(Py_None);
-            return Py_None;
         }
+        // Statistics calculated natively get a wrapper which asks the
+        // model for each value.
+        PyProperty * prop = newPyStatisticsProperty();
+        if (prop != NULL) {
+            prop->m_entity = owner;
+            prop->m_p.statistics = sp;
+        }
+        return (PyObject*)prop;
     }
     TerrainProperty * tp = dynamic_cast<TerrainProperty *>(property);
     if (tp != 0) {
@@ -39,15 +39,19 @@ typedef struct {
     /// \brief Property object handled by this wrapper
     union {
         PropertyBase * base;
+        StatisticsProperty * statistics;
         TerrainProperty * terrain;
         TerrainModProperty * terrainmod;
     } m_p;
 } PyProperty;
 
 extern PyTypeObject PyProperty_Type;
+extern PyTypeObject PyStatisticsProperty_Type;
 extern PyTypeObject PyTerrainProperty_Type;
 extern PyTypeObject PyTerrainModProperty_Type;
 
+#define PyStatisticsProperty_Check(_o) PyObject_TypeCheck(_o, &PyStatisticsProperty_Type)
+
 #define PyTerrainProperty_Check(_o) PyObject_TypeCheck(_o, &PyTerrainProperty_Type)
 #define PyTerrainProperty_CheckExact(_o) (Py_Type(_o) == &PyTerrainProperty_Type)
 
@@ -56,6 +60,7 @@ extern PyTypeObject PyTerrainModProperty_Type;
 
 PyObject * Property_asPyObject(PropertyBase * property, Entity * owner);
 
+PyProperty * newPyStatisticsProperty();
 PyProperty * newPyTerrainProperty();
 PyProperty * newPyTerrainModProperty();
 
@@ -95,7 +95,8 @@ static PyObject * RootEntity_getattro(PyRootEntity * self, PyObject * oname)
                 Py_INCREF(ret);
                 return ret;
             }
-            return MessageElement_asPyObject(attr);
+            // attr is a copy, so it can be handed over without copying
+            return MessageElement_takePyView(attr);
         }
     }
     return PyObject_GenericGetAttr((PyObject *)self, oname);
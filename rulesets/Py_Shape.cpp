@@ -20,6 +20,7 @@
 
 #include "Py_BBox.h"
 #include "Py_Message.h"
+#include "Py_MessageMap.h"
 #include "Py_Point3D.h"
 
 #include "common/log.h"
@@ -322,6 +323,19 @@ static int Shape_init(PyShape * self, PyObject * args, PyObject * kwds)
         }
         return 0;
     }
+    if (PyMessageMap_Check(arg)) {
+        MapType data;
+        if (PyMessageMap_asElement((PyMessageMap*)arg, data) != 0) {
+            PyErr_SetString(PyExc_TypeError, "Error converting dict to atlas");
+            return -1;
+        }
+        self->shape.s = Shape::newFromAtlas(data);
+        if (self->shape.s == 0) {
+            PyErr_SetString(PyExc_TypeError, "Error converting atlas to shape");
+            return -1;
+        }
+        return 0;
+    }
     if (PyMessage_Check(arg)) {
         Element * data = ((PyMessage*)arg)->m_obj;
         if (!data->isMap()) {
@@ -0,0 +1,114 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "Py_Property.h"
+
+#include "rulesets/ArithmeticScript.h"
+#include "rulesets/StatisticsProperty.h"
+
+static PyObject * StatisticsProperty_getattro(PyProperty * self,
+                                              PyObject * oname)
+{
+#ifndef NDEBUG
+    if (self->m_entity == NULL || self->m_p.statistics == NULL) {
+        PyErr_SetString(PyExc_AssertionError, "NULL entity in StatisticsProperty.getattr");
+        return NULL;
+    }
+#endif // NDEBUG
+    ArithmeticScript * script = self->m_p.statistics->script();
+    float val;
+    if (script != 0 && script->attribute(PyString_AsString(oname), val) == 0) {
+        return PyFloat_FromDouble(val);
+    }
+    return PyObject_GenericGetAttr((PyObject *)self, oname);
+}
+
+static int StatisticsProperty_setattro(PyProperty * self,
+                                       PyObject * oname,
+                                       PyObject * v)
+{
+#ifndef NDEBUG
+    if (self->m_entity == NULL || self->m_p.statistics == NULL) {
+        PyErr_SetString(PyExc_AssertionError, "NULL entity in StatisticsProperty.setattro");
+        return -1;
+    }
+#endif // NDEBUG
+    ArithmeticScript * script = self->m_p.statistics->script();
+    if (script == 0) {
+        PyErr_SetString(PyExc_AttributeError, "unknown attribute");
+        return -1;
+    }
+    if (v == NULL || !PyNumber_Check(v)) {
+        PyErr_SetString(PyExc_TypeError, "Statistics must be numeric");
+        return -1;
+    }
+    double val = PyFloat_AsDouble(v);
+    if (PyErr_Occurred() != NULL) {
+        return -1;
+    }
+    script->set(PyString_AsString(oname), val);
+    return 0;
+}
+
+PyTypeObject PyStatisticsProperty_Type = {
+        PyObject_HEAD_INIT(NULL)
+        0,                                                // ob_size
+        "StatisticsProperty",                             // tp_name
+        sizeof(PyProperty),                               // tp_basicsize
+        0,                                                // tp_itemsize
+        // methods 
+        0,                                                // tp_dealloc
+        0,                                                // tp_print
+        0,                                                // tp_getattr
+        0,                                                // tp_setattr
+        0,                                                // tp_compare
+        0,                                                // tp_repr
+        0,                                                // tp_as_number
+        0,                                                // tp_as_sequence
+        0,                                                // tp_as_mapping
+        0,                                                // tp_hash
+        0,                                                // tp_call
+        0,                                                // tp_str
+        (getattrofunc)StatisticsProperty_getattro,        // tp_getattro
+        (setattrofunc)StatisticsProperty_setattro,        // tp_setattro
+        0,                                                // tp_as_buffer
+        Py_TPFLAGS_DEFAULT,                               // tp_flags
+        "StatisticsProperty objects",                     // tp_doc
+        0,                                                // tp_travers
+        0,                                                // tp_clear
+        0,                                                // tp_richcompare
+        0,                                                // tp_weaklistoffset
+        0,                                                // tp_iter
+        0,                                                // tp_iternext
+        0,                                                // tp_methods
+        0,                                                // tp_members
+        0,                                                // tp_getset
+        0,                                                // tp_base
+        0,                                                // tp_dict
+        0,                                                // tp_descr_get
+        0,                                                // tp_descr_set
+        0,                                                // tp_dictoffset
+        0,                                                // tp_init
+        0,                                                // tp_alloc
+        0,                                                // tp_new
+};
+
+PyProperty * newPyStatisticsProperty()
+{
+    return (PyProperty *)PyStatisticsProperty_Type.tp_new(&PyStatisticsProperty_Type, 0, 0);
+}
@@ -40,9 +40,179 @@
 #include "common/TypeNode.h"
 #include "common/Inheritance.h"
 
+#include <map>
+
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
 
+/// \brief Attributes handled directly by the entity wrapper getattro
+/// functions
+enum EntityAttribute {
+    ATTR_ID,
+    ATTR_TYPE,
+    ATTR_LOCATION,
+    ATTR_CONTAINS,
+    ATTR_VISIBLE,
+    ATTR_MAP,
+    ATTR_TIME
+};
+
+static const struct {
+    const char * name;
+    EntityAttribute attr;
+} entity_attribute_names[] = {
+    { "id",             ATTR_ID },
+    { "type",           ATTR_TYPE },
+    { "location",       ATTR_LOCATION },
+    { "contains",       ATTR_CONTAINS },
+    { "visible",        ATTR_VISIBLE },
+    { "map",            ATTR_MAP },
+    { "time",           ATTR_TIME },
+    { 0,                ATTR_ID }
+};
+
+/// \brief Dictionary of interned attribute names to EntityAttribute values
+static PyObject * entity_attributes = 0;
+
+/// \brief Python strings of type names, keyed by type
+static std::map<const TypeNode *, PyObject *> type_names;
+
+/// \brief Find which of the directly handled attributes is being accessed
+///
+/// The names are looked up in a dictionary keyed by interned strings, so
+/// an access by a literal attribute name in Python code is resolved by
+/// hash and pointer comparison rather than a chain of string comparisons.
+/// @return the EntityAttribute value, or -1 if the name is not one of them
+static int entity_attribute(PyObject * oname)
+{
+    if (entity_attributes == 0) {
+        entity_attributes = PyDict_New();
+        if (entity_attributes == 0) {
+            PyErr_Clear();
+            return -1;
+        }
+        for (int i = 0; entity_attribute_names[i].name != 0; ++i) {
+            PyObject * attr = PyInt_FromLong(entity_attribute_names[i].attr);
+            PyDict_SetItemString(entity_attributes,
+                                 entity_attribute_names[i].name, attr);
+            Py_XDECREF(attr);
+        }
+    }
+    PyObject * attr = PyDict_GetItem(entity_attributes, oname);
+    if (attr == 0) {
+        return -1;
+    }
+    return PyInt_AS_LONG(attr);
+}
+
+/// \brief Get the cached Python string of the entity ID
+///
+/// @return a new reference to the ID string
+static PyObject * entity_id(PyEntity * self)
+{
+    if (self->m_id == 0) {
+        self->m_id = PyString_FromString(self->m_entity.l->getId().c_str());
+        if (self->m_id == 0) {
+            return 0;
+        }
+    }
+    Py_INCREF(self->m_id);
+    return self->m_id;
+}
+
+/// \brief Build the list returned for the type attribute of an entity
+///
+/// The Python string for the name of each type is created once, and
+/// shared between all the lists returned.
+static PyObject * entity_type(const TypeNode * type)
+{
+    PyObject * name = 0;
+    std::map<const TypeNode *, PyObject *>::iterator I = type_names.find(type);
+    if (I != type_names.end()) {
+        name = I->second;
+        // The type may have been replaced by a new one at the same address
+        if (type->name() != PyString_AS_STRING(name)) {
+            Py_DECREF(name);
+            type_names.erase(I);
+            name = 0;
+        }
+    }
+    if (name == 0) {
+        name = PyString_FromString(type->name().c_str());
+        if (name == 0) {
+            return 0;
+        }
+        type_names.insert(std::make_pair(type, name));
+    }
+    PyObject * list = PyList_New(1);
+    if (list == 0) {
+        return 0;
+    }
+    Py_INCREF(name);
+    PyList_SET_ITEM(list, 0, name);
+    return list;
+}
+
+static PyObject * entity_location(LocatedEntity * entity)
+{
+    PyLocation * loc = newPyLocation();
+    if (loc != NULL) {
+        loc->location = &entity->m_location;
+        loc->owner = entity;
+    }
+    return (PyObject *)loc;
+}
+
+static PyObject * entity_contains(LocatedEntity * entity)
+{
+    if (entity->m_contains == 0) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    PyObject * list = PyList_New(0);
+    if (list == NULL) {
+        return NULL;
+    }
+    LocatedEntitySet::const_iterator I = entity->m_contains->begin();
+    LocatedEntitySet::const_iterator Iend = entity->m_contains->end();
+    for (; I != Iend; ++I) {
+        LocatedEntity * child = *I;
+        PyObject * wrapper = wrapEntity(child);
+        if (wrapper == NULL) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_Append(list, wrapper);
+        Py_DECREF(wrapper);
+    }
+    return list;
+}
+
+/// \brief Convert a numeric property value to Python without building
+/// an Element
+///
+/// @return a new reference, or 0 if the property is not numeric
+static PyObject * numeric_property(const PropertyBase * prop)
+{
+    const Property<double> * dp = dynamic_cast<const Property<double> *>(prop);
+    if (dp != 0) {
+        return PyFloat_FromDouble(dp->data());
+    }
+    const Property<int> * ip = dynamic_cast<const Property<int> *>(prop);
+    if (ip != 0) {
+        return PyInt_FromLong(ip->data());
+    }
+    const Property<float> * fp = dynamic_cast<const Property<float> *>(prop);
+    if (fp != 0) {
+        return PyFloat_FromDouble(fp->data());
+    }
+    const Property<long> * lp = dynamic_cast<const Property<long> *>(prop);
+    if (lp != 0) {
+        return PyInt_FromLong(lp->data());
+    }
+    return 0;
+}
+
 static PyObject * Entity_as_entity(PyEntity * self)
 {
 #ifndef NDEBUG
@@ -165,6 +335,7 @@ static PyEntity * Entity_new(PyTypeObject * type,
     PyEntity * self = (PyEntity *)type->tp_alloc(type, 0);
     if (self != NULL) {
         self->m_weakreflist = NULL;
+        self->m_id = NULL;
     }
     return self;
 }
@@ -174,6 +345,7 @@ static void Entity_dealloc(PyEntity *self)
     if (self->m_weakreflist != NULL) {
         PyObject_ClearWeakRefs((PyObject *) self);
     }
+    Py_XDECREF(self->m_id);
 
     self->ob_type->tp_free((PyObject*)self);
 }
@@ -186,63 +358,37 @@ static PyObject * Entity_getattro(PyEntity *self, PyObject *oname)
         return NULL;
     }
 #endif // NDEBUG
-    char * name = PyString_AsString(oname);
     // If operation search gets to here, it goes no further
-    if (strcmp(name, "type") == 0) {
-        if (self->m_entity.e->getType() == NULL) {
-            PyErr_SetString(PyExc_AttributeError, name);
-            return NULL;
-        }
-        PyObject * list = PyList_New(0);
-        if (list == NULL) {
-            return NULL;
-        }
-        PyObject * ent = PyString_FromString(self->m_entity.e->getType()->name().c_str());
-        PyList_Append(list, ent);
-        Py_DECREF(ent);
-        return list;
-    }
-    if (strcmp(name, "location") == 0) {
-        PyLocation * loc = newPyLocation();
-        if (loc != NULL) {
-            loc->location = &self->m_entity.e->m_location;
-            loc->owner = self->m_entity.e;
-        }
-        return (PyObject *)loc;
-    }
-    if (strcmp(name, "contains") == 0) {
-        if (self->m_entity.e->m_contains == 0) {
-            Py_INCREF(Py_None);
-            return Py_None;
-        }
-        PyObject * list = PyList_New(0);
-        if (list == NULL) {
-            return NULL;
-        }
-        LocatedEntitySet::const_iterator I = self->m_entity.e->m_contains->begin();
-        LocatedEntitySet::const_iterator Iend = self->m_entity.e->m_contains->end();
-        for (; I != Iend; ++I) {
-            LocatedEntity * child = *I;
-            PyObject * wrapper = wrapEntity(child);
-            if (wrapper == NULL) {
-                Py_DECREF(list);
+    switch (entity_attribute(oname)) {
+        case ATTR_ID:
+            return entity_id(self);
+        case ATTR_TYPE:
+            if (self->m_entity.e->getType() == NULL) {
+                PyErr_SetObject(PyExc_AttributeError, oname);
                 return NULL;
             }
-            PyList_Append(list, wrapper);
-            Py_DECREF(wrapper);
-        }
-        return list;
-    }
-    if (strcmp(name, "visible") == 0) {
-        if (self->m_entity.e->isVisible()) {
-            Py_RETURN_TRUE;
-        }
-        Py_RETURN_FALSE;
+            return entity_type(self->m_entity.e->getType());
+        case ATTR_LOCATION:
+            return entity_location(self->m_entity.e);
+        case ATTR_CONTAINS:
+            return entity_contains(self->m_entity.e);
+        case ATTR_VISIBLE:
+            if (self->m_entity.e->isVisible()) {
+                Py_RETURN_TRUE;
+            }
+            Py_RETURN_FALSE;
+        default:
+            break;
     }
+    char * name = PyString_AsString(oname);
     Entity * entity = self->m_entity.e;
     PropertyBase * prop = entity->modProperty(name);
     if (prop != 0) {
-        PyObject * ret = Property_asPyObject(prop, entity);
+        PyObject * ret = numeric_property(prop);
+        if (ret != 0) {
+            return ret;
+        }
+        ret = Property_asPyObject(prop, entity);
         if (ret != 0) {
             return ret;
         }
@@ -402,70 +548,45 @@ static PyObject * Mind_getattro(PyEntity *self, PyObject *oname)
         return NULL;
     }
 #endif // NDEBUG
-    char * name = PyString_AsString(oname);
-    if (strcmp(name, "id") == 0) {
-        return (PyObject *)PyString_FromString(self->m_entity.m->getId().c_str());
-    }
-    if (strcmp(name, "type") == 0) {
-        if (self->m_entity.m->getType() == NULL) {
-            PyErr_SetString(PyExc_AttributeError, name);
-            return NULL;
-        }
-        PyObject * list = PyList_New(0);
-        if (list == NULL) {
-            return NULL;
-        }
-        PyObject * ent = PyString_FromString(self->m_entity.m->getType()->name().c_str());
-        PyList_Append(list, ent);
-        Py_DECREF(ent);
-        return list;
-    }
-    if (strcmp(name, "map") == 0) {
-        PyMap * map = newPyMap();
-        if (map != NULL) {
-            map->m_map = self->m_entity.m->getMap();
-        }
-        return (PyObject *)map;
-    }
-    if (strcmp(name, "location") == 0) {
-        PyLocation * loc = newPyLocation();
-        if (loc != NULL) {
-            loc->location = &self->m_entity.m->m_location;
-            loc->owner = self->m_entity.m;
-        }
-        return (PyObject *)loc;
-    }
-    if (strcmp(name, "time") == 0) {
-        PyWorldTime * worldtime = newPyWorldTime();
-        if (worldtime != NULL) {
-            worldtime->time = self->m_entity.m->getTime();
-        }
-        return (PyObject *)worldtime;
-    }
-    if (strcmp(name, "contains") == 0) {
-        if (self->m_entity.m->m_contains == 0) {
-            Py_INCREF(Py_None);
-            return Py_None;
-        }
-        PyObject * list = PyList_New(0);
-        if (list == NULL) {
-            return NULL;
-        }
-        LocatedEntitySet::const_iterator I = self->m_entity.m->m_contains->begin();
-        LocatedEntitySet::const_iterator Iend = self->m_entity.m->m_contains->end();
-        for (; I != Iend; ++I) {
-            LocatedEntity * child = *I;
-            PyObject * wrapper = wrapEntity(child);
-            if (wrapper == NULL) {
-                Py_DECREF(list);
+    switch (entity_attribute(oname)) {
+        case ATTR_ID:
+            return entity_id(self);
+        case ATTR_TYPE:
+            if (self->m_entity.m->getType() == NULL) {
+                PyErr_SetObject(PyExc_AttributeError, oname);
                 return NULL;
             }
-            PyList_Append(list, wrapper);
-            Py_DECREF(wrapper);
+            return entity_type(self->m_entity.m->getType());
+        case ATTR_MAP: {
+            PyMap * map = newPyMap();
+            if (map != NULL) {
+                map->m_map = self->m_entity.m->getMap();
+            }
+            return (PyObject *)map;
+        }
+        case ATTR_LOCATION:
+            return entity_location(self->m_entity.m);
+        case ATTR_TIME: {
+            PyWorldTime * worldtime = newPyWorldTime();
+            if (worldtime != NULL) {
+                worldtime->time = self->m_entity.m->getTime();
+            }
+            return (PyObject *)worldtime;
         }
-        return list;
+        case ATTR_CONTAINS:
+            return entity_contains(self->m_entity.m);
+        default:
+            break;
     }
+    char * name = PyString_AsString(oname);
     LocatedEntity * mind = self->m_entity.m;
+    const PropertyBase * prop = mind->getProperty(name);
+    if (prop != 0) {
+        PyObject * ret = numeric_property(prop);
+        if (ret != 0) {
+            return ret;
+        }
+    }
     Element attr;
     if (mind->getAttr(name, attr) == 0) {
         return MessageElement_asPyObject(attr);
@@ -482,6 +603,7 @@ static int Mind_setattro(PyEntity *self, PyObject *oname, PyObject *v)
             return -1;
         }
         self->m_entity.m = ((PyEntity*)v)->m_entity.m;
+        Py_CLEAR(self->m_id);
         return 0;
     }
 #ifndef NDEBUG
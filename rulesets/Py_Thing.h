@@ -39,6 +39,8 @@ typedef struct {
     } m_entity;
     /// \brief List of weak references
     PyObject * m_weakreflist;
+    /// \brief Cached Python string of the entity ID
+    PyObject * m_id;
 } PyEntity;
 
 extern PyTypeObject PyLocatedEntity_Type;
@@ -25,6 +25,8 @@
 #include "common/log.h"
 #include "common/compose.hpp"
 
+unsigned int PythonClass::m_generation = 0;
+
 /// \brief ScriptKit constructor
 /// 
 /// @param package name of the script package scripts are to be created from
@@ -117,5 +119,6 @@ int PythonClass::refresh()
                                      m_package, m_type));
         m_module = new_module;
     }
+    ++m_generation;
     return 0;
 }
@@ -41,12 +41,23 @@ class PythonClass {
                 const std::string & type,
                 struct _typeobject * base);
 
+    /// \brief Count of successful reloads of any script class
+    static unsigned int m_generation;
+
     int getClass(struct _object *);
     int load();
     int refresh();
 
   public:
     ~PythonClass();
+
+    /// \brief Generation which changes every time a script class is reloaded
+    ///
+    /// Code which caches anything looked up on script classes should
+    /// discard its cache when this changes.
+    static unsigned int generation() {
+        return m_generation;
+    }
 };
 
 #endif // RULESETS_PYTHON_CLASS_H
@@ -20,6 +20,7 @@
 
 #include "PythonEntityScript.h"
 
+#include "PythonClass.h"
 #include "Py_Operation.h"
 #include "Py_Oplist.h"
 #include "Py_Thing.h"
@@ -34,9 +35,116 @@
 #include <Atlas/Objects/RootOperation.h>
 
 #include <iostream>
+#include <map>
+#include <vector>
 
 static const bool debug_flag = false;
 
+/// \brief Cached result of looking up an operation handler on a script class
+struct OperationHandler {
+    /// \brief Interned name of the handler method
+    PyObject * m_name;
+    /// \brief Flag indicating whether the class defines the handler
+    bool m_present;
+};
+
+typedef std::map<std::string, OperationHandler> OperationHandlerDict;
+
+/// \brief Operation handlers looked up so far on one script class
+struct ScriptClassHandlers {
+    /// \brief Handlers keyed by the op_type passed to operation()
+    OperationHandlerDict m_byName;
+    /// \brief Handlers indexed by operation class number
+    std::vector<const OperationHandlerDict::value_type *> m_byNumber;
+};
+
+typedef std::map<PyTypeObject *, ScriptClassHandlers> ScriptClassDict;
+
+/// \brief Largest operation class number indexed directly
+static const int max_indexed_class_no = 1024;
+
+static ScriptClassDict script_class_handlers;
+static unsigned int script_class_generation = 0;
+
+static void flushScriptClassHandlers()
+{
+    ScriptClassDict::const_iterator I = script_class_handlers.begin();
+    ScriptClassDict::const_iterator Iend = script_class_handlers.end();
+    for (; I != Iend; ++I) {
+        OperationHandlerDict::const_iterator J = I->second.m_byName.begin();
+        OperationHandlerDict::const_iterator Jend = I->second.m_byName.end();
+        for (; J != Jend; ++J) {
+            Py_XDECREF(J->second.m_name);
+        }
+        Py_DECREF(I->first);
+    }
+    script_class_handlers.clear();
+}
+
+/// \brief Find the handler for an operation on the class of a script
+///
+/// The result of looking up op_type + "_operation" on the class is cached
+/// so that dispatching an operation to a script normally costs no string
+/// building and no attribute lookup in the class hierarchy. The cache holds
+/// a reference to each class it knows, and is discarded whenever any script
+/// class is reloaded.
+/// Handlers must be defined on the class. A handler assigned only on the
+/// instance is not found.
+/// @param script the script object the operation is for
+/// @param op_no class number of the operation
+/// @param op_type name of the operation as passed to operation()
+static const OperationHandler & findOperationHandler(PyObject * script,
+                                                     int op_no,
+                                                     const std::string & op_type)
+{
+    if (script_class_generation != PythonClass::generation()) {
+        flushScriptClassHandlers();
+        script_class_generation = PythonClass::generation();
+    }
+    PyTypeObject * type = Py_TYPE(script);
+    ScriptClassDict::iterator I = script_class_handlers.find(type);
+    if (I == script_class_handlers.end()) {
+        Py_INCREF(type);
+        I = script_class_handlers.insert(std::make_pair(type,
+                                                 ScriptClassHandlers())).first;
+    }
+    ScriptClassHandlers & handlers = I->second;
+    bool indexed = (op_no >= 0 && op_no < max_indexed_class_no);
+    if (indexed && op_no < (int)handlers.m_byNumber.size()) {
+        const OperationHandlerDict::value_type * entry = handlers.m_byNumber[op_no];
+        // Some callers pass a name which is not the operation type, such
+        // as "sight_move", so the name must be checked.
+        if (entry != 0 && entry->first == op_type) {
+            return entry->second;
+        }
+    }
+    OperationHandlerDict::iterator J = handlers.m_byName.find(op_type);
+    if (J == handlers.m_byName.end()) {
+        std::string op_name = op_type + "_operation";
+        OperationHandler handler;
+        handler.m_name = PyString_InternFromString(op_name.c_str());
+        if (handler.m_name == 0) {
+            PyErr_Clear();
+            handler.m_present = false;
+        } else {
+            handler.m_present = (_PyType_Lookup(type, handler.m_name) != 0);
+        }
+        debug( std::cout << "Looked up " << op_name << " on " << type->tp_name
+                         << ": " << handler.m_present
+                         << std::endl << std::flush;);
+        J = handlers.m_byName.insert(std::make_pair(op_type, handler)).first;
+    }
+    if (indexed) {
+        if (op_no >= (int)handlers.m_byNumber.size()) {
+            handlers.m_byNumber.resize(op_no + 1, 0);
+        }
+        if (handlers.m_byNumber[op_no] == 0) {
+            handlers.m_byNumber[op_no] = &*J;
+        }
+    }
+    return J->second;
+}
+
 /// \brief PythonEntityScript constructor
 PythonEntityScript::PythonEntityScript(PyObject * o) :
                     PythonWrapper(o)
@@ -52,32 +160,41 @@ bool PythonEntityScript::operation(const std::string & op_type,
                                    OpVector & res)
 {
     assert(m_wrapper != NULL);
-    std::string op_name = op_type + "_operation";
-    debug( std::cout << "Got script object for " << op_name << std::endl
-                                                            << std::flush;);
+    const OperationHandler & handler = findOperationHandler(m_wrapper,
+                                                            op->getClassNo(),
+                                                            op_type);
     // This check isn't really necessary, except it saves the conversion
     // time.
-    if (!PyObject_HasAttrString(m_wrapper, (char *)(op_name.c_str()))) {
-        debug( std::cout << "No method to be found for " << op_name
-                         << std::endl << std::flush;);
+    if (!handler.m_present) {
+        debug( std::cout << "No method to be found for " << op_type
+                         << "_operation" << std::endl << std::flush;);
+        return false;
+    }
+    PyObject * method = PyObject_GetAttr(m_wrapper, handler.m_name);
+    if (method == NULL) {
+        log(ERROR, String::compose("Python error finding \"%1_operation\"",
+                                   op_type));
+        PyErr_Print();
         return false;
     }
     // Construct apropriate python object thingies from op
     PyOperation * py_op = newPyConstOperation();
     if (py_op == 0) {
+        Py_DECREF(method);
         return false;
     }
     py_op->operation = op;
     PyObject * ret;
-    ret = PyObject_CallMethod(m_wrapper, (char *)(op_name.c_str()),
-                                            (char *)"(O)", py_op);
+    ret = PyObject_CallFunctionObjArgs(method, py_op, NULL);
+    Py_DECREF(method);
     Py_DECREF(py_op);
     if (ret == NULL) {
         if (PyErr_Occurred() == NULL) {
             debug( std::cout << "No method to be found for " << std::endl
                              << std::flush;);
         } else {
-            log(ERROR, String::compose("Python error calling \"%1\"", op_name));
+            log(ERROR, String::compose("Python error calling \"%1_operation\"",
+                                       op_type));
             PyErr_Print();
             if (op->getClassNo() == Atlas::Objects::Operation::TICK_NO) {
                 log(ERROR,
@@ -89,7 +206,7 @@ bool PythonEntityScript::operation(const std::string & op_type,
         }
         return false;
     }
-    debug( std::cout << "Called python method " << op_name
+    debug( std::cout << "Called python method " << op_type << "_operation"
                      << std::endl << std::flush;);
     if (ret == Py_None) {
         debug(std::cout << "Returned none" << std::endl << std::flush;);
@@ -106,8 +223,8 @@ bool PythonEntityScript::operation(const std::string & op_type,
             res.push_back(*I);
         }
     } else {
-        log(ERROR, String::compose("Python script \"%1\" returned an invalid "
-                                   "result.", op_name));
+        log(ERROR, String::compose("Python script \"%1_operation\" returned "
+                                   "an invalid result.", op_type));
     }
     
     Py_DECREF(ret);
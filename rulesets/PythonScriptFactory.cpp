@@ -24,6 +24,7 @@
 #include "rulesets/Py_Task.h"
 #include "rulesets/Python_Script_Utils.h"
 #include "rulesets/PythonEntityScript.h"
+#include "rulesets/PythonTickSystem.h"
 
 #include "rulesets/BaseMind.h"
 #include "rulesets/Task.h"
@@ -54,6 +55,24 @@ PythonScriptFactory<BaseMind>::PythonScriptFactory(const std::string & package,
 {
 }
 
+/// \brief Add an entity to the batched tick of its script class, if any
+template<>
+void PythonScriptFactory<LocatedEntity>::addTickBatch(PyObject * script,
+                                                      LocatedEntity * entity) const
+{
+    PythonTickSystem::instance()->addEntity(script, entity);
+}
+
+template<>
+void PythonScriptFactory<Task>::addTickBatch(PyObject *, Task *) const
+{
+}
+
+template<>
+void PythonScriptFactory<BaseMind>::addTickBatch(PyObject *, BaseMind *) const
+{
+}
+
 template class PythonScriptFactory<LocatedEntity>;
 template class PythonScriptFactory<Task>;
 template class PythonScriptFactory<BaseMind>;
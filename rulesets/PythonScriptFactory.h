@@ -27,6 +27,8 @@
 /// to in game objects.
 template <class T>
 class PythonScriptFactory : public ScriptKit<T>, private PythonClass {
+  protected:
+    void addTickBatch(struct _object * script, T * entity) const;
   public:
     PythonScriptFactory(const std::string & package, const std::string & type);
     ~PythonScriptFactory();
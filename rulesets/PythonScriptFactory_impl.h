@@ -62,6 +62,7 @@ int PythonScriptFactory<T>::addScript(T * entity) const
 
     if (script != NULL) {
         entity->setScript(new PythonEntityScript(script));
+        addTickBatch(script, entity);
 
         Py_DECREF(script);
     }
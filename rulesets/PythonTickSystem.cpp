@@ -0,0 +1,400 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include <Python.h>
+
+#include "PythonTickSystem.h"
+
+#include "Py_Message.h"
+#include "LocatedEntity.h"
+
+#include "common/log.h"
+#include "common/debug.h"
+#include "common/const.h"
+#include "common/compose.hpp"
+#include "common/Monitors.h"
+#include "common/Property.h"
+#include "common/Variable.h"
+#include "common/Update.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <iostream>
+
+using Atlas::Message::Element;
+using Atlas::Objects::Operation::Update;
+
+static const bool debug_flag = false;
+
+PythonTickSystem * PythonTickSystem::m_instance = 0;
+
+PythonTickSystem::PythonTickSystem() : m_entityCount(0)
+{
+    Monitors::instance()->watch("tick_batch_entities",
+                                new Variable<int>(m_entityCount));
+}
+
+PythonTickSystem::~PythonTickSystem()
+{
+    PythonTickBatchDict::const_iterator I = m_batches.begin();
+    PythonTickBatchDict::const_iterator Iend = m_batches.end();
+    for (; I != Iend; ++I) {
+        std::vector<LocatedEntity *>::const_iterator J = I->second.m_members.begin();
+        std::vector<LocatedEntity *>::const_iterator Jend = I->second.m_members.end();
+        for (; J != Jend; ++J) {
+            (*J)->decRef();
+        }
+        Py_DECREF(I->first);
+    }
+}
+
+PythonTickSystem * PythonTickSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new PythonTickSystem;
+    }
+    return m_instance;
+}
+
+void PythonTickSystem::del()
+{
+    delete m_instance;
+    m_instance = 0;
+}
+
+/// \brief Read the batch settings from a script class
+///
+/// @param cls the script class, which defines tick_batch
+/// @param batch the batch to be configured
+/// @return zero if the class settings are valid, non-zero otherwise
+int PythonTickSystem::createBatch(PyObject * cls, PythonTickBatch & batch)
+{
+    batch.m_name = ((PyTypeObject *)cls)->tp_name;
+    batch.m_interval = consts::basic_tick;
+    // The batch is first run one interval after the first tick() call
+    batch.m_due = -1.;
+
+    PyObject * properties = PyObject_GetAttrString(cls,
+                                                   "tick_batch_properties");
+    if (properties == 0) {
+        PyErr_Clear();
+    } else {
+        PyObject * seq = 0;
+        if (!PyString_Check(properties)) {
+            seq = PySequence_Fast(properties, "");
+        }
+        Py_DECREF(properties);
+        if (seq == 0) {
+            PyErr_Clear();
+            log(ERROR, String::compose("Python class \"%1\" has "
+                                       "tick_batch_properties which is not a "
+                                       "sequence of names.", batch.m_name));
+            return -1;
+        }
+        Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+        for (Py_ssize_t i = 0; i < size; ++i) {
+            PyObject * name = PySequence_Fast_GET_ITEM(seq, i);
+            if (!PyString_Check(name)) {
+                log(ERROR, String::compose("Python class \"%1\" has a "
+                                           "non-string name in "
+                                           "tick_batch_properties.",
+                                           batch.m_name));
+                Py_DECREF(seq);
+                return -1;
+            }
+            batch.m_properties.push_back(PyString_AsString(name));
+        }
+        Py_DECREF(seq);
+    }
+
+    PyObject * interval = PyObject_GetAttrString(cls, "tick_batch_interval");
+    if (interval == 0) {
+        PyErr_Clear();
+    } else {
+        double seconds = PyFloat_AsDouble(interval);
+        Py_DECREF(interval);
+        if (PyErr_Occurred() != 0 || seconds <= 0.) {
+            PyErr_Clear();
+            log(ERROR, String::compose("Python class \"%1\" has an invalid "
+                                       "tick_batch_interval.", batch.m_name));
+            return -1;
+        }
+        batch.m_interval = seconds;
+    }
+    return 0;
+}
+
+/// \brief Drop entities which have been destroyed from a batch
+void PythonTickSystem::pruneBatch(PythonTickBatch & batch)
+{
+    std::vector<LocatedEntity *> & members = batch.m_members;
+    std::vector<LocatedEntity *>::iterator I = members.begin();
+    std::vector<LocatedEntity *>::iterator Iend = members.end();
+    std::vector<LocatedEntity *>::iterator J = I;
+    for (; I != Iend; ++I) {
+        if ((*I)->isDestroyed()) {
+            (*I)->decRef();
+            --m_entityCount;
+        } else {
+            *J++ = *I;
+        }
+    }
+    members.erase(J, Iend);
+}
+
+/// \brief Pack the state of every entity in a batch into Python lists
+///
+/// @return a new dict of lists keyed by property name, or NULL on error
+PyObject * PythonTickSystem::packBatch(const PythonTickBatch & batch)
+{
+    const std::vector<LocatedEntity *> & members = batch.m_members;
+    Py_ssize_t count = members.size();
+
+    PyObject * state = PyDict_New();
+    if (state == 0) {
+        return 0;
+    }
+    PyObject * ids = PyList_New(count);
+    if (ids == 0) {
+        Py_DECREF(state);
+        return 0;
+    }
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        PyList_SET_ITEM(ids, i, PyString_FromString(members[i]->getId().c_str()));
+    }
+    PyDict_SetItemString(state, "id", ids);
+    Py_DECREF(ids);
+
+    Element val;
+    std::vector<std::string>::const_iterator I = batch.m_properties.begin();
+    std::vector<std::string>::const_iterator Iend = batch.m_properties.end();
+    for (; I != Iend; ++I) {
+        PyObject * column = PyList_New(count);
+        if (column == 0) {
+            Py_DECREF(state);
+            return 0;
+        }
+        for (Py_ssize_t i = 0; i < count; ++i) {
+            PyObject * item = 0;
+            if (members[i]->getAttr(*I, val) == 0) {
+                item = MessageElement_asPyObject(val);
+            }
+            if (item == 0) {
+                PyErr_Clear();
+                item = Py_None;
+                Py_INCREF(item);
+            }
+            PyList_SET_ITEM(column, i, item);
+        }
+        PyDict_SetItemString(state, I->c_str(), column);
+        Py_DECREF(column);
+    }
+    return state;
+}
+
+/// \brief Set a property returned by a batch on one entity
+///
+/// @return zero if the property was set, non-zero otherwise
+static int setBatchProperty(LocatedEntity * entity,
+                            const std::string & name,
+                            PyObject * value)
+{
+    Element val;
+    if (PyObject_asMessageElement(value, val) != 0) {
+        log(ERROR, String::compose("tick_batch returned a value for \"%1\" "
+                                   "on %2 which can not be converted.",
+                                   name, entity->getId()));
+        return -1;
+    }
+    PropertyBase * prop = entity->setAttr(name, val);
+    if (prop == 0) {
+        return -1;
+    }
+    prop->setFlags(flag_unsent);
+    return 0;
+}
+
+/// \brief Apply the changes returned from a batch to the entities
+///
+/// @param batch the batch which was run
+/// @param count the number of entities which were packed for the batch
+/// @param changes the value returned by tick_batch
+/// @return zero if the changes were valid, non-zero otherwise
+int PythonTickSystem::applyChanges(PythonTickBatch & batch,
+                                   long count,
+                                   PyObject * changes)
+{
+    if (changes == Py_None) {
+        return 0;
+    }
+    if (!PyDict_Check(changes)) {
+        log(ERROR, String::compose("Python class \"%1\" tick_batch returned "
+                                   "an invalid result.", batch.m_name));
+        return -1;
+    }
+    const std::vector<LocatedEntity *> & members = batch.m_members;
+    std::vector<bool> modified(count, false);
+    int ret = 0;
+
+    PyObject * key, * column;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(changes, &pos, &key, &column)) {
+        if (!PyString_Check(key) || strcmp(PyString_AsString(key), "id") == 0) {
+            log(ERROR, String::compose("Python class \"%1\" tick_batch "
+                                       "returned an invalid property name.",
+                                       batch.m_name));
+            ret = -1;
+            continue;
+        }
+        std::string name = PyString_AsString(key);
+        if (PyDict_Check(column)) {
+            PyObject * index, * value;
+            Py_ssize_t ipos = 0;
+            while (PyDict_Next(column, &ipos, &index, &value)) {
+                long i = PyInt_Check(index) ? PyInt_AsLong(index) : -1;
+                if (i < 0 || i >= count) {
+                    log(ERROR, String::compose("Python class \"%1\" "
+                                               "tick_batch returned an "
+                                               "invalid index for \"%2\".",
+                                               batch.m_name, name));
+                    ret = -1;
+                    continue;
+                }
+                if (!members[i]->isDestroyed() &&
+                    setBatchProperty(members[i], name, value) == 0) {
+                    modified[i] = true;
+                }
+            }
+            continue;
+        }
+        PyObject * seq = PySequence_Fast(column, "");
+        if (seq == 0 || PySequence_Fast_GET_SIZE(seq) != count) {
+            PyErr_Clear();
+            Py_XDECREF(seq);
+            log(ERROR, String::compose("Python class \"%1\" tick_batch "
+                                       "returned \"%2\" which is not a dict "
+                                       "or a list of one value per entity.",
+                                       batch.m_name, name));
+            ret = -1;
+            continue;
+        }
+        for (Py_ssize_t i = 0; i < count; ++i) {
+            PyObject * value = PySequence_Fast_GET_ITEM(seq, i);
+            if (value != Py_None && !members[i]->isDestroyed() &&
+                setBatchProperty(members[i], name, value) == 0) {
+                modified[i] = true;
+            }
+        }
+        Py_DECREF(seq);
+    }
+
+    // The update op will broadcast notification for all properties that
+    // are marked flag_unsent
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        if (modified[i]) {
+            Update update;
+            update->setTo(members[i]->getId());
+            members[i]->sendWorld(update);
+        }
+    }
+    return ret;
+}
+
+/// \brief Call tick_batch on a script class, and apply the result
+void PythonTickSystem::runBatch(PyObject * cls, PythonTickBatch & batch)
+{
+    pruneBatch(batch);
+    if (batch.m_members.empty()) {
+        return;
+    }
+    // The script may cause more entities to join the batch, so only
+    // those packed now can be changed by the result.
+    Py_ssize_t count = batch.m_members.size();
+    PyObject * state = packBatch(batch);
+    if (state == 0) {
+        log(ERROR, String::compose("Python error packing tick_batch for "
+                                   "\"%1\"", batch.m_name));
+        PyErr_Print();
+        return;
+    }
+    debug(std::cout << "Running tick_batch for " << batch.m_name << " with "
+                    << count << " entities" << std::endl << std::flush;);
+    PyObject * ret = PyObject_CallMethod(cls, (char *)"tick_batch",
+                                         (char *)"(O)", state);
+    Py_DECREF(state);
+    if (ret == 0) {
+        log(ERROR, String::compose("Python error calling \"%1.tick_batch\"",
+                                   batch.m_name));
+        PyErr_Print();
+        return;
+    }
+    applyChanges(batch, count, ret);
+    Py_DECREF(ret);
+}
+
+/// \brief Add an entity to the batch for the class of its script
+///
+/// @param script the Python script object attached to the entity
+/// @param entity the entity which has the script
+/// @return zero if the entity was added, a positive value if the script
+/// class does not tick in batches, or a negative value on error
+int PythonTickSystem::addEntity(PyObject * script, LocatedEntity * entity)
+{
+    PyObject * cls = (PyObject *)Py_TYPE(script);
+    PythonTickBatchDict::iterator I = m_batches.find(cls);
+    if (I == m_batches.end()) {
+        if (!PyObject_HasAttrString(cls, "tick_batch")) {
+            return 1;
+        }
+        PythonTickBatch batch;
+        if (createBatch(cls, batch) != 0) {
+            return -1;
+        }
+        Py_INCREF(cls);
+        I = m_batches.insert(std::make_pair(cls, batch)).first;
+    }
+    entity->incRef();
+    I->second.m_members.push_back(entity);
+    ++m_entityCount;
+    return 0;
+}
+
+/// \brief Run any batches which are due
+///
+/// @param time the current world time in seconds
+void PythonTickSystem::tick(double time)
+{
+    PythonTickBatchDict::iterator I = m_batches.begin();
+    PythonTickBatchDict::iterator Iend = m_batches.end();
+    for (; I != Iend; ++I) {
+        PythonTickBatch & batch = I->second;
+        if (batch.m_due < 0.) {
+            batch.m_due = time + batch.m_interval;
+            continue;
+        }
+        if (time < batch.m_due) {
+            continue;
+        }
+        // If the server has fallen behind, don't try to catch up.
+        batch.m_due += batch.m_interval;
+        if (batch.m_due <= time) {
+            batch.m_due = time + batch.m_interval;
+        }
+        runBatch(I->first, batch);
+    }
+}
@@ -0,0 +1,89 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef RULESETS_PYTHON_TICK_SYSTEM_H
+#define RULESETS_PYTHON_TICK_SYSTEM_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+class LocatedEntity;
+
+struct _object;
+
+/// \brief All the instances of one script class which ticks in batches
+struct PythonTickBatch {
+    /// \brief Name of the script class, for error reporting
+    std::string m_name;
+    /// \brief Properties packed for each instance when the batch is run
+    std::vector<std::string> m_properties;
+    /// \brief World time in seconds between runs of the batch
+    double m_interval;
+    /// \brief World time at which the batch is next due
+    double m_due;
+    /// \brief Entities whose scripts are instances of the class
+    std::vector<LocatedEntity *> m_members;
+};
+
+typedef std::map<struct _object *, PythonTickBatch> PythonTickBatchDict;
+
+/// \brief Runs batched tick hooks defined on Python entity script classes
+///
+/// A script class can opt in by defining a class method tick_batch, and a
+/// sequence of property names tick_batch_properties. Once every
+/// tick_batch_interval seconds of world time the method is called a single
+/// time with a dict holding a list of entity IDs under "id", and a list of
+/// values for each of the named properties, one item per instance.
+/// It may return a dict of the same form, giving new values for properties.
+/// Each value may be a list with one item per instance, in which None
+/// leaves an instance unchanged, or a dict mapping instance index to value.
+/// The changes are applied directly to the entities, and each modified
+/// entity is sent one Update so the changes are broadcast.
+class PythonTickSystem {
+  protected:
+    static PythonTickSystem * m_instance;
+
+    /// \brief Batches keyed by script class, each holding a reference
+    PythonTickBatchDict m_batches;
+    /// \brief Number of entities ticked in batches
+    int m_entityCount;
+
+    PythonTickSystem();
+
+    int createBatch(struct _object * cls, PythonTickBatch &);
+    void pruneBatch(PythonTickBatch &);
+    struct _object * packBatch(const PythonTickBatch &);
+    int applyChanges(PythonTickBatch &, long count, struct _object * changes);
+    void runBatch(struct _object * cls, PythonTickBatch &);
+  public:
+    ~PythonTickSystem();
+
+    static PythonTickSystem * instance();
+    static void del();
+
+    /// \brief Read only accessor for the number of entities ticked in batches
+    int entityCount() const {
+        return m_entityCount;
+    }
+
+    int addEntity(struct _object * script, LocatedEntity * entity);
+    void tick(double time);
+};
+
+#endif // RULESETS_PYTHON_TICK_SYSTEM_H
@@ -23,6 +23,7 @@
 
 #include "Py_BBox.h"
 #include "Py_Message.h"
+#include "Py_MessageMap.h"
 #include "Py_Thing.h"
 #include "Py_Map.h"
 #include "Py_Location.h"
@@ -623,6 +624,10 @@ void init_python_api(const std::string & ruleset, bool log_stdout)
         return;
     }
     PyModule_AddObject(atlas, "Message", (PyObject *)&PyMessage_Type);
+    if (PyType_Ready(&PyMessageMap_Type) < 0) {
+        log(CRITICAL, "Python init failed to ready MessageMap wrapper type");
+        return;
+    }
 
     PyObject * physics = Py_InitModule("physics", physics_methods);
     if (physics == NULL) {
@@ -815,6 +820,12 @@ void init_python_api(const std::string & ruleset, bool log_stdout)
     // }
     // PyModule_AddObject(rules, "Statistics", (PyObject *)&PyStatistics_Type);
 
+    PyStatisticsProperty_Type.tp_new = PyType_GenericNew;
+    if (PyType_Ready(&PyStatisticsProperty_Type) < 0) {
+        log(CRITICAL, "Python init failed to ready StatisticsProperty wrapper type");
+        return;
+    }
+
     PyTerrainProperty_Type.tp_new = PyType_GenericNew;
     if (PyType_Ready(&PyTerrainProperty_Type) < 0) {
         log(CRITICAL, "Python init failed to ready TerrainProperty wrapper type");
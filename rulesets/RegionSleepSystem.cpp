@@ -0,0 +1,200 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#include "RegionSleepSystem.h"
+
+#include "LocatedEntity.h"
+#include "MindLodScheduler.h"
+
+#include "common/BaseWorld.h"
+#include "common/const.h"
+#include "common/debug.h"
+#include "common/Monitors.h"
+#include "common/Variable.h"
+
+#include <iostream>
+
+#include <cmath>
+
+static const bool debug_flag = false;
+
+RegionSleepSystem * RegionSleepSystem::m_instance = 0;
+
+RegionSleepSystem::RegionSleepSystem() : m_regionSize(0.f),
+                                         m_wakeRadius(1),
+                                         m_interval(consts::basic_tick * 5),
+                                         m_due(-1.),
+                                         m_asleepCount(0),
+                                         m_awakeCount(0)
+{
+    Monitors::instance()->watch("region_sleep_entities",
+                                new Variable<int>(m_asleepCount));
+    Monitors::instance()->watch("region_sleep_awake_regions",
+                                new Variable<int>(m_awakeCount));
+}
+
+RegionSleepSystem::~RegionSleepSystem()
+{
+}
+
+RegionSleepSystem * RegionSleepSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new RegionSleepSystem;
+    }
+    return m_instance;
+}
+
+void RegionSleepSystem::del()
+{
+    delete m_instance;
+    m_instance = 0;
+}
+
+/// \brief Determine which region an entity is in
+///
+/// Entities inside a container are in the region of their top level
+/// ancestor, which is contained directly by the world.
+RegionSleepSystem::Region RegionSleepSystem::region(const LocatedEntity & entity) const
+{
+    const LocatedEntity * top = &entity;
+    while (top->m_location.m_loc != 0 &&
+           top->m_location.m_loc->m_location.m_loc != 0) {
+        top = top->m_location.m_loc;
+    }
+    const Point3D & pos = top->m_location.pos();
+    if (!pos.isValid()) {
+        return Region(0, 0);
+    }
+    return Region((int)std::floor(pos.x() / m_regionSize),
+                  (int)std::floor(pos.y() / m_regionSize));
+}
+
+/// \brief Find the regions around the players, which are kept awake
+void RegionSleepSystem::findAwakeRegions()
+{
+    m_awakeRegions.clear();
+    const std::set<LocatedEntity *> & players =
+          MindLodScheduler::instance()->players();
+    std::set<LocatedEntity *>::const_iterator I = players.begin();
+    std::set<LocatedEntity *>::const_iterator Iend = players.end();
+    for (; I != Iend; ++I) {
+        const LocatedEntity * player = *I;
+        if (player->m_location.m_loc == 0 || player->isDestroyed()) {
+            continue;
+        }
+        Region centre = region(*player);
+        for (int x = -m_wakeRadius; x <= m_wakeRadius; ++x) {
+            for (int y = -m_wakeRadius; y <= m_wakeRadius; ++y) {
+                m_awakeRegions.insert(Region(centre.first + x,
+                                             centre.second + y));
+            }
+        }
+    }
+    m_awakeCount = m_awakeRegions.size();
+}
+
+/// \brief Flag an entity and everything it contains as asleep or awake
+///
+/// @return true if any of the entities was woken.
+bool RegionSleepSystem::setAsleep(LocatedEntity & entity, bool asleep)
+{
+    bool woken = false;
+    if (asleep) {
+        entity.setFlags(entity_asleep);
+        ++m_asleepCount;
+    } else if (entity.getFlags() & entity_asleep) {
+        debug(std::cout << "Waking " << entity.getId()
+                        << std::endl << std::flush;);
+        entity.resetFlags(entity_asleep);
+        woken = true;
+    }
+    if (entity.m_contains != 0) {
+        LocatedEntitySet::const_iterator I = entity.m_contains->begin();
+        LocatedEntitySet::const_iterator Iend = entity.m_contains->end();
+        for (; I != Iend; ++I) {
+            if (setAsleep(**I, asleep)) {
+                woken = true;
+            }
+        }
+    }
+    return woken;
+}
+
+/// \brief Set the size of the regions
+///
+/// @param size length in metres of the side of each region, or zero to
+/// wake all entities and stop them sleeping.
+void RegionSleepSystem::setRegionSize(float size)
+{
+    m_regionSize = size;
+    if (m_regionSize <= 0.f && m_asleepCount > 0) {
+        sweep();
+    }
+}
+
+/// \brief Flag every entity in the world as asleep or awake
+///
+/// If any entities were woken, the world is told so it can send the Tick
+/// operations it parked for them.
+void RegionSleepSystem::sweep()
+{
+    BaseWorld & world = BaseWorld::instance();
+    if (world.m_gameWorld.m_contains == 0) {
+        return;
+    }
+    findAwakeRegions();
+    m_asleepCount = 0;
+    bool woken = false;
+    LocatedEntitySet::const_iterator I = world.m_gameWorld.m_contains->begin();
+    LocatedEntitySet::const_iterator Iend = world.m_gameWorld.m_contains->end();
+    for (; I != Iend; ++I) {
+        LocatedEntity * entity = *I;
+        bool asleep = m_regionSize > 0.f &&
+                      m_awakeRegions.find(region(*entity)) == m_awakeRegions.end();
+        if (setAsleep(*entity, asleep)) {
+            woken = true;
+        }
+    }
+    if (woken) {
+        world.wakeEntities();
+    }
+}
+
+/// \brief Run a sweep if one is due
+///
+/// @param time the current world time
+void RegionSleepSystem::tick(double time)
+{
+    if (m_regionSize <= 0.f) {
+        return;
+    }
+    if (m_due < 0.) {
+        m_due = time;
+    }
+    if (time < m_due) {
+        return;
+    }
+    // If the server has fallen behind, don't try to catch up.
+    m_due += m_interval;
+    if (m_due <= time) {
+        m_due = time + m_interval;
+    }
+    sweep();
+}
@@ -0,0 +1,93 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef RULESETS_REGION_SLEEP_SYSTEM_H
+#define RULESETS_REGION_SLEEP_SYSTEM_H
+
+#include <set>
+#include <utility>
+
+class LocatedEntity;
+
+/// \brief Puts entities to sleep in regions of the world no player is near
+///
+/// The world is divided into square regions. Once every interval the
+/// regions containing player controlled characters, and the regions
+/// around them, are found, and every entity in the world is flagged
+/// asleep or awake according to the region its top level ancestor is in.
+/// Tick operations for sleeping entities are parked by the world until
+/// they wake, and the batched systems skip sleeping members and catch
+/// them up on the cycles they missed when they wake.
+class RegionSleepSystem {
+  public:
+    /// \brief Identifies a region by its coordinates on the region grid
+    typedef std::pair<int, int> Region;
+  protected:
+    static RegionSleepSystem * m_instance;
+
+    /// \brief Regions in which entities are kept awake
+    std::set<Region> m_awakeRegions;
+    /// \brief Length in metres of the side of each region, or zero if
+    /// entities never sleep
+    float m_regionSize;
+    /// \brief Number of regions around a player which are kept awake
+    int m_wakeRadius;
+    /// \brief World time in seconds between sweeps
+    double m_interval;
+    /// \brief World time at which the next sweep is due
+    double m_due;
+    /// \brief Number of entities currently asleep
+    int m_asleepCount;
+    /// \brief Number of regions currently awake
+    int m_awakeCount;
+
+    RegionSleepSystem();
+
+    Region region(const LocatedEntity &) const;
+    void findAwakeRegions();
+    bool setAsleep(LocatedEntity &, bool asleep);
+  public:
+    ~RegionSleepSystem();
+
+    static RegionSleepSystem * instance();
+    static void del();
+
+    /// \brief Read only accessor for the size of each region
+    float regionSize() const {
+        return m_regionSize;
+    }
+
+    /// \brief Read only accessor for the number of entities asleep
+    int asleepCount() const {
+        return m_asleepCount;
+    }
+
+    /// \brief Read only accessor for the interval between sweeps
+    double interval() const {
+        return m_interval;
+    }
+
+    void setRegionSize(float size);
+    void sweep();
+    void tick(double time);
+
+    friend class RegionSleepSystemtest;
+};
+
+#endif // RULESETS_REGION_SLEEP_SYSTEM_H
@@ -19,8 +19,10 @@
 #include "StatisticsProperty.h"
 
 #include "rulesets/ArithmeticScript.h"
+#include "rulesets/NativeArithmeticScript.h"
 
 #include "common/log.h"
+#include "common/compose.hpp"
 #include "common/BaseWorld.h"
 
 #include <cassert>
@@ -39,7 +41,9 @@ using Atlas::Message::FloatType;
 /// on the enity instance.
 StatisticsProperty::StatisticsProperty(const StatisticsProperty & other) :
     m_data(other.m_data),
-    m_script(0)
+    m_formulae(other.m_formulae),
+    m_script(0),
+    m_formulaeChanged(false)
 {
 }
 
@@ -47,7 +51,8 @@ StatisticsProperty::StatisticsProperty(const StatisticsProperty & other) :
 ///
 /// @param data variable that holds the Property value
 /// @param flags flags to indicate how this property is stored
-StatisticsProperty::StatisticsProperty() : m_script(0)
+StatisticsProperty::StatisticsProperty() : m_script(0),
+                                           m_formulaeChanged(false)
 {
 }
 
@@ -60,8 +65,36 @@ void StatisticsProperty::install(LocatedEntity * ent, const std::string & name)
 {
 }
 
+/// \brief Create a native arithmetic model from the formulas
+///
+/// @param owner the entity whose properties the formulas can use
+/// @return the new model, or NULL if any formula could not be compiled
+ArithmeticScript * StatisticsProperty::newFormulaScript(LocatedEntity * owner)
+{
+    NativeArithmeticScript * script = new NativeArithmeticScript(owner);
+    std::map<std::string, std::string>::const_iterator I = m_formulae.begin();
+    std::map<std::string, std::string>::const_iterator Iend = m_formulae.end();
+    for (; I != Iend; ++I) {
+        if (script->addFormula(I->first, I->second) != 0) {
+            log(ERROR, String::compose("Invalid statistics formula for "
+                                       "\"%1\". Falling back to the "
+                                       "statistics script.", I->first));
+            delete script;
+            return 0;
+        }
+    }
+    return script;
+}
+
 void StatisticsProperty::apply(LocatedEntity * ent)
 {
+    // The formulas are compiled into the script, so it must be made again
+    // once they have changed.
+    if (m_formulaeChanged) {
+        delete m_script;
+        m_script = 0;
+        m_formulaeChanged = false;
+    }
     if (m_script == 0) {
         LocatedEntity * instance = 0;
         if (flags() & flag_class) {
@@ -69,7 +102,13 @@ void StatisticsProperty::apply(LocatedEntity * ent)
             instance = ent;
         }
 
-        m_script = BaseWorld::instance().newArithmetic("statistics", instance);
+        if (!m_formulae.empty()) {
+            m_script = newFormulaScript(instance);
+        }
+        if (m_script == 0) {
+            m_script = BaseWorld::instance().newArithmetic("statistics",
+                                                           instance);
+        }
         if (m_script == 0) {
             return;
         }
@@ -91,6 +130,12 @@ int StatisticsProperty::get(Element & val) const
     for (; I != Iend; ++I) {
         val_map[I->first] = I->second;
     }
+
+    std::map<std::string, std::string>::const_iterator J = m_formulae.begin();
+    std::map<std::string, std::string>::const_iterator Jend = m_formulae.end();
+    for (; J != Jend; ++J) {
+        val_map[J->first] = J->second;
+    }
     return 0;
 }
 
@@ -104,11 +149,23 @@ void StatisticsProperty::set(const Element & ent)
     MapType::const_iterator I = smap.begin();
     MapType::const_iterator Iend = smap.end();
     for (; I != Iend; ++I) {
+        if (I->second.isString()) {
+            std::string & formula = m_formulae[I->first];
+            if (formula != I->second.String()) {
+                formula = I->second.String();
+                m_formulaeChanged = true;
+            }
+            m_data.erase(I->first);
+            continue;
+        }
         if (!I->second.isNum()) {
             log(WARNING, "Non numeric stat");
             continue;
         }
         m_data[I->first] = I->second.asNum();
+        if (m_formulae.erase(I->first) != 0) {
+            m_formulaeChanged = true;
+        }
     }
 }
 
@@ -31,9 +31,15 @@ class StatisticsProperty : public PropertyBase {
   protected:
     /// \brief Reference to variable holding the value of this Property
     std::map<std::string, double> m_data;
+    /// \brief Formulas for statistics calculated without a script
+    std::map<std::string, std::string> m_formulae;
     ArithmeticScript * m_script;
+    /// \brief Whether the formulas have changed since the script was made
+    bool m_formulaeChanged;
 
     StatisticsProperty(const StatisticsProperty &);
+
+    ArithmeticScript * newFormulaScript(LocatedEntity * owner);
   public:
     explicit StatisticsProperty();
     virtual ~StatisticsProperty();
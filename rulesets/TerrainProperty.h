@@ -67,6 +67,11 @@ class TerrainProperty : public PropertyBase {
     // Removes a single TerrainMod from the terrain
     void removeMod(const Mercator::TerrainMod *) const;
 
+    /// \brief Accessor for the Mercator terrain this property maintains
+    Mercator::Terrain & getData() const {
+        return m_data;
+    }
+
     bool getHeightAndNormal(float x, float y, float &, Vector3D &) const;
     int getSurface(const Point3D &,  int &);
 
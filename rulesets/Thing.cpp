@@ -20,6 +20,7 @@
 
 #include "Motion.h"
 #include "Domain.h"
+#include "VisibilityGrid.h"
 
 #include "common/BaseWorld.h"
 #include "common/log.h"
@@ -61,6 +62,10 @@ using Atlas::Objects::Entity::RootEntity;
 
 static const bool debug_flag = false;
 
+/// Number of entities in a container above which visibility changes are
+/// found using a VisibilityGrid, rather than checking every entity.
+static const LocatedEntitySet::size_type visibility_threshold = 64;
+
 /// \brief Constructor for physical or tangiable entities.
 Thing::Thing(const std::string & id, long intId) :
        Entity(id, intId)
@@ -257,6 +262,7 @@ void Thing::MoveOperation(const Operation & op, OpVector & res)
     }
 
     // At this point the Location data for this entity has been updated.
+    VisibilityGrid::moved(*this);
 
     bool moving = false;
 
@@ -343,10 +349,30 @@ void Thing::checkVisibility(const Point3D & old_pos, OpVector & res)
 
     assert(m_location.m_loc != 0);
     assert(m_location.m_loc->m_contains != 0);
-    LocatedEntitySet::const_iterator I = m_location.m_loc->m_contains->begin();
-    LocatedEntitySet::const_iterator Iend = m_location.m_loc->m_contains->end();
+    const LocatedEntitySet & contains = *m_location.m_loc->m_contains;
+    BroadPhase::CandidateList candidates;
+    BBox sight;
+    if (contains.size() >= visibility_threshold &&
+        VisibilityGrid::sightBox(old_pos, m_location.pos(),
+                                 VisibilityGrid::sightRange(fromSquSize),
+                                 sight) == 0) {
+        // Only entities near enough to have come into or gone out of
+        // sight need to be checked.
+        VisibilityGrid * grid = VisibilityGrid::forContainer(*m_location.m_loc,
+                                                             m_location.timeStamp());
+        grid->update(this);
+        grid->query(sight, candidates);
+    } else {
+        candidates.assign(contains.begin(), contains.end());
+    }
+    BroadPhase::CandidateList::const_iterator I = candidates.begin();
+    BroadPhase::CandidateList::const_iterator Iend = candidates.end();
     for(; I != Iend; ++I) {
         LocatedEntity * other = *I;
+        // Candidates may still include entities which have left
+        if (contains.find(other) == contains.end()) {
+            continue;
+        }
         assert(other != 0);
         float old_dist = squareDistance(other->m_location.pos(), old_pos),
               new_dist = squareDistance(other->m_location.pos(), m_location.pos()),
@@ -541,6 +567,8 @@ void Thing::UpdateOperation(const Operation & op, OpVector & res)
     }
 
     Point3D old_pos = m_location.pos();
+    Vector3D old_velocity = m_location.velocity();
+    LocatedEntity * old_loc = m_location.m_loc;
 
     bool moving = true;
 
@@ -571,6 +599,7 @@ void Thing::UpdateOperation(const Operation & op, OpVector & res)
                                                     "standing");
     m_location.update(current_time);
     m_flags &= ~(entity_pos_clean | entity_clean);
+    VisibilityGrid::moved(*this);
 
     float update_time = consts::move_tick;
 
@@ -587,18 +616,25 @@ void Thing::UpdateOperation(const Operation & op, OpVector & res)
         }
     }
 
-    Move m;
-    Anonymous move_arg;
-    move_arg->setId(getId());
-    m_location.addToEntity(move_arg);
-    m->setArgs1(move_arg);
-    m->setFrom(getId());
-    m->setTo(getId());
+    // A character moved by the MovementSystem sends a Move itself whenever
+    // its trajectory changes, so observers only need to be told here if a
+    // collision has changed it.
+    if (!(m_flags & entity_moving) || !moving ||
+        m_location.m_loc != old_loc ||
+        m_location.velocity() != old_velocity) {
+        Move m;
+        Anonymous move_arg;
+        move_arg->setId(getId());
+        m_location.addToEntity(move_arg);
+        m->setArgs1(move_arg);
+        m->setFrom(getId());
+        m->setTo(getId());
 
-    Sight s;
-    s->setArgs1(m);
+        Sight s;
+        s->setArgs1(m);
 
-    res.push_back(s);
+        res.push_back(s);
+    }
 
     if (moving) {
         debug(std::cout << "New Update in " << update_time << std::endl << std::flush;);
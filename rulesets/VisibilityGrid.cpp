@@ -0,0 +1,117 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "VisibilityGrid.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include "common/const.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <cmath>
+
+/// Period over which sight ranges are swept, which covers the move tick
+/// after the grid is built, and any update at the end of it
+static const float sweep_interval = 2.f * consts::move_tick;
+
+BroadPhase::BroadPhaseDict VisibilityGrid::m_visibilityGrids;
+
+BroadPhase * VisibilityGrid::create()
+{
+    return new VisibilityGrid;
+}
+
+VisibilityGrid * VisibilityGrid::forContainer(const LocatedEntity & container,
+                                              double time)
+{
+    return static_cast<VisibilityGrid *>(findGrid(m_visibilityGrids,
+                                                  container, time, &create));
+}
+
+void VisibilityGrid::flush()
+{
+    BroadPhaseDict::const_iterator I = m_visibilityGrids.begin();
+    BroadPhaseDict::const_iterator Iend = m_visibilityGrids.end();
+    for (; I != Iend; ++I) {
+        delete I->second;
+    }
+    m_visibilityGrids.clear();
+}
+
+void VisibilityGrid::moved(LocatedEntity & entity)
+{
+    if (entity.m_location.m_loc == 0) {
+        return;
+    }
+    BroadPhaseDict::const_iterator I = m_visibilityGrids.find(entity.m_location.m_loc);
+    if (I != m_visibilityGrids.end()) {
+        I->second->update(&entity);
+    }
+}
+
+float VisibilityGrid::sightRange(float squareBoxSize)
+{
+    // Grown slightly, so rounding in the exact test can never put an
+    // entity in sight beyond this range.
+    return std::sqrt(squareBoxSize / consts::square_sight_factor) * 1.001f
+           + 0.01f;
+}
+
+int VisibilityGrid::sightBox(const Point3D & old_pos, const Point3D & new_pos,
+                             float range, BBox & box)
+{
+    if (!old_pos.isValid() || !new_pos.isValid()) {
+        return -1;
+    }
+    Point3D low, high;
+    for (int i = 0; i < 3; ++i) {
+        low[i] = std::min(old_pos[i], new_pos[i]) - range;
+        high[i] = std::max(old_pos[i], new_pos[i]) + range;
+    }
+    box = BBox(low, high);
+    return 0;
+}
+
+int VisibilityGrid::entryBox(const Location & loc, BBox & box) const
+{
+    if (!loc.pos().isValid()) {
+        // Distances to an entity with no position can not be reasoned
+        // about, so it is made to overlap every query.
+        const float max = std::numeric_limits<float>::max();
+        box = BBox(Point3D(-max, -max, -max), Point3D(max, max, max));
+        return 0;
+    }
+    float range = sightRange(loc.squareBoxSize());
+    const Point3D & pos = loc.pos();
+    Point3D low(pos.x() - range, pos.y() - range, pos.z() - range);
+    Point3D high(pos.x() + range, pos.y() + range, pos.z() + range);
+    if (loc.velocity().isValid()) {
+        for (int i = 0; i < 3; ++i) {
+            float d = loc.velocity()[i] * sweep_interval;
+            if (d < 0) {
+                low[i] += d;
+            } else {
+                high[i] += d;
+            }
+        }
+    }
+    box = BBox(low, high);
+    return 0;
+}
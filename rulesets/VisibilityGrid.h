@@ -0,0 +1,68 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef RULESETS_VISIBILITY_GRID_H
+#define RULESETS_VISIBILITY_GRID_H
+
+#include "rulesets/BroadPhase.h"
+
+#include "physics/Vector3D.h"
+
+/// \brief Uniform grid of sight ranges used to find the entities in a
+/// container whose visibility may change when another entity moves
+///
+/// Each entity is entered in the grid cells within the range at which it
+/// can be seen, swept along its velocity. A moving entity queries the grid
+/// with the box around its old and new positions, grown by the range at
+/// which it can be seen itself, so only entities which can gain or lose
+/// sight of it, or be gained or lost from its sight, are returned.
+class VisibilityGrid : public BroadPhase {
+  protected:
+    static BroadPhaseDict m_visibilityGrids;
+
+    static BroadPhase * create();
+
+    virtual int entryBox(const Location & loc, BBox & box) const;
+  public:
+    /// \brief Get an up to date grid for the contents of a container
+    static VisibilityGrid * forContainer(const LocatedEntity & container,
+                                         double time);
+
+    /// \brief Delete all grids
+    static void flush();
+
+    /// \brief Refresh the entry of an entity which has moved, if its
+    /// container has a grid
+    static void moved(LocatedEntity & entity);
+
+    /// \brief Distance beyond which an entity with a given box size can
+    /// not be seen
+    static float sightRange(float squareBoxSize);
+
+    /// \brief Calculate the box to query for an entity which has moved
+    ///
+    /// @param old_pos position before the move
+    /// @param new_pos position after the move
+    /// @param range distance at which the moving entity can be seen
+    /// @return 0 if the box was calculated, -1 if either position is
+    /// not valid
+    static int sightBox(const Point3D & old_pos, const Point3D & new_pos,
+                        float range, BBox & box);
+};
+
+#endif // RULESETS_VISIBILITY_GRID_H
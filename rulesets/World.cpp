@@ -25,6 +25,7 @@
 #include "common/log.h"
 #include "common/const.h"
 #include "common/debug.h"
+#include "common/Inheritance.h"
 #include "common/TypeNode.h"
 #include "common/compose.hpp"
 #include "common/custom.h"
@@ -37,6 +38,7 @@
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
 
+#include <algorithm>
 #include <sstream>
 
 #include <cassert>
@@ -90,8 +92,11 @@ void World::EatOperation(const Operation & op, OpVector & res)
         return;
     }
    
+    static const TypeHandle plant_type("plant");
+    static const TypeHandle character_type("character");
+
     const TypeNode * from_type = from->getType();
-    if (from_type->isTypeOf("plant")) {
+    if (from_type->isTypeOf(plant_type.get())) {
         if (material == GRASS) {
             debug(std::cout << "From grass" << std::endl << std::flush;);
             Nourish nourish;
@@ -102,15 +107,22 @@ void World::EatOperation(const Operation & op, OpVector & res)
             if (!mass.isFloat()) {
                 mass = 0.;
             }
-            // FIXME to do this right we need to know how long since the
-            // last tick, so the from entity needs to tell us.
+            // A plant which has been asleep tells us how many growth
+            // cycles it has missed since it last ate.
+            long cycles = 1;
+            Element cycles_attr;
+            if (!op->getArgs().empty() &&
+                op->getArgs().front()->copyAttr("cycles", cycles_attr) == 0 &&
+                cycles_attr.isInt()) {
+                cycles = std::max(1L, cycles_attr.Int());
+            }
             nour_arg->setAttr("mass",
-                              std::pow(mass.Float(), 0.5) /
+                              std::pow(mass.Float(), 0.5) * cycles /
                                       (60.0 * 24.0));
             nourish->setArgs1(nour_arg);
             res.push_back(nourish);
         }
-    } else if (from_type->isTypeOf("character")) {
+    } else if (from_type->isTypeOf(character_type.get())) {
         log(NOTICE, "Eat coming from an animal.");
         if (material == GRASS) {
             debug(std::cout << "From grass" << std::endl << std::flush;);
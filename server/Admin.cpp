@@ -57,6 +57,13 @@ using String::compose;
 
 static const bool debug_flag = false;
 
+/// \brief Largest number of entities returned by a by_name or by_type query
+///
+/// A query for a broad type matches its subtypes as well, so without a limit
+/// it could pack every entity in the world into one Info. The entities are
+/// returned in the order the world finds them, and the rest are dropped.
+static const std::size_t max_query_results = 1000;
+
 /// \brief Admin constructor
 Admin::Admin(Connection * conn,
              const std::string & username,
@@ -221,8 +228,8 @@ void Admin::GetOperation(const Operation & op, OpVector & res)
 
         const RouterMap & OOGDict = m_connection->m_server.getObjects();
         RouterMap::const_iterator J = OOGDict.find(intId);
-        const EntityDict & worldDict = m_connection->m_server.m_world.getEntities();
-        EntityDict::const_iterator K = worldDict.find(intId);
+        const EntityTable & worldDict = m_connection->m_server.m_world.getEntities();
+        EntityTable::const_iterator K = worldDict.find(intId);
 
         if (J != OOGDict.end()) {
             Router * obj = J->second;
@@ -238,6 +245,35 @@ void Admin::GetOperation(const Operation & op, OpVector & res)
                         res, getId());
             return;
         }
+    } else if (objtype == "by_name" || objtype == "by_type") {
+        // Find all the in-game entities with the given name, or of
+        // the given type or its subtypes.
+        if (m_connection == 0) {
+            return;
+        }
+        BaseWorld & world = m_connection->m_server.m_world;
+        std::vector<LocatedEntity *> found;
+        if (objtype == "by_name") {
+            world.findAllByName(id, found);
+        } else {
+            world.findAllByType(id, found, true);
+        }
+        if (found.size() > max_query_results) {
+            log(WARNING, compose("Admin %1 query for \"%2\" matched %3 "
+                                 "entities, returning the first %4",
+                                 objtype, id, found.size(),
+                                 max_query_results));
+            found.resize(max_query_results);
+        }
+        std::vector<Root> info_args;
+        std::vector<LocatedEntity *>::const_iterator I = found.begin();
+        std::vector<LocatedEntity *>::const_iterator Iend = found.end();
+        for (; I != Iend; ++I) {
+            Anonymous info_arg;
+            (*I)->addToEntity(info_arg);
+            info_args.push_back(info_arg);
+        }
+        info->setArgs(info_args);
     } else if (objtype == "class" ||
                objtype == "meta" ||
                objtype == "op_definition") {
@@ -113,9 +113,10 @@ bool CommServer::idle(const SystemTime & time, bool busy)
 /// Call the server idle function to do its processing. If the server is
 /// is currently busy, poll all the sockets as quickly as possible.
 /// If the server is idle, use select() to sleep on the sockets for
-/// a short period of time. If any sockets get broken or disconnected,
-/// they are noted and closed down at the end of the process.
-void CommServer::poll(bool busy)
+/// a short period of time, at most timeout milliseconds. If any sockets
+/// get broken or disconnected, they are noted and closed down at the end
+/// of the process.
+void CommServer::poll(bool busy, int timeout)
 {
     // This is the main code loop.
     // Classic select code for checking incoming data on sockets.
@@ -129,7 +130,7 @@ void CommServer::poll(bool busy)
 
     static struct epoll_event events[max_events];
 
-    int rval = ::epoll_wait(m_epollFd, events, max_events, (busy ? 0 : 100));
+    int rval = ::epoll_wait(m_epollFd, events, max_events, (busy ? 0 : timeout));
 
     if (rval <  0) {
         if (errno != EINTR) {
@@ -178,7 +179,7 @@ void CommServer::poll(bool busy)
     struct timeval tv;
 
     tv.tv_sec = 0;
-    tv.tv_usec = (busy ? 0 : 100000);
+    tv.tv_usec = (busy ? 0 : timeout * 1000);
 
     FD_ZERO(&sock_fds);
 
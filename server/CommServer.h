@@ -55,7 +55,7 @@ class CommServer {
     ~CommServer();
 
     int setup();
-    void poll(bool);
+    void poll(bool busy, int timeout = 100);
     bool idle(const SystemTime &, bool);
     int addSocket(CommSocket * cs);
     void removeSocket(CommSocket * client);
@@ -19,6 +19,7 @@
 #ifndef SERVER_CONNECTION_H
 #define SERVER_CONNECTION_H
 
+#include "common/IdMap.h"
 #include "common/Link.h"
 
 #include <sigc++/trackable.h>
@@ -29,7 +30,7 @@ class CommSocket;
 class LocatedEntity;
 class ServerRouting;
 
-typedef std::map<long, Router *> RouterMap;
+typedef IdMap<Router *> RouterMap;
 
 /// \brief Class representing connections from a client at the Atlas level.
 ///
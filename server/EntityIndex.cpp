@@ -0,0 +1,210 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#include "EntityIndex.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include "common/Inheritance.h"
+#include "common/TypeNode.h"
+
+using Atlas::Message::Element;
+
+/// \brief Get the name an entity should be indexed under
+///
+/// @return the name of the entity, or an empty string if it has none.
+std::string EntityIndex::currentName(const LocatedEntity * ent)
+{
+    Element name_attr;
+    if (ent->getAttrType("name", name_attr, Element::TYPE_STRING) == 0) {
+        return name_attr.String();
+    }
+    return std::string();
+}
+
+/// \brief Get the type name an entity should be indexed under
+///
+/// @return the name of the type of the entity, or an empty string if it
+/// has none.
+std::string EntityIndex::currentType(const LocatedEntity * ent)
+{
+    if (ent->getType() != 0) {
+        return ent->getType()->name();
+    }
+    return std::string();
+}
+
+void EntityIndex::addTo(std::map<std::string, EntityDict> & index,
+                        const std::string & key,
+                        LocatedEntity * ent)
+{
+    if (!key.empty()) {
+        index[key][ent->getIntId()] = ent;
+    }
+}
+
+void EntityIndex::removeFrom(std::map<std::string, EntityDict> & index,
+                             const std::string & key,
+                             long id)
+{
+    std::map<std::string, EntityDict>::iterator I = index.find(key);
+    if (I == index.end()) {
+        return;
+    }
+    I->second.erase(id);
+    if (I->second.empty()) {
+        index.erase(I);
+    }
+}
+
+/// \brief Add an entity to the indexes
+void EntityIndex::addEntity(LocatedEntity * ent)
+{
+    long id = ent->getIntId();
+    if (m_indexed.find(id) != m_indexed.end()) {
+        updateEntity(ent);
+        return;
+    }
+    IndexedKeys & keys = m_indexed[id];
+    keys.m_name = currentName(ent);
+    keys.m_type = currentType(ent);
+    addTo(m_byName, keys.m_name, ent);
+    addTo(m_byType, keys.m_type, ent);
+}
+
+/// \brief Remove an entity from the indexes
+///
+/// The entity is removed from under the keys it was last indexed with,
+/// which may not be its current name and type.
+void EntityIndex::delEntity(LocatedEntity * ent)
+{
+    long id = ent->getIntId();
+    IdMap<IndexedKeys>::const_iterator I = m_indexed.find(id);
+    if (I == m_indexed.end()) {
+        return;
+    }
+    removeFrom(m_byName, I->second.m_name, id);
+    removeFrom(m_byType, I->second.m_type, id);
+    m_indexed.erase(I);
+}
+
+/// \brief Index an entity again under its current name and type
+///
+/// Entities which are not in the index are ignored, so this is safe to
+/// call for an entity which has been removed from the world.
+void EntityIndex::updateEntity(LocatedEntity * ent)
+{
+    long id = ent->getIntId();
+    if (m_indexed.find(id) == m_indexed.end()) {
+        return;
+    }
+    IndexedKeys & keys = m_indexed[id];
+    std::string name = currentName(ent);
+    if (name != keys.m_name) {
+        removeFrom(m_byName, keys.m_name, id);
+        addTo(m_byName, name, ent);
+        keys.m_name = name;
+    }
+    std::string type = currentType(ent);
+    if (type != keys.m_type) {
+        removeFrom(m_byType, keys.m_type, id);
+        addTo(m_byType, type, ent);
+        keys.m_type = type;
+    }
+}
+
+/// \brief Find the entity with the lowest ID with the given name
+///
+/// @return a pointer to the entity, or zero if none was found.
+LocatedEntity * EntityIndex::findByName(const std::string & name) const
+{
+    std::map<std::string, EntityDict>::const_iterator I = m_byName.find(name);
+    if (I == m_byName.end()) {
+        return 0;
+    }
+    return I->second.begin()->second;
+}
+
+/// \brief Find the entity with the lowest ID of exactly the given type
+///
+/// @return a pointer to the entity, or zero if none was found.
+LocatedEntity * EntityIndex::findByType(const std::string & type) const
+{
+    std::map<std::string, EntityDict>::const_iterator I = m_byType.find(type);
+    if (I == m_byType.end()) {
+        return 0;
+    }
+    return I->second.begin()->second;
+}
+
+/// \brief Find all the entities with the given name, in order of ID
+///
+/// @param res the entities found are appended to this list.
+void EntityIndex::findAllByName(const std::string & name,
+                                EntityVector & res) const
+{
+    std::map<std::string, EntityDict>::const_iterator I = m_byName.find(name);
+    if (I == m_byName.end()) {
+        return;
+    }
+    EntityDict::const_iterator J = I->second.begin();
+    EntityDict::const_iterator Jend = I->second.end();
+    for (; J != Jend; ++J) {
+        res.push_back(J->second);
+    }
+}
+
+/// \brief Find all the entities of the given type
+///
+/// Entities are found in order of ID within each type.
+/// @param res the entities found are appended to this list.
+/// @param subtypes if true, entities of types which inherit from the
+/// given type are also found. Subtypes are only found if the given type
+/// is installed in the inheritance tree.
+void EntityIndex::findAllByType(const std::string & type,
+                                EntityVector & res,
+                                bool subtypes) const
+{
+    std::map<std::string, EntityDict>::const_iterator I = m_byType.begin();
+    std::map<std::string, EntityDict>::const_iterator Iend = m_byType.end();
+    const TypeNode * base = 0;
+    if (subtypes) {
+        base = Inheritance::instance().getType(type);
+    }
+    if (base == 0) {
+        I = m_byType.find(type);
+        if (I == Iend) {
+            return;
+        }
+        Iend = I;
+        ++Iend;
+    }
+    for (; I != Iend; ++I) {
+        // Every entity under this key has the same type, so check the first
+        const TypeNode * node = I->second.begin()->second->getType();
+        if (base != 0 && (node == 0 || !node->isTypeOf(base))) {
+            continue;
+        }
+        EntityDict::const_iterator J = I->second.begin();
+        EntityDict::const_iterator Jend = I->second.end();
+        for (; J != Jend; ++J) {
+            res.push_back(J->second);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef SERVER_ENTITY_INDEX_H
+#define SERVER_ENTITY_INDEX_H
+
+#include "common/IdMap.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+class LocatedEntity;
+
+/// \brief Secondary indexes of the entities in the world by name and type
+///
+/// Entities are indexed under the value of their name attribute, and under
+/// the name of their type. Each index keeps its entities in order of ID,
+/// so the first entity found is the one with the lowest ID, which is the
+/// one a scan of the world would have found. An entity's name and type are
+/// indexed again whenever updateEntity() is called for it, which the world
+/// does each time the entity emits its updated signal.
+class EntityIndex {
+  public:
+    typedef std::map<long, LocatedEntity *> EntityDict;
+    typedef std::vector<LocatedEntity *> EntityVector;
+  protected:
+    /// \brief Keys under which an entity was last indexed
+    struct IndexedKeys {
+        /// Name of the entity, or empty if it has none
+        std::string m_name;
+        /// Name of the type of the entity, or empty if it has none
+        std::string m_type;
+    };
+
+    /// \brief Entities indexed by name
+    std::map<std::string, EntityDict> m_byName;
+    /// \brief Entities indexed by the name of their type
+    std::map<std::string, EntityDict> m_byType;
+    /// \brief Keys under which each indexed entity was last indexed
+    IdMap<IndexedKeys> m_indexed;
+
+    static std::string currentName(const LocatedEntity * ent);
+    static std::string currentType(const LocatedEntity * ent);
+    static void addTo(std::map<std::string, EntityDict> & index,
+                      const std::string & key,
+                      LocatedEntity * ent);
+    static void removeFrom(std::map<std::string, EntityDict> & index,
+                           const std::string & key,
+                           long id);
+  public:
+    /// \brief Number of entities in the index
+    std::size_t size() const { return m_indexed.size(); }
+
+    void addEntity(LocatedEntity * ent);
+    void delEntity(LocatedEntity * ent);
+    void updateEntity(LocatedEntity * ent);
+
+    LocatedEntity * findByName(const std::string & name) const;
+    LocatedEntity * findByType(const std::string & type) const;
+
+    void findAllByName(const std::string & name, EntityVector & res) const;
+    void findAllByType(const std::string & type, EntityVector & res,
+                       bool subtypes) const;
+};
+
+#endif // SERVER_ENTITY_INDEX_H
@@ -0,0 +1,165 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifndef SERVER_OP_QUEUE_H
+#define SERVER_OP_QUEUE_H
+
+#include "rulesets/LocatedEntity.h"
+
+#include "common/id.h"
+
+#include <list>
+
+/// \brief Type to hold an operation and the Entity it is from for efficiency
+/// when broadcasting.
+///
+/// The integer ID of the target is parsed once when the operation is
+/// queued, so dispatch does not have to parse the TO string again.
+struct OpQueEntry {
+    Operation op;
+    LocatedEntity * from;
+    /// \brief Integer ID of the target, or -1 if the operation has no TO
+    long to;
+
+    OpQueEntry() : op(0), from(0), to(-1) { }
+
+    explicit OpQueEntry(const Operation & o, LocatedEntity & f) : op(o),
+                                                                  from(&f),
+                                                                  to(targetId(o)) {
+        from->incRef();
+    }
+
+    OpQueEntry(const OpQueEntry & o) : op(o.op), from(o.from), to(o.to) {
+        if (from != 0) {
+            from->incRef();
+        }
+    }
+
+    ~OpQueEntry() {
+        release();
+    }
+
+    OpQueEntry & operator=(const OpQueEntry &) = delete;
+
+    /// \brief Hold a new operation in this entry
+    void assign(const Operation & o, LocatedEntity & f) {
+        f.incRef();
+        release();
+        op = o;
+        from = &f;
+        to = targetId(o);
+    }
+
+    /// \brief Drop the operation and entity held by this entry
+    void release() {
+        op = Operation(0);
+        to = -1;
+        if (from != 0) {
+            from->decRef();
+            from = 0;
+        }
+    }
+
+    const Operation & operator*() const {
+        return op;
+    }
+
+    Atlas::Objects::Operation::RootOperationData * operator->() const {
+        return op.get();
+    }
+
+    /// \brief Parse the integer ID of the target of an operation
+    static long targetId(const Operation & o) {
+        if (o->isDefaultTo()) {
+            return -1;
+        }
+        return integerId(o->getTo());
+    }
+};
+
+/// \brief Queue of operations waiting to be dispatched
+///
+/// Entries removed from the queue are released and kept on a spare list,
+/// to be reused by later insertions, so a steady flow of operations
+/// through the queue does not allocate list nodes.
+class OpQueue {
+  public:
+    typedef std::list<OpQueEntry> EntryList;
+    typedef EntryList::iterator iterator;
+    typedef EntryList::const_iterator const_iterator;
+
+    /// \brief Most spare entries kept for reuse after a burst of operations
+    static const std::size_t max_spare = 1024;
+  protected:
+    /// \brief Entries in the queue
+    EntryList m_entries;
+    /// \brief Released entries waiting to be reused
+    EntryList m_spare;
+  public:
+    iterator begin() { return m_entries.begin(); }
+    iterator end() { return m_entries.end(); }
+    const_iterator begin() const { return m_entries.begin(); }
+    const_iterator end() const { return m_entries.end(); }
+
+    bool empty() const { return m_entries.empty(); }
+    std::size_t size() const { return m_entries.size(); }
+
+    /// \brief Number of released entries available for reuse
+    std::size_t spare() const { return m_spare.size(); }
+
+    /// \brief Insert an operation before the entry at pos
+    iterator insert(iterator pos, const Operation & op, LocatedEntity & from) {
+        if (m_spare.empty()) {
+            return m_entries.emplace(pos, op, from);
+        }
+        iterator I = m_spare.begin();
+        I->assign(op, from);
+        m_entries.splice(pos, m_spare, I);
+        return I;
+    }
+
+    /// \brief Add an operation at the end of the queue
+    void push_back(const Operation & op, LocatedEntity & from) {
+        insert(m_entries.end(), op, from);
+    }
+
+    /// \brief Remove the entry at I from the queue
+    void erase(iterator I) {
+        if (m_spare.size() >= max_spare) {
+            m_entries.erase(I);
+            return;
+        }
+        m_spare.splice(m_spare.begin(), m_entries, I);
+        I->release();
+    }
+
+    /// \brief Remove the first entry from the queue
+    void pop_front() {
+        erase(m_entries.begin());
+    }
+
+    /// \brief Remove all entries from the queue
+    void clear() {
+        while (!m_entries.empty()) {
+            erase(m_entries.begin());
+        }
+    }
+};
+
+#endif // SERVER_OP_QUEUE_H
@@ -222,7 +222,7 @@ void Persistence::putAccount(const Account & ac)
 }
 
 void Persistence::registerCharacters(Account & ac,
-                                     const EntityDict & worldObjects)
+                                     const EntityTable & worldObjects)
 {
     DatabaseResult dr = m_db.selectRelation(m_characterRelation,
                                                     ac.getId());
@@ -239,7 +239,7 @@ void Persistence::registerCharacters(Account & ac,
 
         long intId = integerId(id);
 
-        EntityDict::const_iterator J = worldObjects.find(intId);
+        EntityTable::const_iterator J = worldObjects.find(intId);
         if (J == worldObjects.end()) {
             log(WARNING, String::compose("Persistence: Got character id \"%1\" "
                                          "from database which does not exist "
@@ -19,6 +19,8 @@
 #ifndef SERVER_PERSISTENCE_H
 #define SERVER_PERSISTENCE_H
 
+#include "common/IdMap.h"
+
 #include <Atlas/Objects/ObjectsFwd.h>
 
 #include <string>
@@ -28,7 +30,7 @@ class Account;
 class Database;
 class LocatedEntity;
 
-typedef std::map<long, LocatedEntity *> EntityDict;
+typedef IdMap<LocatedEntity *> EntityTable;
 
 /// \brief Class for managing the required database tables for persisting
 /// in-game entities and server accounts
@@ -49,7 +51,7 @@ class Persistence {
     bool findAccount(const std::string &);
     Account * getAccount(const std::string &);
     void putAccount(const Account &);
-    void registerCharacters(Account &, const EntityDict & worldObjects);
+    void registerCharacters(Account &, const EntityTable & worldObjects);
     void addCharacter(const Account &, const LocatedEntity &);
     void delCharacter(const std::string &);
     
@@ -19,6 +19,7 @@
 #ifndef SERVER_SERVER_ROUTING_H
 #define SERVER_SERVER_ROUTING_H
 
+#include "common/IdMap.h"
 #include "common/Router.h"
 #include "common/Shaker.h"
 
@@ -26,7 +27,7 @@ class Account;
 class BaseWorld;
 class Lobby;
 
-typedef std::map<long, Router *> RouterMap;
+typedef IdMap<Router *> RouterMap;
 typedef std::map<std::string, Account *> AccountDict;
 
 extern bool restricted_flag;
@@ -554,7 +554,7 @@ int StorageManager::restoreWorld()
     return 0;
 }
 
-int StorageManager::shutdown(bool& exit_flag, const std::map<long, LocatedEntity *>& entites)
+int StorageManager::shutdown(bool& exit_flag, const IdMap<LocatedEntity *>& entites)
 {
     tick();
     while (Database::instance()->queryQueueSize()) {
@@ -572,7 +572,7 @@ int StorageManager::shutdown(bool& exit_flag, const std::map<long, LocatedEntity
     return 0;
 }
 
-size_t StorageManager::requestMinds(const std::map<long, LocatedEntity *>& entites)
+size_t StorageManager::requestMinds(const IdMap<LocatedEntity *>& entites)
 {
     size_t requests = 0;
     for (auto& pair : entites) {
@@ -19,6 +19,7 @@
 #ifndef SERVER_STORAGE_MANAGER_H
 #define SERVER_STORAGE_MANAGER_H
 
+#include <common/IdMap.h>
 #include <common/OperationRouter.h>
 #include <modules/EntityRef.h>
 
@@ -111,7 +112,7 @@ class StorageManager {
     /// \brief Called when shutting down.
     ///
     /// It's expected that the storage manager attempts to persist entity state.
-    int shutdown(bool& exit_flag, const std::map<long, LocatedEntity *>& entites);
+    int shutdown(bool& exit_flag, const IdMap<LocatedEntity *>& entites);
 
     /// \brief Request thoughts from the supplied entities.
     ///
@@ -120,7 +121,7 @@ class StorageManager {
     /// \param entities A list of entities. Only those entities that have
     /// external minds will be queried.
     /// \return The number of requests sent.
-    size_t requestMinds(const std::map<long, LocatedEntity *>& entites);
+    size_t requestMinds(const IdMap<LocatedEntity *>& entites);
 
     /// \brief Gets the number of outstanding thought requests.
     size_t numberOfOutstandingThoughtRequests() const;
@@ -44,8 +44,14 @@
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
 
+#include <sigc++/adaptors/bind.h>
+#include <sigc++/functors/mem_fun.h>
+
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+
+#include <cmath>
 
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
@@ -55,39 +61,18 @@ using Atlas::Objects::Entity::Anonymous;
 
 static const bool debug_flag = false;
 
-/// \brief Type to hold an operation and the Entity it is from for efficiency
-/// when broadcasting.
-struct OpQueEntry {
-    Operation op;
-    LocatedEntity & from;
-
-    explicit OpQueEntry(const Operation & o, LocatedEntity & f);
-    OpQueEntry(const OpQueEntry & o);
-    ~OpQueEntry();
-
-    const Operation & operator*() const {
-        return op;
-    }
-
-    Atlas::Objects::Operation::RootOperationData * operator->() const {
-        return op.get();
-    }
-};
-
-inline OpQueEntry::OpQueEntry(const Operation & o, LocatedEntity & f) : op(o),
-                                                                        from(f)
+/// \brief Export the allocation statistics of a memory pool to Monitors
+static void watchPool(const std::string & name, const MemoryPool & pool)
 {
-    from.incRef();
-}
-
-inline OpQueEntry::OpQueEntry(const OpQueEntry & o) : op(o.op), from(o.from)
-{
-    from.incRef();
-}
-
-inline OpQueEntry::~OpQueEntry()
-{
-    from.decRef();
+    Monitors * monitors = Monitors::instance();
+    monitors->watch(String::compose("pool_objects{pool=%1}", name),
+                    new Variable<int>(pool.live()));
+    monitors->watch(String::compose("pool_reusable{pool=%1}", name),
+                    new Variable<int>(pool.reusable()));
+    monitors->watch(String::compose("pool_slab_kb{pool=%1}", name),
+                    new Variable<int>(pool.slabKilobytes()));
+    monitors->watch(String::compose("pool_oversize{pool=%1}", name),
+                    new Variable<int>(pool.oversize()));
 }
 
 
@@ -109,7 +94,14 @@ void WorldRouter::updateTime(const SystemTime & time)
 /// but I am not clear why. Need to look into why.
 WorldRouter::WorldRouter(const SystemTime & time) :
       BaseWorld(*new World(consts::rootWorldId, consts::rootWorldIntId)),
-      m_entityCount(1)
+      m_entityCount(1),
+      m_framePeriod(0.),
+      m_frameDue(0.),
+      m_frameCount(0),
+      m_frameTime(0),
+      m_frameOverruns(0),
+      m_partitioned(false),
+      m_resultQueue(0)
           
 {
     m_initTime = time.seconds();
@@ -118,9 +110,16 @@ WorldRouter::WorldRouter(const SystemTime & time) :
     EntityBuilder::init();
     m_gameWorld.setType(Inheritance::instance().getType("world"));
     m_eobjects[m_gameWorld.getIntId()] = &m_gameWorld;
+    m_index.addEntity(&m_gameWorld);
     m_perceptives.insert(&m_gameWorld);
     //WorldTime tmp_date("612-1-1 08:57:00");
     Monitors::instance()->watch("entities", new Variable<int>(m_entityCount));
+    Monitors::instance()->watch("frame_count", new Variable<int>(m_frameCount));
+    Monitors::instance()->watch("frame_time", new Variable<int>(m_frameTime));
+    Monitors::instance()->watch("frame_overruns",
+                                new Variable<int>(m_frameOverruns));
+    watchPool("entity", LocatedEntity::pool());
+    watchPool("property", PropertyBase::pool());
 }
 
 /// \brief Destructor for the world object.
@@ -133,8 +132,8 @@ WorldRouter::~WorldRouter()
         debug(std::cout << "Flushing world with " << m_eobjects.size()
                         << " entities" << std::endl << std::flush;);
     }
-    EntityDict::const_iterator Jend = m_eobjects.end();
-    for (EntityDict::const_iterator J = m_eobjects.begin(); J != Jend; ++J) {
+    EntityTable::const_iterator Jend = m_eobjects.end();
+    for (EntityTable::const_iterator J = m_eobjects.begin(); J != Jend; ++J) {
         J->second->decRef();
     }
     SpawnDict::const_iterator Kend = m_spawns.end();
@@ -161,7 +160,11 @@ void WorldRouter::addOperationToQueue(const Operation & op, LocatedEntity & ent)
     op->setFrom(ent.getId());
     if (!op->hasAttrFlag(Atlas::Objects::Operation::FUTURE_SECONDS_FLAG)) {
         op->setSeconds(m_realTime);
-        m_immediateQueue.push_back(OpQueEntry(op, ent));
+        if (m_resultQueue != 0) {
+            m_resultQueue->push_back(op, ent);
+        } else {
+            m_immediateQueue.push_back(op, ent);
+        }
         return;
     }
     double t = m_realTime + op->getFutureSeconds();
@@ -170,7 +173,7 @@ void WorldRouter::addOperationToQueue(const Operation & op, LocatedEntity & ent)
     OpQueue::iterator I = m_operationQueue.begin();
     OpQueue::iterator Iend = m_operationQueue.end();
     for (; I != Iend && (*I).op->getSeconds() <= t; ++I);
-    m_operationQueue.insert(I, OpQueEntry(op, ent));
+    m_operationQueue.insert(I, op, ent);
 }
 
 /// \brief Get the next due operation from the queue.
@@ -205,7 +208,13 @@ LocatedEntity * WorldRouter::addEntity(LocatedEntity * ent)
     debug(std::cout << "WorldRouter::addEntity(" << ent->getIntId() << ")" << std::endl
                     << std::flush;);
     assert(ent->getIntId() != 0);
-    m_eobjects[ent->getIntId()] = ent;
+    if (m_eobjects.insert(std::make_pair(ent->getIntId(), ent)).second) {
+        // Keep the name index up to date as the entity changes
+        ent->updated.connect(sigc::bind(sigc::mem_fun(m_index,
+                                                      &EntityIndex::updateEntity),
+                                        ent));
+    }
+    m_index.addEntity(ent);
     ++m_entityCount;
     assert(ent->m_location.isValid());
 
@@ -420,6 +429,7 @@ void WorldRouter::delEntity(LocatedEntity * ent)
     assert(ent->getIntId() != 0);
     m_perceptives.erase(ent);
     m_eobjects.erase(ent->getIntId());
+    m_index.delEntity(ent);
     --m_entityCount;
     ent->destroy();
     ent->updated.emit();
@@ -430,9 +440,34 @@ void WorldRouter::resumeWorld()
 {
     //Take all suspended operations and add them to be executed.
     for (OpQueue::const_iterator I = m_suspendedQueue.begin(); I != m_suspendedQueue.end(); ++I) {
-        addOperationToQueue(I->op, I->from);
+        addOperationToQueue(I->op, *I->from);
     }
     m_suspendedQueue.clear();
+    // The frames due while the world was suspended are skipped, rather
+    // than run late or counted as overruns.
+    m_frameDue = m_realTime;
+}
+
+/// \brief Send the Tick operations parked for entities which are now awake
+///
+/// Each Tick is sent immediately, so an entity which was asleep catches
+/// up with a single Tick rather than all those it missed. Ticks parked
+/// for entities which have since been destroyed are discarded.
+void WorldRouter::wakeEntities()
+{
+    OpQueue::iterator I = m_dormantQueue.begin();
+    OpQueue::iterator Iend = m_dormantQueue.end();
+    while (I != Iend) {
+        LocatedEntity * ent = I->from;
+        if (ent->isDestroyed()) {
+            m_dormantQueue.erase(I++);
+        } else if ((ent->getFlags() & entity_asleep) == 0) {
+            addOperationToQueue(I->op, *ent);
+            m_dormantQueue.erase(I++);
+        } else {
+            ++I;
+        }
+    }
 }
 
 
@@ -481,13 +516,21 @@ void WorldRouter::deliverTo(const Operation & op, LocatedEntity & ent)
 {
     //If the world is suspended and the op is a tick, we should store it
     //(to be resent when the world is resumed) and not process it now.
-    if (m_isSuspended) {
-        if (op->getClassNo() == Atlas::Objects::Operation::TICK_NO) {
-            m_suspendedQueue.push_back(OpQueEntry(op, ent));
+    if (op->getClassNo() == Atlas::Objects::Operation::TICK_NO) {
+        if (m_isSuspended) {
+            m_suspendedQueue.push_back(op, ent);
+            return;
+        }
+        //Likewise if the entity is asleep because no player is near it,
+        //until it is woken.
+        if (ent.getFlags() & entity_asleep) {
+            m_dormantQueue.push_back(op, ent);
             return;
         }
     }
+    // Take over the storage of the last delivery's results
     OpVector res;
+    res.swap(m_deliveryResults);
     ent.operation(op, res);
     OpVector::const_iterator Iend = res.end();
     for(OpVector::const_iterator I = res.begin(); I != Iend; ++I) {
@@ -498,6 +541,8 @@ void WorldRouter::deliverTo(const Operation & op, LocatedEntity & ent)
         }
         message(*I, ent);
     }
+    res.clear();
+    res.swap(m_deliveryResults);
 }
 
 /// \brief Main in-game operation dispatch function.
@@ -513,6 +558,16 @@ void WorldRouter::deliverTo(const Operation & op, LocatedEntity & ent)
 /// should still have a valid location, so can be used for range
 /// calculations.
 void WorldRouter::operation(const Operation & op, LocatedEntity & from)
+{
+    operation(op, from, OpQueEntry::targetId(op));
+}
+
+/// \brief Dispatch an operation whose target ID has already been parsed.
+///
+/// @param to integer ID of the target, as parsed from the TO of the
+/// operation when it was queued.
+void WorldRouter::operation(const Operation & op, LocatedEntity & from,
+                            long to)
 {
     debug(std::cout << "WorldRouter::operation {"
                     << op->getParents().front() << ":"
@@ -522,11 +577,10 @@ void WorldRouter::operation(const Operation & op, LocatedEntity & from)
     assert(!op->getParents().empty());
 
     if (!op->isDefaultTo()) {
-        const std::string & to = op->getTo();
-        assert(!to.empty());
+        assert(!op->getTo().empty());
         LocatedEntity * to_entity = 0;
 
-        if (to == from.getId()) {
+        if (to == from.getIntId()) {
             if (from.isDestroyed()) {
                 // Entity no longer exists
                 return;
@@ -536,7 +590,7 @@ void WorldRouter::operation(const Operation & op, LocatedEntity & from)
             to_entity = getEntity(to);
 
             if (to_entity == 0) {
-                debug(std::cerr << "WARNING: Op to=\"" << to << "\""
+                debug(std::cerr << "WARNING: Op to=\"" << op->getTo() << "\""
                                 << " does not exist"
                                 << std::endl << std::flush;);
                 return;
@@ -566,11 +620,20 @@ void WorldRouter::operation(const Operation & op, LocatedEntity & from)
             deliverTo(op, **I);
         }
     } else {
-        EntityDict::const_iterator I = m_eobjects.begin();
-        EntityDict::const_iterator Iend = m_eobjects.end();
+        // Delivery may add entities and grow the table, so take a copy
+        // of the entities to broadcast to first.
+        std::vector<LocatedEntity *> targets;
+        targets.reserve(m_eobjects.size());
+        EntityTable::const_iterator I = m_eobjects.begin();
+        EntityTable::const_iterator Iend = m_eobjects.end();
         for (; I != Iend; ++I) {
-            op->setTo(I->second->getId());
-            deliverTo(op, *I->second);
+            targets.push_back(I->second);
+        }
+        std::vector<LocatedEntity *>::const_iterator J = targets.begin();
+        std::vector<LocatedEntity *>::const_iterator Jend = targets.end();
+        for (; J != Jend; ++J) {
+            op->setTo((*J)->getId());
+            deliverTo(op, **J);
         }
     }
 }
@@ -586,6 +649,213 @@ void WorldRouter::addPerceptive(LocatedEntity * perceptive)
     m_perceptives.insert(perceptive);
 }
 
+/// \brief Dispatch an operation taken from one of the queues
+///
+/// Any exception thrown while the operation is handled is logged, so
+/// one bad operation does not stop the world.
+void WorldRouter::dispatchOperation(OpQueEntry & oqe)
+{
+    Dispatching.emit(oqe.op);
+    try {
+        operation(oqe.op, *oqe.from, oqe.to);
+    }
+    catch (const std::exception& ex) {
+        log(ERROR, String::compose("Exception caught in WorldRouter::idle() "
+                                   "thrown while processing operation "
+                                   "sent to \"%1\" from \"%2\": %3",
+                                   oqe->getTo(), oqe->getFrom(), ex.what()));
+    }
+    catch (...) {
+        log(ERROR, String::compose("Unspecified exception caught in WorldRouter::idle() "
+                                   "thrown while processing operation "
+                                   "sent to \"%1\" from \"%2\"",
+                                   oqe->getTo(), oqe->getFrom()));
+    }
+}
+
+/// \brief Get the key of the partition an operation is dispatched in
+///
+/// @return the integer ID of the top-level entity whose subtree contains
+/// the target of the operation, or -1 if the operation has no target in
+/// such a subtree.
+long WorldRouter::partitionKey(const OpQueEntry & oqe) const
+{
+    if (oqe.to < 0) {
+        return -1;
+    }
+    LocatedEntity * ent = getEntity(oqe.to);
+    if (ent == 0 || ent == &m_gameWorld) {
+        return -1;
+    }
+    while (ent->m_location.m_loc != &m_gameWorld) {
+        ent = ent->m_location.m_loc;
+        if (ent == 0) {
+            return -1;
+        }
+    }
+    return ent->getIntId();
+}
+
+/// \brief Dispatch the due operations grouped by the subtree they are sent to
+///
+/// The same operations are taken from the queues as by the usual dispatch,
+/// and grouped by the top-level entity whose subtree contains their
+/// target. The groups are dispatched one after another in order of the
+/// ID of that entity, each keeping the order of its operations in the
+/// queues. The operations for immediate dispatch generated by each group
+/// are kept apart, and merged into the queue in the same order once all
+/// the groups are done, so the result does not depend on the order the
+/// groups run in. Operations which are broadcast, or sent to the world
+/// itself, cross the partitions, and are dispatched after the merge.
+/// The groups are still run on the world thread.
+/// @return the count used to limit the number of operations dispatched
+unsigned int WorldRouter::dispatchPartitioned()
+{
+    PartitionDict partitions;
+    OpQueue cross_partition;
+
+    unsigned int op_count = 0;
+    OpQueue::iterator I = m_operationQueue.begin();
+    OpQueue::iterator Iend = m_operationQueue.end();
+    while (++op_count < 10 && I != Iend && (*I)->getSeconds() <= m_realTime) {
+        long key = partitionKey(*I);
+        OpQueue & ops = key < 0 ? cross_partition : partitions[key].ops;
+        ops.push_back(I->op, *I->from);
+        m_operationQueue.erase(I);
+        I = m_operationQueue.begin();
+    }
+
+    I = m_immediateQueue.begin();
+    Iend = m_immediateQueue.end();
+    while (++op_count < 10 && I != Iend) {
+        long key = partitionKey(*I);
+        OpQueue & ops = key < 0 ? cross_partition : partitions[key].ops;
+        ops.push_back(I->op, *I->from);
+        m_immediateQueue.erase(I);
+        I = m_immediateQueue.begin();
+    }
+
+    PartitionDict::iterator J = partitions.begin();
+    PartitionDict::iterator Jend = partitions.end();
+    for (; J != Jend; ++J) {
+        DispatchPartition & partition = J->second;
+        m_resultQueue = &partition.results;
+        while (!partition.ops.empty()) {
+            dispatchOperation(*partition.ops.begin());
+            partition.ops.pop_front();
+        }
+        m_resultQueue = 0;
+    }
+
+    for (J = partitions.begin(); J != Jend; ++J) {
+        OpQueue & results = J->second.results;
+        while (!results.empty()) {
+            m_immediateQueue.push_back(results.begin()->op,
+                                       *results.begin()->from);
+            results.pop_front();
+        }
+    }
+
+    while (!cross_partition.empty()) {
+        dispatchOperation(*cross_partition.begin());
+        cross_partition.pop_front();
+    }
+    return op_count;
+}
+
+/// \brief Run each of the registered systems
+///
+/// @param time the world time passed to the systems
+void WorldRouter::runSystems(double time)
+{
+    FrameSystemList::iterator I = m_systems.begin();
+    FrameSystemList::iterator Iend = m_systems.end();
+    for (; I != Iend; ++I) {
+        std::chrono::steady_clock::time_point start =
+              std::chrono::steady_clock::now();
+        I->tick(time);
+        I->time = std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+/// \brief Run a frame of the simulation
+///
+/// The systems are run with the world time at which the frame was due,
+/// so each frame advances the systems by exactly one frame period. The
+/// operations they queue for immediate dispatch, such as perception of
+/// the changes they made, are then dispatched together. Operations queued
+/// while those are dispatched wait for the next call to idle().
+void WorldRouter::runFrame()
+{
+    std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+
+    runSystems(m_frameDue);
+
+    std::size_t count = m_immediateQueue.size();
+    for (std::size_t i = 0; i < count && !m_immediateQueue.empty(); ++i) {
+        dispatchOperation(*m_immediateQueue.begin());
+        m_immediateQueue.pop_front();
+    }
+
+    // If the server has fallen behind, don't try to catch up.
+    m_frameDue += m_framePeriod;
+    if (m_frameDue <= m_realTime) {
+        m_frameDue = m_realTime + m_framePeriod;
+        ++m_frameOverruns;
+    }
+    ++m_frameCount;
+    m_frameTime = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start).count();
+}
+
+/// \brief Register a native system to be run by the world
+///
+/// Systems are run in the order they are registered, after the operations
+/// due have been dispatched. The time taken by each system the last time
+/// it was run is published as a monitor.
+/// @param name name of the system, used to name its monitor
+/// @param tick slot called with the world time when the system is run
+void WorldRouter::addSystem(const std::string & name,
+                            const sigc::slot<void, double> & tick)
+{
+    m_systems.push_back(FrameSystem());
+    FrameSystem & system = m_systems.back();
+    system.name = name;
+    system.tick = tick;
+    Monitors::instance()->watch(String::compose("frame_system_time{system=%1}", name),
+                                new Variable<int>(system.time));
+}
+
+/// \brief Set the rate at which frames of the simulation are run
+///
+/// @param rate number of frames each second, or zero to run the systems
+/// each time the world is idle, with the current world time.
+void WorldRouter::setFrameRate(double rate)
+{
+    m_framePeriod = rate > 0. ? 1. / rate : 0.;
+    m_frameDue = m_realTime;
+}
+
+/// \brief Get the time the server may sleep waiting for client traffic
+///
+/// If a frame rate has been set, the sleep ends when the next frame is due,
+/// so frames are not run up to a whole sleep late.
+/// @param max_wait longest time to sleep in milliseconds
+/// @return time to sleep in milliseconds
+int WorldRouter::pollTimeout(int max_wait) const
+{
+    if (m_framePeriod <= 0. || m_isSuspended) {
+        return max_wait;
+    }
+    double wait = std::ceil((m_frameDue - m_realTime) * 1000.);
+    if (wait <= 0.) {
+        return 0;
+    }
+    return wait < max_wait ? static_cast<int>(wait) : max_wait;
+}
+
 /// Main world loop function.
 /// This function is called whenever the communications code is idle.
 /// It updates the in-game time, and dispatches operations that are
@@ -596,60 +866,46 @@ void WorldRouter::addPerceptive(LocatedEntity * perceptive)
 /// will call this function again as soon as possible rather than sleeping.
 /// This ensures that the maximum possible number of operations are dispatched
 /// without becoming unresponsive to client communications traffic.
+/// If partitioned dispatch is enabled, the operations are dispatched
+/// grouped by the subtree of the world they are sent to.
+/// The registered systems are then run, either every call, or once each
+/// frame if a frame rate has been set, unless the world is suspended.
 /// @param sec world time seconds component
 /// @param usec world time microseconds component
 bool WorldRouter::idle(const SystemTime & time)
 {
     updateTime(time);
-	unsigned int op_count = 0;
-	OpQueue::iterator I = m_operationQueue.begin();
-	OpQueue::iterator Iend = m_operationQueue.end();
-    while (++op_count < 10 && I != Iend && (*I)->getSeconds() <= m_realTime) {
-        assert(I != m_operationQueue.end());
-        OpQueEntry & oqe = *I;
-        Dispatching.emit(oqe.op);
-        try {
-            operation(oqe.op, oqe.from);
-        }
-        catch (const std::exception& ex) {
-            log(ERROR, String::compose("Exception caught in WorldRouter::idle() "
-                                       "thrown while processing operation "
-                                       "sent to \"%1\" from \"%2\": %3",
-                                       oqe->getTo(), oqe->getFrom(), ex.what()));
+    unsigned int op_count = 0;
+    if (m_partitioned) {
+        op_count = dispatchPartitioned();
+    } else {
+        OpQueue::iterator I = m_operationQueue.begin();
+        OpQueue::iterator Iend = m_operationQueue.end();
+        while (++op_count < 10 && I != Iend &&
+               (*I)->getSeconds() <= m_realTime) {
+            assert(I != m_operationQueue.end());
+            dispatchOperation(*I);
+            m_operationQueue.erase(I);
+            I = m_operationQueue.begin();
         }
-        catch (...) {
-            log(ERROR, String::compose("Unspecified exception caught in WorldRouter::idle() "
-                                       "thrown while processing operation "
-                                       "sent to \"%1\" from \"%2\"",
-                                       oqe->getTo(), oqe->getFrom()));
+
+        I = m_immediateQueue.begin();
+        Iend = m_immediateQueue.end();
+        while (++op_count < 10 && I != Iend) {
+            assert(I != m_immediateQueue.end());
+            dispatchOperation(*I);
+            m_immediateQueue.erase(I);
+            I = m_immediateQueue.begin();
         }
-        m_operationQueue.erase(I);
-        I = m_operationQueue.begin();
     }
 
-    I = m_immediateQueue.begin();
-    Iend = m_immediateQueue.end();
-    while (++op_count < 10 && I != Iend) {
-        assert(I != m_immediateQueue.end());
-        OpQueEntry & oqe = *I;
-        Dispatching.emit(oqe.op);
-        try {
-            operation(oqe.op, oqe.from);
+    // The systems stop along with the Ticks while the world is suspended.
+    if (!m_isSuspended) {
+        if (m_framePeriod <= 0.) {
+            runSystems(m_realTime);
+        } else if (m_frameDue <= m_realTime) {
+            runFrame();
         }
-        catch (const std::exception& ex) {
-            log(ERROR, String::compose("Exception caught in WorldRouter::idle() "
-                                       "thrown while processing operation "
-                                       "sent to \"%1\" from \"%2\": %3",
-                                       oqe->getTo(), oqe->getFrom(), ex.what()));
-        }
-        catch (...) {
-            log(ERROR, String::compose("Unspecified exception caught in WorldRouter::idle() "
-                                       "thrown while processing operation "
-                                       "sent to \"%1\" from \"%2\"",
-                                       oqe->getTo(), oqe->getFrom()));
-        }
-        m_immediateQueue.erase(I);
-        I = m_immediateQueue.begin();
     }
     // If we have processed the maximum number for this call, return true
     // to tell the server not to sleep when polling clients. This ensures
@@ -659,38 +915,44 @@ bool WorldRouter::idle(const SystemTime & time)
 }
 
 /// Find an entity of the given name. This is provided to allow administrators
-/// to perform certain admin tasks. It finds and returns the first instance
-/// with the name provided in the game world.
+/// to perform certain admin tasks. It finds and returns the instance with
+/// the lowest ID with the name provided in the game world.
 /// @param name string specifying name of the instance required.
 /// @return a pointer to an entity with the type required, or zero if an
 /// instance with this name was not found.
 LocatedEntity * WorldRouter::findByName(const std::string & name)
 {
-    Element name_attr;
-    EntityDict::const_iterator Iend = m_eobjects.end();
-    for (EntityDict::const_iterator I = m_eobjects.begin(); I != Iend; ++I) {
-        if (I->second->getAttr("name", name_attr) == 0) {
-            if (name_attr == name) {
-                return I->second;
-            }
-        }
-    }
-    return NULL;
+    return m_index.findByName(name);
 }
 
 /// Find an entity of the given type. This is provided to allow administrators
-/// to perform certain admin tasks. It finds and returns the first instance
-/// of the type provided in the game world.
+/// to perform certain admin tasks. It finds and returns the instance with
+/// the lowest ID of the type provided in the game world.
 /// @param type string specifying the class name of the instance required.
 /// @return a pointer to an entity of the type required, or zero if no
 /// instance was found.
 LocatedEntity * WorldRouter::findByType(const std::string & type)
 {
-    EntityDict::const_iterator Iend = m_eobjects.end();
-    for(EntityDict::const_iterator I = m_eobjects.begin(); I != Iend; ++I) {
-        if (I->second->getType()->name() == type) {
-            return I->second;
-        }
-    }
-    return NULL;
+    return m_index.findByType(type);
+}
+
+/// Find all the entities of the given name.
+/// @param name string specifying name of the instances required.
+/// @param res the entities found are appended to this list.
+void WorldRouter::findAllByName(const std::string & name,
+                                std::vector<LocatedEntity *> & res)
+{
+    m_index.findAllByName(name, res);
+}
+
+/// Find all the entities of the given type.
+/// @param type string specifying the class name of the instances required.
+/// @param res the entities found are appended to this list.
+/// @param subtypes if true, instances of types which inherit from the
+/// given type are also found.
+void WorldRouter::findAllByType(const std::string & type,
+                                std::vector<LocatedEntity *> & res,
+                                bool subtypes)
+{
+    m_index.findAllByType(type, res, subtypes);
 }
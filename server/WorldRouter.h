@@ -19,20 +19,46 @@
 #ifndef SERVER_WORLD_ROUTER_H
 #define SERVER_WORLD_ROUTER_H
 
+#include "EntityIndex.h"
+#include "OpQueue.h"
+
 #include "common/BaseWorld.h"
 
+#include <sigc++/slot.h>
+
 #include <list>
+#include <map>
 #include <set>
 
 #include <ctime>
 
 class Spawn;
 
-struct OpQueEntry;
+/// \brief A native system registered to be run by the world
+struct FrameSystem {
+    /// Name of the system, used to name its monitor
+    std::string name;
+    /// Called with the world time when the system is run
+    sigc::slot<void, double> tick;
+    /// Time in microseconds taken the last time the system was run
+    int time;
+
+    FrameSystem() : time(0) { }
+};
 
-typedef std::list<OpQueEntry> OpQueue;
 typedef std::set<LocatedEntity *> EntitySet;
 typedef std::map<std::string, Spawn *> SpawnDict;
+typedef std::list<FrameSystem> FrameSystemList;
+
+/// \brief Operations due for dispatch to one top-level subtree of the world
+struct DispatchPartition {
+    /// Operations sent to entities in the subtree, in queue order
+    OpQueue ops;
+    /// Operations for immediate dispatch generated by the subtree
+    OpQueue results;
+};
+
+typedef std::map<long, DispatchPartition> PartitionDict;
 
 /// \brief WorldRouter encapsulates the game world running in the server.
 ///
@@ -47,14 +73,38 @@ class WorldRouter : public BaseWorld {
     OpQueue m_immediateQueue;
     /// An ordered queue of suspended operations to be dispatched when resumed.
     OpQueue m_suspendedQueue;
+    /// An ordered queue of Tick operations parked for sleeping entities.
+    OpQueue m_dormantQueue;
     /// The system time when the server was started.
     std::time_t m_initTime;
     /// List of perceptive entities.
     EntitySet m_perceptives;
+    /// Index of entities by name and type.
+    EntityIndex m_index;
     /// Count of in world entities
     int m_entityCount;
     /// Map of spawns
     SpawnDict m_spawns;
+    /// Buffer for the results of each delivery, kept to reuse its storage
+    OpVector m_deliveryResults;
+    /// Native systems run by the world, in the order they are run
+    FrameSystemList m_systems;
+    /// World time in seconds between frames, or zero if systems are run
+    /// every time the world is idle
+    double m_framePeriod;
+    /// World time at which the next frame is due
+    double m_frameDue;
+    /// Number of frames run
+    int m_frameCount;
+    /// Time in microseconds taken to run the last frame
+    int m_frameTime;
+    /// Number of frames which finished after the next was due
+    int m_frameOverruns;
+    /// Whether due operations are dispatched grouped by subtree
+    bool m_partitioned;
+    /// Queue for operations for immediate dispatch, while a partition is
+    /// dispatched, or zero
+    OpQueue * m_resultQueue;
   protected:
     void addOperationToQueue(const Atlas::Objects::Operation::RootOperation &,
                              LocatedEntity &);
@@ -63,6 +113,13 @@ class WorldRouter : public BaseWorld {
     void updateTime(const SystemTime &);
     void deliverTo(const Atlas::Objects::Operation::RootOperation &,
                    LocatedEntity &);
+    void operation(const Atlas::Objects::Operation::RootOperation &,
+                   LocatedEntity &, long);
+    void dispatchOperation(OpQueEntry &);
+    long partitionKey(const OpQueEntry &) const;
+    unsigned int dispatchPartitioned();
+    void runSystems(double time);
+    void runFrame();
     void resumeWorld();
   public:
     explicit WorldRouter(const SystemTime &);
@@ -91,11 +148,32 @@ class WorldRouter : public BaseWorld {
     void operation(const Atlas::Objects::Operation::RootOperation &,
                    LocatedEntity &);
 
+    void addSystem(const std::string & name,
+                   const sigc::slot<void, double> & tick);
+    void setFrameRate(double rate);
+    int pollTimeout(int max_wait) const;
+
+    /// \brief Set whether due operations are dispatched grouped by subtree
+    void setPartitioned(bool partitioned) {
+        m_partitioned = partitioned;
+    }
+
+    /// \brief Read only accessor for the number of frames run
+    int frameCount() const {
+        return m_frameCount;
+    }
+
     virtual void addPerceptive(LocatedEntity *);
+    virtual void wakeEntities();
     virtual void message(const Atlas::Objects::Operation::RootOperation &,
                          LocatedEntity &);
     virtual LocatedEntity * findByName(const std::string & name);
     virtual LocatedEntity * findByType(const std::string & type);
+    virtual void findAllByName(const std::string & name,
+                               std::vector<LocatedEntity *> & res);
+    virtual void findAllByType(const std::string & type,
+                               std::vector<LocatedEntity *> & res,
+                               bool subtypes);
 
     /// \brief Signal that a new Entity has been inserted.
     sigc::signal<void, LocatedEntity *> inserted;
@@ -48,7 +48,15 @@
 #include "TeleportAuthenticator.h"
 #include "TrustedConnection.h"
 
+#include "rulesets/BroadPhase.h"
 #include "rulesets/BulletDomain.h"
+#include "rulesets/MetabolismSystem.h"
+#include "rulesets/MovementSystem.h"
+#include "rulesets/MindLodScheduler.h"
+#include "rulesets/PlantGrowthSystem.h"
+#include "rulesets/PythonTickSystem.h"
+#include "rulesets/RegionSleepSystem.h"
+#include "rulesets/VisibilityGrid.h"
 #include "rulesets/Python_API.h"
 
 #include "common/id.h"
@@ -93,6 +101,26 @@ BOOL_OPTION(useMetaserver, true, CYPHESIS, "usemetaserver",
 STRING_OPTION(mserver, "metaserver.worldforge.org", CYPHESIS, "metaserver",
               "Hostname to use as the metaserver");
 
+STRING_OPTION(mind_lod_tiers, "", CYPHESIS, "mindlod",
+              "Space separated distance:tickscale:perceptioninterval tiers "
+              "used to schedule NPC minds far from any player");
+
+INT_OPTION(region_sleep_size, 0, CYPHESIS, "regionsleep",
+           "Size in metres of the regions in which entities sleep while no "
+           "player is near. Zero disables sleeping");
+
+INT_OPTION(frame_rate, 0, CYPHESIS, "framerate",
+           "Number of frames each second in which the native systems are "
+           "run. Zero runs them every time the world is idle");
+
+BOOL_OPTION(partitioned_dispatch, false, CYPHESIS, "partitioneddispatch",
+            "Flag to dispatch the operations due in the world grouped by "
+            "the top-level entity they are sent to");
+
+STRING_OPTION(movement_domain, "legacy", CYPHESIS, "domain",
+              "Movement domain used for collision detection and ground "
+              "clamping in the world, either legacy or bullet");
+
 int main(int argc, char ** argv)
 {
     if (security_init() != 0) {
@@ -194,13 +222,51 @@ int main(int argc, char ** argv)
     init_python_api(ruleset_name);
 
     Inheritance::instance();
-    new BulletDomain;
+
+    if (MindLodScheduler::instance()->configure(mind_lod_tiers) != 0) {
+        log(ERROR, "Invalid mind LOD tiers. Minds will not be scheduled "
+                   "by distance.");
+    }
+
+    RegionSleepSystem::instance()->setRegionSize(region_sleep_size);
 
     SystemTime time;
     time.update();
 
     WorldRouter * world = new WorldRouter(time);
 
+    if (movement_domain == "bullet") {
+        new BulletDomain(world->m_gameWorld);
+    } else {
+        if (movement_domain != "legacy") {
+            log(ERROR, String::compose("Unknown movement domain \"%1\". "
+                                       "Using legacy domain.",
+                                       movement_domain));
+        }
+        new Domain;
+    }
+
+    // The native systems are run by the world, in this order.
+    world->addSystem("domain",
+                     sigc::mem_fun(*Domain::instance(), &Domain::tick));
+    world->addSystem("python_tick",
+                     sigc::mem_fun(*PythonTickSystem::instance(),
+                                   &PythonTickSystem::tick));
+    world->addSystem("metabolism",
+                     sigc::mem_fun(*MetabolismSystem::instance(),
+                                   &MetabolismSystem::tick));
+    world->addSystem("movement",
+                     sigc::mem_fun(*MovementSystem::instance(),
+                                   &MovementSystem::tick));
+    world->addSystem("plant_growth",
+                     sigc::mem_fun(*PlantGrowthSystem::instance(),
+                                   &PlantGrowthSystem::tick));
+    world->addSystem("region_sleep",
+                     sigc::mem_fun(*RegionSleepSystem::instance(),
+                                   &RegionSleepSystem::tick));
+    world->setFrameRate(frame_rate);
+    world->setPartitioned(partitioned_dispatch);
+
     Ruleset::init(ruleset_name);
 
     TeleportAuthenticator::init();
@@ -399,7 +465,8 @@ int main(int argc, char ** argv)
             time.update();
             bool busy = world->idle(time);
             commServer->idle(time, busy);
-            commServer->poll(busy);
+            // Wake in time for the next frame of the world
+            commServer->poll(busy, world->pollTimeout(100));
             if (soft_exit_in_progess) {
                 //If we're in soft exit mode and either the deadline has been exceeded
                 //or we've persisted all minds we should shut down normally.
@@ -477,6 +544,19 @@ int main(int argc, char ** argv)
 
     delete store;
 
+    // Release the entities held by batched systems while the world
+    // still exists.
+    PythonTickSystem::del();
+    MetabolismSystem::del();
+    MovementSystem::del();
+    PlantGrowthSystem::del();
+    RegionSleepSystem::del();
+
+    // The grids are keyed by the containers they cover, so they go before
+    // the world.
+    BroadPhase::flush();
+    VisibilityGrid::flush();
+
     delete world;
 
     Persistence::instance()->shutdown();
@@ -484,6 +564,7 @@ int main(int argc, char ** argv)
     EntityBuilder::instance()->flushFactories();
     EntityBuilder::del();
     ArithmeticBuilder::del();
+    MindLodScheduler::del();
     TeleportAuthenticator::del();
 
     Inheritance::clear();
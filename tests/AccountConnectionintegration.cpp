@@ -480,7 +480,7 @@ Persistence * Persistence::instance()
 }
 
 void Persistence::registerCharacters(Account & ac,
-                                     const EntityDict & worldObjects)
+                                     const EntityTable & worldObjects)
 {
 }
 
@@ -366,6 +366,7 @@ LocatedEntity * TestWorld::addNewEntity(const std::string &,
 #include "server/TeleportProperty.h"
 
 #include "rulesets/Motion.h"
+#include "rulesets/VisibilityGrid.h"
 #include "rulesets/Pedestrian.h"
 #include "rulesets/AreaProperty.h"
 #include "rulesets/AtlasProperties.h"
@@ -562,7 +563,7 @@ void Persistence::putAccount(const Account & ac)
 }
 
 void Persistence::registerCharacters(Account & ac,
-                                     const EntityDict & worldObjects)
+                                     const EntityTable & worldObjects)
 {
 }
 
@@ -1101,6 +1102,104 @@ void TerrainModProperty::remove(LocatedEntity * owner)
 {
 }
 
+#include "rulesets/MetabolismSystem.h"
+#include "rulesets/MovementSystem.h"
+#include "rulesets/MindLodScheduler.h"
+
+MindLodScheduler * MindLodScheduler::m_instance = 0;
+
+MindLodScheduler::MindLodScheduler() : m_monitored(0)
+{
+}
+
+MindLodScheduler::~MindLodScheduler()
+{
+}
+
+MindLodScheduler * MindLodScheduler::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MindLodScheduler;
+    }
+    return m_instance;
+}
+
+void MindLodScheduler::addPlayer(LocatedEntity *)
+{
+}
+
+void MindLodScheduler::removePlayer(LocatedEntity *)
+{
+}
+
+void MindLodScheduler::removeMind(LocatedEntity *)
+{
+}
+
+void MindLodScheduler::scheduleTick(LocatedEntity &, const Operation &)
+{
+}
+
+bool MindLodScheduler::checkTick(LocatedEntity &, const Operation &)
+{
+    return true;
+}
+
+bool MindLodScheduler::checkPerception(LocatedEntity &, const Operation &)
+{
+    return true;
+}
+
+void MindLodScheduler::playerMoved(LocatedEntity &)
+{
+}
+
+MetabolismSystem * MetabolismSystem::m_instance = 0;
+
+MetabolismSystem::MetabolismSystem()
+{
+}
+
+MetabolismSystem::~MetabolismSystem()
+{
+}
+
+MetabolismSystem * MetabolismSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MetabolismSystem;
+    }
+    return m_instance;
+}
+
+int MetabolismSystem::addEntity(Character *)
+{
+    return 0;
+}
+
+MovementSystem * MovementSystem::m_instance = 0;
+
+MovementSystem::MovementSystem()
+{
+}
+
+MovementSystem::~MovementSystem()
+{
+}
+
+MovementSystem * MovementSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MovementSystem;
+    }
+    return m_instance;
+}
+
+int MovementSystem::addEntity(Character *)
+{
+    return 0;
+}
+
 Pedestrian::Pedestrian(LocatedEntity & body) : Movement(body)
 {
 }
@@ -1487,6 +1586,35 @@ void Motion::setMode(const std::string & mode)
 {
 }
 
+VisibilityGrid * VisibilityGrid::forContainer(const LocatedEntity & container,
+                                              double time)
+{
+    return 0;
+}
+
+void VisibilityGrid::moved(LocatedEntity & entity)
+{
+}
+
+float VisibilityGrid::sightRange(float squareBoxSize)
+{
+    return 0.f;
+}
+
+int VisibilityGrid::sightBox(const Point3D & old_pos, const Point3D & new_pos,
+                             float range, BBox & box)
+{
+    return -1;
+}
+
+void BroadPhase::update(LocatedEntity * entity)
+{
+}
+
+void BroadPhase::query(const BBox & box, CandidateList & res)
+{
+}
+
 void Motion::adjustPostion()
 {
 }
@@ -1659,6 +1787,11 @@ bool TypeNode::isTypeOf(const std::string & base_type) const
     return false;
 }
 
+bool TypeNode::isTypeOf(const TypeNode * base_type) const
+{
+    return false;
+}
+
 void TypeNode::addProperties(const Atlas::Message::MapType & attributes)
 {
 }
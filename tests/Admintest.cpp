@@ -157,6 +157,7 @@ class Admintest : public Cyphesis::TestBase
     void test_GetOperation_obj_OOG();
     void test_GetOperation_obj_IG();
     void test_GetOperation_obj_not_found();
+    void test_GetOperation_by_name_not_found();
     void test_GetOperation_rule_found();
     void test_GetOperation_rule_not_found();
     void test_GetOperation_unknown();
@@ -283,6 +284,7 @@ Admintest::Admintest() : m_server(0),
     ADD_TEST(Admintest::test_GetOperation_obj_OOG);
     ADD_TEST(Admintest::test_GetOperation_obj_IG);
     ADD_TEST(Admintest::test_GetOperation_obj_not_found);
+    ADD_TEST(Admintest::test_GetOperation_by_name_not_found);
     ADD_TEST(Admintest::test_GetOperation_rule_found);
     ADD_TEST(Admintest::test_GetOperation_rule_not_found);
     ADD_TEST(Admintest::test_GetOperation_unknown);
@@ -814,6 +816,25 @@ void Admintest::test_GetOperation_obj_not_found()
                  Atlas::Objects::Operation::ERROR_NO);
 }
 
+void Admintest::test_GetOperation_by_name_not_found()
+{
+    Atlas::Objects::Operation::Get op;
+    OpVector res;
+
+    Anonymous arg;
+    arg->setObjtype("by_name");
+    arg->setId("nobody");
+    op->setArgs1(arg);
+
+    m_account->GetOperation(op, res);
+
+    // A query which matches nothing is not an error
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front()->getClassNo(),
+                 Atlas::Objects::Operation::INFO_NO);
+    ASSERT_TRUE(res.front()->getArgs().empty());
+}
+
 void Admintest::test_GetOperation_rule_found()
 {
     Atlas::Objects::Operation::Get op;
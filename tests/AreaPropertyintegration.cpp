@@ -156,6 +156,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return 0.f;
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
 }
@@ -0,0 +1,199 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "rulesets/ArithmeticExpression.h"
+#include "rulesets/ArithmeticScript.h"
+
+#include <map>
+
+#include <cassert>
+#include <cmath>
+
+class TestArithmeticScript : public ArithmeticScript
+{
+  public:
+    std::map<std::string, float> m_values;
+
+    virtual int attribute(const std::string & name, float & val) {
+        std::map<std::string, float>::const_iterator I = m_values.find(name);
+        if (I == m_values.end()) {
+            return -1;
+        }
+        val = I->second;
+        return 0;
+    }
+    virtual void set(const std::string & name, const float & val) {
+        m_values[name] = val;
+    }
+};
+
+static float evaluate(const std::string & source, ArithmeticScript & context)
+{
+    ArithmeticExpression e;
+    int ret = e.compile(source);
+    assert(ret == 0);
+    assert(e.isValid());
+    float val = -12345.f;
+    ret = e.evaluate(context, val);
+    assert(ret == 0);
+    return val;
+}
+
+static bool fails(const std::string & source)
+{
+    ArithmeticExpression e;
+    int ret = e.compile(source);
+    if (ret == 0) {
+        return false;
+    }
+    assert(!e.isValid());
+    return true;
+}
+
+int main()
+{
+    TestArithmeticScript tas;
+    tas.set("mass", 60.f);
+    tas.set("attack", 2.f);
+    tas.set("skill_1", 0.5f);
+
+    {
+        ArithmeticExpression e;
+        assert(!e.isValid());
+        float val;
+        assert(e.evaluate(tas, val) != 0);
+    }
+
+    assert(evaluate("1", tas) == 1.f);
+    assert(evaluate(" 2.5 ", tas) == 2.5f);
+    assert(evaluate("1e2", tas) == 100.f);
+    assert(evaluate("1 + 2 * 3", tas) == 7.f);
+    assert(evaluate("(1 + 2) * 3", tas) == 9.f);
+    assert(evaluate("10 - 4 - 3", tas) == 3.f);
+    assert(evaluate("12 / 3 / 2", tas) == 2.f);
+    assert(evaluate("-3 + 5", tas) == 2.f);
+    assert(evaluate("--3", tas) == 3.f);
+    assert(evaluate("+3", tas) == 3.f);
+    assert(evaluate("2 ^ 3 ^ 2", tas) == 512.f);
+    assert(evaluate("-2 ^ 2", tas) == -4.f);
+    assert(evaluate("2 ^ -1", tas) == 0.5f);
+    assert(evaluate("min(3, 4)", tas) == 3.f);
+    assert(evaluate("max(3, 4)", tas) == 4.f);
+    assert(evaluate("abs(-3)", tas) == 3.f);
+    assert(evaluate("sqrt(16)", tas) == 4.f);
+    assert(evaluate("pow(2, 10)", tas) == 1024.f);
+    assert(evaluate("max(min(1, 2), min(3, 4) + 1)", tas) == 4.f);
+
+    // Names are looked up in the context
+    assert(evaluate("mass", tas) == 60.f);
+    assert(evaluate("mass / 10 + attack * skill_1", tas) == 7.f);
+
+    // Each name is only recorded once
+    {
+        ArithmeticExpression e;
+        int ret = e.compile("mass * mass + attack - mass");
+        assert(ret == 0);
+        assert(e.symbols().size() == 2);
+        assert(e.symbols()[0] == "mass");
+        assert(e.symbols()[1] == "attack");
+    }
+
+    // Unknown names and division by zero leave a formula with no value
+    {
+        ArithmeticExpression e;
+        int ret = e.compile("mass + defence");
+        assert(ret == 0);
+        float val;
+        ret = e.evaluate(tas, val);
+        assert(ret != 0);
+
+        ret = e.compile("mass / (attack - 2)");
+        assert(ret == 0);
+        ret = e.evaluate(tas, val);
+        assert(ret != 0);
+
+        tas.set("defence", 1.f);
+        ret = e.compile("mass + defence");
+        assert(ret == 0);
+        ret = e.evaluate(tas, val);
+        assert(ret == 0);
+        assert(val == 61.f);
+    }
+
+    // Compiling again replaces the previous formula
+    {
+        ArithmeticExpression e;
+        int ret = e.compile("mass");
+        assert(ret == 0);
+        ret = e.compile("1 +");
+        assert(ret != 0);
+        assert(!e.isValid());
+        assert(e.symbols().empty());
+    }
+
+    assert(fails(""));
+    assert(fails("   "));
+    assert(fails("1 +"));
+    assert(fails("(1 + 2"));
+    assert(fails("1 + 2)"));
+    assert(fails("1 2"));
+    assert(fails("mass attack"));
+    assert(fails("1 $ 2"));
+    assert(fails("."));
+    assert(fails("cos(1)"));
+    assert(fails("min(1)"));
+    assert(fails("min(1, 2, 3)"));
+    assert(fails("sqrt(1, 2)"));
+    assert(fails("abs 1"));
+
+    // Very deeply nested formulas are rejected rather than overflowing
+    {
+        std::string deep;
+        for (int i = 0; i < 40; ++i) {
+            deep += "1 + (";
+        }
+        deep += "1";
+        for (int i = 0; i < 40; ++i) {
+            deep += ")";
+        }
+        assert(fails(deep));
+
+        std::string wide = "1";
+        for (int i = 0; i < 100; ++i) {
+            wide += " + 1";
+        }
+        assert(evaluate(wide, tas) == 101.f);
+    }
+
+    return 0;
+}
+
+// stubs
+
+#include "common/log.h"
+
+void log(LogLevel lvl, const std::string & msg)
+{
+}
@@ -0,0 +1,66 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef TESTS_BENCHMARK_TIMER_H
+#define TESTS_BENCHMARK_TIMER_H
+
+#include "common/SystemTime.h"
+
+#include <iostream>
+#include <string>
+
+/// \brief Wall clock timer used by the benchmark programs
+///
+/// Benchmarks are not run as part of make check. They are built on demand
+/// with make <name> in the tests directory.
+class BenchmarkTimer {
+  protected:
+    SystemTime m_start;
+  public:
+    BenchmarkTimer() {
+        m_start.update();
+    }
+
+    /// \brief Restart the timer
+    void reset() {
+        m_start.update();
+    }
+
+    /// \brief Microseconds since the timer was started
+    long elapsed() const {
+        SystemTime now;
+        now.update();
+        return (now.seconds() - m_start.seconds()) * 1000000L +
+               (now.microseconds() - m_start.microseconds());
+    }
+
+    /// \brief Print the time taken for a number of iterations of a task
+    ///
+    /// @param name description of the task timed
+    /// @param iterations number of times the task was performed
+    void report(const std::string & name, long iterations) const {
+        long usec = elapsed();
+        std::cout << name << ": " << iterations << " in " << usec << "us";
+        if (iterations > 0) {
+            std::cout << " (" << (usec * 1000.) / iterations << "ns each)";
+        }
+        std::cout << std::endl << std::flush;
+    }
+};
+
+#endif // TESTS_BENCHMARK_TIMER_H
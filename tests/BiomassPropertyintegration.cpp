@@ -135,6 +135,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return 0.f;
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
 }
@@ -180,7 +187,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 {
     long intId = integerId(id);
 
-    EntityDict::const_iterator I = m_eobjects.find(intId);
+    EntityTable::const_iterator I = m_eobjects.find(intId);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -191,7 +198,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 
 LocatedEntity * BaseWorld::getEntity(long id) const
 {
-    EntityDict::const_iterator I = m_eobjects.find(id);
+    EntityTable::const_iterator I = m_eobjects.find(id);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -0,0 +1,375 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "rulesets/BroadPhase.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include "common/compose.hpp"
+
+#include <wfmath/stream.h>
+
+#include <cmath>
+
+class TestEntity : public LocatedEntity
+{
+  public:
+    TestEntity(const std::string & id, long intId) : LocatedEntity(id, intId)
+    {
+    }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+    virtual void destroy() { }
+};
+
+class BroadPhasetest : public Cyphesis::TestBase
+{
+  private:
+    TestEntity * m_world;
+    TestEntity * m_near;
+    TestEntity * m_far;
+    TestEntity * m_moving;
+
+    TestEntity * addEntity(long id, const Point3D & pos);
+  public:
+    BroadPhasetest();
+
+    void setup();
+    void teardown();
+
+    void test_sweptBox();
+    void test_sweptBox_no_box();
+    void test_sweptBox_oriented();
+    void test_query();
+    void test_query_moving();
+    void test_query_large();
+    void test_update();
+    void test_forContainer();
+};
+
+BroadPhasetest::BroadPhasetest()
+{
+    ADD_TEST(BroadPhasetest::test_sweptBox);
+    ADD_TEST(BroadPhasetest::test_sweptBox_no_box);
+    ADD_TEST(BroadPhasetest::test_sweptBox_oriented);
+    ADD_TEST(BroadPhasetest::test_query);
+    ADD_TEST(BroadPhasetest::test_query_moving);
+    ADD_TEST(BroadPhasetest::test_query_large);
+    ADD_TEST(BroadPhasetest::test_update);
+    ADD_TEST(BroadPhasetest::test_forContainer);
+}
+
+TestEntity * BroadPhasetest::addEntity(long id, const Point3D & pos)
+{
+    TestEntity * e = new TestEntity(String::compose("%1", id), id);
+    e->m_location.m_loc = m_world;
+    e->m_location.m_pos = pos;
+    e->m_location.m_bBox = BBox(Point3D(-1, -1, 0), Point3D(1, 1, 2));
+    m_world->m_contains->insert(e);
+    return e;
+}
+
+void BroadPhasetest::setup()
+{
+    m_world = new TestEntity("0", 0);
+    m_world->makeContainer();
+
+    m_near = addEntity(1, Point3D(5, 0, 0));
+    m_far = addEntity(2, Point3D(500, 0, 0));
+    m_moving = addEntity(3, Point3D(0, 100, 0));
+    m_moving->m_location.m_velocity = Vector3D(0, -5, 0);
+}
+
+void BroadPhasetest::teardown()
+{
+    BroadPhase::flush();
+
+    LocatedEntitySet::const_iterator I = m_world->m_contains->begin();
+    LocatedEntitySet::const_iterator Iend = m_world->m_contains->end();
+    for (; I != Iend; ++I) {
+        delete *I;
+    }
+    delete m_world;
+}
+
+void BroadPhasetest::test_sweptBox()
+{
+    BBox box;
+    int ret = BroadPhase::sweptBox(m_moving->m_location, 2.f, box);
+
+    ASSERT_EQUAL(ret, 0);
+    ASSERT_EQUAL(box.lowCorner(), Point3D(-1, 89, 0));
+    ASSERT_EQUAL(box.highCorner(), Point3D(1, 101, 2));
+}
+
+void BroadPhasetest::test_sweptBox_no_box()
+{
+    m_near->m_location.m_bBox = BBox();
+
+    BBox box;
+    int ret = BroadPhase::sweptBox(m_near->m_location, 2.f, box);
+
+    ASSERT_EQUAL(ret, -1);
+}
+
+void BroadPhasetest::test_sweptBox_oriented()
+{
+    m_near->m_location.m_orientation = Quaternion(1, 0, 0, 0);
+
+    BBox box;
+    int ret = BroadPhase::sweptBox(m_near->m_location, 2.f, box);
+
+    // The box covers the bounding sphere of the entity's box
+    float radius = std::sqrt(6.f);
+    ASSERT_EQUAL(ret, 0);
+    ASSERT_EQUAL(box.lowCorner(), Point3D(5 - radius, -radius, -radius));
+    ASSERT_EQUAL(box.highCorner(), Point3D(5 + radius, radius, radius));
+}
+
+void BroadPhasetest::test_query()
+{
+    BroadPhase grid;
+    grid.build(*m_world, 0.);
+    ASSERT_EQUAL(grid.size(), 3u);
+
+    BroadPhase::CandidateList res;
+    grid.query(BBox(Point3D(0, -1, 0), Point3D(4, 1, 2)), res);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), m_near);
+
+    // Boxes which do not overlap vertically are not candidates
+    res.clear();
+    grid.query(BBox(Point3D(0, -1, 5), Point3D(4, 1, 7)), res);
+    ASSERT_TRUE(res.empty());
+}
+
+void BroadPhasetest::test_query_moving()
+{
+    BroadPhase grid;
+    grid.build(*m_world, 0.);
+
+    // The moving entity is found where it will be during the next ticks
+    BroadPhase::CandidateList res;
+    grid.query(BBox(Point3D(-1, 85, 0), Point3D(1, 86, 2)), res);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), m_moving);
+
+    // Query boxes covering much of the grid are still answered exactly
+    res.clear();
+    grid.query(BBox(Point3D(-1000, -1000, 0), Point3D(1000, 1000, 2)), res);
+    ASSERT_EQUAL(res.size(), 3u);
+    ASSERT_TRUE(res[0] < res[1]);
+    ASSERT_TRUE(res[1] < res[2]);
+}
+
+void BroadPhasetest::test_query_large()
+{
+    m_far->m_location.m_bBox = BBox(Point3D(-1000, -1000, 0),
+                                    Point3D(1000, 1000, 2));
+
+    BroadPhase grid;
+    grid.build(*m_world, 0.);
+
+    BroadPhase::CandidateList res;
+    grid.query(BBox(Point3D(-1, -1, 0), Point3D(1, 1, 2)), res);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), m_far);
+}
+
+void BroadPhasetest::test_update()
+{
+    BroadPhase grid;
+    grid.build(*m_world, 0.);
+
+    m_near->m_location.m_pos = Point3D(-200, 0, 0);
+    grid.update(m_near);
+
+    BroadPhase::CandidateList res;
+    grid.query(BBox(Point3D(0, -1, 0), Point3D(4, 1, 2)), res);
+    ASSERT_TRUE(res.empty());
+
+    grid.query(BBox(Point3D(-201, -1, 0), Point3D(-199, 1, 2)), res);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), m_near);
+
+    // Entities not yet in the grid are added
+    TestEntity * e = addEntity(4, Point3D(300, 300, 0));
+    grid.update(e);
+    ASSERT_EQUAL(grid.size(), 4u);
+}
+
+void BroadPhasetest::test_forContainer()
+{
+    BroadPhase * grid = BroadPhase::forContainer(*m_world, 10.);
+    ASSERT_NOT_NULL(grid);
+    ASSERT_EQUAL(grid->size(), 3u);
+
+    // Within a move tick, the same grid is used
+    ASSERT_EQUAL(BroadPhase::forContainer(*m_world, 11.), grid);
+
+    // New entities cause a rebuild
+    addEntity(4, Point3D(300, 300, 0));
+    ASSERT_EQUAL(BroadPhase::forContainer(*m_world, 11.), grid);
+    ASSERT_EQUAL(grid->size(), 4u);
+
+    // So does one entity replacing another, though the count is unchanged
+    m_world->m_contains->erase(m_far);
+    TestEntity * replacement = addEntity(6, Point3D(500, 0, 0));
+    ASSERT_EQUAL(BroadPhase::forContainer(*m_world, 11.), grid);
+    ASSERT_EQUAL(grid->size(), 4u);
+    BroadPhase::CandidateList res;
+    grid->query(BBox(Point3D(499, -1, 0), Point3D(501, 1, 2)), res);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), replacement);
+    delete m_far;
+
+    // Each container has its own grid
+    TestEntity other("5", 5);
+    other.makeContainer();
+    BroadPhase * other_grid = BroadPhase::forContainer(other, 11.);
+    ASSERT_NOT_EQUAL(other_grid, grid);
+    ASSERT_EQUAL(other_grid->size(), 0u);
+
+    // Later on the grid is rebuilt, and the idle grid of the other
+    // container is discarded
+    ASSERT_EQUAL(BroadPhase::forContainer(*m_world, 100.), grid);
+    ASSERT_EQUAL(grid->size(), 4u);
+}
+
+int main()
+{
+    BroadPhasetest t;
+
+    return t.run();
+}
+
+// stubs
+
+LocatedEntity::LocatedEntity(const std::string & id, long intId) :
+               Router(id, intId),
+               m_refCount(0), m_seq(0),
+               m_script(0), m_type(0), m_flags(0), m_contains(0)
+{
+}
+
+LocatedEntity::~LocatedEntity()
+{
+    delete m_contains;
+}
+
+bool LocatedEntity::hasAttr(const std::string & name) const
+{
+    return false;
+}
+
+int LocatedEntity::getAttr(const std::string & name,
+                           Atlas::Message::Element & attr) const
+{
+    return -1;
+}
+
+int LocatedEntity::getAttrType(const std::string & name,
+                               Atlas::Message::Element & attr,
+                               int type) const
+{
+    return -1;
+}
+
+PropertyBase * LocatedEntity::setAttr(const std::string & name,
+                                      const Atlas::Message::Element & attr)
+{
+    return 0;
+}
+
+const PropertyBase * LocatedEntity::getProperty(const std::string & name) const
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::modProperty(const std::string & name)
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::setProperty(const std::string & name,
+                                          PropertyBase * prop)
+{
+    return 0;
+}
+
+void LocatedEntity::installDelegate(int, const std::string &)
+{
+}
+
+void LocatedEntity::destroy()
+{
+}
+
+Domain * LocatedEntity::getMovementDomain()
+{
+    return 0;
+}
+
+void LocatedEntity::sendWorld(const Operation & op)
+{
+}
+
+void LocatedEntity::onContainered(const LocatedEntity*)
+{
+}
+
+void LocatedEntity::onUpdated()
+{
+}
+
+void LocatedEntity::makeContainer()
+{
+    if (m_contains == 0) {
+        m_contains = new LocatedEntitySet;
+    }
+}
+
+Router::Router(const std::string & id, long intId) : m_id(id), m_intId(intId)
+{
+}
+
+Router::~Router()
+{
+}
+
+void Router::addToMessage(Atlas::Message::MapType & omap) const
+{
+}
+
+void Router::addToEntity(const Atlas::Objects::Entity::RootEntity & ent) const
+{
+}
+
+Location::Location() : m_loc(0)
+{
+}
@@ -22,17 +22,39 @@
 
 #include "rulesets/BulletDomain.h"
 
+#include "rulesets/BroadPhase.h"
+#include "rulesets/LocatedEntity.h"
 #include "rulesets/TerrainProperty.h"
 
 #ifdef HAVE_BULLET
 #include "btBulletCollisionCommon.h"
 #endif // HAVE_BULLET
 
+#include "common/const.h"
+
+#include <algorithm>
+
 #include <cassert>
 
+class TestEntity : public LocatedEntity
+{
+  public:
+    TestEntity(const std::string & id, long intId) : LocatedEntity(id, intId)
+    {
+    }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+    virtual void destroy() { }
+};
+
 class TestBulletDomain : public BulletDomain
 {
   public:
+    explicit TestBulletDomain(LocatedEntity & world) : BulletDomain(world)
+    {
+    }
+
     btCollisionWorld * test_getCollisionWorld() const
     {
         return m_collisionWorld;
@@ -42,18 +64,21 @@ class TestBulletDomain : public BulletDomain
 int main()
 {
 #ifdef HAVE_BULLET
+    TestEntity world("0", 0);
+    world.makeContainer();
+
     {
-        BulletDomain * bd = new BulletDomain;
+        BulletDomain * bd = new BulletDomain(world);
         delete bd;
     }
 
     {
-        BulletDomain * bd = new BulletDomain;
+        BulletDomain * bd = new BulletDomain(world);
         delete bd;
     }
 
     {
-        TestBulletDomain * bd = new TestBulletDomain;
+        TestBulletDomain * bd = new TestBulletDomain(world);
         assert(bd->test_getCollisionWorld() != 0);
 
         btCollisionObject * obj = new btCollisionObject;
@@ -69,6 +94,109 @@ int main()
 
         delete bd;
     }
+
+    {
+        TestEntity near("1", 1);
+        near.m_location.m_loc = &world;
+        near.m_location.m_pos = Point3D(3, 0, 0);
+        near.m_location.m_bBox = BBox(Point3D(-1, -1, 0), Point3D(1, 1, 2));
+        world.m_contains->insert(&near);
+
+        TestEntity far("2", 2);
+        far.m_location.m_loc = &world;
+        far.m_location.m_pos = Point3D(500, 0, 0);
+        far.m_location.m_bBox = BBox(Point3D(-1, -1, 0), Point3D(1, 1, 2));
+        world.m_contains->insert(&far);
+
+        TestEntity moving("3", 3);
+        moving.m_location.m_loc = &world;
+        moving.m_location.m_pos = Point3D(0, 0, 0);
+        moving.m_location.m_velocity = Vector3D(1, 0, 0);
+        moving.m_location.m_bBox = BBox(Point3D(-1, -1, 0), Point3D(1, 1, 2));
+        world.m_contains->insert(&moving);
+
+        // Entities with no box are not mirrored
+        TestEntity ghost("4", 4);
+        ghost.m_location.m_loc = &world;
+        ghost.m_location.m_pos = Point3D(1, 0, 0);
+        world.m_contains->insert(&ghost);
+
+        BulletDomain * bd = new BulletDomain(world);
+        bd->tick(0.);
+        assert(bd->entityCount() == 3);
+
+        BBox box;
+        BroadPhase::sweptBox(moving.m_location, consts::move_tick, box);
+
+        std::vector<LocatedEntity *> res;
+        assert(bd->collisionCandidates(moving, box, res));
+        assert(std::find(res.begin(), res.end(), &near) != res.end());
+        assert(std::find(res.begin(), res.end(), &far) == res.end());
+
+        // The moving entity's object follows its course
+        moving.m_location.m_pos = Point3D(497, 0, 0);
+        moving.m_location.update(1.);
+        BroadPhase::sweptBox(moving.m_location, consts::move_tick, box);
+        res.clear();
+        assert(bd->collisionCandidates(moving, box, res));
+        assert(std::find(res.begin(), res.end(), &far) != res.end());
+        assert(std::find(res.begin(), res.end(), &near) == res.end());
+
+        // Entities not at the top level are left to the legacy path
+        TestEntity inner("5", 5);
+        inner.m_location.m_loc = &near;
+        inner.m_location.m_pos = Point3D(0, 0, 0);
+        inner.m_location.m_bBox = BBox(Point3D(-1, -1, 0), Point3D(1, 1, 2));
+        res.clear();
+        assert(!bd->collisionCandidates(inner, box, res));
+
+        // An entity which replaces another is found before the next tick
+        world.m_contains->erase(&far);
+        TestEntity replacement("6", 6);
+        replacement.m_location.m_loc = &world;
+        replacement.m_location.m_pos = Point3D(500, 0, 0);
+        replacement.m_location.m_bBox = BBox(Point3D(-1, -1, 0),
+                                             Point3D(1, 1, 2));
+        world.m_contains->insert(&replacement);
+        res.clear();
+        assert(bd->collisionCandidates(moving, box, res));
+        assert(std::find(res.begin(), res.end(), &replacement) != res.end());
+        assert(std::find(res.begin(), res.end(), &far) == res.end());
+
+        // Candidates are in the order of the contents of the world
+        near.m_location.m_pos = Point3D(499, 0, 0);
+        near.m_location.update(1.);
+        world.m_contains->erase(&near);
+        world.m_contains->insert(&near);
+        res.clear();
+        assert(bd->collisionCandidates(moving, box, res));
+        assert(res.size() == 3);
+        LocatedEntitySet::const_iterator I = world.m_contains->begin();
+        LocatedEntitySet::const_iterator Iend = world.m_contains->end();
+        std::vector<LocatedEntity *>::const_iterator J = res.begin();
+        for (; I != Iend; ++I) {
+            if (J != res.end() && *J == *I) {
+                ++J;
+            }
+        }
+        assert(J == res.end());
+
+        // Entities which leave the world are removed
+        world.m_contains->erase(&replacement);
+        bd->tick(1.);
+        assert(bd->entityCount() == 3);
+        bd->tick(consts::move_tick + 1.);
+        assert(bd->entityCount() == 2);
+
+        // No terrain has been registered, so heights come from the
+        // legacy code
+        assert(bd->terrainCount() == 0);
+        bd->constrainHeight(&world, Point3D(0, 0, 0), "standing");
+
+        delete bd;
+
+        world.m_contains->clear();
+    }
 #endif // HAVE_BULLET
 
     return 0;
@@ -76,6 +204,113 @@ int main()
 
 // stubs
 
+LocatedEntity::LocatedEntity(const std::string & id, long intId) :
+               Router(id, intId),
+               m_refCount(0), m_seq(0),
+               m_script(0), m_type(0), m_flags(0), m_contains(0)
+{
+}
+
+LocatedEntity::~LocatedEntity()
+{
+    delete m_contains;
+}
+
+bool LocatedEntity::hasAttr(const std::string & name) const
+{
+    return false;
+}
+
+int LocatedEntity::getAttr(const std::string & name,
+                           Atlas::Message::Element & attr) const
+{
+    return -1;
+}
+
+int LocatedEntity::getAttrType(const std::string & name,
+                               Atlas::Message::Element & attr,
+                               int type) const
+{
+    return -1;
+}
+
+PropertyBase * LocatedEntity::setAttr(const std::string & name,
+                                      const Atlas::Message::Element & attr)
+{
+    return 0;
+}
+
+const PropertyBase * LocatedEntity::getProperty(const std::string & name) const
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::modProperty(const std::string & name)
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::setProperty(const std::string & name,
+                                          PropertyBase * prop)
+{
+    return 0;
+}
+
+void LocatedEntity::installDelegate(int, const std::string &)
+{
+}
+
+void LocatedEntity::destroy()
+{
+}
+
+Domain * LocatedEntity::getMovementDomain()
+{
+    return 0;
+}
+
+void LocatedEntity::sendWorld(const Operation & op)
+{
+}
+
+void LocatedEntity::onContainered(const LocatedEntity*)
+{
+}
+
+void LocatedEntity::onUpdated()
+{
+}
+
+void LocatedEntity::makeContainer()
+{
+    if (m_contains == 0) {
+        m_contains = new LocatedEntitySet;
+    }
+}
+
+Router::Router(const std::string & id, long intId) : m_id(id), m_intId(intId)
+{
+}
+
+Router::~Router()
+{
+}
+
+void Router::addToMessage(Atlas::Message::MapType & omap) const
+{
+}
+
+void Router::addToEntity(const Atlas::Objects::Entity::RootEntity & ent) const
+{
+}
+
+Location::Location() :
+    m_simple(true), m_solid(true),
+    m_timeStamp(0.),
+    m_loc(0)
+{
+}
+
 TerrainProperty::TerrainProperty() :
     m_data(*(Mercator::Terrain*)0),
     m_tileShader(*(Mercator::TileShader*)0)
@@ -18,6 +18,7 @@
 
 #include "rulesets/BulletDomain.h"
 
+#include "rulesets/LocatedEntity.h"
 #include "rulesets/TerrainProperty.h"
 
 #ifdef HAVE_BULLET
@@ -26,9 +27,25 @@
 
 #include <cassert>
 
+class TestEntity : public LocatedEntity
+{
+  public:
+    TestEntity(const std::string & id, long intId) : LocatedEntity(id, intId)
+    {
+    }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+    virtual void destroy() { }
+};
+
 class TestBulletDomain : public BulletDomain
 {
   public:
+    explicit TestBulletDomain(LocatedEntity & world) : BulletDomain(world)
+    {
+    }
+
     btCollisionWorld * test_getCollisionWorld() const
     {
         return m_collisionWorld;
@@ -38,18 +55,21 @@ class TestBulletDomain : public BulletDomain
 int main()
 {
 #ifdef HAVE_BULLET
+    TestEntity world("0", 0);
+    world.makeContainer();
+
     {
-        BulletDomain * bd = new BulletDomain;
+        BulletDomain * bd = new BulletDomain(world);
         delete bd;
     }
 
     {
-        BulletDomain * bd = new BulletDomain;
+        BulletDomain * bd = new BulletDomain(world);
         delete bd;
     }
 
     {
-        TestBulletDomain * bd = new TestBulletDomain;
+        TestBulletDomain * bd = new TestBulletDomain(world);
         assert(bd->test_getCollisionWorld() != 0);
 
         btCollisionObject * obj = new btCollisionObject;
@@ -72,6 +92,113 @@ int main()
 
 // stubs
 
+LocatedEntity::LocatedEntity(const std::string & id, long intId) :
+               Router(id, intId),
+               m_refCount(0), m_seq(0),
+               m_script(0), m_type(0), m_flags(0), m_contains(0)
+{
+}
+
+LocatedEntity::~LocatedEntity()
+{
+    delete m_contains;
+}
+
+bool LocatedEntity::hasAttr(const std::string & name) const
+{
+    return false;
+}
+
+int LocatedEntity::getAttr(const std::string & name,
+                           Atlas::Message::Element & attr) const
+{
+    return -1;
+}
+
+int LocatedEntity::getAttrType(const std::string & name,
+                               Atlas::Message::Element & attr,
+                               int type) const
+{
+    return -1;
+}
+
+PropertyBase * LocatedEntity::setAttr(const std::string & name,
+                                      const Atlas::Message::Element & attr)
+{
+    return 0;
+}
+
+const PropertyBase * LocatedEntity::getProperty(const std::string & name) const
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::modProperty(const std::string & name)
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::setProperty(const std::string & name,
+                                          PropertyBase * prop)
+{
+    return 0;
+}
+
+void LocatedEntity::installDelegate(int, const std::string &)
+{
+}
+
+void LocatedEntity::destroy()
+{
+}
+
+Domain * LocatedEntity::getMovementDomain()
+{
+    return 0;
+}
+
+void LocatedEntity::sendWorld(const Operation & op)
+{
+}
+
+void LocatedEntity::onContainered(const LocatedEntity*)
+{
+}
+
+void LocatedEntity::onUpdated()
+{
+}
+
+void LocatedEntity::makeContainer()
+{
+    if (m_contains == 0) {
+        m_contains = new LocatedEntitySet;
+    }
+}
+
+Router::Router(const std::string & id, long intId) : m_id(id), m_intId(intId)
+{
+}
+
+Router::~Router()
+{
+}
+
+void Router::addToMessage(Atlas::Message::MapType & omap) const
+{
+}
+
+void Router::addToEntity(const Atlas::Objects::Entity::RootEntity & ent) const
+{
+}
+
+Location::Location() :
+    m_simple(true), m_solid(true),
+    m_timeStamp(0.),
+    m_loc(0)
+{
+}
+
 Domain::Domain() : m_refCount(0)
 {
 }
@@ -87,6 +214,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return 0.f;
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
 }
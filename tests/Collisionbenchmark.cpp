@@ -0,0 +1,135 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "BenchmarkTimer.h"
+
+#include "physics/Collision.h"
+
+#include "modules/Location.h"
+
+#include "common/random.h"
+
+#include <vector>
+
+#include <cassert>
+
+static const int trials = 2000;
+static const float horizon = 3.f;
+static const float limit = 2.f;
+
+/// Predict collision with each location in turn, the way Motion did before
+/// collisions were predicted in batches, to provide a baseline.
+static int scalarCheck(const Location & mover,
+                       const std::vector<Location> & others,
+                       float & time)
+{
+    int hit = -1;
+    for (size_t i = 0; i < others.size(); ++i) {
+        float t = horizon;
+        Vector3D normal;
+        if (predictCollision(mover, others[i], t, normal) &&
+            t >= 0 && t <= time) {
+            hit = i;
+            time = t;
+        }
+    }
+    return hit;
+}
+
+static void randomBox(Location & loc, float range)
+{
+    loc.m_pos = Point3D(uniform(-range, range), uniform(-range, range), 0);
+    loc.m_bBox = BBox(WFMath::Point<3>(-uniform(0.2, 2), -uniform(0.2, 2), 0),
+                      WFMath::Point<3>(uniform(0.2, 2), uniform(0.2, 2),
+                                       uniform(0.5, 3)));
+    if (randint(0, 1) == 0) {
+        loc.m_velocity = Vector3D(uniform(-3, 3), uniform(-3, 3), 0);
+    }
+}
+
+static void benchmark(int candidates, float range)
+{
+    std::vector<Location> movers(trials);
+    std::vector<std::vector<Location> > others(trials);
+    std::vector<CollisionBatch> batches(trials);
+    for (int i = 0; i < trials; ++i) {
+        movers[i] = Location(0, Point3D(0, 0, 0),
+                             Vector3D(uniform(-3, 3), uniform(-3, 3), 0));
+        movers[i].m_bBox = BBox(WFMath::Point<3>(-0.5, -0.5, 0),
+                                WFMath::Point<3>(0.5, 0.5, 2));
+        others[i].resize(candidates);
+        for (int j = 0; j < candidates; ++j) {
+            randomBox(others[i][j], range);
+        }
+    }
+
+    std::vector<int> scalar_hits(trials), batch_hits(trials);
+    std::vector<float> scalar_times(trials, limit), batch_times(trials, limit);
+
+    std::cout << candidates << " candidates within " << range << "m"
+              << std::endl << std::flush;
+    {
+        BenchmarkTimer timer;
+        for (int i = 0; i < trials; ++i) {
+            scalar_hits[i] = scalarCheck(movers[i], others[i],
+                                         scalar_times[i]);
+        }
+        timer.report("  scalar predictCollision", trials * candidates);
+    }
+
+    {
+        BenchmarkTimer timer;
+        for (int i = 0; i < trials; ++i) {
+            CollisionBatch & batch = batches[i];
+            for (int j = 0; j < candidates; ++j) {
+                batch.add(others[i][j]);
+            }
+            Vector3D normal;
+            batch_hits[i] = predictCollision(movers[i], batch, horizon,
+                                             batch_times[i], normal);
+        }
+        timer.report("  batched predictCollision", trials * candidates);
+    }
+
+    int collisions = 0;
+    for (int i = 0; i < trials; ++i) {
+        assert(batch_hits[i] == scalar_hits[i]);
+        assert(batch_times[i] == scalar_times[i]);
+        if (scalar_hits[i] != -1) {
+            ++collisions;
+        }
+    }
+    std::cout << "  " << collisions << " collisions predicted in "
+              << trials << " trials" << std::endl << std::flush;
+}
+
+int main()
+{
+    // Candidates as returned by a broadphase, mostly close enough to hit
+    benchmark(8, 4.f);
+    benchmark(64, 8.f);
+    // Whole containers checked without a broadphase
+    benchmark(512, 100.f);
+}
@@ -32,6 +32,39 @@
 #include <iostream>
 
 #include <cassert>
+#include <cstdlib>
+
+static float uniform(float min, float max)
+{
+    return min + (max - min) * (std::rand() / (float)RAND_MAX);
+}
+
+static void randomLocation(Location & loc)
+{
+    loc.m_pos = Point3D(uniform(-6, 6), uniform(-6, 6), uniform(-2, 2));
+    // Snap some positions to a coarse grid, so boxes line up exactly
+    if (std::rand() % 3 == 0) {
+        loc.m_pos = Point3D((int)loc.m_pos.x(), (int)loc.m_pos.y(), 0);
+    }
+    loc.m_bBox = BBox(WFMath::Point<3>(-uniform(0.2, 2), -uniform(0.2, 2), 0),
+                      WFMath::Point<3>(uniform(0.2, 2), uniform(0.2, 2),
+                                       uniform(0.5, 3)));
+    switch (std::rand() % 4) {
+      case 0:
+        // Not moving
+        break;
+      case 1:
+        loc.m_velocity = Vector3D(0, 0, 0);
+        break;
+      default:
+        loc.m_velocity = Vector3D(uniform(-3, 3), uniform(-3, 3),
+                                  (std::rand() % 2) ? uniform(-1, 1) : 0);
+        break;
+    }
+    if (std::rand() % 8 == 0) {
+        loc.m_orientation = Quaternion(Vector3D(0, 0, 1), uniform(0, 3));
+    }
+}
 
 int main()
 {
@@ -192,6 +225,76 @@ int main()
 
     }
 
+    {
+        // The batched prediction must give exactly the same result as
+        // predicting collision with each location in turn.
+        std::srand(1);
+        for (int i = 0; i < 2000; ++i) {
+            Location mover(0, Point3D(0, 0, 0), Vector3D(uniform(-3, 3),
+                                                         uniform(-3, 3), 0));
+            mover.m_bBox = BBox(WFMath::Point<3>(-0.5, -0.5, 0),
+                                WFMath::Point<3>(0.5, 0.5, 2));
+            if (i % 10 == 0) {
+                mover.m_orientation = Quaternion(Vector3D(0, 0, 1), 0.5);
+            }
+
+            std::vector<Location> others(std::rand() % 40);
+            CollisionBatch batch;
+            for (size_t j = 0; j < others.size(); ++j) {
+                randomLocation(others[j]);
+                batch.add(others[j]);
+            }
+            assert(batch.size() == others.size());
+
+            float time = 2;
+            Vector3D normal;
+            int expected = -1;
+            for (size_t j = 0; j < others.size(); ++j) {
+                float t = 3;
+                Vector3D n;
+                if (predictCollision(mover, others[j], t, n) &&
+                    t >= 0 && t <= time) {
+                    expected = j;
+                    time = t;
+                    normal = n;
+                }
+            }
+
+            float batch_time = 2;
+            Vector3D batch_normal;
+            int hit = predictCollision(mover, batch, 3, batch_time,
+                                       batch_normal);
+            assert(hit == expected);
+            assert(batch_time == time);
+            if (hit != -1) {
+                assert(batch_normal == normal);
+            }
+        }
+
+        CollisionBatch batch;
+        float time = 2;
+        Vector3D normal;
+        Location mover(0, Point3D(0, 0, 0), Vector3D(1, 0, 0));
+        mover.m_bBox = BBox(WFMath::Point<3>(-0.5, -0.5, 0),
+                            WFMath::Point<3>(0.5, 0.5, 2));
+        assert(predictCollision(mover, batch, 3, time, normal) == -1);
+
+        Location wall(0, Point3D(2, 0, 0));
+        wall.m_bBox = BBox(WFMath::Point<3>(0, -5, 0),
+                           WFMath::Point<3>(1, 5, 2));
+        Location far(0, Point3D(20, 0, 0));
+        far.m_bBox = wall.m_bBox;
+        batch.add(far);
+        batch.add(wall);
+
+        assert(predictCollision(mover, batch, 3, time, normal) == 1);
+        assert(time == 1.5f);
+        assert(normal == Vector3D(-1, 0, 0));
+
+        batch.clear();
+        assert(batch.size() == 0);
+    }
+
     return ret;
 }
 
@@ -324,6 +324,104 @@ int THINK_NO = -1;
 int COMMUNE_NO = -1;
 } } }
 
+#include "rulesets/MetabolismSystem.h"
+#include "rulesets/MovementSystem.h"
+#include "rulesets/MindLodScheduler.h"
+
+MindLodScheduler * MindLodScheduler::m_instance = 0;
+
+MindLodScheduler::MindLodScheduler() : m_monitored(0)
+{
+}
+
+MindLodScheduler::~MindLodScheduler()
+{
+}
+
+MindLodScheduler * MindLodScheduler::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MindLodScheduler;
+    }
+    return m_instance;
+}
+
+void MindLodScheduler::addPlayer(LocatedEntity *)
+{
+}
+
+void MindLodScheduler::removePlayer(LocatedEntity *)
+{
+}
+
+void MindLodScheduler::removeMind(LocatedEntity *)
+{
+}
+
+void MindLodScheduler::scheduleTick(LocatedEntity &, const Operation &)
+{
+}
+
+bool MindLodScheduler::checkTick(LocatedEntity &, const Operation &)
+{
+    return true;
+}
+
+bool MindLodScheduler::checkPerception(LocatedEntity &, const Operation &)
+{
+    return true;
+}
+
+void MindLodScheduler::playerMoved(LocatedEntity &)
+{
+}
+
+MetabolismSystem * MetabolismSystem::m_instance = 0;
+
+MetabolismSystem::MetabolismSystem()
+{
+}
+
+MetabolismSystem::~MetabolismSystem()
+{
+}
+
+MetabolismSystem * MetabolismSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MetabolismSystem;
+    }
+    return m_instance;
+}
+
+int MetabolismSystem::addEntity(Character *)
+{
+    return 0;
+}
+
+MovementSystem * MovementSystem::m_instance = 0;
+
+MovementSystem::MovementSystem()
+{
+}
+
+MovementSystem::~MovementSystem()
+{
+}
+
+MovementSystem * MovementSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MovementSystem;
+    }
+    return m_instance;
+}
+
+int MovementSystem::addEntity(Character *)
+{
+    return 0;
+}
+
 Pedestrian::Pedestrian(LocatedEntity & body) : Movement(body)
 {
 }
@@ -490,7 +490,7 @@ void Persistence::putAccount(const Account & ac)
 }
 
 void Persistence::registerCharacters(Account & ac,
-                                     const EntityDict & worldObjects)
+                                     const EntityTable & worldObjects)
 {
 }
 
@@ -0,0 +1,256 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "server/EntityIndex.h"
+
+#include "rulesets/Entity.h"
+
+#include "common/Inheritance.h"
+#include "common/TypeNode.h"
+
+#include <Atlas/Message/Element.h>
+#include <Atlas/Objects/Anonymous.h>
+
+#include <algorithm>
+
+using Atlas::Message::Element;
+using Atlas::Objects::Entity::Anonymous;
+
+/// Entity with a name which does not need a property manager
+class NamedEntity : public Entity {
+  public:
+    std::string m_name;
+
+    NamedEntity(const std::string & id, long intId, const TypeNode * type,
+                const std::string & name) : Entity(id, intId), m_name(name) {
+        setType(type);
+    }
+
+    virtual int getAttrType(const std::string & name,
+                            Element & attr,
+                            int type) const {
+        if (name == "name" && !m_name.empty()) {
+            attr = m_name;
+            return 0;
+        }
+        return -1;
+    }
+};
+
+class EntityIndextest : public Cyphesis::TestBase
+{
+  private:
+    const TypeNode * m_thingType;
+    const TypeNode * m_treeType;
+    const TypeNode * m_oakType;
+    NamedEntity * m_bob;
+    NamedEntity * m_tree;
+    NamedEntity * m_oak;
+    NamedEntity * m_otherBob;
+    EntityIndex * m_index;
+
+    static const TypeNode * addType(const std::string & name,
+                                    const std::string & parent);
+  public:
+    EntityIndextest();
+
+    void setup();
+    void teardown();
+
+    void test_findByName();
+    void test_findByType();
+    void test_findAllByName();
+    void test_findAllByType();
+    void test_delEntity();
+    void test_updateEntity();
+    void test_updateEntity_type();
+};
+
+EntityIndextest::EntityIndextest()
+{
+    ADD_TEST(EntityIndextest::test_findByName);
+    ADD_TEST(EntityIndextest::test_findByType);
+    ADD_TEST(EntityIndextest::test_findAllByName);
+    ADD_TEST(EntityIndextest::test_findAllByType);
+    ADD_TEST(EntityIndextest::test_delEntity);
+    ADD_TEST(EntityIndextest::test_updateEntity);
+    ADD_TEST(EntityIndextest::test_updateEntity_type);
+}
+
+const TypeNode * EntityIndextest::addType(const std::string & name,
+                                          const std::string & parent)
+{
+    Anonymous type_desc;
+    type_desc->setId(name);
+    type_desc->setParents(std::list<std::string>(1, parent));
+    type_desc->setObjtype("class");
+    return Inheritance::instance().addChild(type_desc);
+}
+
+void EntityIndextest::setup()
+{
+    m_thingType = addType("thing", "root");
+    m_treeType = addType("tree", "thing");
+    m_oakType = addType("oak", "tree");
+
+    m_bob = new NamedEntity("1", 1, m_thingType, "bob");
+    m_tree = new NamedEntity("2", 2, m_treeType, "");
+    m_oak = new NamedEntity("3", 3, m_oakType, "bob");
+    m_otherBob = new NamedEntity("4", 4, m_thingType, "bob");
+
+    m_index = new EntityIndex;
+    // Added out of order, so the index has to order them by ID
+    m_index->addEntity(m_otherBob);
+    m_index->addEntity(m_oak);
+    m_index->addEntity(m_tree);
+    m_index->addEntity(m_bob);
+}
+
+void EntityIndextest::teardown()
+{
+    delete m_index;
+    delete m_otherBob;
+    delete m_oak;
+    delete m_tree;
+    delete m_bob;
+    Inheritance::clear();
+}
+
+void EntityIndextest::test_findByName()
+{
+    ASSERT_EQUAL(m_index->size(), 4u);
+    ASSERT_EQUAL(m_index->findByName("bob"), m_bob);
+    ASSERT_NULL(m_index->findByName("fred"));
+    // Entities with no name are not indexed by name
+    ASSERT_NULL(m_index->findByName(""));
+}
+
+void EntityIndextest::test_findByType()
+{
+    ASSERT_EQUAL(m_index->findByType("thing"), m_bob);
+    ASSERT_EQUAL(m_index->findByType("tree"), m_tree);
+    ASSERT_NULL(m_index->findByType("rock"));
+}
+
+void EntityIndextest::test_findAllByName()
+{
+    EntityIndex::EntityVector res;
+    m_index->findAllByName("bob", res);
+    ASSERT_EQUAL(res.size(), 3u);
+    ASSERT_EQUAL(res[0], m_bob);
+    ASSERT_EQUAL(res[1], m_oak);
+    ASSERT_EQUAL(res[2], m_otherBob);
+}
+
+void EntityIndextest::test_findAllByType()
+{
+    EntityIndex::EntityVector res;
+    m_index->findAllByType("tree", res, false);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res[0], m_tree);
+
+    res.clear();
+    m_index->findAllByType("tree", res, true);
+    ASSERT_EQUAL(res.size(), 2u);
+
+    res.clear();
+    m_index->findAllByType("thing", res, true);
+    ASSERT_EQUAL(res.size(), 4u);
+
+    res.clear();
+    m_index->findAllByType("rock", res, true);
+    ASSERT_TRUE(res.empty());
+
+    // Subtypes are found when no entity has exactly the given type
+    m_index->delEntity(m_bob);
+    m_index->delEntity(m_otherBob);
+    res.clear();
+    m_index->findAllByType("thing", res, true);
+    ASSERT_EQUAL(res.size(), 2u);
+    ASSERT_TRUE(std::find(res.begin(), res.end(), m_tree) != res.end());
+    ASSERT_TRUE(std::find(res.begin(), res.end(), m_oak) != res.end());
+}
+
+void EntityIndextest::test_delEntity()
+{
+    m_index->delEntity(m_bob);
+    ASSERT_EQUAL(m_index->size(), 3u);
+    ASSERT_EQUAL(m_index->findByName("bob"), m_oak);
+    ASSERT_EQUAL(m_index->findByType("thing"), m_otherBob);
+
+    // Removing an entity twice does nothing
+    m_index->delEntity(m_bob);
+    ASSERT_EQUAL(m_index->size(), 3u);
+
+    m_index->delEntity(m_tree);
+    ASSERT_NULL(m_index->findByType("tree"));
+}
+
+void EntityIndextest::test_updateEntity()
+{
+    m_bob->m_name = "fred";
+    m_index->updateEntity(m_bob);
+    ASSERT_EQUAL(m_index->findByName("fred"), m_bob);
+    ASSERT_EQUAL(m_index->findByName("bob"), m_oak);
+
+    m_tree->m_name = "bob";
+    m_index->updateEntity(m_tree);
+    ASSERT_EQUAL(m_index->findByName("bob"), m_tree);
+
+    // Entities which are not indexed are not added by an update
+    m_index->delEntity(m_tree);
+    m_index->updateEntity(m_tree);
+    ASSERT_EQUAL(m_index->findByName("bob"), m_oak);
+    ASSERT_EQUAL(m_index->size(), 3u);
+}
+
+void EntityIndextest::test_updateEntity_type()
+{
+    m_tree->setType(m_oakType);
+    m_index->updateEntity(m_tree);
+    ASSERT_NULL(m_index->findByType("tree"));
+    ASSERT_EQUAL(m_index->findByType("oak"), m_tree);
+
+    EntityIndex::EntityVector res;
+    m_index->findAllByType("oak", res, false);
+    ASSERT_EQUAL(res.size(), 2u);
+
+    // The entity is removed from under the type it is indexed by
+    m_index->delEntity(m_tree);
+    res.clear();
+    m_index->findAllByType("oak", res, false);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res[0], m_oak);
+}
+
+int main()
+{
+    EntityIndextest t;
+
+    return t.run();
+}
@@ -0,0 +1,157 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "BenchmarkTimer.h"
+
+#include "rulesets/Thing.h"
+
+#include "common/Property.h"
+
+#include <cassert>
+#include <new>
+#include <vector>
+
+static const int entity_count = 1000000;
+static const int churn_rounds = 10;
+
+/// Create a Thing and its mass property in memory from the global heap,
+/// bypassing the pools, the way they were allocated before the pools were
+/// added, to provide a baseline.
+static Thing * heapThing(std::vector<Property<double> *> & props, long id)
+{
+    void * p = ::operator new(sizeof(Property<double>));
+    props.push_back(::new (p) Property<double>);
+    return ::new (::operator new(sizeof(Thing))) Thing("1", id);
+}
+
+static void heapDestroy(Thing * thing, Property<double> * prop)
+{
+    thing->~Thing();
+    ::operator delete(thing);
+    prop->~Property<double>();
+    ::operator delete(prop);
+}
+
+static void report(const char * name, const MemoryPool & pool)
+{
+    std::cout << name << " pool: " << pool.live() << " live, "
+              << pool.reusable() << " reusable, "
+              << pool.slabKilobytes() << "kB in slabs"
+              << std::endl << std::flush;
+}
+
+int main()
+{
+    std::vector<Thing *> things;
+    std::vector<Property<double> *> props;
+    things.reserve(entity_count);
+    props.reserve(entity_count);
+
+    {
+        BenchmarkTimer timer;
+        for (int i = 0; i < entity_count; ++i) {
+            things.push_back(heapThing(props, i));
+        }
+        for (int i = 0; i < entity_count; ++i) {
+            heapDestroy(things[i], props[i]);
+        }
+        timer.report("heap create and destroy", entity_count);
+    }
+    things.clear();
+    props.clear();
+
+    // The first pass fills the pools with slabs, so time a second pass
+    // which reuses them, as a long running server would.
+    for (int pass = 0; pass < 2; ++pass) {
+        BenchmarkTimer timer;
+        for (int i = 0; i < entity_count; ++i) {
+            props.push_back(new Property<double>);
+            things.push_back(new Thing("1", i));
+        }
+        for (int i = 0; i < entity_count; ++i) {
+            delete things[i];
+            delete props[i];
+        }
+        timer.report(pass == 0 ? "pool create and destroy (cold)"
+                               : "pool create and destroy (warm)",
+                     entity_count);
+        things.clear();
+        props.clear();
+    }
+    report("entity", LocatedEntity::pool());
+    report("property", PropertyBase::pool());
+    assert(LocatedEntity::pool().live() == 0);
+
+    // Replace a tenth of a live population in each round, so the
+    // entities which survive are interleaved with the ones replaced.
+    for (int i = 0; i < entity_count; ++i) {
+        things.push_back(heapThing(props, i));
+    }
+    {
+        BenchmarkTimer timer;
+        for (int round = 0; round < churn_rounds; ++round) {
+            for (int i = round; i < entity_count; i += 10) {
+                heapDestroy(things[i], props[i]);
+                void * p = ::operator new(sizeof(Property<double>));
+                props[i] = ::new (p) Property<double>;
+                things[i] = ::new (::operator new(sizeof(Thing))) Thing("1", i);
+            }
+        }
+        timer.report("heap churn", entity_count);
+    }
+    for (int i = 0; i < entity_count; ++i) {
+        heapDestroy(things[i], props[i]);
+    }
+    things.clear();
+    props.clear();
+
+    for (int i = 0; i < entity_count; ++i) {
+        props.push_back(new Property<double>);
+        things.push_back(new Thing("1", i));
+    }
+    {
+        BenchmarkTimer timer;
+        for (int round = 0; round < churn_rounds; ++round) {
+            for (int i = round; i < entity_count; i += 10) {
+                delete things[i];
+                delete props[i];
+                props[i] = new Property<double>;
+                things[i] = new Thing("1", i);
+            }
+        }
+        timer.report("pool churn", entity_count);
+    }
+    for (int i = 0; i < entity_count; ++i) {
+        delete things[i];
+        delete props[i];
+    }
+    report("entity", LocatedEntity::pool());
+    report("property", PropertyBase::pool());
+}
@@ -0,0 +1,204 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/IdMap.h"
+
+#include <set>
+
+class IdMaptest : public Cyphesis::TestBase
+{
+  private:
+    IdMap<int *> * m_map;
+    int m_values[4];
+  public:
+    IdMaptest();
+
+    void setup();
+    void teardown();
+
+    void test_empty();
+    void test_insert();
+    void test_erase();
+    void test_iterate();
+    void test_grow();
+    void test_collide();
+};
+
+IdMaptest::IdMaptest()
+{
+    ADD_TEST(IdMaptest::test_empty);
+    ADD_TEST(IdMaptest::test_insert);
+    ADD_TEST(IdMaptest::test_erase);
+    ADD_TEST(IdMaptest::test_iterate);
+    ADD_TEST(IdMaptest::test_grow);
+    ADD_TEST(IdMaptest::test_collide);
+}
+
+void IdMaptest::setup()
+{
+    m_map = new IdMap<int *>;
+}
+
+void IdMaptest::teardown()
+{
+    delete m_map;
+}
+
+void IdMaptest::test_empty()
+{
+    ASSERT_TRUE(m_map->empty());
+    ASSERT_EQUAL(m_map->size(), 0u);
+    ASSERT_TRUE(m_map->begin() == m_map->end());
+    ASSERT_TRUE(m_map->find(1) == m_map->end());
+    ASSERT_NULL(m_map->get(1));
+    ASSERT_EQUAL(m_map->erase(1), 0u);
+}
+
+void IdMaptest::test_insert()
+{
+    (*m_map)[1] = &m_values[0];
+    ASSERT_EQUAL(m_map->size(), 1u);
+    ASSERT_TRUE(m_map->find(1) != m_map->end());
+    ASSERT_EQUAL(m_map->find(1)->first, 1);
+    ASSERT_TRUE(m_map->find(1)->second == &m_values[0]);
+    ASSERT_TRUE(m_map->get(1) == &m_values[0]);
+    ASSERT_TRUE(m_map->find(2) == m_map->end());
+
+    // Assigning an existing ID replaces the value
+    (*m_map)[1] = &m_values[1];
+    ASSERT_EQUAL(m_map->size(), 1u);
+    ASSERT_TRUE(m_map->get(1) == &m_values[1]);
+
+    std::pair<IdMap<int *>::const_iterator, bool> r =
+          m_map->insert(std::make_pair(1L, &m_values[2]));
+    ASSERT_TRUE(!r.second);
+    ASSERT_TRUE(r.first->second == &m_values[1]);
+
+    r = m_map->insert(std::make_pair(0L, &m_values[2]));
+    ASSERT_TRUE(r.second);
+    ASSERT_EQUAL(r.first->first, 0);
+    ASSERT_EQUAL(m_map->size(), 2u);
+
+    // Negative IDs are keys like any other
+    (*m_map)[-1] = &m_values[3];
+    ASSERT_TRUE(m_map->get(-1) == &m_values[3]);
+    ASSERT_EQUAL(m_map->size(), 3u);
+}
+
+void IdMaptest::test_erase()
+{
+    (*m_map)[1] = &m_values[0];
+    (*m_map)[2] = &m_values[1];
+    ASSERT_EQUAL(m_map->erase(1), 1u);
+    ASSERT_EQUAL(m_map->size(), 1u);
+    ASSERT_TRUE(m_map->find(1) == m_map->end());
+    ASSERT_TRUE(m_map->get(2) == &m_values[1]);
+
+    m_map->erase(m_map->find(2));
+    ASSERT_TRUE(m_map->empty());
+    ASSERT_TRUE(m_map->begin() == m_map->end());
+
+    // Removed slots are reused
+    (*m_map)[1] = &m_values[2];
+    ASSERT_TRUE(m_map->get(1) == &m_values[2]);
+    ASSERT_EQUAL(m_map->size(), 1u);
+
+    m_map->clear();
+    ASSERT_TRUE(m_map->empty());
+    ASSERT_TRUE(m_map->find(1) == m_map->end());
+}
+
+void IdMaptest::test_iterate()
+{
+    for (long i = 0; i < 10; ++i) {
+        (*m_map)[i] = &m_values[i % 4];
+    }
+    // Removing the current entry does not disturb iteration
+    std::set<long> seen;
+    IdMap<int *>::const_iterator I = m_map->begin();
+    IdMap<int *>::const_iterator Iend = m_map->end();
+    for (; I != Iend; ++I) {
+        seen.insert(I->first);
+        if (I->first % 2 == 0) {
+            m_map->erase(I);
+        }
+    }
+    ASSERT_EQUAL(seen.size(), 10u);
+    ASSERT_EQUAL(m_map->size(), 5u);
+
+    seen.clear();
+    for (I = m_map->begin(); I != m_map->end(); ++I) {
+        seen.insert(I->first);
+    }
+    ASSERT_EQUAL(seen.size(), 5u);
+    ASSERT_TRUE(seen.find(1) != seen.end());
+    ASSERT_TRUE(seen.find(2) == seen.end());
+}
+
+void IdMaptest::test_grow()
+{
+    for (long i = 0; i < 10000; ++i) {
+        (*m_map)[i * 3] = &m_values[i % 4];
+    }
+    ASSERT_EQUAL(m_map->size(), 10000u);
+    for (long i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(m_map->get(i * 3) == &m_values[i % 4]);
+        ASSERT_NULL(m_map->get(i * 3 + 1));
+    }
+
+    // Churn leaves the table usable
+    for (long i = 0; i < 10000; ++i) {
+        m_map->erase(i * 3);
+        (*m_map)[100000 + i] = &m_values[0];
+    }
+    ASSERT_EQUAL(m_map->size(), 10000u);
+    ASSERT_TRUE(m_map->find(0) == m_map->end());
+    ASSERT_TRUE(m_map->get(109999) == &m_values[0]);
+}
+
+void IdMaptest::test_collide()
+{
+    // IDs a multiple of the table size apart share a home slot
+    (*m_map)[1] = &m_values[0];
+    (*m_map)[17] = &m_values[1];
+    (*m_map)[33] = &m_values[2];
+    ASSERT_TRUE(m_map->get(17) == &m_values[1]);
+
+    // Removing the first of them leaves the others reachable
+    m_map->erase(1);
+    ASSERT_TRUE(m_map->get(17) == &m_values[1]);
+    ASSERT_TRUE(m_map->get(33) == &m_values[2]);
+    ASSERT_NULL(m_map->get(1));
+}
+
+int main()
+{
+    IdMaptest t;
+
+    return t.run();
+}
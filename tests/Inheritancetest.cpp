@@ -100,6 +100,7 @@ class Inheritancetest : public Cyphesis::TestBase
     void test_isTypeOf_TypeNode();
     void test_isTypeOf_TypeNode2();
     void test_flush();
+    void test_TypeHandle();
 };
 
 int Inheritancetest::SQUIGGLYMUFF_NO = OP_INVALID;
@@ -125,6 +126,7 @@ Inheritancetest::Inheritancetest()
     ADD_TEST(Inheritancetest::test_isTypeOf_string);
     ADD_TEST(Inheritancetest::test_isTypeOf_TypeNode);
     ADD_TEST(Inheritancetest::test_isTypeOf_TypeNode2);
+    ADD_TEST(Inheritancetest::test_TypeHandle);
     ADD_TEST(Inheritancetest::test_flush);
 }
 
@@ -337,6 +339,44 @@ void Inheritancetest::test_isTypeOf_TypeNode2()
     assert(i.isTypeOf(root_operation, root_operation));
 }
 
+void Inheritancetest::test_TypeHandle()
+{
+    Inheritance & i = Inheritance::instance();
+
+    TypeHandle root_operation("root_operation");
+    ASSERT_EQUAL(root_operation.name(), "root_operation");
+    ASSERT_EQUAL(root_operation.get(), i.getType("root_operation"));
+
+    const TypeNode * disappearance = i.getType("disappearance");
+    ASSERT_NOT_NULL(disappearance);
+    ASSERT_TRUE(disappearance->isTypeOf(root_operation.get()));
+    ASSERT_TRUE(!i.getType("root_entity")->isTypeOf(root_operation.get()));
+
+    // A handle to a type which does not exist yet resolves once the
+    // type is installed
+    TypeHandle handle_test("handle_test_type");
+    ASSERT_NULL(handle_test.get());
+
+    Root r;
+    r->setId("handle_test_type");
+    r->setParents(std::list<std::string>(1, "disappearance"));
+    ASSERT_NOT_NULL(i.addChild(r));
+
+    ASSERT_EQUAL(handle_test.get(), i.getType("handle_test_type"));
+    ASSERT_TRUE(handle_test.get()->isTypeOf(root_operation.get()));
+    ASSERT_TRUE(handle_test.get()->isTypeOf(disappearance));
+    ASSERT_TRUE(!disappearance->isTypeOf(handle_test.get()));
+    ASSERT_TRUE(i.isTypeOf("handle_test_type", "root_operation"));
+
+    // Once the tree is rebuilt, the handle no longer refers to the old node
+    unsigned long generation = Inheritance::generation();
+    Inheritance::clear();
+    ASSERT_TRUE(Inheritance::generation() != generation);
+    Inheritance & j = Inheritance::instance();
+    ASSERT_EQUAL(root_operation.get(), j.getType("root_operation"));
+    ASSERT_NULL(handle_test.get());
+}
+
 void Inheritancetest::test_flush()
 {
     Inheritance & i = Inheritance::instance();
@@ -396,14 +436,16 @@ int THINK_NO = -1;
 int RELAY_NO = -1;
 } } }
 
-TypeNode::TypeNode(const std::string & name) : m_name(name), m_parent(0)
+TypeNode::TypeNode(const std::string & name) : m_name(name), m_parent(0),
+                                               m_ancestors(1, this)
 {
 }
 
 TypeNode::TypeNode(const std::string & name,
                    const Atlas::Objects::Root & d) : m_name(name),
                                                      m_description(d),
-                                                     m_parent(0)
+                                                     m_parent(0),
+                                                     m_ancestors(1, this)
 {
 }
 
@@ -425,14 +467,11 @@ bool TypeNode::isTypeOf(const std::string & base_type) const
 
 bool TypeNode::isTypeOf(const TypeNode * base_type) const
 {
-    const TypeNode * node = this;
-    do {
-        if (node == base_type) {
-            return true;
-        }
-        node = node->parent();
-    } while (node != 0);
-    return false;
+    if (base_type == 0) {
+        return false;
+    }
+    std::size_t depth = base_type->depth();
+    return depth < m_ancestors.size() && m_ancestors[depth] == base_type;
 }
 
 void log(LogLevel lvl, const std::string & msg)
@@ -0,0 +1,216 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "rulesets/LocatedEntitySet.h"
+
+#include "common/random.h"
+
+#include <set>
+
+class LocatedEntitySettest : public Cyphesis::TestBase
+{
+  private:
+    // The set never dereferences its members, so any distinct addresses
+    // will do.
+    long m_storage[1000];
+
+    LocatedEntity * member(int i);
+  public:
+    LocatedEntitySettest();
+
+    void setup();
+    void teardown();
+
+    void test_insert();
+    void test_erase();
+    void test_large();
+    void test_random();
+    void test_stamp();
+};
+
+LocatedEntitySettest::LocatedEntitySettest()
+{
+    ADD_TEST(LocatedEntitySettest::test_insert);
+    ADD_TEST(LocatedEntitySettest::test_erase);
+    ADD_TEST(LocatedEntitySettest::test_large);
+    ADD_TEST(LocatedEntitySettest::test_random);
+    ADD_TEST(LocatedEntitySettest::test_stamp);
+}
+
+LocatedEntity * LocatedEntitySettest::member(int i)
+{
+    return reinterpret_cast<LocatedEntity *>(&m_storage[i]);
+}
+
+void LocatedEntitySettest::setup()
+{
+}
+
+void LocatedEntitySettest::teardown()
+{
+}
+
+void LocatedEntitySettest::test_insert()
+{
+    LocatedEntitySet les;
+    ASSERT_TRUE(les.empty());
+
+    std::pair<LocatedEntitySet::const_iterator, bool> ret;
+    ret = les.insert(member(0));
+    ASSERT_TRUE(ret.second);
+    ASSERT_EQUAL(*ret.first, member(0));
+    ret = les.insert(member(1));
+    ASSERT_TRUE(ret.second);
+
+    ret = les.insert(member(0));
+    ASSERT_TRUE(!ret.second);
+    ASSERT_EQUAL(*ret.first, member(0));
+    ASSERT_EQUAL(les.size(), 2u);
+
+    // Members are iterated in the order they were inserted
+    LocatedEntitySet::const_iterator I = les.begin();
+    ASSERT_EQUAL(*I, member(0));
+    ++I;
+    ASSERT_EQUAL(*I, member(1));
+    ++I;
+    ASSERT_TRUE(I == les.end());
+
+    ASSERT_TRUE(les.find(member(1)) != les.end());
+    ASSERT_TRUE(les.find(member(2)) == les.end());
+    ASSERT_EQUAL(les.count(member(1)), 1u);
+    ASSERT_EQUAL(les.count(member(2)), 0u);
+}
+
+void LocatedEntitySettest::test_erase()
+{
+    LocatedEntitySet les;
+    for (int i = 0; i < 4; ++i) {
+        les.insert(member(i));
+    }
+
+    ASSERT_EQUAL(les.erase(member(5)), 0u);
+    ASSERT_EQUAL(les.erase(member(1)), 1u);
+    ASSERT_EQUAL(les.erase(member(1)), 0u);
+    ASSERT_EQUAL(les.size(), 3u);
+    ASSERT_TRUE(les.find(member(1)) == les.end());
+
+    // The last member takes the place of the erased one
+    LocatedEntitySet::const_iterator I = les.begin();
+    ASSERT_EQUAL(*I, member(0));
+    ++I;
+    ASSERT_EQUAL(*I, member(3));
+    ++I;
+    ASSERT_EQUAL(*I, member(2));
+
+    les.clear();
+    ASSERT_TRUE(les.empty());
+    ASSERT_TRUE(les.find(member(0)) == les.end());
+}
+
+void LocatedEntitySettest::test_large()
+{
+    LocatedEntitySet les;
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(les.insert(member(i)).second);
+    }
+    ASSERT_EQUAL(les.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(les.find(member(i)) != les.end());
+        ASSERT_EQUAL(*les.find(member(i)), member(i));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        ASSERT_EQUAL(les.erase(member(i)), 1u);
+    }
+    ASSERT_EQUAL(les.size(), 500u);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQUAL(les.count(member(i)), (i % 2) ? 1u : 0u);
+    }
+}
+
+void LocatedEntitySettest::test_random()
+{
+    // Check against std::set across sizes both sides of the point at
+    // which the hash table is used.
+    int populations[] = { 10, 40, 1000 };
+    for (int p = 0; p < 3; ++p) {
+        LocatedEntitySet les;
+        std::set<LocatedEntity *> reference;
+        for (int i = 0; i < 20000; ++i) {
+            LocatedEntity * e = member(randint(0, populations[p]));
+            switch (randint(0, 3)) {
+                case 0:
+                    ASSERT_EQUAL(les.insert(e).second,
+                                 reference.insert(e).second);
+                    break;
+                case 1:
+                    ASSERT_EQUAL(les.erase(e), reference.erase(e));
+                    break;
+                default:
+                    ASSERT_EQUAL(les.count(e), reference.count(e));
+                    break;
+            }
+            ASSERT_EQUAL(les.size(), reference.size());
+        }
+        std::set<LocatedEntity *> members(les.begin(), les.end());
+        ASSERT_TRUE(members == reference);
+    }
+}
+
+void LocatedEntitySettest::test_stamp()
+{
+    LocatedEntitySet les;
+    LocatedEntitySet other;
+    ASSERT_NOT_EQUAL(les.stamp(), other.stamp());
+
+    unsigned long stamp = les.stamp();
+    les.insert(member(0));
+    ASSERT_NOT_EQUAL(les.stamp(), stamp);
+
+    // Changes which leave the membership alone keep the stamp
+    stamp = les.stamp();
+    les.insert(member(0));
+    les.erase(member(1));
+    ASSERT_EQUAL(les.stamp(), stamp);
+
+    // Replacing a member changes the stamp, though the size is the same
+    les.erase(member(0));
+    les.insert(member(1));
+    ASSERT_NOT_EQUAL(les.stamp(), stamp);
+    ASSERT_EQUAL(les.size(), 1u);
+
+    stamp = les.stamp();
+    les.clear();
+    ASSERT_NOT_EQUAL(les.stamp(), stamp);
+}
+
+int main()
+{
+    LocatedEntitySettest t;
+
+    return t.run();
+}
@@ -29,6 +29,7 @@
 #include "rulesets/LocatedEntity.h"
 
 #include "rulesets/AtlasProperties.h"
+#include "rulesets/PropertySlots.h"
 #include "rulesets/Script.h"
 
 #include <cassert>
@@ -37,6 +38,9 @@ using Atlas::Message::Element;
 using Atlas::Message::ListType;
 using Atlas::Message::MapType;
 
+typedef PropertySlot<SoftProperty, PropertyKey::MASS> TestMassSlot;
+typedef PropertySlot<IdProperty, PropertyKey::MASS> WrongMassSlot;
+
 class LocatedEntitytest : public Cyphesis::TestBase
 {
   private:
@@ -48,12 +52,14 @@ class LocatedEntitytest : public Cyphesis::TestBase
     void teardown();
 
     void test_setProperty();
+    void test_propertySlot();
     void test_coverage();
 };
 
 LocatedEntitytest::LocatedEntitytest()
 {
     ADD_TEST(LocatedEntitytest::test_setProperty);
+    ADD_TEST(LocatedEntitytest::test_propertySlot);
     ADD_TEST(LocatedEntitytest::test_coverage);
 }
 
@@ -81,6 +87,23 @@ void LocatedEntitytest::test_setProperty()
                 m_entity->m_properties.end());
 }
 
+void LocatedEntitytest::test_propertySlot()
+{
+    ASSERT_NULL(m_entity->getPropertySlot<TestMassSlot>());
+    ASSERT_NULL(m_entity->modPropertySlot<TestMassSlot>());
+
+    SoftProperty * mass = new SoftProperty;
+    m_entity->setProperty("mass", mass);
+
+    ASSERT_EQUAL(m_entity->getPropertySlot<TestMassSlot>(), mass);
+    ASSERT_EQUAL(m_entity->modPropertySlot<TestMassSlot>(), mass);
+    ASSERT_EQUAL(m_entity->requirePropertySlot<TestMassSlot>(), mass);
+
+    // A property of the wrong class is not returned
+    ASSERT_NULL(m_entity->getPropertySlot<WrongMassSlot>());
+    ASSERT_NULL(m_entity->modPropertySlot<WrongMassSlot>());
+}
+
 void LocatedEntitytest::test_coverage()
 {
     m_entity->setScript(new Script());
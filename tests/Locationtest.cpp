@@ -34,6 +34,7 @@
 #include <Atlas/Objects/RootOperation.h>
 
 #include <cassert>
+#include <cmath>
 
 
 void testDistanceFunctions()
@@ -332,6 +333,46 @@ void testDistanceFunctions()
         ent2.m_location.m_loc = 0;
     }
 
+    {
+        Entity tlve("0", 0), ent1("1", 1), ent2("2", 2), ent3("3", 3);
+
+        ent1.m_location.m_loc = &tlve;
+        ent1.m_location.m_pos = Point3D(-1, 1, 0);
+        ent1.m_location.m_orientation = WFMath::Quaternion(2, M_PI / 2.f);
+
+        ent2.m_location.m_loc = &tlve;
+        ent2.m_location.m_pos = Point3D(1, 1, 0);
+
+        ent3.m_location.m_loc = &ent1;
+        ent3.m_location.m_pos = Point3D(0, 0, 2);
+
+        // The cached transforms must agree with the full calculation
+        float d = squareDistance(ent3.m_location, ent2.m_location);
+        assert(std::fabs(d - 8.f) < 0.0001f);
+        assert(std::fabs(d - sqrMag(relativePos(ent3.m_location,
+                                                ent2.m_location))) < 0.0001f);
+
+        ent3.m_location.m_pos = Point3D(1, 0, 0);
+        d = squareDistance(ent3.m_location, ent2.m_location);
+        assert(std::fabs(d - sqrMag(relativePos(ent3.m_location,
+                                                ent2.m_location))) < 0.0001f);
+
+        // Moving the parent invalidates the child
+        ent3.m_location.m_pos = Point3D(0, 0, 2);
+        ent1.m_location.m_pos = Point3D(-3, 1, 0);
+        d = squareDistance(ent3.m_location, ent2.m_location);
+        assert(std::fabs(d - 20.f) < 0.0001f);
+
+        // So does a change of parent
+        ent3.m_location.m_loc = &ent2;
+        d = squareDistance(ent3.m_location, ent2.m_location);
+        assert(std::fabs(d - 4.f) < 0.0001f);
+
+        ent1.m_location.m_loc = 0;
+        ent2.m_location.m_loc = 0;
+        ent3.m_location.m_loc = 0;
+    }
+
 }
 
 int main()
@@ -0,0 +1,186 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/MemoryPool.h"
+
+#include <set>
+
+#include <cstring>
+
+class MemoryPooltest : public Cyphesis::TestBase
+{
+  private:
+    MemoryPool * m_pool;
+  public:
+    MemoryPooltest();
+
+    void setup();
+    void teardown();
+
+    void test_allocate();
+    void test_reuse();
+    void test_sizeClasses();
+    void test_oversize();
+    void test_slabs();
+};
+
+MemoryPooltest::MemoryPooltest()
+{
+    ADD_TEST(MemoryPooltest::test_allocate);
+    ADD_TEST(MemoryPooltest::test_reuse);
+    ADD_TEST(MemoryPooltest::test_sizeClasses);
+    ADD_TEST(MemoryPooltest::test_oversize);
+    ADD_TEST(MemoryPooltest::test_slabs);
+}
+
+void MemoryPooltest::setup()
+{
+    m_pool = new MemoryPool;
+}
+
+void MemoryPooltest::teardown()
+{
+    delete m_pool;
+}
+
+void MemoryPooltest::test_allocate()
+{
+    ASSERT_EQUAL(m_pool->live(), 0);
+    ASSERT_EQUAL(m_pool->slabKilobytes(), 0);
+
+    char * a = static_cast<char *>(m_pool->allocate(40));
+    char * b = static_cast<char *>(m_pool->allocate(40));
+    ASSERT_NOT_NULL(a);
+    ASSERT_NOT_NULL(b);
+    ASSERT_TRUE(a != b);
+    ASSERT_EQUAL(m_pool->live(), 2);
+    ASSERT_EQUAL(m_pool->slabKilobytes(),
+                 (int)(MemoryPool::slab_size / 1024));
+
+    // Blocks are aligned and do not overlap
+    ASSERT_EQUAL(reinterpret_cast<std::size_t>(a) % MemoryPool::granularity,
+                 0u);
+    ASSERT_EQUAL(reinterpret_cast<std::size_t>(b) % MemoryPool::granularity,
+                 0u);
+    std::memset(a, 0x55, 40);
+    std::memset(b, 0xaa, 40);
+    ASSERT_EQUAL(a[39], 0x55);
+
+    m_pool->deallocate(a, 40);
+    m_pool->deallocate(b, 40);
+    ASSERT_EQUAL(m_pool->live(), 0);
+    ASSERT_EQUAL(m_pool->reusable(), 2);
+
+    m_pool->deallocate(0, 40);
+    ASSERT_EQUAL(m_pool->reusable(), 2);
+}
+
+void MemoryPooltest::test_reuse()
+{
+    void * a = m_pool->allocate(100);
+    m_pool->deallocate(a, 100);
+
+    // Any size in the same class reuses the block
+    void * b = m_pool->allocate(97);
+    ASSERT_EQUAL(a, b);
+    ASSERT_EQUAL(m_pool->reusable(), 0);
+    ASSERT_EQUAL(m_pool->live(), 1);
+
+    // A different class does not
+    m_pool->deallocate(b, 97);
+    void * c = m_pool->allocate(24);
+    ASSERT_TRUE(c != a);
+    ASSERT_EQUAL(m_pool->reusable(), 1);
+
+    m_pool->deallocate(c, 24);
+}
+
+void MemoryPooltest::test_sizeClasses()
+{
+    std::set<void *> blocks;
+    for (std::size_t size = 1; size <= MemoryPool::max_size; ++size) {
+        void * p = m_pool->allocate(size);
+        ASSERT_TRUE(blocks.insert(p).second);
+        std::memset(p, 0, size);
+        m_pool->deallocate(p, size);
+        // Blocks are reused within the class
+        ASSERT_EQUAL(m_pool->allocate(size), p);
+    }
+    ASSERT_EQUAL(m_pool->live(), (int)MemoryPool::max_size);
+    ASSERT_EQUAL(m_pool->oversize(), 0);
+}
+
+void MemoryPooltest::test_oversize()
+{
+    std::size_t size = MemoryPool::max_size + 1;
+    void * p = m_pool->allocate(size);
+    ASSERT_NOT_NULL(p);
+    ASSERT_EQUAL(m_pool->oversize(), 1);
+    ASSERT_EQUAL(m_pool->live(), 0);
+    ASSERT_EQUAL(m_pool->slabKilobytes(), 0);
+
+    m_pool->deallocate(p, size);
+    ASSERT_EQUAL(m_pool->oversize(), 0);
+    ASSERT_EQUAL(m_pool->reusable(), 0);
+}
+
+void MemoryPooltest::test_slabs()
+{
+    // Enough blocks to fill several slabs
+    const std::size_t size = 512;
+    const int count = 3 * MemoryPool::slab_size / size + 1;
+    std::set<void *> blocks;
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(blocks.insert(m_pool->allocate(size)).second);
+    }
+    ASSERT_EQUAL(m_pool->live(), count);
+    ASSERT_EQUAL(m_pool->slabKilobytes(),
+                 (int)(4 * MemoryPool::slab_size / 1024));
+
+    std::set<void *>::const_iterator I = blocks.begin();
+    std::set<void *>::const_iterator Iend = blocks.end();
+    for (; I != Iend; ++I) {
+        m_pool->deallocate(*I, size);
+    }
+    ASSERT_EQUAL(m_pool->live(), 0);
+    ASSERT_EQUAL(m_pool->reusable(), count);
+
+    // No more slabs are needed to allocate them again
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(blocks.count(m_pool->allocate(size)) == 1);
+    }
+    ASSERT_EQUAL(m_pool->slabKilobytes(),
+                 (int)(4 * MemoryPool::slab_size / 1024));
+}
+
+int main()
+{
+    MemoryPooltest t;
+
+    return t.run();
+}
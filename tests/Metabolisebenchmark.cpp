@@ -0,0 +1,179 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "BenchmarkTimer.h"
+
+#include "rulesets/Character.h"
+#include "rulesets/PropertySlots.h"
+#include "rulesets/StatusProperty.h"
+#include "rulesets/TasksProperty.h"
+
+#include "common/Property.h"
+#include "common/compose.hpp"
+
+#include <cassert>
+#include <map>
+
+static const int iterations = 1000000;
+
+class TestCharacter : public Character
+{
+  public:
+    TestCharacter(const std::string & id, long intId) : Character(id, intId)
+    {
+    }
+
+    void test_applyMetabolism()
+    {
+        applyMetabolism();
+    }
+};
+
+typedef std::map<std::string, PropertyBase *> PropertyMap;
+
+template <class PropertyT>
+static PropertyT * mapLookup(const PropertyMap & properties,
+                             const std::string & name)
+{
+    PropertyMap::const_iterator I = properties.find(name);
+    if (I == properties.end()) {
+        return 0;
+    }
+    return dynamic_cast<PropertyT *>(I->second);
+}
+
+/// Look up the properties applyMetabolism uses in a std::map with dynamic_cast,
+/// the way they were found before properties were keyed by interned name,
+/// to provide a baseline.
+static double lookupByMap(const PropertyMap & properties)
+{
+    StatusProperty * status = mapLookup<StatusProperty>(properties, "status");
+    Property<double> * food = mapLookup<Property<double> >(properties, "food");
+    Property<double> * mass = mapLookup<Property<double> >(properties, "mass");
+    TasksProperty * tasks = mapLookup<TasksProperty>(properties, "tasks");
+    Property<double> * stamina = mapLookup<Property<double> >(properties, "stamina");
+    assert(tasks != 0);
+    return status->data() + food->data() + mass->data() + stamina->data();
+}
+
+/// Look up the properties applyMetabolism uses by name
+static double lookupByName(LocatedEntity & e)
+{
+    StatusProperty * status = e.modPropertyClass<StatusProperty>("status");
+    Property<double> * food = e.modPropertyType<double>("food");
+    Property<double> * mass = e.modPropertyType<double>("mass");
+    const TasksProperty * tasks = e.getPropertyClass<TasksProperty>("tasks");
+    Property<double> * stamina = e.modPropertyType<double>("stamina");
+    assert(tasks != 0);
+    return status->data() + food->data() + mass->data() + stamina->data();
+}
+
+/// Look up the properties applyMetabolism uses through their fixed slots
+static double lookupBySlot(LocatedEntity & e)
+{
+    StatusProperty * status = e.modPropertySlot<StatusSlot>();
+    Property<double> * food = e.modPropertySlot<FoodSlot>();
+    Property<double> * mass = e.modPropertySlot<MassSlot>();
+    const TasksProperty * tasks = e.getPropertySlot<TasksSlot>();
+    Property<double> * stamina = e.modPropertySlot<StaminaSlot>();
+    assert(tasks != 0);
+    return status->data() + food->data() + mass->data() + stamina->data();
+}
+
+static void addProperty(LocatedEntity & e, PropertyMap & properties,
+                        const std::string & name, PropertyBase * prop)
+{
+    e.setProperty(name, prop);
+    properties[name] = prop;
+}
+
+int main()
+{
+    TestCharacter * character = new TestCharacter("1", 1);
+    PropertyMap properties;
+
+    // Give the character a realistic number of properties, so the lookups
+    // are not made in unusually small tables.
+    for (int i = 0; i < 12; ++i) {
+        Property<double> * p = new Property<double>;
+        p->set(i);
+        addProperty(*character, properties, String::compose("test_%1", i), p);
+    }
+
+    StatusProperty * status = new StatusProperty;
+    status->set(1.);
+    addProperty(*character, properties, "status", status);
+    Property<double> * food = new Property<double>;
+    food->set(0.);
+    addProperty(*character, properties, "food", food);
+    Property<double> * mass = new Property<double>;
+    mass->set(60.);
+    addProperty(*character, properties, "mass", mass);
+    addProperty(*character, properties, "tasks", new TasksProperty);
+    Property<double> * stamina = new Property<double>;
+    stamina->set(1.);
+    addProperty(*character, properties, "stamina", stamina);
+
+    double total = 0;
+    {
+        BenchmarkTimer timer;
+        for (int i = 0; i < iterations; ++i) {
+            total += lookupByMap(properties);
+        }
+        timer.report("std::map lookups", iterations);
+    }
+
+    {
+        BenchmarkTimer timer;
+        for (int i = 0; i < iterations; ++i) {
+            total += lookupByName(*character);
+        }
+        timer.report("interned name lookups", iterations);
+    }
+
+    {
+        BenchmarkTimer timer;
+        for (int i = 0; i < iterations; ++i) {
+            total += lookupBySlot(*character);
+        }
+        timer.report("fixed slot lookups", iterations);
+    }
+
+    {
+        BenchmarkTimer timer;
+        for (int i = 0; i < iterations; ++i) {
+            character->test_applyMetabolism();
+        }
+        timer.report("Character::applyMetabolism", iterations);
+    }
+
+    std::cout << "Checksum: " << total << std::endl << std::flush;
+
+    delete character;
+}
@@ -0,0 +1,319 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "rulesets/Character.h"
+#include "rulesets/Entity.h"
+#include "rulesets/MetabolismSystem.h"
+#include "rulesets/StatusProperty.h"
+
+#include "common/BaseWorld.h"
+#include "common/compose.hpp"
+#include "common/Property.h"
+#include "common/Tick.h"
+
+#include <Atlas/Objects/Operation.h>
+
+using Atlas::Objects::Operation::Tick;
+
+static OpVector sent_ops;
+
+/// Food digested by each pass, from Character::foodConsumption
+static const double food_consumption = 0.1;
+
+static Property<double> * newDouble(double value)
+{
+    Property<double> * p = new Property<double>;
+    p->set(value);
+    return p;
+}
+
+class TestWorld : public BaseWorld {
+  public:
+    explicit TestWorld(LocatedEntity& e) : BaseWorld(e) {
+        m_realTime = 100000;
+    }
+
+    virtual bool idle(const SystemTime &) { return false; }
+    virtual LocatedEntity * addEntity(LocatedEntity * ent) {
+        return 0;
+    }
+    virtual LocatedEntity * addNewEntity(const std::string &,
+                                  const Atlas::Objects::Entity::RootEntity &) {
+        return 0;
+    }
+    void delEntity(LocatedEntity * obj) {}
+    int createSpawnPoint(const Atlas::Message::MapType & data,
+                         LocatedEntity *) { return 0; }
+    int getSpawnList(Atlas::Message::ListType & data) { return 0; }
+    LocatedEntity * spawnNewEntity(const std::string & name,
+                                   const std::string & type,
+                                   const Atlas::Objects::Entity::RootEntity & desc) {
+        return addNewEntity(type, desc);
+    }
+    virtual int moveToSpawn(const std::string & name,
+                            Location& location){return 0;}
+    virtual Task * newTask(const std::string &, LocatedEntity &) { return 0; }
+    virtual Task * activateTask(const std::string &, const std::string &,
+                                LocatedEntity *, LocatedEntity &) { return 0; }
+    virtual ArithmeticScript * newArithmetic(const std::string &,
+                                             LocatedEntity *) {
+        return 0;
+    }
+    virtual void message(const Operation & op, LocatedEntity & ent) {
+        sent_ops.push_back(op);
+    }
+    virtual LocatedEntity * findByName(const std::string & name) { return 0; }
+    virtual LocatedEntity * findByType(const std::string & type) { return 0; }
+    virtual void addPerceptive(LocatedEntity *) { }
+};
+
+class MetabolismSystemtest : public Cyphesis::TestBase
+{
+  private:
+    Entity * m_worldEntity;
+    TestWorld * m_world;
+
+    Character * newCharacter(long id, double food);
+  public:
+    MetabolismSystemtest();
+
+    void setup();
+    void teardown();
+
+    void test_addEntity();
+    void test_tickOperation();
+    void test_tick();
+    void test_observable();
+    void test_destroyed();
+    void test_asleep();
+};
+
+MetabolismSystemtest::MetabolismSystemtest()
+{
+    ADD_TEST(MetabolismSystemtest::test_addEntity);
+    ADD_TEST(MetabolismSystemtest::test_tickOperation);
+    ADD_TEST(MetabolismSystemtest::test_tick);
+    ADD_TEST(MetabolismSystemtest::test_observable);
+    ADD_TEST(MetabolismSystemtest::test_destroyed);
+    ADD_TEST(MetabolismSystemtest::test_asleep);
+}
+
+void MetabolismSystemtest::setup()
+{
+    m_worldEntity = new Entity("0", 0);
+    m_world = new TestWorld(*m_worldEntity);
+    sent_ops.clear();
+}
+
+void MetabolismSystemtest::teardown()
+{
+    MetabolismSystem::del();
+    delete m_world;
+    delete m_worldEntity;
+    sent_ops.clear();
+}
+
+Character * MetabolismSystemtest::newCharacter(long id, double food)
+{
+    Character * c = new Character(String::compose("%1", id), id);
+    StatusProperty * status = new StatusProperty;
+    status->set(1.);
+    c->setProperty("status", status);
+    c->setProperty("food", newDouble(food));
+    c->setProperty("mass", newDouble(60.));
+    c->setProperty("stamina", newDouble(1.));
+    return c;
+}
+
+void MetabolismSystemtest::test_addEntity()
+{
+    MetabolismSystem * system = MetabolismSystem::instance();
+    ASSERT_EQUAL(system->entityCount(), 0);
+
+    Character * c = newCharacter(1, 0.);
+    ASSERT_EQUAL(system->addEntity(c), 0);
+    ASSERT_EQUAL(system->entityCount(), 1);
+    ASSERT_TRUE(c->getFlags() & entity_metabolising);
+    ASSERT_EQUAL(c->checkRef(), 1);
+
+    // Adding again has no effect
+    ASSERT_EQUAL(system->addEntity(c), 1);
+    ASSERT_EQUAL(system->entityCount(), 1);
+    ASSERT_EQUAL(c->checkRef(), 1);
+
+    MetabolismSystem::del();
+    ASSERT_EQUAL(c->checkRef(), 0);
+    ASSERT_TRUE((c->getFlags() & entity_metabolising) == 0);
+    c->decRef();
+}
+
+void MetabolismSystemtest::test_tickOperation()
+{
+    Character * c = newCharacter(1, 0.);
+
+    // A metabolism Tick adds the character to the system, and is not
+    // rescheduled
+    OpVector res;
+    Tick tick;
+    c->TickOperation(tick, res);
+    ASSERT_TRUE(res.empty());
+    ASSERT_EQUAL(MetabolismSystem::instance()->entityCount(), 1);
+
+    c->TickOperation(tick, res);
+    ASSERT_TRUE(res.empty());
+    ASSERT_EQUAL(MetabolismSystem::instance()->entityCount(), 1);
+
+    MetabolismSystem::del();
+    c->decRef();
+}
+
+void MetabolismSystemtest::test_tick()
+{
+    MetabolismSystem * system = MetabolismSystem::instance();
+    double interval = system->interval();
+
+    Character * c = newCharacter(1, 1.);
+    system->addEntity(c);
+
+    // The first tick schedules the first pass
+    system->tick(10.);
+    ASSERT_EQUAL(c->getPropertySlot<FoodSlot>()->data(), 1.);
+    system->tick(10. + interval / 2);
+    ASSERT_EQUAL(c->getPropertySlot<FoodSlot>()->data(), 1.);
+
+    system->tick(10. + interval);
+    ASSERT_EQUAL(c->getPropertySlot<FoodSlot>()->data(),
+                 1. - food_consumption);
+    ASSERT_EQUAL(sent_ops.size(), 1u);
+    ASSERT_EQUAL(sent_ops.front()->getClassNo(),
+                 Atlas::Objects::Operation::UPDATE_NO);
+    ASSERT_EQUAL(sent_ops.front()->getTo(), c->getId());
+
+    // Not due again yet
+    system->tick(10. + interval * 1.5);
+    ASSERT_EQUAL(c->getPropertySlot<FoodSlot>()->data(),
+                 1. - food_consumption);
+
+    MetabolismSystem::del();
+    c->decRef();
+}
+
+void MetabolismSystemtest::test_observable()
+{
+    MetabolismSystem * system = MetabolismSystem::instance();
+    double interval = system->interval();
+
+    // A starving character loses status too slowly for each pass to be
+    // observable, so an Update is only sent once enough has accumulated
+    Character * c = newCharacter(1, 0.);
+    system->addEntity(c);
+
+    system->tick(0.);
+    int passes = 0;
+    while (sent_ops.empty() && passes < 1000) {
+        ++passes;
+        system->tick(passes * interval);
+    }
+    ASSERT_EQUAL(sent_ops.size(), 1u);
+    ASSERT_TRUE(passes > 1);
+    ASSERT_EQUAL(system->updateCount(), 1);
+    double status = c->getPropertySlot<StatusSlot>()->data();
+    ASSERT_TRUE(1. - status > MetabolismSystem::observable_change);
+    ASSERT_TRUE(c->getPropertySlot<StatusSlot>()->flags() & flag_unsent);
+
+    // The next pass is measured from the values just sent
+    system->tick((passes + 1) * interval);
+    ASSERT_EQUAL(sent_ops.size(), 1u);
+
+    MetabolismSystem::del();
+    c->decRef();
+}
+
+void MetabolismSystemtest::test_destroyed()
+{
+    MetabolismSystem * system = MetabolismSystem::instance();
+    double interval = system->interval();
+
+    Character * c1 = newCharacter(1, 1.);
+    Character * c2 = newCharacter(2, 1.);
+    Character * c3 = newCharacter(3, 1.);
+    system->addEntity(c1);
+    system->addEntity(c2);
+    system->addEntity(c3);
+    ASSERT_EQUAL(system->entityCount(), 3);
+
+    c1->setFlags(entity_destroyed);
+    // The system holds the only reference to c1 now
+    c1->decRef();
+
+    system->tick(0.);
+    system->tick(interval);
+    ASSERT_EQUAL(system->entityCount(), 2);
+    ASSERT_EQUAL(sent_ops.size(), 2u);
+    ASSERT_EQUAL(c2->getPropertySlot<FoodSlot>()->data(),
+                 1. - food_consumption);
+    ASSERT_EQUAL(c3->getPropertySlot<FoodSlot>()->data(),
+                 1. - food_consumption);
+
+    MetabolismSystem::del();
+    c2->decRef();
+    c3->decRef();
+}
+
+void MetabolismSystemtest::test_asleep()
+{
+    MetabolismSystem * system = MetabolismSystem::instance();
+    double interval = system->interval();
+
+    Character * c = newCharacter(1, 1.);
+    system->addEntity(c);
+    c->setFlags(entity_asleep);
+
+    system->tick(0.);
+    system->tick(interval);
+    system->tick(2 * interval);
+    ASSERT_EQUAL(c->getPropertySlot<FoodSlot>()->data(), 1.);
+    ASSERT_TRUE(sent_ops.empty());
+
+    // Once awake the passes it missed are caught up in one step
+    c->resetFlags(entity_asleep);
+    system->tick(3 * interval);
+    ASSERT_EQUAL(c->getPropertySlot<FoodSlot>()->data(),
+                 1. - 3 * food_consumption);
+    ASSERT_EQUAL(sent_ops.size(), 1u);
+
+    MetabolismSystem::del();
+    c->decRef();
+}
+
+int main()
+{
+    MetabolismSystemtest t;
+
+    return t.run();
+}
@@ -0,0 +1,473 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "rulesets/MindLodScheduler.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include "common/Tick.h"
+
+#include <Atlas/Objects/Operation.h>
+#include <Atlas/Objects/Anonymous.h>
+
+using Atlas::Objects::Operation::Move;
+using Atlas::Objects::Operation::Sight;
+using Atlas::Objects::Operation::Tick;
+using Atlas::Objects::Entity::Anonymous;
+
+class TestEntity : public LocatedEntity
+{
+  public:
+    int m_sent;
+
+    TestEntity(const std::string & id, long intId) : LocatedEntity(id, intId),
+                                                     m_sent(0)
+    {
+    }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+    virtual void destroy() { }
+    virtual void sendWorld(const Operation &) { ++m_sent; }
+};
+
+class MindLodSchedulertest : public Cyphesis::TestBase
+{
+  private:
+    MindLodScheduler * m_scheduler;
+    TestEntity * m_world;
+    TestEntity * m_player;
+    TestEntity * m_mind;
+
+    Operation mindTick(double future_seconds);
+  public:
+    MindLodSchedulertest();
+
+    void setup();
+    void teardown();
+
+    void test_default_tiers();
+    void test_configure_malformed();
+    void test_configure_order();
+    void test_scheduleTick();
+    void test_no_players();
+    void test_checkPerception();
+    void test_checkPerception_self();
+    void test_playerMoved();
+    void test_playerMoved_throttled();
+    void test_removeMind();
+};
+
+MindLodSchedulertest::MindLodSchedulertest()
+{
+    ADD_TEST(MindLodSchedulertest::test_default_tiers);
+    ADD_TEST(MindLodSchedulertest::test_configure_malformed);
+    ADD_TEST(MindLodSchedulertest::test_configure_order);
+    ADD_TEST(MindLodSchedulertest::test_scheduleTick);
+    ADD_TEST(MindLodSchedulertest::test_no_players);
+    ADD_TEST(MindLodSchedulertest::test_checkPerception);
+    ADD_TEST(MindLodSchedulertest::test_checkPerception_self);
+    ADD_TEST(MindLodSchedulertest::test_playerMoved);
+    ADD_TEST(MindLodSchedulertest::test_playerMoved_throttled);
+    ADD_TEST(MindLodSchedulertest::test_removeMind);
+}
+
+void MindLodSchedulertest::setup()
+{
+    m_scheduler = MindLodScheduler::instance();
+
+    m_world = new TestEntity("0", 0);
+    m_world->makeContainer();
+
+    m_player = new TestEntity("1", 1);
+    m_player->m_location.m_loc = m_world;
+    m_player->m_location.m_pos = Point3D(0, 0, 0);
+    m_world->m_contains->insert(m_player);
+
+    m_mind = new TestEntity("2", 2);
+    m_mind->m_location.m_loc = m_world;
+    m_mind->m_location.m_pos = Point3D(50, 0, 0);
+    m_world->m_contains->insert(m_mind);
+}
+
+void MindLodSchedulertest::teardown()
+{
+    MindLodScheduler::del();
+
+    m_player->m_location.m_loc = 0;
+    m_mind->m_location.m_loc = 0;
+    delete m_player;
+    delete m_mind;
+    delete m_world;
+}
+
+Operation MindLodSchedulertest::mindTick(double future_seconds)
+{
+    Anonymous tick_arg;
+    tick_arg->setName("mind");
+
+    Tick tick;
+    tick->setArgs1(tick_arg);
+    tick->setFutureSeconds(future_seconds);
+    return tick;
+}
+
+void MindLodSchedulertest::test_default_tiers()
+{
+    ASSERT_EQUAL(m_scheduler->tiers().size(), 1u);
+    ASSERT_EQUAL(m_scheduler->configure(""), 0);
+    ASSERT_EQUAL(m_scheduler->tiers().size(), 1u);
+
+    Operation tick = mindTick(3.);
+    m_scheduler->scheduleTick(*m_mind, tick);
+    ASSERT_EQUAL(tick->getFutureSeconds(), 3.);
+    ASSERT_EQUAL(m_scheduler->tierCounts()[0], 1);
+}
+
+void MindLodSchedulertest::test_configure_malformed()
+{
+    ASSERT_NOT_EQUAL(m_scheduler->configure("10:1"), 0);
+    ASSERT_NOT_EQUAL(m_scheduler->configure("10;1;1"), 0);
+    ASSERT_NOT_EQUAL(m_scheduler->configure("10:0:1"), 0);
+    ASSERT_EQUAL(m_scheduler->tiers().size(), 1u);
+}
+
+void MindLodSchedulertest::test_configure_order()
+{
+    ASSERT_NOT_EQUAL(m_scheduler->configure("100:1:1 10:4:4"), 0);
+    ASSERT_EQUAL(m_scheduler->tiers().size(), 1u);
+
+    ASSERT_EQUAL(m_scheduler->configure("10:1:1 100:4:4"), 0);
+    ASSERT_EQUAL(m_scheduler->tiers().size(), 2u);
+}
+
+void MindLodSchedulertest::test_scheduleTick()
+{
+    m_scheduler->configure("10:1:1 100:4:2 1000:16:0");
+    m_scheduler->addPlayer(m_player);
+
+    Operation tick = mindTick(3.);
+    m_scheduler->scheduleTick(*m_mind, tick);
+
+    ASSERT_EQUAL(tick->getFutureSeconds(), 12.);
+    ASSERT_EQUAL(m_scheduler->tierCounts()[1], 1);
+    ASSERT_TRUE(m_scheduler->checkTick(*m_mind, tick));
+}
+
+void MindLodSchedulertest::test_no_players()
+{
+    m_scheduler->configure("10:1:1 100:4:2 1000:16:0");
+
+    ASSERT_EQUAL(m_scheduler->tier(*m_mind), 2);
+    ASSERT_EQUAL(m_scheduler->tierCounts()[2], 1);
+}
+
+void MindLodSchedulertest::test_checkPerception()
+{
+    m_scheduler->configure("10:1:1 100:4:2 1000:16:0");
+    m_scheduler->addPlayer(m_player);
+
+    Sight s;
+    s->setFrom(m_player->getId());
+    s->setArgs1(Move());
+
+    ASSERT_TRUE(!m_scheduler->checkPerception(*m_mind, s));
+    ASSERT_TRUE(m_scheduler->checkPerception(*m_mind, s));
+    ASSERT_TRUE(!m_scheduler->checkPerception(*m_mind, s));
+
+    // Perception of anything other than movement is never throttled
+    Sight t;
+    t->setFrom(m_player->getId());
+    t->setArgs1(Tick());
+    ASSERT_TRUE(m_scheduler->checkPerception(*m_mind, t));
+}
+
+void MindLodSchedulertest::test_checkPerception_self()
+{
+    m_scheduler->configure("10:1:1 100:4:0");
+    m_scheduler->addPlayer(m_player);
+
+    Sight s;
+    s->setFrom(m_mind->getId());
+    s->setArgs1(Move());
+
+    ASSERT_TRUE(m_scheduler->checkPerception(*m_mind, s));
+
+    s->setFrom(m_player->getId());
+    ASSERT_TRUE(!m_scheduler->checkPerception(*m_mind, s));
+}
+
+void MindLodSchedulertest::test_playerMoved()
+{
+    m_scheduler->configure("10:1:1 100:4:2 1000:16:0");
+    m_mind->m_location.m_pos = Point3D(500, 0, 0);
+    m_scheduler->addPlayer(m_player);
+
+    Operation old_tick = mindTick(3.);
+    m_scheduler->scheduleTick(*m_mind, old_tick);
+    ASSERT_EQUAL(old_tick->getFutureSeconds(), 48.);
+
+    // Moving within the same tier does not trigger promotion
+    m_player->m_location.m_pos = Point3D(100, 0, 0);
+    m_scheduler->playerMoved(*m_player);
+    ASSERT_EQUAL(m_mind->m_sent, 0);
+
+    m_player->m_location.m_pos = Point3D(495, 0, 0);
+    m_scheduler->playerMoved(*m_player);
+    ASSERT_EQUAL(m_mind->m_sent, 1);
+    ASSERT_EQUAL(m_scheduler->tierCounts()[0], 1);
+    ASSERT_EQUAL(m_scheduler->tierCounts()[2], 0);
+
+    // The long tick scheduled before promotion is now obsolete
+    ASSERT_TRUE(!m_scheduler->checkTick(*m_mind, old_tick));
+
+    Operation new_tick = mindTick(3.);
+    m_scheduler->scheduleTick(*m_mind, new_tick);
+    ASSERT_EQUAL(new_tick->getFutureSeconds(), 3.);
+    ASSERT_TRUE(m_scheduler->checkTick(*m_mind, new_tick));
+}
+
+void MindLodSchedulertest::test_playerMoved_throttled()
+{
+    m_scheduler->configure("10:1:1 100:4:2");
+    m_mind->m_location.m_pos = Point3D(11, 0, 0);
+    ASSERT_EQUAL(m_scheduler->tier(*m_mind), 1);
+    m_scheduler->addPlayer(m_player);
+    ASSERT_EQUAL(m_scheduler->tierCounts()[1], 1);
+
+    // A step shorter than a quarter of the nearest tier is not re-evaluated
+    m_player->m_location.m_pos = Point3D(2, 0, 0);
+    m_scheduler->playerMoved(*m_player);
+    ASSERT_EQUAL(m_mind->m_sent, 0);
+
+    m_player->m_location.m_pos = Point3D(3, 0, 0);
+    m_scheduler->playerMoved(*m_player);
+    ASSERT_EQUAL(m_mind->m_sent, 1);
+    ASSERT_EQUAL(m_scheduler->tierCounts()[0], 1);
+
+    // Removing the player forgets where it was last evaluated
+    m_scheduler->removePlayer(m_player);
+    m_scheduler->addPlayer(m_player);
+    ASSERT_EQUAL(m_scheduler->m_evaluated.size(), 1u);
+    m_scheduler->removePlayer(m_player);
+    ASSERT_TRUE(m_scheduler->m_evaluated.empty());
+}
+
+void MindLodSchedulertest::test_removeMind()
+{
+    m_scheduler->configure("10:1:1 100:4:2");
+    m_scheduler->addPlayer(m_player);
+
+    ASSERT_EQUAL(m_scheduler->tier(*m_mind), 1);
+    ASSERT_EQUAL(m_scheduler->tierCounts()[1], 1);
+
+    m_scheduler->removeMind(m_mind);
+    ASSERT_EQUAL(m_scheduler->tierCounts()[1], 0);
+
+    m_scheduler->removePlayer(m_player);
+    ASSERT_EQUAL(m_scheduler->tier(*m_mind), 1);
+}
+
+int main()
+{
+    MindLodSchedulertest t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "common/log.h"
+#include "common/Monitors.h"
+#include "common/Variable.h"
+
+namespace Atlas { namespace Objects { namespace Operation {
+int TICK_NO = -1;
+} } }
+
+LocatedEntity::LocatedEntity(const std::string & id, long intId) :
+               Router(id, intId),
+               m_refCount(0), m_seq(0),
+               m_script(0), m_type(0), m_flags(0), m_contains(0)
+{
+}
+
+LocatedEntity::~LocatedEntity()
+{
+    delete m_contains;
+}
+
+bool LocatedEntity::hasAttr(const std::string & name) const
+{
+    return false;
+}
+
+int LocatedEntity::getAttr(const std::string & name,
+                           Atlas::Message::Element & attr) const
+{
+    return -1;
+}
+
+int LocatedEntity::getAttrType(const std::string & name,
+                               Atlas::Message::Element & attr,
+                               int type) const
+{
+    return -1;
+}
+
+PropertyBase * LocatedEntity::setAttr(const std::string & name,
+                                      const Atlas::Message::Element & attr)
+{
+    return 0;
+}
+
+const PropertyBase * LocatedEntity::getProperty(const std::string & name) const
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::modProperty(const std::string & name)
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::setProperty(const std::string & name,
+                                          PropertyBase * prop)
+{
+    return 0;
+}
+
+void LocatedEntity::installDelegate(int, const std::string &)
+{
+}
+
+void LocatedEntity::destroy()
+{
+}
+
+Domain * LocatedEntity::getMovementDomain()
+{
+    return 0;
+}
+
+void LocatedEntity::sendWorld(const Operation & op)
+{
+}
+
+void LocatedEntity::onContainered(const LocatedEntity*)
+{
+}
+
+void LocatedEntity::onUpdated()
+{
+}
+
+void LocatedEntity::makeContainer()
+{
+    if (m_contains == 0) {
+        m_contains = new LocatedEntitySet;
+    }
+}
+
+Router::Router(const std::string & id, long intId) : m_id(id), m_intId(intId)
+{
+}
+
+Router::~Router()
+{
+}
+
+void Router::addToMessage(Atlas::Message::MapType & omap) const
+{
+}
+
+void Router::addToEntity(const Atlas::Objects::Entity::RootEntity & ent) const
+{
+}
+
+Location::Location() : m_loc(0)
+{
+}
+
+float squareDistance(const Location & self, const Location & other)
+{
+    return (other.pos() - self.pos()).sqrMag();
+}
+
+float squareDistance(const Point3D & u, const Point3D & v)
+{
+    return (v - u).sqrMag();
+}
+
+VariableBase::~VariableBase()
+{
+}
+
+template <typename T>
+Variable<T>::Variable(const T & variable) : m_variable(variable)
+{
+}
+
+template <typename T>
+Variable<T>::~Variable()
+{
+}
+
+template <typename T>
+void Variable<T>::send(std::ostream & o)
+{
+    o << m_variable;
+}
+
+template class Variable<int>;
+
+Monitors * Monitors::m_instance = NULL;
+
+Monitors::Monitors()
+{
+}
+
+Monitors::~Monitors()
+{
+}
+
+Monitors * Monitors::instance()
+{
+    if (m_instance == NULL) {
+        m_instance = new Monitors();
+    }
+    return m_instance;
+}
+
+void Monitors::watch(const::std::string & name, VariableBase * monitor)
+{
+    delete monitor;
+}
+
+void log(LogLevel lvl, const std::string & msg)
+{
+}
@@ -0,0 +1,216 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "BenchmarkTimer.h"
+
+#include "rulesets/BroadPhase.h"
+#include "rulesets/BulletDomain.h"
+#include "rulesets/Entity.h"
+#include "rulesets/Motion.h"
+
+#include "physics/Collision.h"
+
+#include "common/compose.hpp"
+#include "common/const.h"
+#include "common/random.h"
+
+#include <cassert>
+#include <cmath>
+
+static const int static_count = 10000;
+static const int moving_count = 1000;
+static const int ticks = 10;
+/// Width of the square area the bodies are placed in
+static const float area_size = 2000.f;
+
+/// Check for collisions against everything in the container, the way
+/// Motion did before the broadphase was added, to provide a baseline.
+static bool exhaustiveCheck(LocatedEntity & mover)
+{
+    float coll_time = consts::move_tick;
+    bool collision = false;
+    LocatedEntitySet::const_iterator I = mover.m_location.m_loc->m_contains->begin();
+    LocatedEntitySet::const_iterator Iend = mover.m_location.m_loc->m_contains->end();
+    for (; I != Iend; ++I) {
+        if ((*I) == &mover) { continue; }
+        const Location & other_location = (*I)->m_location;
+        if (!other_location.bBox().isValid() || !other_location.isSolid()) {
+            continue;
+        }
+        Vector3D normal;
+        float t = consts::move_tick + 1;
+        if (!predictCollision(mover.m_location, other_location, t, normal) || (t < 0)) {
+            continue;
+        }
+        if (t <= coll_time) {
+            collision = true;
+            coll_time = t;
+        }
+    }
+    return collision;
+}
+
+static Entity * newBody(Entity * world, long id)
+{
+    Entity * e = new Entity(String::compose("%1", id), id);
+    e->m_location.m_loc = world;
+    e->m_location.m_pos = Point3D(uniform(0, area_size),
+                                  uniform(0, area_size), 0);
+    e->m_location.m_bBox = BBox(Point3D(-0.5, -0.5, 0), Point3D(0.5, 0.5, 2));
+    world->m_contains->insert(e);
+    return e;
+}
+
+/// Move each moving body on by a tick, as its Update operation would
+static void advance(std::vector<Entity *> & movers, double time)
+{
+    std::vector<Entity *>::const_iterator I = movers.begin();
+    std::vector<Entity *>::const_iterator Iend = movers.end();
+    for (; I != Iend; ++I) {
+        Location & loc = (*I)->m_location;
+        loc.m_pos += loc.m_velocity * consts::move_tick;
+        loc.update(time);
+    }
+}
+
+/// Return the moving bodies to where they started
+static void restart(std::vector<Entity *> & movers,
+                    const std::vector<Point3D> & start)
+{
+    for (std::size_t i = 0; i < movers.size(); ++i) {
+        movers[i]->m_location.m_pos = start[i];
+        movers[i]->m_location.update(0);
+    }
+}
+
+/// Check for collisions using Motion, as the moving bodies would on
+/// each of their movement updates
+static long motionCollisions(std::vector<Entity *> & movers,
+                             std::vector<Motion *> & motions)
+{
+    long collisions = 0;
+    for (int tick = 0; tick < ticks; ++tick) {
+        if (Domain::instance() != 0) {
+            Domain::instance()->tick(tick * consts::move_tick);
+        }
+        for (int i = 0; i < moving_count; ++i) {
+            motions[i]->checkCollisions();
+            if (motions[i]->collision()) {
+                ++collisions;
+            }
+        }
+        advance(movers, tick * consts::move_tick);
+    }
+    return collisions;
+}
+
+int main()
+{
+    ::srand(42);
+
+    Entity * world = new Entity("0", 0);
+    world->m_contains = new LocatedEntitySet;
+
+    long id = 1;
+    for (int i = 0; i < static_count; ++i) {
+        newBody(world, id++);
+    }
+
+    std::vector<Entity *> movers;
+    std::vector<Motion *> motions;
+    std::vector<Point3D> start;
+    for (int i = 0; i < moving_count; ++i) {
+        Entity * e = newBody(world, id++);
+        float heading = uniform(0, 2 * M_PI);
+        e->m_location.m_velocity = Vector3D(std::cos(heading),
+                                            std::sin(heading),
+                                            0) * consts::base_velocity;
+        movers.push_back(e);
+        motions.push_back(new Motion(*e));
+        start.push_back(e->m_location.pos());
+    }
+
+    long exhaustive_collisions = 0;
+    {
+        BenchmarkTimer timer;
+        for (int tick = 0; tick < ticks; ++tick) {
+            for (int i = 0; i < moving_count; ++i) {
+                if (exhaustiveCheck(*movers[i])) {
+                    ++exhaustive_collisions;
+                }
+            }
+            advance(movers, tick * consts::move_tick);
+        }
+        timer.report("exhaustive checkCollisions", ticks * moving_count);
+    }
+
+    restart(movers, start);
+
+    long broadphase_collisions = 0;
+    {
+        BenchmarkTimer timer;
+        broadphase_collisions = motionCollisions(movers, motions);
+        timer.report("broadphase checkCollisions", ticks * moving_count);
+    }
+
+    std::cout << "Collisions predicted: " << exhaustive_collisions
+              << " exhaustive, " << broadphase_collisions << " broadphase"
+              << std::endl << std::flush;
+    assert(broadphase_collisions == exhaustive_collisions);
+
+#ifdef HAVE_BULLET
+    restart(movers, start);
+
+    Domain * domain = new BulletDomain(*world);
+    long bullet_collisions = 0;
+    {
+        BenchmarkTimer timer;
+        bullet_collisions = motionCollisions(movers, motions);
+        timer.report("bullet domain checkCollisions", ticks * moving_count);
+    }
+    delete domain;
+
+    std::cout << "Collisions predicted: " << bullet_collisions
+              << " bullet domain" << std::endl << std::flush;
+    assert(bullet_collisions == exhaustive_collisions);
+#endif // HAVE_BULLET
+
+    for (int i = 0; i < moving_count; ++i) {
+        delete motions[i];
+    }
+    BroadPhase::flush();
+    LocatedEntitySet::const_iterator I = world->m_contains->begin();
+    LocatedEntitySet::const_iterator Iend = world->m_contains->end();
+    for (; I != Iend; ++I) {
+        (*I)->m_location.m_loc = 0;
+        delete *I;
+    }
+    world->m_contains->clear();
+    delete world;
+}
@@ -27,8 +27,10 @@
 
 #include "rulesets/Motion.h"
 
+#include "rulesets/BroadPhase.h"
 #include "rulesets/Entity.h"
 
+#include "common/compose.hpp"
 #include "common/TypeNode.h"
 
 class Motiontest : public Cyphesis::TestBase
@@ -58,6 +60,7 @@ class Motiontest : public Cyphesis::TestBase
     void test_checkCollision_inner2();
     void test_checkCollision_inner3();
     void test_checkCollision_inner4();
+    void test_checkCollision_broadphase();
 };
 
 void Motiontest::setup()
@@ -108,10 +111,13 @@ Motiontest::Motiontest()
     ADD_TEST(Motiontest::test_checkCollision_inner2);
     ADD_TEST(Motiontest::test_checkCollision_inner3);
     ADD_TEST(Motiontest::test_checkCollision_inner4);
+    ADD_TEST(Motiontest::test_checkCollision_broadphase);
 }
 
 void Motiontest::teardown()
 {
+    BroadPhase::flush();
+
     ent->m_location.m_loc = 0;
     other->m_location.m_loc = 0;
 
@@ -358,6 +364,56 @@ void Motiontest::test_checkCollision_inner4()
     inner.m_location.m_loc = 0;
 }
 
+void Motiontest::test_checkCollision_broadphase()
+{
+    // Set up our moving entity with a bbox so collisions can be checked for.
+    ent->m_location.m_bBox = BBox(Point3D(-1,-1,-1), Point3D(1,1,1));
+
+    // Set up the other entity with a bbox so collisions can be checked for.
+    other->m_location.m_bBox = BBox(Point3D(-1,-1,-1), Point3D(5,1,1));
+
+    // Move it closer
+    other->m_location.m_pos = Point3D(3, 0, 0);
+
+    // Fill the container with enough distant entities that the
+    // broadphase grid is used to find candidates.
+    std::vector<Entity *> filler;
+    for (int i = 0; i < 100; ++i) {
+        Entity * e = new Entity(String::compose("%1", i + 10), i + 10);
+        e->m_location.m_loc = tlve;
+        e->m_location.m_pos = Point3D(100 + (i % 10) * 10, (i / 10) * 10, 0);
+        e->m_location.m_bBox = BBox(Point3D(-1,-1,-1), Point3D(1,1,1));
+        e->setType(type);
+        tlve->m_contains->insert(e);
+        filler.push_back(e);
+    }
+
+    motion->checkCollisions();
+
+    assert(motion->collision());
+    ASSERT_EQUAL(motion->m_collEntity, other);
+
+    // Once other has gone, there is nothing else nearby.
+    tlve->m_contains->erase(other);
+    motion->checkCollisions();
+    assert(!motion->collision());
+
+    // Entities far away are found once we are moving towards them.
+    ent->m_location.m_pos = Point3D(97, 0, 0);
+    motion->checkCollisions();
+    assert(motion->collision());
+    ASSERT_EQUAL(motion->m_collEntity, filler.front());
+
+    tlve->m_contains->insert(other);
+    std::vector<Entity *>::const_iterator I = filler.begin();
+    std::vector<Entity *>::const_iterator Iend = filler.end();
+    for (; I != Iend; ++I) {
+        tlve->m_contains->erase(*I);
+        (*I)->m_location.m_loc = 0;
+        delete *I;
+    }
+}
+
 int main()
 {
     Motiontest t;
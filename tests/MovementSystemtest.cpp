@@ -0,0 +1,479 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "rulesets/Character.h"
+#include "rulesets/Domain.h"
+#include "rulesets/Entity.h"
+#include "rulesets/MovementSystem.h"
+
+#include "physics/Vector3D.h"
+
+#include "common/BaseWorld.h"
+#include "common/compose.hpp"
+#include "common/const.h"
+#include "common/Tick.h"
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Entity::RootEntity;
+using Atlas::Objects::Operation::Move;
+using Atlas::Objects::Operation::Tick;
+using Atlas::Objects::smart_dynamic_cast;
+
+static OpVector sent_ops;
+
+class TestWorld : public BaseWorld {
+  public:
+    explicit TestWorld(LocatedEntity& e) : BaseWorld(e) {
+        m_realTime = 0;
+    }
+
+    void setTime(double time) {
+        m_realTime = time;
+    }
+
+    virtual bool idle(const SystemTime &) { return false; }
+    virtual LocatedEntity * addEntity(LocatedEntity * ent) {
+        return 0;
+    }
+    virtual LocatedEntity * addNewEntity(const std::string &,
+                                  const Atlas::Objects::Entity::RootEntity &) {
+        return 0;
+    }
+    void delEntity(LocatedEntity * obj) {}
+    int createSpawnPoint(const Atlas::Message::MapType & data,
+                         LocatedEntity *) { return 0; }
+    int getSpawnList(Atlas::Message::ListType & data) { return 0; }
+    LocatedEntity * spawnNewEntity(const std::string & name,
+                                   const std::string & type,
+                                   const Atlas::Objects::Entity::RootEntity & desc) {
+        return addNewEntity(type, desc);
+    }
+    virtual int moveToSpawn(const std::string & name,
+                            Location& location){return 0;}
+    virtual Task * newTask(const std::string &, LocatedEntity &) { return 0; }
+    virtual Task * activateTask(const std::string &, const std::string &,
+                                LocatedEntity *, LocatedEntity &) { return 0; }
+    virtual ArithmeticScript * newArithmetic(const std::string &,
+                                             LocatedEntity *) {
+        return 0;
+    }
+    virtual void message(const Operation & op, LocatedEntity & ent) {
+        sent_ops.push_back(op);
+    }
+    virtual LocatedEntity * findByName(const std::string & name) { return 0; }
+    virtual LocatedEntity * findByType(const std::string & type) { return 0; }
+    virtual void addPerceptive(LocatedEntity *) { }
+};
+
+class MovementSystemtest : public Cyphesis::TestBase
+{
+  private:
+    Entity * m_worldEntity;
+    TestWorld * m_world;
+    Domain * m_domain;
+
+    Character * newCharacter(long id, const Point3D & pos);
+    void mindMove(Character * c, const Point3D & target, OpVector & res);
+    void dispatch(Character * c, const OpVector & res, double time);
+    int ticksUntilSent(double start, int limit);
+  public:
+    MovementSystemtest();
+
+    void setup();
+    void teardown();
+
+    void test_addEntity();
+    void test_tickOperation();
+    void test_mindMove();
+    void test_arrival();
+    void test_retarget();
+    void test_contact();
+    void test_contact_once();
+    void test_destroyed();
+    void test_asleep();
+};
+
+MovementSystemtest::MovementSystemtest()
+{
+    ADD_TEST(MovementSystemtest::test_addEntity);
+    ADD_TEST(MovementSystemtest::test_tickOperation);
+    ADD_TEST(MovementSystemtest::test_mindMove);
+    ADD_TEST(MovementSystemtest::test_arrival);
+    ADD_TEST(MovementSystemtest::test_retarget);
+    ADD_TEST(MovementSystemtest::test_contact);
+    ADD_TEST(MovementSystemtest::test_contact_once);
+    ADD_TEST(MovementSystemtest::test_destroyed);
+    ADD_TEST(MovementSystemtest::test_asleep);
+}
+
+void MovementSystemtest::setup()
+{
+    m_worldEntity = new Entity("0", 0);
+    m_world = new TestWorld(*m_worldEntity);
+    m_domain = new Domain;
+    sent_ops.clear();
+}
+
+void MovementSystemtest::teardown()
+{
+    MovementSystem::del();
+    delete m_domain;
+    delete m_world;
+    delete m_worldEntity;
+    sent_ops.clear();
+}
+
+Character * MovementSystemtest::newCharacter(long id, const Point3D & pos)
+{
+    Character * c = new Character(String::compose("%1", id), id);
+    c->m_location.m_loc = m_worldEntity;
+    c->m_location.m_pos = pos;
+    c->m_location.setBBox(BBox(WFMath::Point<3>(-0.5f, -0.5f, 0.f),
+                               WFMath::Point<3>(0.5f, 0.5f, 2.f)));
+    c->m_location.update(m_world->getTime());
+    return c;
+}
+
+/// Send a character a Move from its mind to walk to a target
+void MovementSystemtest::mindMove(Character * c, const Point3D & target,
+                                  OpVector & res)
+{
+    Anonymous move_arg;
+    move_arg->setId(c->getId());
+    std::vector<double> pos;
+    pos.push_back(target.x());
+    pos.push_back(target.y());
+    pos.push_back(target.z());
+    move_arg->setPos(pos);
+    Move move;
+    move->setArgs1(move_arg);
+    c->mindMoveOperation(move, res);
+}
+
+/// Dispatch the operations a character has sent itself in order,
+/// applying Moves to its location as Thing::MoveOperation would
+void MovementSystemtest::dispatch(Character * c, const OpVector & res,
+                                  double time)
+{
+    OpVector::const_iterator I = res.begin();
+    OpVector::const_iterator Iend = res.end();
+    for (; I != Iend; ++I) {
+        if ((*I)->getClassNo() == Atlas::Objects::Operation::TICK_NO) {
+            OpVector tick_res;
+            c->TickOperation(*I, tick_res);
+            ASSERT_TRUE(tick_res.empty());
+            continue;
+        }
+        if ((*I)->getClassNo() != Atlas::Objects::Operation::MOVE_NO) {
+            continue;
+        }
+        RootEntity arg = smart_dynamic_cast<RootEntity>((*I)->getArgs().front());
+        ASSERT_TRUE(arg.isValid());
+        fromStdVector(c->m_location.m_pos, arg->getPos());
+        fromStdVector(c->m_location.m_velocity, arg->getVelocity());
+        c->m_location.update(time);
+    }
+}
+
+/// Run passes from the time given until the system sends an operation
+///
+/// @return the number of passes run after the one scheduling the first
+int MovementSystemtest::ticksUntilSent(double start, int limit)
+{
+    MovementSystem * system = MovementSystem::instance();
+    system->tick(start);
+    int passes = 0;
+    while (sent_ops.empty() && passes < limit) {
+        ++passes;
+        system->tick(start + passes * system->interval());
+    }
+    return passes;
+}
+
+void MovementSystemtest::test_addEntity()
+{
+    MovementSystem * system = MovementSystem::instance();
+    ASSERT_EQUAL(system->entityCount(), 0);
+
+    Character * c = newCharacter(1, Point3D(0, 0, 0));
+    ASSERT_EQUAL(system->addEntity(c), 0);
+    ASSERT_EQUAL(system->entityCount(), 1);
+    ASSERT_TRUE(c->getFlags() & entity_moving);
+    ASSERT_EQUAL(c->checkRef(), 1);
+
+    // Adding again has no effect
+    ASSERT_EQUAL(system->addEntity(c), 1);
+    ASSERT_EQUAL(system->entityCount(), 1);
+    ASSERT_EQUAL(c->checkRef(), 1);
+
+    MovementSystem::del();
+    ASSERT_EQUAL(c->checkRef(), 0);
+    ASSERT_TRUE((c->getFlags() & entity_moving) == 0);
+    c->decRef();
+}
+
+void MovementSystemtest::test_tickOperation()
+{
+    Character * c = newCharacter(1, Point3D(0, 0, 0));
+
+    // A move Tick adds the character to the system, and is not rescheduled
+    OpVector res;
+    Anonymous tick_arg;
+    tick_arg->setName("move");
+    tick_arg->setAttr("serialno", 0);
+    Tick tick;
+    tick->setArgs1(tick_arg);
+    c->TickOperation(tick, res);
+    ASSERT_TRUE(res.empty());
+    ASSERT_EQUAL(MovementSystem::instance()->entityCount(), 1);
+
+    MovementSystem::del();
+    c->decRef();
+}
+
+void MovementSystemtest::test_mindMove()
+{
+    Character * c = newCharacter(1, Point3D(0, 0, 0));
+
+    // Walking to a target sends one Move, followed by an immediate move
+    // Tick which adds the character to the system once the Move is applied
+    OpVector res;
+    mindMove(c, Point3D(10, 0, 0), res);
+    ASSERT_EQUAL(res.size(), 2u);
+    ASSERT_EQUAL(res.front()->getClassNo(),
+                 Atlas::Objects::Operation::MOVE_NO);
+    ASSERT_EQUAL(res.back()->getClassNo(),
+                 Atlas::Objects::Operation::TICK_NO);
+    ASSERT_TRUE(res.back()->isDefaultFutureSeconds());
+    ASSERT_EQUAL(MovementSystem::instance()->entityCount(), 0);
+
+    dispatch(c, res, 0.);
+    ASSERT_EQUAL(MovementSystem::instance()->entityCount(), 1);
+    ASSERT_TRUE(c->getFlags() & entity_moving);
+
+    MovementSystem::del();
+    c->decRef();
+}
+
+void MovementSystemtest::test_arrival()
+{
+    MovementSystem * system = MovementSystem::instance();
+
+    Character * c = newCharacter(1, Point3D(0, 0, 0));
+    OpVector res;
+    mindMove(c, Point3D(10, 0, 0), res);
+    dispatch(c, res, 0.);
+
+    // No Moves are sent while the character walks in a straight line,
+    // until it arrives
+    int passes = ticksUntilSent(0., 1000);
+    double arrival = 10. / consts::base_velocity;
+    ASSERT_TRUE(passes * system->interval() > arrival - system->interval());
+    ASSERT_TRUE(passes * system->interval() < arrival + system->interval());
+
+    ASSERT_EQUAL(sent_ops.size(), 1u);
+    const Operation & move = sent_ops.front();
+    ASSERT_EQUAL(move->getClassNo(), Atlas::Objects::Operation::MOVE_NO);
+    ASSERT_EQUAL(move->getTo(), c->getId());
+    RootEntity arg = smart_dynamic_cast<RootEntity>(move->getArgs().front());
+    ASSERT_TRUE(arg.isValid());
+    ASSERT_EQUAL(arg->getPos()[0], 10.);
+    ASSERT_EQUAL(arg->getVelocity()[0], 0.);
+    ASSERT_EQUAL(system->entityCount(), 0);
+    ASSERT_EQUAL(system->moveCount(), 1);
+    ASSERT_TRUE((c->getFlags() & entity_moving) == 0);
+    ASSERT_EQUAL(c->checkRef(), 0);
+
+    MovementSystem::del();
+    c->decRef();
+}
+
+void MovementSystemtest::test_retarget()
+{
+    MovementSystem * system = MovementSystem::instance();
+
+    Character * c = newCharacter(1, Point3D(0, 0, 0));
+    OpVector res;
+    mindMove(c, Point3D(10, 0, 0), res);
+    dispatch(c, res, 0.);
+    system->tick(0.);
+
+    // The new target is behind the character, but it must not be taken
+    // to have arrived before the Move turning it round is applied, and
+    // the move Tick following it has been handled
+    res.clear();
+    mindMove(c, Point3D(-10, 0, 0), res);
+    system->tick(system->interval());
+    system->tick(2 * system->interval());
+    ASSERT_TRUE(sent_ops.empty());
+    ASSERT_EQUAL(system->entityCount(), 1);
+
+    dispatch(c, res, 2 * system->interval());
+    int passes = ticksUntilSent(3 * system->interval(), 1000);
+    ASSERT_TRUE(passes > 1);
+    ASSERT_EQUAL(sent_ops.size(), 1u);
+    RootEntity arg = smart_dynamic_cast<RootEntity>(sent_ops.front()->getArgs().front());
+    ASSERT_EQUAL(arg->getPos()[0], -10.);
+
+    MovementSystem::del();
+    c->decRef();
+}
+
+void MovementSystemtest::test_contact()
+{
+    MovementSystem * system = MovementSystem::instance();
+
+    // Two characters walking towards each other
+    Character * c1 = newCharacter(1, Point3D(0, 0, 0));
+    Character * c2 = newCharacter(2, Point3D(3, 0, 0));
+    // A third walking away from them
+    Character * c3 = newCharacter(3, Point3D(-10, 0, 0));
+    OpVector res;
+    mindMove(c1, Point3D(20, 0, 0), res);
+    dispatch(c1, res, 0.);
+    res.clear();
+    mindMove(c2, Point3D(-20, 0, 0), res);
+    dispatch(c2, res, 0.);
+    res.clear();
+    mindMove(c3, Point3D(-30, 0, 0), res);
+    dispatch(c3, res, 0.);
+
+    int passes = ticksUntilSent(0., 100);
+    ASSERT_TRUE(passes < 100);
+
+    // A Move is sent to each of the pair coming into contact, from where
+    // they are now, without stopping them
+    ASSERT_EQUAL(sent_ops.size(), 2u);
+    OpVector::const_iterator I = sent_ops.begin();
+    OpVector::const_iterator Iend = sent_ops.end();
+    for (; I != Iend; ++I) {
+        ASSERT_TRUE((*I)->getTo() == c1->getId() ||
+                    (*I)->getTo() == c2->getId());
+        RootEntity arg = smart_dynamic_cast<RootEntity>((*I)->getArgs().front());
+        ASSERT_TRUE(arg->getVelocity()[0] != 0.);
+    }
+    ASSERT_EQUAL(system->entityCount(), 3);
+
+    MovementSystem::del();
+    c1->decRef();
+    c2->decRef();
+    c3->decRef();
+}
+
+void MovementSystemtest::test_contact_once()
+{
+    MovementSystem * system = MovementSystem::instance();
+
+    // Two characters walking side by side
+    Character * c1 = newCharacter(1, Point3D(0, 0, 0));
+    Character * c2 = newCharacter(2, Point3D(0, 0.8, 0));
+    OpVector res;
+    mindMove(c1, Point3D(20, 0, 0), res);
+    dispatch(c1, res, 0.);
+    res.clear();
+    mindMove(c2, Point3D(20, 0.8, 0), res);
+    dispatch(c2, res, 0.);
+
+    system->tick(0.);
+    system->tick(system->interval());
+    ASSERT_EQUAL(sent_ops.size(), 2u);
+
+    // No more are sent while they stay in contact
+    system->tick(2 * system->interval());
+    system->tick(3 * system->interval());
+    ASSERT_EQUAL(sent_ops.size(), 2u);
+    ASSERT_EQUAL(system->moveCount(), 2);
+
+    MovementSystem::del();
+    c1->decRef();
+    c2->decRef();
+}
+
+void MovementSystemtest::test_destroyed()
+{
+    MovementSystem * system = MovementSystem::instance();
+
+    Character * c1 = newCharacter(1, Point3D(0, 0, 0));
+    Character * c2 = newCharacter(2, Point3D(0, 10, 0));
+    OpVector res;
+    mindMove(c1, Point3D(10, 0, 0), res);
+    dispatch(c1, res, 0.);
+    res.clear();
+    mindMove(c2, Point3D(10, 10, 0), res);
+    dispatch(c2, res, 0.);
+    ASSERT_EQUAL(system->entityCount(), 2);
+
+    c1->setFlags(entity_destroyed);
+    // The system holds the only reference to c1 now
+    c1->decRef();
+
+    ticksUntilSent(0., 1000);
+    ASSERT_EQUAL(sent_ops.size(), 1u);
+    ASSERT_EQUAL(sent_ops.front()->getTo(), c2->getId());
+    ASSERT_EQUAL(system->entityCount(), 0);
+
+    MovementSystem::del();
+    c2->decRef();
+}
+
+void MovementSystemtest::test_asleep()
+{
+    MovementSystem * system = MovementSystem::instance();
+
+    Character * c = newCharacter(1, Point3D(0, 0, 0));
+    OpVector res;
+    mindMove(c, Point3D(10, 0, 0), res);
+    dispatch(c, res, 0.);
+    c->setFlags(entity_asleep);
+
+    double arrival = 10. / consts::base_velocity;
+    system->tick(0.);
+    system->tick(arrival * 2);
+    ASSERT_TRUE(sent_ops.empty());
+    ASSERT_EQUAL(system->entityCount(), 1);
+
+    // Once awake it is found to have arrived
+    c->resetFlags(entity_asleep);
+    system->tick(arrival * 3);
+    ASSERT_EQUAL(sent_ops.size(), 1u);
+    RootEntity arg = smart_dynamic_cast<RootEntity>(sent_ops.front()->getArgs().front());
+    ASSERT_EQUAL(arg->getPos()[0], 10.);
+
+    MovementSystem::del();
+    c->decRef();
+}
+
+int main()
+{
+    MovementSystemtest t;
+
+    return t.run();
+}
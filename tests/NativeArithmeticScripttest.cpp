@@ -0,0 +1,248 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "rulesets/NativeArithmeticScript.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include <cassert>
+
+class TestEntity : public LocatedEntity
+{
+  public:
+    TestEntity(const std::string & id, long intId) : LocatedEntity(id, intId)
+    {
+    }
+
+    virtual int getAttr(const std::string & name,
+                        Atlas::Message::Element & attr) const
+    {
+        if (name == "mass") {
+            attr = 60.;
+            return 0;
+        }
+        if (name == "name") {
+            attr = "bob";
+            return 0;
+        }
+        return -1;
+    }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+    virtual void destroy() { }
+};
+
+int main()
+{
+    float val;
+
+    // A model without an owner can only use formulas and set values
+    {
+        NativeArithmeticScript nas(0);
+        assert(nas.attribute("attack", val) != 0);
+
+        nas.set("attack", 25.f);
+        assert(nas.attribute("attack", val) == 0);
+        assert(val == 25.f);
+
+        assert(nas.addFormula("damage", "attack * 2") == 0);
+        assert(nas.attribute("damage", val) == 0);
+        assert(val == 50.f);
+
+        nas.set("attack", 10.f);
+        assert(nas.attribute("damage", val) == 0);
+        assert(val == 20.f);
+
+        // Formulas can use other formulas
+        assert(nas.addFormula("critical", "damage + attack") == 0);
+        assert(nas.attribute("critical", val) == 0);
+        assert(val == 30.f);
+
+        // A formula takes precedence over a set value of the same name
+        nas.set("damage", 1.f);
+        assert(nas.attribute("damage", val) == 0);
+        assert(val == 20.f);
+
+        // A formula which uses a name with no value has no value
+        assert(nas.addFormula("defence", "armour + 1") == 0);
+        assert(nas.attribute("defence", val) != 0);
+        nas.set("armour", 2.f);
+        assert(nas.attribute("defence", val) == 0);
+        assert(val == 3.f);
+
+        // Invalid formulas are rejected, and leave any previous formula
+        assert(nas.addFormula("damage", "attack *") != 0);
+        assert(nas.attribute("damage", val) == 0);
+        assert(val == 20.f);
+
+        // Formulas which refer to themselves have no value
+        assert(nas.addFormula("loop", "loop + 1") == 0);
+        assert(nas.attribute("loop", val) != 0);
+        assert(nas.addFormula("ping", "pong") == 0);
+        assert(nas.addFormula("pong", "ping") == 0);
+        assert(nas.attribute("ping", val) != 0);
+    }
+
+    // Numeric properties of the owner can be used
+    {
+        TestEntity owner("1", 1);
+        NativeArithmeticScript nas(&owner);
+
+        assert(nas.addFormula("strength", "mass / 2") == 0);
+        assert(nas.attribute("strength", val) == 0);
+        assert(val == 30.f);
+
+        assert(nas.attribute("mass", val) == 0);
+        assert(val == 60.f);
+
+        // Non-numeric properties can not
+        assert(nas.attribute("name", val) != 0);
+        assert(nas.attribute("height", val) != 0);
+
+        // Set values hide properties
+        nas.set("mass", 100.f);
+        assert(nas.attribute("strength", val) == 0);
+        assert(val == 50.f);
+    }
+
+    return 0;
+}
+
+// stubs
+
+#include "common/log.h"
+
+ArithmeticScript::~ArithmeticScript()
+{
+}
+
+LocatedEntity::LocatedEntity(const std::string & id, long intId) :
+               Router(id, intId),
+               m_refCount(0), m_seq(0),
+               m_script(0), m_type(0), m_flags(0), m_contains(0)
+{
+}
+
+LocatedEntity::~LocatedEntity()
+{
+    delete m_contains;
+}
+
+bool LocatedEntity::hasAttr(const std::string & name) const
+{
+    return false;
+}
+
+int LocatedEntity::getAttr(const std::string & name,
+                           Atlas::Message::Element & attr) const
+{
+    return -1;
+}
+
+int LocatedEntity::getAttrType(const std::string & name,
+                               Atlas::Message::Element & attr,
+                               int type) const
+{
+    return -1;
+}
+
+PropertyBase * LocatedEntity::setAttr(const std::string & name,
+                                      const Atlas::Message::Element & attr)
+{
+    return 0;
+}
+
+const PropertyBase * LocatedEntity::getProperty(const std::string & name) const
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::modProperty(const std::string & name)
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::setProperty(const std::string & name,
+                                          PropertyBase * prop)
+{
+    return 0;
+}
+
+void LocatedEntity::installDelegate(int, const std::string &)
+{
+}
+
+void LocatedEntity::destroy()
+{
+}
+
+Domain * LocatedEntity::getMovementDomain()
+{
+    return 0;
+}
+
+void LocatedEntity::sendWorld(const Operation & op)
+{
+}
+
+void LocatedEntity::onContainered(const LocatedEntity*)
+{
+}
+
+void LocatedEntity::onUpdated()
+{
+}
+
+void LocatedEntity::makeContainer()
+{
+    if (m_contains == 0) {
+        m_contains = new LocatedEntitySet;
+    }
+}
+
+Router::Router(const std::string & id, long intId) : m_id(id), m_intId(intId)
+{
+}
+
+Router::~Router()
+{
+}
+
+void Router::addToMessage(Atlas::Message::MapType & omap) const
+{
+}
+
+void Router::addToEntity(const Atlas::Objects::Entity::RootEntity & ent) const
+{
+}
+
+Location::Location() : m_loc(0)
+{
+}
+
+void log(LogLevel lvl, const std::string & msg)
+{
+}
@@ -0,0 +1,158 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "BenchmarkTimer.h"
+
+#include "server/OpQueue.h"
+
+#include "rulesets/Entity.h"
+
+#include "common/compose.hpp"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static const int iterations = 1000000;
+static const int entity_count = 100;
+/// Operations in flight, as a busy server would have queued
+static const int queue_length = 50;
+
+static long allocation_count = 0;
+
+void * operator new(std::size_t size)
+{
+    ++allocation_count;
+    void * p = std::malloc(size == 0 ? 1 : size);
+    if (p == 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+/// Stand in for an entity's operation handler, replying to each operation
+static void deliver(const Operation & reply, OpVector & res)
+{
+    res.push_back(reply);
+}
+
+static void report(const std::string & name, const BenchmarkTimer & timer,
+                   long allocations)
+{
+    timer.report(name, iterations);
+    std::cout << name << ": " << (double)allocations / iterations
+              << " allocations per dispatched op"
+              << std::endl << std::flush;
+}
+
+/// Dispatch through a std::list which allocates a node for each queued
+/// operation, with a new result vector for each delivery, the way
+/// WorldRouter did before entries and buffers were reused, to provide a
+/// baseline.
+static void dispatchList(std::vector<Entity *> & entities,
+                         const Operation & op)
+{
+    std::list<OpQueEntry> queue;
+    for (int i = 0; i < queue_length; ++i) {
+        queue.push_back(OpQueEntry(op, *entities[i % entity_count]));
+    }
+
+    long start = allocation_count;
+    BenchmarkTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        OpQueEntry & oqe = queue.front();
+        OpVector res;
+        deliver(op, res);
+        OpVector::const_iterator I = res.begin();
+        OpVector::const_iterator Iend = res.end();
+        for (; I != Iend; ++I) {
+            queue.push_back(OpQueEntry(*I, *oqe.from));
+        }
+        queue.pop_front();
+    }
+    report("std::list dispatch", timer, allocation_count - start);
+}
+
+/// Dispatch through an OpQueue, reusing one result buffer
+static void dispatchQueue(std::vector<Entity *> & entities,
+                          const Operation & op)
+{
+    OpQueue queue;
+    OpVector buffer;
+    for (int i = 0; i < queue_length; ++i) {
+        queue.push_back(op, *entities[i % entity_count]);
+    }
+
+    long start = allocation_count;
+    BenchmarkTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        OpQueEntry & oqe = *queue.begin();
+        OpVector res;
+        res.swap(buffer);
+        deliver(op, res);
+        OpVector::const_iterator I = res.begin();
+        OpVector::const_iterator Iend = res.end();
+        for (; I != Iend; ++I) {
+            queue.push_back(*I, *oqe.from);
+        }
+        res.clear();
+        res.swap(buffer);
+        queue.pop_front();
+    }
+    report("OpQueue dispatch", timer, allocation_count - start);
+}
+
+int main()
+{
+    std::vector<Entity *> entities;
+    for (int i = 0; i < entity_count; ++i) {
+        entities.push_back(new Entity(String::compose("%1", i), i));
+    }
+
+    Atlas::Objects::Operation::Tick op;
+    op->setTo("1");
+
+    dispatchList(entities, op);
+    dispatchQueue(entities, op);
+
+    for (int i = 0; i < entity_count; ++i) {
+        // The queues have released every reference they held
+        assert(entities[i]->checkRef() == 0);
+        entities[i]->decRef();
+    }
+}
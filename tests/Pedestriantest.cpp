@@ -406,6 +406,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return 8.f;
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
     
@@ -0,0 +1,394 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "rulesets/BBoxProperty.h"
+#include "rulesets/Entity.h"
+#include "rulesets/Plant.h"
+#include "rulesets/PlantGrowthSystem.h"
+#include "rulesets/StatusProperty.h"
+
+#include "common/BaseWorld.h"
+#include "common/compose.hpp"
+#include "common/const.h"
+#include "common/Nourish.h"
+#include "common/Property.h"
+#include "common/Tick.h"
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Operation::Nourish;
+using Atlas::Objects::Operation::Tick;
+
+static OpVector sent_ops;
+
+static int countOps(int class_no)
+{
+    int count = 0;
+    OpVector::const_iterator I = sent_ops.begin();
+    OpVector::const_iterator Iend = sent_ops.end();
+    for (; I != Iend; ++I) {
+        if ((*I)->getClassNo() == class_no) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+class TestWorld : public BaseWorld {
+  public:
+    explicit TestWorld(LocatedEntity& e) : BaseWorld(e) {
+        m_realTime = 100000;
+    }
+
+    virtual bool idle(const SystemTime &) { return false; }
+    virtual LocatedEntity * addEntity(LocatedEntity * ent) {
+        return 0;
+    }
+    virtual LocatedEntity * addNewEntity(const std::string &,
+                                  const Atlas::Objects::Entity::RootEntity &) {
+        return 0;
+    }
+    void delEntity(LocatedEntity * obj) {}
+    int createSpawnPoint(const Atlas::Message::MapType & data,
+                         LocatedEntity *) { return 0; }
+    int getSpawnList(Atlas::Message::ListType & data) { return 0; }
+    LocatedEntity * spawnNewEntity(const std::string & name,
+                                   const std::string & type,
+                                   const Atlas::Objects::Entity::RootEntity & desc) {
+        return addNewEntity(type, desc);
+    }
+    virtual int moveToSpawn(const std::string & name,
+                            Location& location){return 0;}
+    virtual Task * newTask(const std::string &, LocatedEntity &) { return 0; }
+    virtual Task * activateTask(const std::string &, const std::string &,
+                                LocatedEntity *, LocatedEntity &) { return 0; }
+    virtual ArithmeticScript * newArithmetic(const std::string &,
+                                             LocatedEntity *) {
+        return 0;
+    }
+    virtual void message(const Operation & op, LocatedEntity & ent) {
+        sent_ops.push_back(op);
+    }
+    virtual LocatedEntity * findByName(const std::string & name) { return 0; }
+    virtual LocatedEntity * findByType(const std::string & type) { return 0; }
+    virtual void addPerceptive(LocatedEntity *) { }
+};
+
+class PlantGrowthSystemtest : public Cyphesis::TestBase
+{
+  private:
+    Entity * m_worldEntity;
+    TestWorld * m_world;
+
+    Plant * newPlant(long id);
+    void nourish(Plant * plant, double mass);
+  public:
+    PlantGrowthSystemtest();
+
+    void setup();
+    void teardown();
+
+    void test_phase();
+    void test_addEntity();
+    void test_tickOperation();
+    void test_tick();
+    void test_visible();
+    void test_order();
+    void test_destroyed();
+    void test_asleep();
+};
+
+PlantGrowthSystemtest::PlantGrowthSystemtest()
+{
+    ADD_TEST(PlantGrowthSystemtest::test_phase);
+    ADD_TEST(PlantGrowthSystemtest::test_addEntity);
+    ADD_TEST(PlantGrowthSystemtest::test_tickOperation);
+    ADD_TEST(PlantGrowthSystemtest::test_tick);
+    ADD_TEST(PlantGrowthSystemtest::test_visible);
+    ADD_TEST(PlantGrowthSystemtest::test_order);
+    ADD_TEST(PlantGrowthSystemtest::test_destroyed);
+    ADD_TEST(PlantGrowthSystemtest::test_asleep);
+}
+
+void PlantGrowthSystemtest::setup()
+{
+    m_worldEntity = new Entity("0", 0);
+    m_world = new TestWorld(*m_worldEntity);
+    sent_ops.clear();
+}
+
+void PlantGrowthSystemtest::teardown()
+{
+    PlantGrowthSystem::del();
+    delete m_world;
+    delete m_worldEntity;
+    sent_ops.clear();
+}
+
+Plant * PlantGrowthSystemtest::newPlant(long id)
+{
+    Plant * p = new Plant(String::compose("%1", id), id);
+    p->m_location.m_loc = m_worldEntity;
+    p->m_location.setBBox(BBox(Point3D(-1, -1, 0), Point3D(1, 1, 5)));
+    StatusProperty * status = new StatusProperty;
+    status->set(1.);
+    p->setProperty("status", status);
+    Property<double> * mass = new Property<double>;
+    mass->set(10.);
+    p->setProperty("mass", mass);
+    p->setProperty("bbox", new BBoxProperty);
+    return p;
+}
+
+void PlantGrowthSystemtest::nourish(Plant * plant, double mass)
+{
+    Anonymous arg;
+    arg->setAttr("mass", mass);
+    Nourish nourish;
+    nourish->setArgs1(arg);
+    OpVector res;
+    plant->NourishOperation(nourish, res);
+}
+
+void PlantGrowthSystemtest::test_phase()
+{
+    // The phase is derived from the ID, and always the same
+    double phase = PlantGrowthSystem::phase(23);
+    ASSERT_EQUAL(PlantGrowthSystem::phase(23), phase);
+    ASSERT_TRUE(phase >= 0.);
+    ASSERT_TRUE(phase < PlantGrowthSystem::max_jitter);
+    ASSERT_TRUE(PlantGrowthSystem::phase(24) != phase);
+
+    // Plants each added their jitter to their own cycle, so the shared
+    // cycle includes the mean jitter
+    ASSERT_EQUAL(PlantGrowthSystem::instance()->period(),
+                 consts::basic_tick * 20 + PlantGrowthSystem::max_jitter / 2.);
+}
+
+void PlantGrowthSystemtest::test_addEntity()
+{
+    PlantGrowthSystem * system = PlantGrowthSystem::instance();
+    ASSERT_EQUAL(system->entityCount(), 0);
+
+    Plant * p = newPlant(1);
+    ASSERT_EQUAL(system->addEntity(p), 0);
+    ASSERT_EQUAL(system->entityCount(), 1);
+    ASSERT_EQUAL(p->checkRef(), 1);
+
+    // Adding again has no effect
+    ASSERT_EQUAL(system->addEntity(p), 1);
+    ASSERT_EQUAL(system->entityCount(), 1);
+    ASSERT_EQUAL(p->checkRef(), 1);
+
+    PlantGrowthSystem::del();
+    ASSERT_EQUAL(p->checkRef(), 0);
+    p->decRef();
+}
+
+void PlantGrowthSystemtest::test_tickOperation()
+{
+    Plant * p = newPlant(1);
+
+    // A Tick adds the plant to the system, and is not rescheduled
+    OpVector res;
+    Tick tick;
+    p->TickOperation(tick, res);
+    ASSERT_TRUE(res.empty());
+    ASSERT_EQUAL(PlantGrowthSystem::instance()->entityCount(), 1);
+
+    p->TickOperation(tick, res);
+    ASSERT_TRUE(res.empty());
+    ASSERT_EQUAL(PlantGrowthSystem::instance()->entityCount(), 1);
+
+    PlantGrowthSystem::del();
+    p->decRef();
+}
+
+void PlantGrowthSystemtest::test_tick()
+{
+    PlantGrowthSystem * system = PlantGrowthSystem::instance();
+    double period = system->period();
+
+    Plant * p = newPlant(1);
+    double due = 10. + period + PlantGrowthSystem::phase(1);
+    system->addEntity(p);
+    nourish(p, 10.);
+
+    // The first tick starts the first cycle
+    system->tick(10.);
+    ASSERT_TRUE(sent_ops.empty());
+    system->tick(due - 0.1);
+    ASSERT_TRUE(sent_ops.empty());
+
+    system->tick(due);
+    ASSERT_EQUAL(p->getPropertySlot<MassSlot>()->data(), 20.);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::EAT_NO), 1);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::UPDATE_NO), 1);
+    ASSERT_EQUAL(system->updateCount(), 1);
+    ASSERT_TRUE(p->m_location.bBox().highCorner().z() > 5.f);
+
+    // Not due again until the next cycle
+    sent_ops.clear();
+    system->tick(due + period - 0.1);
+    ASSERT_TRUE(sent_ops.empty());
+    system->tick(due + period);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::EAT_NO), 1);
+
+    PlantGrowthSystem::del();
+    p->decRef();
+}
+
+void PlantGrowthSystemtest::test_visible()
+{
+    PlantGrowthSystem * system = PlantGrowthSystem::instance();
+    double period = system->period();
+
+    // Growth too small to see is fed, but not broadcast
+    Plant * p = newPlant(1);
+    system->addEntity(p);
+    nourish(p, 0.1);
+
+    system->tick(0.);
+    system->tick(period + PlantGrowthSystem::max_jitter);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::EAT_NO), 1);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::UPDATE_NO), 0);
+    ASSERT_TRUE(p->m_location.bBox().highCorner().z() > 5.f);
+    ASSERT_TRUE(p->getPropertySlot<StatusSlot>()->flags() & flag_unsent);
+
+    // The growth accumulates until it becomes visible
+    nourish(p, 1.);
+    system->tick(2 * period + PlantGrowthSystem::max_jitter);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::UPDATE_NO), 1);
+
+    PlantGrowthSystem::del();
+    p->decRef();
+}
+
+void PlantGrowthSystemtest::test_order()
+{
+    PlantGrowthSystem * system = PlantGrowthSystem::instance();
+    double period = system->period();
+
+    Plant * p1 = newPlant(1);
+    Plant * p2 = newPlant(2);
+    Plant * early = p1, * late = p2;
+    if (PlantGrowthSystem::phase(2) < PlantGrowthSystem::phase(1)) {
+        std::swap(early, late);
+    }
+    system->addEntity(late);
+    system->addEntity(early);
+
+    // Only the plant with the earlier phase is due
+    system->tick(0.);
+    system->tick(period + (PlantGrowthSystem::phase(1) +
+                           PlantGrowthSystem::phase(2)) / 2);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::EAT_NO), 1);
+    // Without nourishment a plant withers each time it is grown
+    ASSERT_EQUAL(early->getPropertySlot<StatusSlot>()->data(), 0.9);
+    ASSERT_EQUAL(late->getPropertySlot<StatusSlot>()->data(), 1.);
+
+    system->tick(period + PlantGrowthSystem::max_jitter);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::EAT_NO), 2);
+    ASSERT_EQUAL(late->getPropertySlot<StatusSlot>()->data(), 0.9);
+
+    PlantGrowthSystem::del();
+    p1->decRef();
+    p2->decRef();
+}
+
+void PlantGrowthSystemtest::test_destroyed()
+{
+    PlantGrowthSystem * system = PlantGrowthSystem::instance();
+    double period = system->period();
+
+    Plant * p1 = newPlant(1);
+    Plant * p2 = newPlant(2);
+    Plant * p3 = newPlant(3);
+    system->addEntity(p1);
+    system->addEntity(p2);
+    system->addEntity(p3);
+    ASSERT_EQUAL(system->entityCount(), 3);
+
+    p1->setFlags(entity_destroyed);
+    // The system holds the only reference to p1 now
+    p1->decRef();
+
+    system->tick(0.);
+    system->tick(period + PlantGrowthSystem::max_jitter);
+    ASSERT_EQUAL(system->entityCount(), 2);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::EAT_NO), 2);
+
+    // The next cycle skips the destroyed plant too
+    system->tick(2 * period + PlantGrowthSystem::max_jitter);
+    ASSERT_EQUAL(system->entityCount(), 2);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::EAT_NO), 4);
+
+    PlantGrowthSystem::del();
+    p2->decRef();
+    p3->decRef();
+}
+
+void PlantGrowthSystemtest::test_asleep()
+{
+    PlantGrowthSystem * system = PlantGrowthSystem::instance();
+    double period = system->period();
+
+    Plant * p = newPlant(1);
+    system->addEntity(p);
+    p->setFlags(entity_asleep);
+
+    system->tick(0.);
+    system->tick(period + PlantGrowthSystem::max_jitter);
+    system->tick(2 * period + PlantGrowthSystem::max_jitter);
+    ASSERT_TRUE(sent_ops.empty());
+    ASSERT_EQUAL(p->getPropertySlot<StatusSlot>()->data(), 1.);
+
+    // Once awake the cycles it missed are grown in one step, and the
+    // container is told how many there were
+    p->resetFlags(entity_asleep);
+    system->tick(3 * period + PlantGrowthSystem::max_jitter);
+    ASSERT_EQUAL(p->getPropertySlot<StatusSlot>()->data(), 1. - 0.1 * 3);
+    ASSERT_EQUAL(countOps(Atlas::Objects::Operation::EAT_NO), 1);
+    Atlas::Message::Element cycles;
+    ASSERT_EQUAL(sent_ops.front()->getArgs().front()->copyAttr("cycles",
+                                                               cycles), 0);
+    ASSERT_TRUE(cycles.isInt());
+    ASSERT_EQUAL(cycles.Int(), 3L);
+
+    PlantGrowthSystem::del();
+    p->decRef();
+}
+
+int main()
+{
+    PlantGrowthSystemtest t;
+
+    return t.run();
+}
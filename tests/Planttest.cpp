@@ -27,6 +27,7 @@
 #include "allOperations.h"
 
 #include "rulesets/Plant.h"
+#include "rulesets/PlantGrowthSystem.h"
 
 #include "rulesets/AtlasProperties.h"
 #include "rulesets/AreaProperty.h"
@@ -92,6 +93,29 @@ int TICK_NO = -1;
 int UPDATE_NO = -1;
 } } }
 
+PlantGrowthSystem * PlantGrowthSystem::m_instance = 0;
+
+PlantGrowthSystem::PlantGrowthSystem()
+{
+}
+
+PlantGrowthSystem::~PlantGrowthSystem()
+{
+}
+
+PlantGrowthSystem * PlantGrowthSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new PlantGrowthSystem;
+    }
+    return m_instance;
+}
+
+int PlantGrowthSystem::addEntity(Plant *)
+{
+    return 0;
+}
+
 Thing::Thing(const std::string & id, long intId) :
        Entity(id, intId)
 {
@@ -402,6 +426,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return 0.f;
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
     
@@ -455,7 +486,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 {
     long intId = integerId(id);
 
-    EntityDict::const_iterator I = m_eobjects.find(intId);
+    EntityTable::const_iterator I = m_eobjects.find(intId);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -466,7 +497,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 
 LocatedEntity * BaseWorld::getEntity(long id) const
 {
-    EntityDict::const_iterator I = m_eobjects.find(id);
+    EntityTable::const_iterator I = m_eobjects.find(id);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
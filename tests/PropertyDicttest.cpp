@@ -0,0 +1,259 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/PropertyDict.h"
+
+class PropertyDicttest : public Cyphesis::TestBase
+{
+  private:
+    // The table never dereferences its properties, so any distinct
+    // addresses will do.
+    long m_storage[4];
+
+    PropertyBase * prop(int i);
+  public:
+    PropertyDicttest();
+
+    void setup();
+    void teardown();
+
+    void test_intern();
+    void test_insert();
+    void test_find();
+    void test_erase();
+    void test_iterate();
+    void test_slots();
+    void test_not_interned();
+};
+
+PropertyDicttest::PropertyDicttest()
+{
+    ADD_TEST(PropertyDicttest::test_intern);
+    ADD_TEST(PropertyDicttest::test_insert);
+    ADD_TEST(PropertyDicttest::test_find);
+    ADD_TEST(PropertyDicttest::test_erase);
+    ADD_TEST(PropertyDicttest::test_iterate);
+    ADD_TEST(PropertyDicttest::test_slots);
+    ADD_TEST(PropertyDicttest::test_not_interned);
+}
+
+PropertyBase * PropertyDicttest::prop(int i)
+{
+    return reinterpret_cast<PropertyBase *>(&m_storage[i]);
+}
+
+void PropertyDicttest::setup()
+{
+}
+
+void PropertyDicttest::teardown()
+{
+}
+
+void PropertyDicttest::test_intern()
+{
+    ASSERT_TRUE(!PropertyKey().isValid());
+    ASSERT_TRUE(!PropertyKey::lookup("test_never_interned").isValid());
+
+    PropertyKey mass("test_mass");
+    ASSERT_TRUE(mass.isValid());
+    ASSERT_EQUAL(mass.name(), "test_mass");
+    ASSERT_TRUE(PropertyKey("test_mass") == mass);
+    ASSERT_TRUE(PropertyKey::lookup("test_mass") == mass);
+
+    PropertyKey status("test_status");
+    ASSERT_TRUE(status != mass);
+    ASSERT_EQUAL(status.name(), "test_status");
+}
+
+void PropertyDicttest::test_insert()
+{
+    PropertyDict pd;
+    ASSERT_TRUE(pd.empty());
+
+    pd["test_mass"] = prop(0);
+    pd["test_bbox"] = prop(1);
+    ASSERT_EQUAL(pd.size(), 2u);
+
+    // Replacing the value of an existing entry does not add another
+    pd["test_mass"] = prop(2);
+    ASSERT_EQUAL(pd.size(), 2u);
+    ASSERT_EQUAL(pd.find("test_mass")->second, prop(2));
+
+    // Lookup by key and by name find the same entry
+    ASSERT_EQUAL(pd[PropertyKey("test_bbox")], prop(1));
+    ASSERT_EQUAL(pd.size(), 2u);
+}
+
+void PropertyDicttest::test_find()
+{
+    PropertyDict pd;
+    pd["test_mass"] = prop(0);
+
+    PropertyDict::const_iterator I = pd.find("test_mass");
+    ASSERT_TRUE(I != pd.end());
+    ASSERT_EQUAL(I->first, "test_mass");
+    ASSERT_EQUAL(I->second, prop(0));
+    ASSERT_TRUE(I.key() == PropertyKey::lookup("test_mass"));
+
+    ASSERT_TRUE(pd.find("test_status") == pd.end());
+    ASSERT_TRUE(pd.find("test_never_interned") == pd.end());
+    ASSERT_TRUE(pd.find(PropertyKey()) == pd.end());
+}
+
+void PropertyDicttest::test_erase()
+{
+    PropertyDict pd;
+    pd["test_mass"] = prop(0);
+    pd["test_bbox"] = prop(1);
+
+    ASSERT_EQUAL(pd.erase("test_status"), 0u);
+    ASSERT_EQUAL(pd.erase("test_mass"), 1u);
+    ASSERT_TRUE(pd.find("test_mass") == pd.end());
+    ASSERT_EQUAL(pd.size(), 1u);
+
+    pd.erase(pd.find("test_bbox"));
+    ASSERT_TRUE(pd.empty());
+}
+
+void PropertyDicttest::test_iterate()
+{
+    PropertyDict pd;
+    pd["test_status"] = prop(0);
+    pd["test_mass"] = prop(1);
+    pd["test_bbox"] = prop(2);
+    pd["test_other"] = prop(3);
+
+    int count = 0;
+    PropertyDict::const_iterator I = pd.begin();
+    PropertyDict::const_iterator Iend = pd.end();
+    for (; I != Iend; ++I) {
+        ASSERT_TRUE(pd.find(I->first) == I);
+        ++count;
+    }
+    ASSERT_EQUAL(count, 4);
+}
+
+void PropertyDicttest::test_slots()
+{
+    ASSERT_TRUE(PropertyKey("status") == PropertyKey(PropertyKey::STATUS));
+    ASSERT_TRUE(PropertyKey::lookup("mass").isFixed());
+    ASSERT_TRUE(!PropertyKey("test_mass").isFixed());
+    ASSERT_EQUAL(PropertyKey(PropertyKey::BBOX).name(), "bbox");
+
+    PropertyDict pd;
+    ASSERT_NULL(pd.slot(PropertyKey::STATUS));
+    ASSERT_TRUE(pd.find("status") == pd.end());
+
+    pd["status"] = prop(0);
+    pd["test_mass"] = prop(1);
+    pd[PropertyKey(PropertyKey::MASS)] = prop(2);
+    ASSERT_EQUAL(pd.size(), 3u);
+    ASSERT_EQUAL(pd.slot(PropertyKey::STATUS), prop(0));
+    ASSERT_EQUAL(pd.slot(PropertyKey::MASS), prop(2));
+    ASSERT_EQUAL(pd.find("status")->second, prop(0));
+    ASSERT_EQUAL(pd.find("status")->first, "status");
+
+    // Slots and other entries are both visited
+    int count = 0;
+    PropertyDict::const_iterator I = pd.begin();
+    PropertyDict::const_iterator Iend = pd.end();
+    for (; I != Iend; ++I) {
+        ASSERT_TRUE(pd.find(I->first) == I);
+        ++count;
+    }
+    ASSERT_EQUAL(count, 3);
+
+    ASSERT_EQUAL(pd.erase("status"), 1u);
+    ASSERT_NULL(pd.slot(PropertyKey::STATUS));
+    ASSERT_TRUE(pd.find("status") == pd.end());
+    ASSERT_EQUAL(pd.size(), 2u);
+
+    pd.clear();
+    ASSERT_TRUE(pd.empty());
+    ASSERT_NULL(pd.slot(PropertyKey::MASS));
+}
+
+void PropertyDicttest::test_not_interned()
+{
+    PropertyKey::intern("test_ruleset");
+
+    PropertyDict pd;
+    pd["test_ruleset"] = prop(0);
+    pd["test_client_b"] = prop(1);
+    pd["test_client_a"] = prop(2);
+
+    // Setting a name does not intern it
+    ASSERT_TRUE(!PropertyKey::lookup("test_client_a").isValid());
+    ASSERT_TRUE(!PropertyKey::lookup("test_client_b").isValid());
+    ASSERT_EQUAL(pd.size(), 3u);
+
+    PropertyDict::const_iterator I = pd.find("test_client_a");
+    ASSERT_TRUE(I != pd.end());
+    ASSERT_EQUAL(I->first, "test_client_a");
+    ASSERT_EQUAL(I->second, prop(2));
+    ASSERT_TRUE(!I.key().isValid());
+    ASSERT_TRUE(pd.find("test_ruleset").key().isValid());
+
+    pd["test_client_a"] = prop(3);
+    ASSERT_EQUAL(pd.size(), 3u);
+    ASSERT_EQUAL(pd.find("test_client_a")->second, prop(3));
+
+    int count = 0;
+    PropertyDict::const_iterator J = pd.begin();
+    PropertyDict::const_iterator Jend = pd.end();
+    for (; J != Jend; ++J) {
+        ASSERT_TRUE(pd.find(J->first) == J);
+        ++count;
+    }
+    ASSERT_EQUAL(count, 3);
+
+    // An entry made before the name was interned is still found
+    PropertyKey client_b = PropertyKey::intern("test_client_b");
+    ASSERT_EQUAL(pd.find("test_client_b")->second, prop(1));
+    ASSERT_EQUAL(pd.find(client_b, "test_client_b")->second, prop(1));
+    pd["test_client_b"] = prop(4);
+    ASSERT_EQUAL(pd.size(), 3u);
+    ASSERT_EQUAL(pd.find("test_client_b")->second, prop(4));
+
+    ASSERT_EQUAL(pd.erase("test_client_a"), 1u);
+    ASSERT_TRUE(pd.find("test_client_a") == pd.end());
+    pd.erase(pd.find("test_client_b"));
+    ASSERT_EQUAL(pd.size(), 1u);
+
+    pd["test_client_a"] = prop(5);
+    pd.clear();
+    ASSERT_TRUE(pd.empty());
+}
+
+int main()
+{
+    PropertyDicttest t;
+
+    return t.run();
+}
@@ -102,6 +102,7 @@ LocatedEntity * TestWorld::addNewEntity(const std::string &,
 #include "rulesets/AtlasProperties.h"
 #include "rulesets/Domain.h"
 #include "rulesets/Motion.h"
+#include "rulesets/VisibilityGrid.h"
 
 #include "common/const.h"
 #include "common/log.h"
@@ -198,6 +199,35 @@ void Motion::setMode(const std::string & mode)
     // FIXME Re-configure stuff, and possible schedule an update?
 }
 
+VisibilityGrid * VisibilityGrid::forContainer(const LocatedEntity & container,
+                                              double time)
+{
+    return 0;
+}
+
+void VisibilityGrid::moved(LocatedEntity & entity)
+{
+}
+
+float VisibilityGrid::sightRange(float squareBoxSize)
+{
+    return 0.f;
+}
+
+int VisibilityGrid::sightBox(const Point3D & old_pos, const Point3D & new_pos,
+                             float range, BBox & box)
+{
+    return -1;
+}
+
+void BroadPhase::update(LocatedEntity * entity)
+{
+}
+
+void BroadPhase::query(const BBox & box, CandidateList & res)
+{
+}
+
 void Motion::adjustPostion()
 {
 }
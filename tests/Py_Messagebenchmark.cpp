@@ -0,0 +1,149 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include <Python.h>
+
+#include "python_testers.h"
+#include "BenchmarkTimer.h"
+
+#include "rulesets/Python_API.h"
+#include "rulesets/Py_Message.h"
+#include "rulesets/Py_Operation.h"
+#include "rulesets/Py_RootEntity.h"
+
+#include "common/compose.hpp"
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <cassert>
+
+using Atlas::Message::Element;
+using Atlas::Message::MapType;
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Operation::Set;
+
+static const long iterations = 10000;
+
+/// Convert an entity attribute the way Entity.__getattr__ did before
+/// maps were converted lazily, to provide a baseline.
+static PyObject * eager_getattr(PyObject * self, PyObject * args)
+{
+    PyRootEntity * ent;
+    char * name;
+    if (!PyArg_ParseTuple(args, "O!s", &PyRootEntity_Type, &ent, &name)) {
+        return NULL;
+    }
+    Element attr;
+    if (ent->entity->copyAttr(name, attr) != 0) {
+        PyErr_SetString(PyExc_AttributeError, name);
+        return NULL;
+    }
+    return MessageElement_asPyObject(attr);
+}
+
+static PyMethodDef bench_methods[] = {
+    {"eager_getattr", eager_getattr,                    METH_VARARGS},
+    {NULL,          NULL}                       /* Sentinel */
+};
+
+static void run_handler(const char * name, PyObject * handler,
+                        PyObject * op)
+{
+    BenchmarkTimer timer;
+    for (long i = 0; i < iterations; ++i) {
+        PyObject * ret = PyObject_CallFunctionObjArgs(handler, op, NULL);
+        assert(ret != 0);
+        Py_DECREF(ret);
+    }
+    timer.report(name, iterations);
+}
+
+int main()
+{
+    init_python_api("2c4b6e1e-84c8-4a4e-bf0e-1e6d3f7a9b52");
+
+    Py_InitModule("bench", bench_methods);
+
+    // A sight of a Set op with a large map attribute, as seen when an
+    // entity with a lot of state changes
+    MapType big;
+    for (int i = 0; i < 1000; ++i) {
+        MapType item;
+        item["name"] = String::compose("item%1", i);
+        item["mass"] = (double)i;
+        item["pos"] = Atlas::Message::ListType(3, 1.);
+        big[String::compose("k%1", i)] = item;
+    }
+    Anonymous ent;
+    ent->setId("1");
+    ent->setAttr("status", 1.);
+    ent->setAttr("contents", big);
+    Set set;
+    set->setArgs1(ent);
+
+    PyOperation * py_op = newPyOperation();
+    assert(py_op != 0);
+    py_op->operation = set;
+
+    run_python_string("import bench");
+    // Handlers in the style of the sight_*_operation methods in the basic
+    // ruleset minds, which look at a few attributes of the op argument
+    run_python_string("def status_handler(op):\n"
+                      " return op[0].status\n");
+    run_python_string("def lazy_handler(op):\n"
+                      " return op[0].contents['k500'].mass\n");
+    run_python_string("def eager_handler(op):\n"
+                      " return bench.eager_getattr(op[0], 'contents')['k500'].mass\n");
+    run_python_string("def lazy_scan_handler(op):\n"
+                      " return len([k for k in op[0].contents if k.endswith('0')])\n");
+    run_python_string("def eager_scan_handler(op):\n"
+                      " return len([k for k in bench.eager_getattr(op[0], 'contents') if k.endswith('0')])\n");
+
+    PyObject * main_module = PyImport_AddModule("__main__");
+    assert(main_module != 0);
+    PyObject * main_dict = PyModule_GetDict(main_module);
+
+    run_handler("Scalar attribute",
+                PyDict_GetItemString(main_dict, "status_handler"),
+                (PyObject *)py_op);
+    run_handler("Eager lookup of one key",
+                PyDict_GetItemString(main_dict, "eager_handler"),
+                (PyObject *)py_op);
+    run_handler("Lazy lookup of one key",
+                PyDict_GetItemString(main_dict, "lazy_handler"),
+                (PyObject *)py_op);
+    run_handler("Eager scan of keys",
+                PyDict_GetItemString(main_dict, "eager_scan_handler"),
+                (PyObject *)py_op);
+    run_handler("Lazy scan of keys",
+                PyDict_GetItemString(main_dict, "lazy_scan_handler"),
+                (PyObject *)py_op);
+
+    Py_DECREF(py_op);
+
+    shutdown_python_api();
+    return 0;
+}
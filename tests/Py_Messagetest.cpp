@@ -105,6 +105,47 @@ int main()
     run_python_string("print m.foo");
     run_python_string("m.foo = {'foo': 1}");
     run_python_string("print m.foo");
+
+    // Maps and lists inside a message share its data
+    run_python_string("m=Message({'a': {'b': 1, 'c': [2, 3]}, 'd': [4, {}]})");
+    run_python_string("a=m.a");
+    run_python_string("assert len(a) == 2");
+    run_python_string("assert 'b' in a");
+    run_python_string("assert 'z' not in a");
+    run_python_string("assert a.has_key('c')");
+    run_python_string("assert a['b'] == 1");
+    run_python_string("assert a.get('b') == 1");
+    run_python_string("assert a.get('z') is None");
+    run_python_string("assert a.get('z', 5) == 5");
+    expect_python_error("a['z']", PyExc_KeyError);
+    run_python_string("assert sorted(a.keys()) == ['b', 'c']");
+    run_python_string("assert sorted(k for k in a) == ['b', 'c']");
+    run_python_string("assert len(a.items()) == 2");
+    run_python_string("assert len(a.values()) == 2");
+    run_python_string("assert a['c'].pythonize() == [2, 3]");
+    run_python_string("assert Message({'s': {'p': 1}}).s == {'p': 1}");
+    run_python_string("print a");
+    run_python_string("d=m.d");
+    run_python_string("assert len(d) == 2");
+    run_python_string("assert d[0] == 4");
+    run_python_string("assert Message(a).b == 1");
+    run_python_string("assert Message(a).c[1] == 3");
+    // Modifying a view or its items does not modify the message
+    run_python_string("a['z']=6");
+    run_python_string("assert a['z'] == 6");
+    run_python_string("assert 'z' not in m.a");
+    run_python_string("assert Message(a).z == 6");
+    run_python_string("a.update({'y': 7})");
+    run_python_string("assert a.pop('y') == 7");
+    run_python_string("e=m.a");
+    run_python_string("n=Message({'g': {'h': {}}})");
+    run_python_string("h=n.g['h']");
+    run_python_string("h.x = 1");
+    run_python_string("assert h.x == 1");
+    expect_python_error("print n.g['h'].x", PyExc_AttributeError);
+    run_python_string("m.a = 1");
+    run_python_string("assert e['b'] == 1");
+    run_python_string("assert m.a == 1");
     run_python_string("m=Message(1)");
     run_python_string("assert m == 1");
     run_python_string("assert not m == 1.0");
@@ -47,7 +47,12 @@ static PyObject * add_properties(PyObject * self, PyEntity * o)
 
     Entity * ent = o->m_entity.e;
     
+    // Statistics with formulas are calculated without a script
+    Atlas::Message::MapType stats;
+    stats["attack"] = 25.;
+    stats["damage"] = "attack * 2";
     PropertyBase * p = ent->setProperty("statistics", new StatisticsProperty);
+    p->set(stats);
     p->install(ent, "statistics");
     p->apply(ent);
     p = ent->setProperty("terrain", new TerrainProperty);
@@ -90,6 +95,12 @@ int main()
     run_python_string("testprop.add_properties(t)");
     run_python_string("t.line");
     run_python_string("t.statistics");
+    run_python_string("assert t.statistics.attack == 25");
+    run_python_string("assert t.statistics.damage == 50");
+    run_python_string("t.statistics.attack = 10");
+    run_python_string("assert t.statistics.damage == 20");
+    expect_python_error("t.statistics.defence", PyExc_AttributeError);
+    expect_python_error("t.statistics.attack = 'high'", PyExc_TypeError);
     run_python_string("t.terrain");
 
 
@@ -100,6 +100,18 @@ int main()
     run_python_string("e.ptr=set([1,2])");
     run_python_string("e.foo");
     run_python_string("e.ptr");
+    run_python_string("assert e.baz[0] == 1");
+    run_python_string("assert len(e.baz) == 3");
+    run_python_string("assert e.qux['mim'] == 23");
+    run_python_string("assert 'mim' in e.qux");
+    run_python_string("assert e.qux == {'mim': 23}");
+    run_python_string("assert e.qux.keys() == ['mim']");
+    run_python_string("q=e.qux");
+    run_python_string("q['nim']=5");
+    run_python_string("assert len(q) == 2");
+    run_python_string("assert len(e.qux) == 1");
+    run_python_string("e.qux=q");
+    run_python_string("assert e.qux['nim'] == 5");
 
 #ifdef CYPHESIS_DEBUG
     run_python_string("import sabotage");
@@ -176,6 +176,11 @@ int main()
     run_python_string("le.type='game_entity'");
     expect_python_error("le.type='game_entity'", PyExc_RuntimeError);
     run_python_string("le.type");
+    run_python_string("assert(le.type == ['game_entity'])");
+    run_python_string("le.type.append('modified')");
+    run_python_string("assert(le.type == ['game_entity'])");
+    run_python_string("assert(le.id == '1')");
+    run_python_string("assert(le.id is le.id)");
     expect_python_error("le.map=1", PyExc_AttributeError);
     run_python_string("le.map_attr={'1': 2}");
     run_python_string("le.map_attr");
@@ -254,6 +259,8 @@ int main()
     run_python_string("m.int_attr=23");
     run_python_string("assert(m.int_attr == 23)");
     run_python_string("m.float_attr=17.23");
+    run_python_string("assert(m.float_attr == 17.23)");
+    run_python_string("assert(m.id == '1')");
     expect_python_error("m.map_attr={'1': 2}", PyExc_AttributeError);
     expect_python_error("m.map_attr", PyExc_AttributeError);
     expect_python_error("m.list_attr=[1,2]", PyExc_AttributeError);
@@ -0,0 +1,149 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include <Python.h>
+
+#include "python_testers.h"
+#include "BenchmarkTimer.h"
+#include "TestWorld.h"
+
+#include "rulesets/Entity.h"
+#include "rulesets/Py_Operation.h"
+#include "rulesets/Python_API.h"
+#include "rulesets/PythonEntityScript.h"
+#include "rulesets/PythonScriptFactory.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <cassert>
+
+using Atlas::Objects::Operation::Look;
+using Atlas::Objects::Operation::Touch;
+
+static const long iterations = 1000000;
+
+/// Dispatch an operation the way PythonEntityScript did before handler
+/// lookups were cached, to provide a baseline.
+static bool uncachedOperation(PyObject * script,
+                              const std::string & op_type,
+                              const Operation & op)
+{
+    std::string op_name = op_type + "_operation";
+    if (!PyObject_HasAttrString(script, (char *)(op_name.c_str()))) {
+        return false;
+    }
+    PyOperation * py_op = newPyConstOperation();
+    assert(py_op != 0);
+    py_op->operation = op;
+    PyObject * ret = PyObject_CallMethod(script, (char *)(op_name.c_str()),
+                                         (char *)"(O)", py_op);
+    Py_DECREF(py_op);
+    assert(ret != 0);
+    Py_DECREF(ret);
+    return true;
+}
+
+static PyMethodDef no_methods[] = {
+    {NULL,          NULL}                       /* Sentinel */
+};
+
+int main()
+{
+    init_python_api("4f1f3d65-0c5e-4c4b-9a8e-7d7a31f2c6b0");
+
+    Py_InitModule("testmod", no_methods);
+
+    run_python_string("import server");
+    run_python_string("import testmod");
+    run_python_string("class BenchEntity(server.Thing):\n"
+                      " def look_operation(self, op): pass\n");
+    run_python_string("testmod.BenchEntity=BenchEntity");
+
+    PythonScriptFactory<LocatedEntity> psf("testmod", "BenchEntity");
+    int ret = psf.setup();
+    assert(ret == 0);
+    Entity * e = new Entity("1", 1);
+    new TestWorld(*e);
+    ret = psf.addScript(e);
+    assert(ret == 0);
+
+    PythonEntityScript * script = dynamic_cast<PythonEntityScript *>(e->script());
+    assert(script != 0);
+
+    OpVector res;
+    Look look;
+    Touch touch;
+
+    {
+        BenchmarkTimer timer;
+        for (long i = 0; i < iterations; ++i) {
+            uncachedOperation(script->wrapper(), "look", look);
+        }
+        timer.report("Uncached dispatch to handler", iterations);
+    }
+
+    {
+        BenchmarkTimer timer;
+        for (long i = 0; i < iterations; ++i) {
+            script->operation("look", look, res);
+        }
+        timer.report("Cached dispatch to handler", iterations);
+    }
+
+    {
+        BenchmarkTimer timer;
+        for (long i = 0; i < iterations; ++i) {
+            uncachedOperation(script->wrapper(), "touch", touch);
+        }
+        timer.report("Uncached dispatch without handler", iterations);
+    }
+
+    {
+        BenchmarkTimer timer;
+        for (long i = 0; i < iterations; ++i) {
+            script->operation("touch", touch, res);
+        }
+        timer.report("Cached dispatch without handler", iterations);
+    }
+
+    assert(res.empty());
+
+    delete e;
+
+    shutdown_python_api();
+    return 0;
+}
+
+// stubs
+
+LocatedEntity * TestWorld::addNewEntity(const std::string &,
+                                        const Atlas::Objects::Entity::RootEntity &)
+{
+    return 0;
+}
+
+void TestWorld::message(const Operation & op, LocatedEntity & ent)
+{
+}
@@ -146,6 +146,21 @@ int main()
     Script * script = e->script();
     assert(script != 0);
 
+    // Handler lookups are cached per class, so check that repeated
+    // dispatches, and dispatches under a name which is not the operation
+    // type, still find the right handler.
+    res.clear();
+    assert(script->operation("look", op1, res));
+    assert(script->operation("look", op1, res));
+    assert(!script->operation("create", op2, res));
+    assert(!script->operation("create", op2, res));
+    assert(res.empty());
+    assert(script->operation("set", op6, res));
+    assert(res.size() == 1);
+    assert(script->operation("move", op6, res));
+    assert(res.size() == 3);
+    assert(!script->operation("sight_move", op6, res));
+
     script->hook("nohookfunction", e);
     script->hook("test_hook", e);
 
@@ -0,0 +1,232 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include <Python.h>
+
+#include "python_testers.h"
+#include "TestPropertyManager.h"
+
+#include "rulesets/Entity.h"
+#include "rulesets/Python_API.h"
+#include "rulesets/PythonScriptFactory.h"
+#include "rulesets/PythonTickSystem.h"
+
+#include "common/BaseWorld.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <cassert>
+
+using Atlas::Message::Element;
+
+static OpVector sent_ops;
+
+class TestWorld : public BaseWorld {
+  public:
+    explicit TestWorld(LocatedEntity& e) : BaseWorld(e) {
+        m_realTime = 100000;
+    }
+
+    virtual bool idle(const SystemTime &) { return false; }
+    virtual LocatedEntity * addEntity(LocatedEntity * ent) {
+        return 0;
+    }
+    virtual LocatedEntity * addNewEntity(const std::string &,
+                                  const Atlas::Objects::Entity::RootEntity &) {
+        return 0;
+    }
+    void delEntity(LocatedEntity * obj) {}
+    int createSpawnPoint(const Atlas::Message::MapType & data,
+                         LocatedEntity *) { return 0; }
+    int getSpawnList(Atlas::Message::ListType & data) { return 0; }
+    LocatedEntity * spawnNewEntity(const std::string & name,
+                                   const std::string & type,
+                                   const Atlas::Objects::Entity::RootEntity & desc) {
+        return addNewEntity(type, desc);
+    }
+    virtual int moveToSpawn(const std::string & name,
+                            Location& location){return 0;}
+    virtual Task * newTask(const std::string &, LocatedEntity &) { return 0; }
+    virtual Task * activateTask(const std::string &, const std::string &,
+                                LocatedEntity *, LocatedEntity &) { return 0; }
+    virtual ArithmeticScript * newArithmetic(const std::string &,
+                                             LocatedEntity *) {
+        return 0;
+    }
+    virtual void message(const Operation & op, LocatedEntity & ent) {
+        sent_ops.push_back(op);
+    }
+    virtual LocatedEntity * findByName(const std::string & name) { return 0; }
+    virtual LocatedEntity * findByType(const std::string & type) { return 0; }
+    virtual void addPerceptive(LocatedEntity *) { }
+};
+
+static PyMethodDef no_methods[] = {
+    {NULL,          NULL}                       /* Sentinel */
+};
+
+int main()
+{
+    new TestPropertyManager;
+
+    init_python_api("0d1bbc63-9dfd-4e0c-9c7f-6f4b8c1e3a52");
+
+    Py_InitModule("testmod", no_methods);
+
+    run_python_string("import server");
+    run_python_string("import testmod");
+    run_python_string("class BatchEntity(server.Thing):\n"
+                      " tick_batch_properties = ('mass', 'status')\n"
+                      " tick_batch_interval = 10\n"
+                      " calls = []\n"
+                      " result = None\n"
+                      " @classmethod\n"
+                      " def tick_batch(cls, state):\n"
+                      "  cls.calls.append(state)\n"
+                      "  return cls.result\n");
+    run_python_string("class PlainEntity(server.Thing):\n"
+                      " def tick_operation(self, op): pass\n");
+    run_python_string("class BrokenEntity(server.Thing):\n"
+                      " tick_batch_properties = 'mass'\n"
+                      " @classmethod\n"
+                      " def tick_batch(cls, state): pass\n");
+    run_python_string("testmod.BatchEntity=BatchEntity");
+    run_python_string("testmod.PlainEntity=PlainEntity");
+    run_python_string("testmod.BrokenEntity=BrokenEntity");
+
+    PythonScriptFactory<LocatedEntity> batch_factory("testmod",
+                                                     "BatchEntity");
+    int ret = batch_factory.setup();
+    assert(ret == 0);
+    PythonScriptFactory<LocatedEntity> plain_factory("testmod",
+                                                     "PlainEntity");
+    ret = plain_factory.setup();
+    assert(ret == 0);
+    PythonScriptFactory<LocatedEntity> broken_factory("testmod",
+                                                      "BrokenEntity");
+    ret = broken_factory.setup();
+    assert(ret == 0);
+
+    Entity * world_entity = new Entity("0", 0);
+    new TestWorld(*world_entity);
+
+    PythonTickSystem * system = PythonTickSystem::instance();
+    assert(system->entityCount() == 0);
+
+    Entity * e1 = new Entity("1", 1);
+    e1->setAttr("mass", 1.);
+    e1->setAttr("status", 1.);
+    ret = batch_factory.addScript(e1);
+    assert(ret == 0);
+    assert(system->entityCount() == 1);
+
+    Entity * e2 = new Entity("2", 2);
+    e2->setAttr("mass", 2.);
+    ret = batch_factory.addScript(e2);
+    assert(ret == 0);
+    assert(system->entityCount() == 2);
+
+    // Classes which do not define tick_batch are not batched
+    Entity * e3 = new Entity("3", 3);
+    ret = plain_factory.addScript(e3);
+    assert(ret == 0);
+    assert(system->entityCount() == 2);
+
+    // Classes which define tick_batch badly are not batched
+    Entity * e4 = new Entity("4", 4);
+    ret = broken_factory.addScript(e4);
+    assert(ret == 0);
+    assert(system->entityCount() == 2);
+
+    // The first tick schedules the batches, and nothing runs until an
+    // interval has passed.
+    system->tick(100.);
+    system->tick(105.);
+    run_python_string("assert len(BatchEntity.calls) == 0");
+
+    system->tick(110.);
+    run_python_string("assert len(BatchEntity.calls) == 1");
+    run_python_string("state = BatchEntity.calls[0]");
+    run_python_string("assert state['id'] == ['1', '2']");
+    run_python_string("assert state['mass'] == [1., 2.]");
+    run_python_string("assert state['status'] == [1., None]");
+    assert(sent_ops.empty());
+
+    // Changes can be given as a list per property, or as a dict by index
+    run_python_string("BatchEntity.result = {'mass': [None, 5.],"
+                                            " 'status': {0: 0.5}}");
+    system->tick(120.);
+    run_python_string("assert len(BatchEntity.calls) == 2");
+
+    Element val;
+    ret = e1->getAttr("mass", val);
+    assert(ret == 0);
+    assert(val == 1.);
+    ret = e1->getAttr("status", val);
+    assert(ret == 0);
+    assert(val == 0.5);
+    ret = e2->getAttr("mass", val);
+    assert(ret == 0);
+    assert(val == 5.);
+
+    // Each modified entity is sent a single Update
+    assert(sent_ops.size() == 2);
+    assert(sent_ops[0]->getParents().front() == "update");
+    assert(sent_ops[0]->getTo() == "1");
+    assert(sent_ops[1]->getTo() == "2");
+    sent_ops.clear();
+
+    // Invalid results are reported, and do not change anything
+    run_python_string("BatchEntity.result = {'mass': [1.]}");
+    system->tick(130.);
+    run_python_string("BatchEntity.result = {'mass': {7: 1.}}");
+    system->tick(140.);
+    run_python_string("BatchEntity.result = 1");
+    system->tick(150.);
+    assert(sent_ops.empty());
+    run_python_string("assert len(BatchEntity.calls) == 5");
+
+    // A server which has fallen behind does not run batches to catch up
+    run_python_string("BatchEntity.result = None");
+    system->tick(200.);
+    system->tick(201.);
+    run_python_string("assert len(BatchEntity.calls) == 6");
+
+    // Destroyed entities are dropped from the batch
+    e1->setFlags(entity_destroyed);
+    system->tick(211.);
+    assert(system->entityCount() == 1);
+    run_python_string("assert BatchEntity.calls[-1]['id'] == ['2']");
+
+    PythonTickSystem::del();
+
+    delete e1;
+    delete e2;
+    delete e3;
+    delete e4;
+
+    shutdown_python_api();
+    return 0;
+}
@@ -0,0 +1,231 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "rulesets/Entity.h"
+#include "rulesets/MindLodScheduler.h"
+#include "rulesets/RegionSleepSystem.h"
+
+#include "common/BaseWorld.h"
+#include "common/compose.hpp"
+
+static int wake_count = 0;
+
+class TestWorld : public BaseWorld {
+  public:
+    explicit TestWorld(LocatedEntity& e) : BaseWorld(e) {
+        m_realTime = 100000;
+    }
+
+    virtual bool idle(const SystemTime &) { return false; }
+    virtual LocatedEntity * addEntity(LocatedEntity * ent) {
+        return 0;
+    }
+    virtual LocatedEntity * addNewEntity(const std::string &,
+                                  const Atlas::Objects::Entity::RootEntity &) {
+        return 0;
+    }
+    void delEntity(LocatedEntity * obj) {}
+    int createSpawnPoint(const Atlas::Message::MapType & data,
+                         LocatedEntity *) { return 0; }
+    int getSpawnList(Atlas::Message::ListType & data) { return 0; }
+    LocatedEntity * spawnNewEntity(const std::string & name,
+                                   const std::string & type,
+                                   const Atlas::Objects::Entity::RootEntity & desc) {
+        return addNewEntity(type, desc);
+    }
+    virtual int moveToSpawn(const std::string & name,
+                            Location& location){return 0;}
+    virtual Task * newTask(const std::string &, LocatedEntity &) { return 0; }
+    virtual Task * activateTask(const std::string &, const std::string &,
+                                LocatedEntity *, LocatedEntity &) { return 0; }
+    virtual ArithmeticScript * newArithmetic(const std::string &,
+                                             LocatedEntity *) {
+        return 0;
+    }
+    virtual void message(const Operation & op, LocatedEntity & ent) { }
+    virtual LocatedEntity * findByName(const std::string & name) { return 0; }
+    virtual LocatedEntity * findByType(const std::string & type) { return 0; }
+    virtual void addPerceptive(LocatedEntity *) { }
+    virtual void wakeEntities() { ++wake_count; }
+};
+
+class RegionSleepSystemtest : public Cyphesis::TestBase
+{
+  private:
+    Entity * m_worldEntity;
+    TestWorld * m_world;
+    Entity * m_player;
+    Entity * m_near;
+    Entity * m_far;
+    Entity * m_inside;
+
+    Entity * newEntity(long id, LocatedEntity * loc, const Point3D & pos);
+  public:
+    RegionSleepSystemtest();
+
+    void setup();
+    void teardown();
+
+    void test_disabled();
+    void test_sweep();
+    void test_wake();
+    void test_setRegionSize();
+    void test_tick();
+};
+
+RegionSleepSystemtest::RegionSleepSystemtest()
+{
+    ADD_TEST(RegionSleepSystemtest::test_disabled);
+    ADD_TEST(RegionSleepSystemtest::test_sweep);
+    ADD_TEST(RegionSleepSystemtest::test_wake);
+    ADD_TEST(RegionSleepSystemtest::test_setRegionSize);
+    ADD_TEST(RegionSleepSystemtest::test_tick);
+}
+
+Entity * RegionSleepSystemtest::newEntity(long id,
+                                          LocatedEntity * loc,
+                                          const Point3D & pos)
+{
+    Entity * e = new Entity(String::compose("%1", id), id);
+    e->m_location.m_loc = loc;
+    e->m_location.m_pos = pos;
+    loc->makeContainer();
+    loc->m_contains->insert(e);
+    return e;
+}
+
+void RegionSleepSystemtest::setup()
+{
+    m_worldEntity = new Entity("0", 0);
+    m_world = new TestWorld(*m_worldEntity);
+    m_player = newEntity(1, m_worldEntity, Point3D(5, 5, 0));
+    m_near = newEntity(2, m_worldEntity, Point3D(150, 5, 0));
+    m_far = newEntity(3, m_worldEntity, Point3D(1000, 1000, 0));
+    m_inside = newEntity(4, m_far, Point3D(0, 0, 0));
+    MindLodScheduler::instance()->addPlayer(m_player);
+    wake_count = 0;
+}
+
+void RegionSleepSystemtest::teardown()
+{
+    RegionSleepSystem::del();
+    MindLodScheduler::del();
+    delete m_world;
+    delete m_inside;
+    delete m_far;
+    delete m_near;
+    delete m_player;
+    delete m_worldEntity;
+}
+
+void RegionSleepSystemtest::test_disabled()
+{
+    RegionSleepSystem * system = RegionSleepSystem::instance();
+    ASSERT_EQUAL(system->regionSize(), 0.f);
+
+    system->tick(0.);
+    system->tick(system->interval());
+    ASSERT_EQUAL(system->asleepCount(), 0);
+    ASSERT_TRUE((m_far->getFlags() & entity_asleep) == 0);
+}
+
+void RegionSleepSystemtest::test_sweep()
+{
+    RegionSleepSystem * system = RegionSleepSystem::instance();
+    system->setRegionSize(100.f);
+
+    system->sweep();
+    // The regions next to the player's are awake too
+    ASSERT_TRUE((m_player->getFlags() & entity_asleep) == 0);
+    ASSERT_TRUE((m_near->getFlags() & entity_asleep) == 0);
+    // Contained entities sleep with their container
+    ASSERT_TRUE(m_far->getFlags() & entity_asleep);
+    ASSERT_TRUE(m_inside->getFlags() & entity_asleep);
+    ASSERT_EQUAL(system->asleepCount(), 2);
+    ASSERT_EQUAL(wake_count, 0);
+}
+
+void RegionSleepSystemtest::test_wake()
+{
+    RegionSleepSystem * system = RegionSleepSystem::instance();
+    system->setRegionSize(100.f);
+    system->sweep();
+
+    m_player->m_location.m_pos = Point3D(990, 990, 0);
+    system->sweep();
+    ASSERT_TRUE((m_far->getFlags() & entity_asleep) == 0);
+    ASSERT_TRUE((m_inside->getFlags() & entity_asleep) == 0);
+    ASSERT_TRUE(m_near->getFlags() & entity_asleep);
+    ASSERT_EQUAL(system->asleepCount(), 1);
+    ASSERT_EQUAL(wake_count, 1);
+
+    // With no players everything sleeps
+    MindLodScheduler::instance()->removePlayer(m_player);
+    system->sweep();
+    ASSERT_EQUAL(system->asleepCount(), 4);
+    ASSERT_EQUAL(wake_count, 1);
+}
+
+void RegionSleepSystemtest::test_setRegionSize()
+{
+    RegionSleepSystem * system = RegionSleepSystem::instance();
+    system->setRegionSize(100.f);
+    system->sweep();
+    ASSERT_EQUAL(system->asleepCount(), 2);
+
+    // Disabling sleep wakes everything
+    system->setRegionSize(0.f);
+    ASSERT_EQUAL(system->asleepCount(), 0);
+    ASSERT_TRUE((m_far->getFlags() & entity_asleep) == 0);
+    ASSERT_TRUE((m_inside->getFlags() & entity_asleep) == 0);
+    ASSERT_EQUAL(wake_count, 1);
+}
+
+void RegionSleepSystemtest::test_tick()
+{
+    RegionSleepSystem * system = RegionSleepSystem::instance();
+    double interval = system->interval();
+    system->setRegionSize(100.f);
+
+    // The first tick sweeps straight away
+    system->tick(10.);
+    ASSERT_EQUAL(system->asleepCount(), 2);
+
+    m_player->m_location.m_pos = Point3D(990, 990, 0);
+    system->tick(10. + interval / 2);
+    ASSERT_EQUAL(wake_count, 0);
+    system->tick(10. + interval);
+    ASSERT_EQUAL(wake_count, 1);
+}
+
+int main()
+{
+    RegionSleepSystemtest t;
+
+    return t.run();
+}
@@ -1403,10 +1403,6 @@ Character::~Character() {
 
 }
 
-void Character::metabolise(OpVector & res, double ammount)
-{
-}
-
 void Character::wieldDropped()
 {
 }
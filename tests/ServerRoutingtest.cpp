@@ -413,7 +413,7 @@ Account * Persistence::getAccount(const std::string & name)
 }
 
 void Persistence::registerCharacters(Account & ac,
-                                     const EntityDict & worldObjects)
+                                     const EntityTable & worldObjects)
 {
 }
 
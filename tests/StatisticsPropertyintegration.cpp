@@ -102,6 +102,9 @@ class StatisicsPropertyintegration : public Cyphesis::TestBase
     void teardown();
 
     void test_copy();
+    void test_formulae();
+    void test_formulae_fallback();
+    void test_formulae_changed();
 };
 
 StatisicsPropertyintegration::StatisicsPropertyintegration()
@@ -109,6 +112,9 @@ StatisicsPropertyintegration::StatisicsPropertyintegration()
     new ArithmeticTestWorld(*(LocatedEntity*)0);
 
     ADD_TEST(StatisicsPropertyintegration::test_copy);
+    ADD_TEST(StatisicsPropertyintegration::test_formulae);
+    ADD_TEST(StatisicsPropertyintegration::test_formulae_fallback);
+    ADD_TEST(StatisicsPropertyintegration::test_formulae_changed);
 }
 
 void StatisicsPropertyintegration::setup()
@@ -145,6 +151,90 @@ void StatisicsPropertyintegration::test_copy()
     ASSERT_NOT_EQUAL(pb, m_char_property);
 }
 
+void StatisicsPropertyintegration::test_formulae()
+{
+    Atlas::Message::MapType stats;
+    stats["attack"] = 25.;
+    stats["damage"] = "attack * 2";
+
+    StatisticsProperty * sp = new StatisticsProperty;
+    sp->set(stats);
+    m_char1->setProperty("statistics", sp);
+    sp->install(m_char1, "statistics");
+    sp->apply(m_char1);
+
+    // Formulas are evaluated natively, not by the world's script
+    ArithmeticScript * script = sp->script();
+    ASSERT_NOT_NULL(script);
+    ASSERT_NULL(dynamic_cast<TestArithmeticScript *>(script));
+
+    float val;
+    ASSERT_EQUAL(script->attribute("damage", val), 0);
+    ASSERT_EQUAL(val, 50.f);
+
+    // Formulas are kept as strings in the property value
+    Atlas::Message::Element data;
+    ASSERT_EQUAL(sp->get(data), 0);
+    ASSERT_TRUE(data.isMap());
+    ASSERT_TRUE(data.Map()["attack"] == 25.);
+    ASSERT_TRUE(data.Map()["damage"] == "attack * 2");
+}
+
+void StatisicsPropertyintegration::test_formulae_fallback()
+{
+    Atlas::Message::MapType stats;
+    stats["damage"] = "attack *";
+
+    StatisticsProperty * sp = new StatisticsProperty;
+    sp->set(stats);
+    m_char1->setProperty("statistics", sp);
+    sp->install(m_char1, "statistics");
+    sp->apply(m_char1);
+
+    // A formula which can't be compiled falls back to the world's script
+    ASSERT_NOT_NULL(dynamic_cast<TestArithmeticScript *>(sp->script()));
+}
+
+void StatisicsPropertyintegration::test_formulae_changed()
+{
+    Atlas::Message::MapType stats;
+    stats["attack"] = 25.;
+    stats["damage"] = "attack * 2";
+
+    StatisticsProperty * sp = new StatisticsProperty;
+    sp->set(stats);
+    m_char1->setProperty("statistics", sp);
+    sp->install(m_char1, "statistics");
+    sp->apply(m_char1);
+
+    float val;
+    ASSERT_EQUAL(sp->script()->attribute("damage", val), 0);
+    ASSERT_EQUAL(val, 50.f);
+
+    // A changed formula is compiled the next time the property is applied
+    stats.clear();
+    stats["damage"] = "attack * 3";
+    stats["defence"] = "attack + 5";
+    sp->set(stats);
+    sp->apply(m_char1);
+
+    ASSERT_EQUAL(sp->script()->attribute("damage", val), 0);
+    ASSERT_EQUAL(val, 75.f);
+    ASSERT_EQUAL(sp->script()->attribute("defence", val), 0);
+    ASSERT_EQUAL(val, 30.f);
+
+    // A formula replaced by a number is no longer used
+    stats.clear();
+    stats["damage"] = 10.;
+    sp->set(stats);
+    sp->apply(m_char1);
+
+    ASSERT_EQUAL(sp->script()->attribute("damage", val), 0);
+    ASSERT_EQUAL(val, 10.f);
+    ASSERT_EQUAL(sp->script()->attribute("defence", val), 0);
+    ASSERT_EQUAL(val, 30.f);
+}
+
 int main()
 {
     StatisicsPropertyintegration t;
@@ -191,6 +281,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return 0.f;
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
 }
@@ -204,38 +204,6 @@ int main()
 using Atlas::Message::MapType;
 using Atlas::Objects::Entity::RootEntity;
 
-struct OpQueEntry {
-    Operation op;
-    Entity & from;
-
-    explicit OpQueEntry(const Operation & o, Entity & f);
-    OpQueEntry(const OpQueEntry & o);
-    ~OpQueEntry();
-
-    const Operation & operator*() const {
-        return op;
-    }
-
-    Atlas::Objects::Operation::RootOperationData * operator->() const {
-        return op.get();
-    }
-};
-
-OpQueEntry::OpQueEntry(const Operation & o, Entity & f) : op(o), from(f)
-{
-    from.incRef();
-}
-
-OpQueEntry::OpQueEntry(const OpQueEntry & o) : op(o.op), from(o.from)
-{
-    from.incRef();
-}
-
-OpQueEntry::~OpQueEntry()
-{
-    from.decRef();
-}
-
 WorldRouter::WorldRouter(const SystemTime &) :
       BaseWorld(*new Entity(consts::rootWorldId, consts::rootWorldIntId)),
       m_entityCount(1)
@@ -29,6 +29,7 @@
 #include "rulesets/Thing.h"
 
 #include "rulesets/Domain.h"
+#include "rulesets/VisibilityGrid.h"
 
 #include "common/const.h"
 #include "common/id.h"
@@ -113,6 +114,35 @@ void Motion::setMode(const std::string & mode)
 {
 }
 
+VisibilityGrid * VisibilityGrid::forContainer(const LocatedEntity & container,
+                                              double time)
+{
+    return 0;
+}
+
+void VisibilityGrid::moved(LocatedEntity & entity)
+{
+}
+
+float VisibilityGrid::sightRange(float squareBoxSize)
+{
+    return 0.f;
+}
+
+int VisibilityGrid::sightBox(const Point3D & old_pos, const Point3D & new_pos,
+                             float range, BBox & box)
+{
+    return -1;
+}
+
+void BroadPhase::update(LocatedEntity * entity)
+{
+}
+
+void BroadPhase::query(const BBox & box, CandidateList & res)
+{
+}
+
 void Motion::adjustPostion()
 {
 }
@@ -428,6 +458,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return 0.f;
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
     
@@ -481,7 +518,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 {
     long intId = integerId(id);
 
-    EntityDict::const_iterator I = m_eobjects.find(intId);
+    EntityTable::const_iterator I = m_eobjects.find(intId);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -492,7 +529,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 
 LocatedEntity * BaseWorld::getEntity(long id) const
 {
-    EntityDict::const_iterator I = m_eobjects.find(id);
+    EntityTable::const_iterator I = m_eobjects.find(id);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -135,6 +135,7 @@ int main()
 
 #include "rulesets/Domain.h"
 #include "rulesets/Motion.h"
+#include "rulesets/VisibilityGrid.h"
 
 #include "common/BaseWorld.h"
 #include "common/const.h"
@@ -175,6 +176,35 @@ void Motion::setMode(const std::string & mode)
 {
 }
 
+VisibilityGrid * VisibilityGrid::forContainer(const LocatedEntity & container,
+                                              double time)
+{
+    return 0;
+}
+
+void VisibilityGrid::moved(LocatedEntity & entity)
+{
+}
+
+float VisibilityGrid::sightRange(float squareBoxSize)
+{
+    return 0.f;
+}
+
+int VisibilityGrid::sightBox(const Point3D & old_pos, const Point3D & new_pos,
+                             float range, BBox & box)
+{
+    return -1;
+}
+
+void BroadPhase::update(LocatedEntity * entity)
+{
+}
+
+void BroadPhase::query(const BBox & box, CandidateList & res)
+{
+}
+
 void Motion::adjustPostion()
 {
 }
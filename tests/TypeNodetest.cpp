@@ -44,6 +44,42 @@ int main()
     assert(!foo.isTypeOf(&bar));
     assert(bar.isTypeOf(&foo));
 
+    assert(!foo.isTypeOf(0));
+
+    {
+        // Siblings, and a chain deeper than either of them
+        TypeNode baz("baz");
+        baz.setParent(&foo);
+        TypeNode qux("qux");
+        qux.setParent(&bar);
+        TypeNode quux("quux");
+        quux.setParent(&qux);
+
+        assert(foo.depth() == 0);
+        assert(baz.depth() == 1);
+        assert(quux.depth() == 3);
+
+        assert(baz.isTypeOf(&foo));
+        assert(!baz.isTypeOf(&bar));
+        assert(!bar.isTypeOf(&baz));
+        assert(quux.isTypeOf(&foo));
+        assert(quux.isTypeOf(&bar));
+        assert(quux.isTypeOf(&qux));
+        assert(quux.isTypeOf(&quux));
+        assert(!quux.isTypeOf(&baz));
+        assert(!qux.isTypeOf(&quux));
+
+        // Unrelated tree of the same depth
+        TypeNode other_root("other_root");
+        TypeNode other("other");
+        other.setParent(&other_root);
+        assert(!bar.isTypeOf(&other));
+        assert(!other.isTypeOf(&bar));
+        assert(!quux.isTypeOf(&other_root));
+        assert(other.isTypeOf("other_root"));
+        assert(!other.isTypeOf("thing"));
+    }
+
     foo.defaults();
     return 0;
 }
@@ -0,0 +1,350 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2014 Alistair Riddoch
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "rulesets/VisibilityGrid.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include "common/compose.hpp"
+#include "common/const.h"
+#include "common/random.h"
+
+#include <algorithm>
+
+#include <cmath>
+
+class TestEntity : public LocatedEntity
+{
+  public:
+    TestEntity(const std::string & id, long intId) : LocatedEntity(id, intId)
+    {
+    }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+    virtual void destroy() { }
+};
+
+class VisibilityGridtest : public Cyphesis::TestBase
+{
+  private:
+    TestEntity * m_world;
+    TestEntity * m_near;
+    TestEntity * m_far;
+    TestEntity * m_huge;
+    TestEntity * m_nowhere;
+
+    TestEntity * addEntity(long id, const Point3D & pos);
+    bool found(const BroadPhase::CandidateList & res, LocatedEntity * e);
+  public:
+    VisibilityGridtest();
+
+    void setup();
+    void teardown();
+
+    void test_sightRange();
+    void test_sightBox();
+    void test_query();
+    void test_moved();
+    void test_visibility_changes();
+};
+
+VisibilityGridtest::VisibilityGridtest()
+{
+    ADD_TEST(VisibilityGridtest::test_sightRange);
+    ADD_TEST(VisibilityGridtest::test_sightBox);
+    ADD_TEST(VisibilityGridtest::test_query);
+    ADD_TEST(VisibilityGridtest::test_moved);
+    ADD_TEST(VisibilityGridtest::test_visibility_changes);
+}
+
+TestEntity * VisibilityGridtest::addEntity(long id, const Point3D & pos)
+{
+    TestEntity * e = new TestEntity(String::compose("%1", id), id);
+    e->m_location.m_loc = m_world;
+    e->m_location.m_pos = pos;
+    e->m_location.setVisibility(consts::minBoxSize);
+    m_world->m_contains->insert(e);
+    return e;
+}
+
+bool VisibilityGridtest::found(const BroadPhase::CandidateList & res,
+                               LocatedEntity * e)
+{
+    return std::find(res.begin(), res.end(), e) != res.end();
+}
+
+void VisibilityGridtest::setup()
+{
+    m_world = new TestEntity("0", 0);
+    m_world->makeContainer();
+
+    m_near = addEntity(1, Point3D(5, 0, 0));
+    m_far = addEntity(2, Point3D(500, 0, 0));
+    m_huge = addEntity(3, Point3D(1000, 0, 0));
+    m_huge->m_location.setVisibility(100.f);
+    m_nowhere = addEntity(4, Point3D());
+}
+
+void VisibilityGridtest::teardown()
+{
+    VisibilityGrid::flush();
+
+    LocatedEntitySet::const_iterator I = m_world->m_contains->begin();
+    LocatedEntitySet::const_iterator Iend = m_world->m_contains->end();
+    for (; I != Iend; ++I) {
+        delete *I;
+    }
+    delete m_world;
+}
+
+void VisibilityGridtest::test_sightRange()
+{
+    float range = VisibilityGrid::sightRange(consts::minSqrBoxSize);
+    ASSERT_TRUE(range >= consts::minBoxSize / consts::sight_factor);
+    ASSERT_TRUE(range < consts::minBoxSize / consts::sight_factor + 1.f);
+}
+
+void VisibilityGridtest::test_sightBox()
+{
+    BBox box;
+    int ret = VisibilityGrid::sightBox(Point3D(0, 0, 0), Point3D(10, -5, 0),
+                                       2.f, box);
+    ASSERT_EQUAL(ret, 0);
+    ASSERT_EQUAL(box.lowCorner(), Point3D(-2, -7, -2));
+    ASSERT_EQUAL(box.highCorner(), Point3D(12, 2, 2));
+
+    ret = VisibilityGrid::sightBox(Point3D(), Point3D(10, -5, 0), 2.f, box);
+    ASSERT_EQUAL(ret, -1);
+}
+
+void VisibilityGridtest::test_query()
+{
+    VisibilityGrid * grid = VisibilityGrid::forContainer(*m_world, 10.);
+    ASSERT_NOT_NULL(grid);
+    ASSERT_EQUAL(grid->size(), 4u);
+
+    BBox box;
+    VisibilityGrid::sightBox(Point3D(0, 0, 0), Point3D(1, 0, 0),
+                             VisibilityGrid::sightRange(consts::minSqrBoxSize),
+                             box);
+    BroadPhase::CandidateList res;
+    grid->query(box, res);
+
+    ASSERT_TRUE(found(res, m_near));
+    ASSERT_TRUE(!found(res, m_far));
+    // Large entities can be seen from far away
+    ASSERT_TRUE(found(res, m_huge));
+    // Entities without a position are always checked
+    ASSERT_TRUE(found(res, m_nowhere));
+}
+
+void VisibilityGridtest::test_moved()
+{
+    VisibilityGrid * grid = VisibilityGrid::forContainer(*m_world, 10.);
+
+    BBox box;
+    VisibilityGrid::sightBox(Point3D(0, 0, 0), Point3D(1, 0, 0),
+                             VisibilityGrid::sightRange(consts::minSqrBoxSize),
+                             box);
+
+    m_far->m_location.m_pos = Point3D(3, 0, 0);
+    VisibilityGrid::moved(*m_far);
+
+    BroadPhase::CandidateList res;
+    grid->query(box, res);
+    ASSERT_TRUE(found(res, m_far));
+}
+
+void VisibilityGridtest::test_visibility_changes()
+{
+    // Every entity which would gain or lose sight of the mover, or come
+    // into or go out of its sight, must be returned by the query.
+    for (long id = 10; id < 1010; ++id) {
+        TestEntity * e = addEntity(id, Point3D(uniform(0, 1000),
+                                               uniform(0, 1000), 0));
+        e->m_location.setVisibility(uniform(0.5, 10.f));
+    }
+    TestEntity * mover = addEntity(2000, Point3D(500, 500, 0));
+
+    for (int i = 0; i < 200; ++i) {
+        Point3D old_pos = mover->m_location.pos();
+        mover->m_location.m_pos = Point3D(uniform(0, 1000),
+                                          uniform(0, 1000), 0);
+        mover->m_location.setVisibility(uniform(0.5, 5.f));
+        float fromSquSize = mover->m_location.squareBoxSize();
+
+        VisibilityGrid * grid = VisibilityGrid::forContainer(*m_world, 10.);
+        grid->update(mover);
+        BBox box;
+        VisibilityGrid::sightBox(old_pos, mover->m_location.pos(),
+                                 VisibilityGrid::sightRange(fromSquSize),
+                                 box);
+        BroadPhase::CandidateList res;
+        grid->query(box, res);
+
+        LocatedEntitySet::const_iterator I = m_world->m_contains->begin();
+        LocatedEntitySet::const_iterator Iend = m_world->m_contains->end();
+        for (; I != Iend; ++I) {
+            LocatedEntity * other = *I;
+            if (other == mover || !other->m_location.pos().isValid()) {
+                continue;
+            }
+            float old_dist = squareDistance(other->m_location.pos(), old_pos),
+                  new_dist = squareDistance(other->m_location.pos(),
+                                            mover->m_location.pos()),
+                  squ_size = other->m_location.squareBoxSize();
+            bool was_in_range = ((fromSquSize / old_dist) > consts::square_sight_factor),
+                 is_in_range = ((fromSquSize / new_dist) > consts::square_sight_factor);
+            bool could_see = ((squ_size / old_dist) > consts::square_sight_factor),
+                 can_see = ((squ_size / new_dist) > consts::square_sight_factor);
+            if (was_in_range != is_in_range || could_see != can_see) {
+                ASSERT_TRUE(found(res, other));
+            }
+        }
+    }
+}
+
+int main()
+{
+    VisibilityGridtest t;
+
+    return t.run();
+}
+
+// stubs
+
+
+LocatedEntity::LocatedEntity(const std::string & id, long intId) :
+               Router(id, intId),
+               m_refCount(0), m_seq(0),
+               m_script(0), m_type(0), m_flags(0), m_contains(0)
+{
+}
+
+LocatedEntity::~LocatedEntity()
+{
+    delete m_contains;
+}
+
+bool LocatedEntity::hasAttr(const std::string & name) const
+{
+    return false;
+}
+
+int LocatedEntity::getAttr(const std::string & name,
+                           Atlas::Message::Element & attr) const
+{
+    return -1;
+}
+
+int LocatedEntity::getAttrType(const std::string & name,
+                               Atlas::Message::Element & attr,
+                               int type) const
+{
+    return -1;
+}
+
+PropertyBase * LocatedEntity::setAttr(const std::string & name,
+                                      const Atlas::Message::Element & attr)
+{
+    return 0;
+}
+
+const PropertyBase * LocatedEntity::getProperty(const std::string & name) const
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::modProperty(const std::string & name)
+{
+    return 0;
+}
+
+PropertyBase * LocatedEntity::setProperty(const std::string & name,
+                                          PropertyBase * prop)
+{
+    return 0;
+}
+
+void LocatedEntity::installDelegate(int, const std::string &)
+{
+}
+
+void LocatedEntity::destroy()
+{
+}
+
+Domain * LocatedEntity::getMovementDomain()
+{
+    return 0;
+}
+
+void LocatedEntity::sendWorld(const Operation & op)
+{
+}
+
+void LocatedEntity::onContainered(const LocatedEntity*)
+{
+}
+
+void LocatedEntity::onUpdated()
+{
+}
+
+void LocatedEntity::makeContainer()
+{
+    if (m_contains == 0) {
+        m_contains = new LocatedEntitySet;
+    }
+}
+
+Router::Router(const std::string & id, long intId) : m_id(id), m_intId(intId)
+{
+}
+
+Router::~Router()
+{
+}
+
+void Router::addToMessage(Atlas::Message::MapType & omap) const
+{
+}
+
+void Router::addToEntity(const Atlas::Objects::Entity::RootEntity & ent) const
+{
+}
+
+Location::Location() : m_squareBoxSize(consts::minSqrBoxSize), m_loc(0)
+{
+}
+
+void Location::setVisibility(float v)
+{
+    m_boxSize = v;
+    m_squareBoxSize = v * v;
+}
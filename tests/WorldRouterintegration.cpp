@@ -104,6 +104,10 @@ void WorldRouterintegration::test_sequence()
     ent2->m_location.m_pos = Point3D(0,0,0);
     test_world->addEntity(ent2);
 
+    // Entities are found through the index of their type
+    ASSERT_EQUAL(test_world->findByType("thing"), ent1);
+    ASSERT_NULL(test_world->findByName("__no_such_name__"));
+
     test_world->getOperationFromQueue();
 
     Tick tick;
@@ -244,6 +248,7 @@ int main()
 #include "rulesets/Stackable.h"
 #include "rulesets/ExternalMind.h"
 #include "rulesets/Motion.h"
+#include "rulesets/VisibilityGrid.h"
 #include "rulesets/Pedestrian.h"
 #include "rulesets/PythonArithmeticFactory.h"
 #include "rulesets/Task.h"
@@ -759,6 +764,35 @@ void Motion::setMode(const std::string & mode)
 {
 }
 
+VisibilityGrid * VisibilityGrid::forContainer(const LocatedEntity & container,
+                                              double time)
+{
+    return 0;
+}
+
+void VisibilityGrid::moved(LocatedEntity & entity)
+{
+}
+
+float VisibilityGrid::sightRange(float squareBoxSize)
+{
+    return 0.f;
+}
+
+int VisibilityGrid::sightBox(const Point3D & old_pos, const Point3D & new_pos,
+                             float range, BBox & box)
+{
+    return -1;
+}
+
+void BroadPhase::update(LocatedEntity * entity)
+{
+}
+
+void BroadPhase::query(const BBox & box, CandidateList & res)
+{
+}
+
 void Motion::adjustPostion()
 {
 }
@@ -773,6 +807,104 @@ Operation * Motion::genMoveOperation()
     return 0;
 }
 
+#include "rulesets/MetabolismSystem.h"
+#include "rulesets/MovementSystem.h"
+#include "rulesets/MindLodScheduler.h"
+
+MindLodScheduler * MindLodScheduler::m_instance = 0;
+
+MindLodScheduler::MindLodScheduler() : m_monitored(0)
+{
+}
+
+MindLodScheduler::~MindLodScheduler()
+{
+}
+
+MindLodScheduler * MindLodScheduler::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MindLodScheduler;
+    }
+    return m_instance;
+}
+
+void MindLodScheduler::addPlayer(LocatedEntity *)
+{
+}
+
+void MindLodScheduler::removePlayer(LocatedEntity *)
+{
+}
+
+void MindLodScheduler::removeMind(LocatedEntity *)
+{
+}
+
+void MindLodScheduler::scheduleTick(LocatedEntity &, const Operation &)
+{
+}
+
+bool MindLodScheduler::checkTick(LocatedEntity &, const Operation &)
+{
+    return true;
+}
+
+bool MindLodScheduler::checkPerception(LocatedEntity &, const Operation &)
+{
+    return true;
+}
+
+void MindLodScheduler::playerMoved(LocatedEntity &)
+{
+}
+
+MetabolismSystem * MetabolismSystem::m_instance = 0;
+
+MetabolismSystem::MetabolismSystem()
+{
+}
+
+MetabolismSystem::~MetabolismSystem()
+{
+}
+
+MetabolismSystem * MetabolismSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MetabolismSystem;
+    }
+    return m_instance;
+}
+
+int MetabolismSystem::addEntity(Character *)
+{
+    return 0;
+}
+
+MovementSystem * MovementSystem::m_instance = 0;
+
+MovementSystem::MovementSystem()
+{
+}
+
+MovementSystem::~MovementSystem()
+{
+}
+
+MovementSystem * MovementSystem::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new MovementSystem;
+    }
+    return m_instance;
+}
+
+int MovementSystem::addEntity(Character *)
+{
+    return 0;
+}
+
 Pedestrian::Pedestrian(LocatedEntity & body) : Movement(body)
 {
 }
@@ -1002,7 +1134,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 {
     long intId = integerId(id);
 
-    EntityDict::const_iterator I = m_eobjects.find(intId);
+    EntityTable::const_iterator I = m_eobjects.find(intId);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -1013,7 +1145,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 
 LocatedEntity * BaseWorld::getEntity(long id) const
 {
-    EntityDict::const_iterator I = m_eobjects.find(id);
+    EntityTable::const_iterator I = m_eobjects.find(id);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -42,10 +42,13 @@
 #include "common/Monitors.h"
 #include "common/SystemTime.h"
 #include "common/Tick.h"
+#include "common/TypeNode.h"
 #include "common/Variable.h"
 
 #include <Atlas/Objects/Anonymous.h>
 
+#include <sigc++/functors/ptr_fun.h>
+
 #include <cstdio>
 #include <cstdlib>
 
@@ -58,6 +61,20 @@ using Atlas::Objects::Operation::Tick;
 
 static bool stub_deny_newid = false;
 
+static std::vector<double> system_times;
+
+static void recordSystemTime(double time)
+{
+    system_times.push_back(time);
+}
+
+static std::vector<std::string> dispatched_to;
+
+static void recordDispatch(Operation op)
+{
+    dispatched_to.push_back(op->getTo());
+}
+
 class WorldRoutertest : public Cyphesis::TestBase
 {
     WorldRouter * test_world;
@@ -80,6 +97,12 @@ class WorldRoutertest : public Cyphesis::TestBase
     void test_createSpawnPoint();
     void test_delEntity();
     void test_delEntity_world();
+    void test_queue_reuse();
+    void test_dormant();
+    void test_frames();
+    void test_suspended();
+    void test_pollTimeout();
+    void test_partitioned();
 };
 
 WorldRoutertest::WorldRoutertest()
@@ -97,6 +120,12 @@ WorldRoutertest::WorldRoutertest()
     ADD_TEST(WorldRoutertest::test_createSpawnPoint);
     ADD_TEST(WorldRoutertest::test_delEntity);
     ADD_TEST(WorldRoutertest::test_delEntity_world);
+    ADD_TEST(WorldRoutertest::test_queue_reuse);
+    ADD_TEST(WorldRoutertest::test_dormant);
+    ADD_TEST(WorldRoutertest::test_frames);
+    ADD_TEST(WorldRoutertest::test_suspended);
+    ADD_TEST(WorldRoutertest::test_pollTimeout);
+    ADD_TEST(WorldRoutertest::test_partitioned);
 }
 
 void WorldRoutertest::setup()
@@ -194,6 +223,216 @@ void WorldRoutertest::test_addEntity_tick_get()
     test_world->getOperationFromQueue();
 }
 
+void WorldRoutertest::test_queue_reuse()
+{
+    std::string id;
+    long int_id = newId(id);
+
+    Entity * ent2 = new Entity(id, int_id);
+    ent2->m_location.m_loc = &test_world->m_gameWorld;
+    ent2->m_location.m_pos = Point3D(0,0,0);
+    test_world->addEntity(ent2);
+    int refs = ent2->checkRef();
+
+    Tick tick;
+    tick->setTo(ent2->getId());
+    test_world->message(tick, *ent2);
+    ASSERT_EQUAL(test_world->m_immediateQueue.size(), 1u);
+    ASSERT_EQUAL(test_world->m_immediateQueue.spare(), 0u);
+    ASSERT_EQUAL(ent2->checkRef(), refs + 1);
+
+    // The entry releases its references when removed, and is kept
+    test_world->m_immediateQueue.pop_front();
+    ASSERT_TRUE(test_world->m_immediateQueue.empty());
+    ASSERT_EQUAL(test_world->m_immediateQueue.spare(), 1u);
+    ASSERT_EQUAL(ent2->checkRef(), refs);
+
+    test_world->message(tick, *ent2);
+    ASSERT_EQUAL(test_world->m_immediateQueue.size(), 1u);
+    ASSERT_EQUAL(test_world->m_immediateQueue.spare(), 0u);
+    ASSERT_EQUAL(ent2->checkRef(), refs + 1);
+    ASSERT_TRUE(test_world->m_immediateQueue.begin()->op.get() == tick.get());
+}
+
+void WorldRoutertest::test_dormant()
+{
+    std::string id;
+    long int_id = newId(id);
+
+    Entity * ent2 = new Entity(id, int_id);
+    ent2->m_location.m_loc = &test_world->m_gameWorld;
+    ent2->m_location.m_pos = Point3D(0,0,0);
+    test_world->addEntity(ent2);
+    ent2->setFlags(entity_asleep);
+
+    // A Tick for a sleeping entity is parked
+    Tick tick;
+    tick->setTo(ent2->getId());
+    test_world->deliverTo(tick, *ent2);
+    ASSERT_EQUAL(test_world->m_dormantQueue.size(), 1u);
+    ASSERT_TRUE(test_world->m_immediateQueue.empty());
+
+    test_world->wakeEntities();
+    ASSERT_EQUAL(test_world->m_dormantQueue.size(), 1u);
+
+    // Once the entity is awake it is sent on
+    ent2->resetFlags(entity_asleep);
+    test_world->wakeEntities();
+    ASSERT_TRUE(test_world->m_dormantQueue.empty());
+    ASSERT_EQUAL(test_world->m_immediateQueue.size(), 1u);
+    ASSERT_TRUE(test_world->m_immediateQueue.begin()->op.get() == tick.get());
+}
+
+void WorldRoutertest::test_frames()
+{
+    system_times.clear();
+    test_world->addSystem("test", sigc::ptr_fun(&recordSystemTime));
+
+    // Without a frame rate systems are run with the current time
+    test_world->m_realTime = 10.;
+    test_world->runSystems(test_world->m_realTime);
+    ASSERT_EQUAL(system_times.size(), 1u);
+    ASSERT_EQUAL(system_times.back(), 10.);
+
+    std::string id;
+    long int_id = newId(id);
+
+    Entity * ent2 = new Entity(id, int_id);
+    ent2->m_location.m_loc = &test_world->m_gameWorld;
+    ent2->m_location.m_pos = Point3D(0,0,0);
+    test_world->addEntity(ent2);
+    test_world->m_immediateQueue.clear();
+
+    test_world->setFrameRate(10.);
+    ASSERT_EQUAL(test_world->m_frameDue, 10.);
+
+    // Operations queued for immediate dispatch are sent with the frame
+    Tick tick;
+    tick->setFrom(ent2->getId());
+    tick->setTo(ent2->getId());
+    test_world->m_immediateQueue.push_back(tick, *ent2);
+
+    test_world->m_realTime = 10.05;
+    test_world->runFrame();
+    ASSERT_EQUAL(system_times.size(), 2u);
+    // Systems see the time the frame was due
+    ASSERT_EQUAL(system_times.back(), 10.);
+    ASSERT_TRUE(test_world->m_immediateQueue.empty());
+    ASSERT_EQUAL(test_world->frameCount(), 1);
+    ASSERT_EQUAL(test_world->m_frameDue, 10. + 0.1);
+    ASSERT_EQUAL(test_world->m_frameOverruns, 0);
+
+    // A world which has fallen behind skips frames
+    test_world->m_realTime = 11.;
+    test_world->runFrame();
+    ASSERT_EQUAL(system_times.back(), 10. + 0.1);
+    ASSERT_EQUAL(test_world->m_frameDue, 11. + 0.1);
+    ASSERT_EQUAL(test_world->m_frameOverruns, 1);
+}
+
+void WorldRoutertest::test_suspended()
+{
+    system_times.clear();
+    test_world->addSystem("test", sigc::ptr_fun(&recordSystemTime));
+
+    SystemTime time;
+    time.update();
+
+    // Systems are not run while the world is suspended
+    test_world->m_isSuspended = true;
+    test_world->idle(time);
+    ASSERT_TRUE(system_times.empty());
+
+    test_world->setFrameRate(10.);
+    test_world->m_frameDue = 0.;
+    test_world->idle(time);
+    ASSERT_TRUE(system_times.empty());
+    ASSERT_EQUAL(test_world->frameCount(), 0);
+
+    // Frames missed while suspended are skipped, not counted as overruns
+    test_world->m_isSuspended = false;
+    test_world->resumeWorld();
+    ASSERT_EQUAL(test_world->m_frameDue, test_world->m_realTime);
+    test_world->idle(time);
+    ASSERT_EQUAL(system_times.size(), 1u);
+    ASSERT_EQUAL(test_world->frameCount(), 1);
+    ASSERT_EQUAL(test_world->m_frameOverruns, 0);
+}
+
+void WorldRoutertest::test_pollTimeout()
+{
+    // Without a frame rate the server sleeps for as long as it likes
+    ASSERT_EQUAL(test_world->pollTimeout(100), 100);
+
+    test_world->m_realTime = 10.;
+    test_world->setFrameRate(20.);
+
+    // The sleep ends when the next frame is due
+    ASSERT_EQUAL(test_world->pollTimeout(100), 0);
+    test_world->m_frameDue = 10.02;
+    ASSERT_EQUAL(test_world->pollTimeout(100), 20);
+    test_world->m_frameDue = 11.;
+    ASSERT_EQUAL(test_world->pollTimeout(100), 100);
+
+    // A frame which is overdue doesn't wait for traffic
+    test_world->m_frameDue = 9.;
+    ASSERT_EQUAL(test_world->pollTimeout(100), 0);
+
+    // Frames are not run while the world is suspended
+    test_world->m_isSuspended = true;
+    ASSERT_EQUAL(test_world->pollTimeout(100), 100);
+    test_world->m_isSuspended = false;
+}
+
+void WorldRoutertest::test_partitioned()
+{
+    std::string id;
+    long int_id = newId(id);
+    Entity * top1 = new Entity(id, int_id);
+    top1->m_location.m_loc = &test_world->m_gameWorld;
+    top1->m_location.m_pos = Point3D(0,0,0);
+    test_world->addEntity(top1);
+
+    int_id = newId(id);
+    Entity * top2 = new Entity(id, int_id);
+    top2->m_location.m_loc = &test_world->m_gameWorld;
+    top2->m_location.m_pos = Point3D(0,0,0);
+    test_world->addEntity(top2);
+
+    int_id = newId(id);
+    Entity * child = new Entity(id, int_id);
+    child->m_location.m_loc = top1;
+    child->m_location.m_pos = Point3D(0,0,0);
+    test_world->addEntity(child);
+
+    test_world->m_immediateQueue.clear();
+    test_world->setPartitioned(true);
+    test_world->Dispatching.connect(sigc::ptr_fun(&recordDispatch));
+    dispatched_to.clear();
+
+    LocatedEntity * targets[] = { &test_world->m_gameWorld, top2, child, top1 };
+    for (int i = 0; i < 4; ++i) {
+        Tick tick;
+        tick->setTo(targets[i]->getId());
+        test_world->message(tick, *targets[i]);
+    }
+    ASSERT_EQUAL(test_world->partitionKey(*test_world->m_immediateQueue.begin()), -1);
+
+    SystemTime time;
+    time.update();
+    test_world->idle(time);
+
+    // Each subtree is dispatched in turn, in the order of its top-level
+    // entity, and operations which cross subtrees are dispatched last
+    ASSERT_EQUAL(dispatched_to.size(), 4u);
+    ASSERT_EQUAL(dispatched_to[0], child->getId());
+    ASSERT_EQUAL(dispatched_to[1], top1->getId());
+    ASSERT_EQUAL(dispatched_to[2], top2->getId());
+    ASSERT_EQUAL(dispatched_to[3], test_world->m_gameWorld.getId());
+    ASSERT_TRUE(test_world->m_immediateQueue.empty());
+    ASSERT_TRUE(test_world->m_resultQueue == 0);
+}
+
 void WorldRoutertest::test_spawnNewEntity_unknown()
 {
     LocatedEntity * ent3 = test_world->spawnNewEntity("__no_spawn__",
@@ -395,6 +634,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return 0.f;
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
     
@@ -764,7 +1010,8 @@ long newId(std::string & id)
     return new_id;
 }
 
-BaseWorld::BaseWorld(LocatedEntity & gw) : m_gameWorld(gw)
+BaseWorld::BaseWorld(LocatedEntity & gw) : m_isSuspended(false),
+                                            m_gameWorld(gw)
 {
 }
 
@@ -776,7 +1023,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 {
     long intId = integerId(id);
 
-    EntityDict::const_iterator I = m_eobjects.find(intId);
+    EntityTable::const_iterator I = m_eobjects.find(intId);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -787,7 +1034,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 
 LocatedEntity * BaseWorld::getEntity(long id) const
 {
-    EntityDict::const_iterator I = m_eobjects.find(id);
+    EntityTable::const_iterator I = m_eobjects.find(id);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -819,6 +1066,11 @@ const TypeNode * Inheritance::getType(const std::string & parent)
     return I->second;
 }
 
+bool TypeNode::isTypeOf(const TypeNode * base_type) const
+{
+    return false;
+}
+
 VariableBase::~VariableBase()
 {
 }
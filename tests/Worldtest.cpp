@@ -408,6 +408,13 @@ float Domain::constrainHeight(LocatedEntity * parent,
     return 0.f;
 }
 
+bool Domain::collisionCandidates(LocatedEntity & entity,
+                                 const BBox & box,
+                                 std::vector<LocatedEntity *> & res)
+{
+    return false;
+}
+
 void Domain::tick(double t)
 {
     
@@ -461,7 +468,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 {
     long intId = integerId(id);
 
-    EntityDict::const_iterator I = m_eobjects.find(intId);
+    EntityTable::const_iterator I = m_eobjects.find(intId);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -472,7 +479,7 @@ LocatedEntity * BaseWorld::getEntity(const std::string & id) const
 
 LocatedEntity * BaseWorld::getEntity(long id) const
 {
-    EntityDict::const_iterator I = m_eobjects.find(id);
+    EntityTable::const_iterator I = m_eobjects.find(id);
     if (I != m_eobjects.end()) {
         assert(I->second != 0);
         return I->second;
@@ -530,6 +537,16 @@ bool TypeNode::isTypeOf(const std::string & base_type) const
     return false;
 }
 
+bool TypeNode::isTypeOf(const TypeNode * base_type) const
+{
+    return false;
+}
+
+const TypeNode * TypeHandle::get() const
+{
+    return 0;
+}
+
 TerrainProperty::TerrainProperty() :
       m_data(*(Mercator::Terrain*)0),
       m_tileShader(*(Mercator::TileShader*)0)